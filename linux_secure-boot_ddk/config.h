@@ -46,5 +46,16 @@
 // as you wish but I think the EIP123 IP HW can support 2 MB max Enc/Decrypt
 #define SBHYBRID_MAX_SIZE_PE_JOB_BLOCKS     (0x3FFF * 64)
 
+// Number of worker threads that verify the certificate chain (ECDSA_SW only),
+// while the image is decrypted and hashed. 0 verifies the chain in the
+// calling thread after the image pass.
+#define SBHYBRID_CERT_VERIFY_THREADS        2
+
+// Hash tree images (HASH_TREE_IMAGE): number of worker threads that verify
+// data blocks with the hash calculated by the CM, and on the CPU. The
+// calling thread also verifies blocks (with the CM).
+#define SBHYBRID_HASHTREE_CM_THREADS        1
+#define SBHYBRID_HASHTREE_SW_THREADS        1
+
 #endif /* __CONFIG_H__ */
 
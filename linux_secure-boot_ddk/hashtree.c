@@ -0,0 +1,736 @@
+/*
+** Secure Boot Image Authentication usign EIP-123 DDK
+** Hash tree images: block-level decrypt and verify
+**
+*/
+
+/*
+ * Headers
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include <sfzcryptoapi.h>
+#include <sfzcrypto_context.h>
+#include "hashtree.h"
+
+/*
+ * Macro
+*/
+
+#ifndef SBHYBRID_HASHTREE_CM_THREADS
+#define SBHYBRID_HASHTREE_CM_THREADS 0
+#endif
+
+#ifndef SBHYBRID_HASHTREE_SW_THREADS
+#define SBHYBRID_HASHTREE_SW_THREADS 0
+#endif
+
+#define SBHYBRID_HASHTREE_THREADS \
+        (SBHYBRID_HASHTREE_CM_THREADS + SBHYBRID_HASHTREE_SW_THREADS)
+
+#define SBHYBRID_HASHTREE_DIGEST_LEN SBIF_ECDSA_BYTES
+
+#if SBIF_ECDSA_WORDS == 7
+#define SBHYBRID_HASHTREE_ALGO SFZCRYPTO_ALGO_HASH_SHA224
+#else
+#define SBHYBRID_HASHTREE_ALGO SFZCRYPTO_ALGO_HASH_SHA256
+#endif /* SBIF_ECDSA_WORDS */
+
+/* Data block states. */
+#define SBHYBRID_HASHTREE_BLOCK_NEW      0
+#define SBHYBRID_HASHTREE_BLOCK_VERIFIED 1
+#define SBHYBRID_HASHTREE_BLOCK_FAILED   2
+#define SBHYBRID_HASHTREE_BLOCK_BUSY     3   /* being decrypted/verified */
+
+/*
+ * Type definition
+*/
+
+/* SHA-224/256 state for the software hash path. */
+typedef struct
+{
+    uint32_t H[8];
+    uint8_t  Block[64];
+}
+SBHYBRID_Sha2_t;
+
+/* VerifyAll: one job per level 0 hash block, i.e. per HashesPerBlock
+   data blocks. */
+typedef struct
+{
+    SBHYBRID_HashTree_t * Tree_p;
+
+    pthread_mutex_t Lock;       // protects NextJob and Result
+    uint32_t        NextJob;
+    uint32_t        JobCount;
+    SfzCryptoStatus Result;     // first failure, skip remaining jobs
+}
+SBHYBRID_HashTree_Pool_t;
+
+typedef struct
+{
+    SBHYBRID_HashTree_Pool_t * Pool_p;
+    bool                       UseCM;
+    pthread_t                  Thread;
+}
+SBHYBRID_HashTree_Worker_t;
+
+/*
+ * Local Functions
+*/
+
+static inline uint32_t
+Load_BE32(
+        const void * const Value_p)
+{
+    const uint8_t * const p = (const uint8_t *)Value_p;
+
+    return (p[0] << 24 |
+            p[1] << 16 |
+            p[2] << 8  |
+            p[3]);
+}
+
+static const uint32_t SBHYBRID_Sha2_K[64] =
+{
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define SBHYBRID_SHA2_ROR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+/*----------------------------------------------------------------------------
+ * SBHYBRID_Sha2_Block
+ */
+static void
+SBHYBRID_Sha2_Block(
+        SBHYBRID_Sha2_t * const Sha_p,
+        const uint8_t * Block_p)
+{
+    uint32_t W[64];
+    uint32_t a, b, c, d, e, f, g, h;
+    unsigned int i;
+
+    for (i = 0; i < 16; i++)
+        W[i] = Load_BE32(Block_p + 4 * i);
+
+    for (i = 16; i < 64; i++)
+    {
+        const uint32_t s0 = SBHYBRID_SHA2_ROR(W[i - 15], 7) ^
+                            SBHYBRID_SHA2_ROR(W[i - 15], 18) ^
+                            (W[i - 15] >> 3);
+        const uint32_t s1 = SBHYBRID_SHA2_ROR(W[i - 2], 17) ^
+                            SBHYBRID_SHA2_ROR(W[i - 2], 19) ^
+                            (W[i - 2] >> 10);
+
+        W[i] = W[i - 16] + s0 + W[i - 7] + s1;
+    }
+
+    a = Sha_p->H[0]; b = Sha_p->H[1]; c = Sha_p->H[2]; d = Sha_p->H[3];
+    e = Sha_p->H[4]; f = Sha_p->H[5]; g = Sha_p->H[6]; h = Sha_p->H[7];
+
+    for (i = 0; i < 64; i++)
+    {
+        const uint32_t S1 = SBHYBRID_SHA2_ROR(e, 6) ^
+                            SBHYBRID_SHA2_ROR(e, 11) ^
+                            SBHYBRID_SHA2_ROR(e, 25);
+        const uint32_t T1 = h + S1 + ((e & f) ^ (~e & g)) +
+                            SBHYBRID_Sha2_K[i] + W[i];
+        const uint32_t S0 = SBHYBRID_SHA2_ROR(a, 2) ^
+                            SBHYBRID_SHA2_ROR(a, 13) ^
+                            SBHYBRID_SHA2_ROR(a, 22);
+        const uint32_t T2 = S0 + ((a & b) ^ (a & c) ^ (b & c));
+
+        h = g; g = f; f = e; e = d + T1;
+        d = c; c = b; b = a; a = T1 + T2;
+    }
+
+    Sha_p->H[0] += a; Sha_p->H[1] += b; Sha_p->H[2] += c; Sha_p->H[3] += d;
+    Sha_p->H[4] += e; Sha_p->H[5] += f; Sha_p->H[6] += g; Sha_p->H[7] += h;
+}
+
+
+/*----------------------------------------------------------------------------
+ * SBHYBRID_Sha2
+ *
+ * Software SHA-224/SHA-256 (same algorithm as the signature digest).
+ */
+static void
+SBHYBRID_Sha2(
+        const uint8_t * Data_p,
+        const uint32_t DataLen,
+        uint8_t * Digest_p)
+{
+#if SBIF_ECDSA_WORDS == 7
+    static const uint32_t H0[8] =
+    {
+        0xc1059ed8, 0x367cd507, 0x3070dd17, 0xf70e5939,
+        0xffc00b31, 0x68581511, 0x64f98fa7, 0xbefa4fa4
+    };
+#else
+    static const uint32_t H0[8] =
+    {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+        0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+#endif /* SBIF_ECDSA_WORDS */
+    SBHYBRID_Sha2_t Sha;
+    const uint64_t BitLen = (uint64_t)DataLen * 8;
+    uint32_t Left = DataLen;
+    unsigned int i;
+
+    memcpy(Sha.H, H0, sizeof(Sha.H));
+
+    for (; Left >= 64; Left -= 64, Data_p += 64)
+        SBHYBRID_Sha2_Block(&Sha, Data_p);
+
+    memset(Sha.Block, 0, sizeof(Sha.Block));
+    memcpy(Sha.Block, Data_p, Left);
+    Sha.Block[Left] = 0x80;
+
+    if (Left >= 56)
+    {
+        SBHYBRID_Sha2_Block(&Sha, Sha.Block);
+        memset(Sha.Block, 0, sizeof(Sha.Block));
+    }
+
+    for (i = 0; i < 8; i++)
+        Sha.Block[56 + i] = (uint8_t)(BitLen >> (56 - 8 * i));
+
+    SBHYBRID_Sha2_Block(&Sha, Sha.Block);
+
+    for (i = 0; i < SBHYBRID_HASHTREE_DIGEST_LEN; i++)
+        Digest_p[i] = (uint8_t)(Sha.H[i / 4] >> (24 - 8 * (i % 4)));
+}
+
+
+/*----------------------------------------------------------------------------
+ * SBHYBRID_HashTree_Hash
+ *
+ * One complete digest, through the CM or on the CPU.
+ */
+static SfzCryptoStatus
+SBHYBRID_HashTree_Hash(
+        const bool UseCM,
+        const uint8_t * Data_p,
+        const uint32_t DataLen,
+        uint8_t * Digest_p)
+{
+    SfzCryptoHashContext sha_ctx;
+    SfzCryptoStatus res;
+
+    if (!UseCM)
+    {
+        SBHYBRID_Sha2(Data_p, DataLen, Digest_p);
+        return SFZCRYPTO_SUCCESS;
+    }
+
+    memset((void *)&sha_ctx, 0, sizeof(sha_ctx));
+    sha_ctx.algo = SBHYBRID_HASHTREE_ALGO;
+
+    res = sfzcrypto_hash_data( sfzcrypto_context_get(),
+                               (SfzCryptoHashContext * const) &sha_ctx,
+                               (uint8_t *) Data_p,
+                               DataLen,
+                               true, // init
+                               true); // final
+
+    if (res == SFZCRYPTO_SUCCESS)
+        memcpy(Digest_p, sha_ctx.digest, SBHYBRID_HASHTREE_DIGEST_LEN);
+
+    return res;
+}
+
+
+/*----------------------------------------------------------------------------
+ * SBHYBRID_HashTree_HashBlock
+ */
+static inline const uint8_t *
+SBHYBRID_HashTree_HashBlock(
+        const SBHYBRID_HashTree_t * const Tree_p,
+        const unsigned int Level,
+        const uint32_t BlockNr)
+{
+    return Tree_p->HashBlocks_p +
+           (size_t)(Tree_p->LevelFirst[Level] + BlockNr) * Tree_p->BlockSize;
+}
+
+
+/*----------------------------------------------------------------------------
+ * SBHYBRID_HashTree_VerifyHashBlock
+ *
+ * Verifies a hash block against its entry in the parent hash block (which
+ * is verified first, if needed) or against the root hash.
+ * Each hash block is hashed once.
+ */
+static SfzCryptoStatus
+SBHYBRID_HashTree_VerifyHashBlock(
+        SBHYBRID_HashTree_t * const Tree_p,
+        const bool UseCM,
+        const unsigned int Level,
+        const uint32_t BlockNr)
+{
+    const uint32_t Index = Tree_p->LevelFirst[Level] + BlockNr;
+    uint8_t Digest[SBHYBRID_HASHTREE_DIGEST_LEN];
+    const uint8_t * Expected_p;
+    SfzCryptoStatus res;
+    bool Verified;
+
+    pthread_mutex_lock(&Tree_p->Lock);
+    Verified = Tree_p->HashBlockVerified_p[Index] != 0;
+    pthread_mutex_unlock(&Tree_p->Lock);
+
+    if (Verified)
+        return SFZCRYPTO_SUCCESS;
+
+    res = SBHYBRID_HashTree_Hash(
+                UseCM,
+                SBHYBRID_HashTree_HashBlock(Tree_p, Level, BlockNr),
+                Tree_p->BlockSize,
+                Digest);
+
+    if (res != SFZCRYPTO_SUCCESS)
+        return res;
+
+    if (Level + 1 == Tree_p->LevelCount)
+    {
+        Expected_p = Tree_p->RootHash;
+    }
+    else
+    {
+        const uint32_t ParentNr = BlockNr / Tree_p->HashesPerBlock;
+
+        res = SBHYBRID_HashTree_VerifyHashBlock(
+                    Tree_p, UseCM, Level + 1, ParentNr);
+
+        if (res != SFZCRYPTO_SUCCESS)
+            return res;
+
+        Expected_p = SBHYBRID_HashTree_HashBlock(Tree_p, Level + 1, ParentNr) +
+                     (BlockNr % Tree_p->HashesPerBlock) *
+                     SBHYBRID_HASHTREE_DIGEST_LEN;
+    }
+
+    if (memcmp(Digest, Expected_p, SBHYBRID_HASHTREE_DIGEST_LEN) != 0)
+    {
+        fprintf(stderr,
+                "Hash tree level %u block %u mismatch\n", Level, BlockNr);
+        return SFZCRYPTO_SIGNATURE_CHECK_FAILED;
+    }
+
+    pthread_mutex_lock(&Tree_p->Lock);
+    Tree_p->HashBlockVerified_p[Index] = 1;
+    pthread_mutex_unlock(&Tree_p->Lock);
+
+    return SFZCRYPTO_SUCCESS;
+}
+
+
+/*----------------------------------------------------------------------------
+ * SBHYBRID_HashTree_VerifyDataBlock
+ *
+ * Decrypts a data block in place and verifies it. A block that fails is
+ * cleared, so unverified content is never left behind.
+ * The calling thread claims the block (BUSY) before decrypting it in place;
+ * other callers for the same block wait for the result, so a block is never
+ * decrypted twice.
+ */
+static SfzCryptoStatus
+SBHYBRID_HashTree_VerifyDataBlock(
+        SBHYBRID_HashTree_t * const Tree_p,
+        const bool UseCM,
+        const uint32_t BlockNr)
+{
+    uint8_t * const Block_p = Tree_p->Data_p + (size_t)BlockNr * Tree_p->BlockSize;
+    uint32_t BlockLen = Tree_p->DataLen - BlockNr * Tree_p->BlockSize;
+    uint8_t Digest[SBHYBRID_HASHTREE_DIGEST_LEN];
+    SfzCryptoStatus res = SFZCRYPTO_SUCCESS;
+    uint8_t State;
+
+    if (BlockLen > Tree_p->BlockSize)
+        BlockLen = Tree_p->BlockSize;
+
+    pthread_mutex_lock(&Tree_p->Lock);
+    while (Tree_p->DataBlockState_p[BlockNr] == SBHYBRID_HASHTREE_BLOCK_BUSY)
+        pthread_cond_wait(&Tree_p->BlockDone, &Tree_p->Lock);
+
+    State = Tree_p->DataBlockState_p[BlockNr];
+    if (State == SBHYBRID_HASHTREE_BLOCK_NEW)
+        Tree_p->DataBlockState_p[BlockNr] = SBHYBRID_HASHTREE_BLOCK_BUSY;
+    pthread_mutex_unlock(&Tree_p->Lock);
+
+    if (State == SBHYBRID_HASHTREE_BLOCK_VERIFIED)
+        return SFZCRYPTO_SUCCESS;
+
+    if (State == SBHYBRID_HASHTREE_BLOCK_FAILED)
+        return SFZCRYPTO_SIGNATURE_CHECK_FAILED;
+
+    if (Tree_p->DoDecrypt)
+    {
+        SfzCryptoCipherContext aes_ctx;
+        SfzCryptoCipherKey     aes_key = Tree_p->Key;
+        uint32_t               tmp_dst_len = BlockLen;
+
+        memset((void *)&aes_ctx, 0, sizeof(aes_ctx));
+        aes_ctx.fbmode      = SFZCRYPTO_MODE_CBC;
+        memcpy((void *)aes_ctx.iv, Tree_p->IV_p[BlockNr], 16);
+        aes_ctx.iv_asset_id = SFZCRYPTO_ASSETID_INVALID;
+        aes_ctx.iv_loc      = SFZ_IN_CONTEXT;
+
+        res = sfzcrypto_symm_crypt( sfzcrypto_context_get(),
+                                    (SfzCryptoCipherContext * const) &aes_ctx,
+                                    (SfzCryptoCipherKey * const) &aes_key,
+                                    Block_p,
+                                    BlockLen,
+                                    Block_p,
+                                    (uint32_t * const) &tmp_dst_len,
+                                    SFZ_DECRYPT);
+
+        memset((void *)&aes_key, 0, sizeof(aes_key));
+
+        if (res == SFZCRYPTO_SUCCESS && tmp_dst_len != BlockLen)
+            res = SFZCRYPTO_INTERNAL_ERROR;
+
+        if (res != SFZCRYPTO_SUCCESS)
+        {
+            fprintf(stderr,
+                    "Hash tree block %u decrypt failed (res=%d)\n",
+                    BlockNr, res);
+        }
+    }
+
+    if (res == SFZCRYPTO_SUCCESS)
+        res = SBHYBRID_HashTree_Hash(UseCM, Block_p, BlockLen, Digest);
+
+    if (res == SFZCRYPTO_SUCCESS)
+    {
+        res = SBHYBRID_HashTree_VerifyHashBlock(
+                    Tree_p, UseCM, 0, BlockNr / Tree_p->HashesPerBlock);
+    }
+
+    if (res == SFZCRYPTO_SUCCESS &&
+        memcmp(Digest,
+               SBHYBRID_HashTree_HashBlock(
+                        Tree_p, 0, BlockNr / Tree_p->HashesPerBlock) +
+               (BlockNr % Tree_p->HashesPerBlock) *
+               SBHYBRID_HASHTREE_DIGEST_LEN,
+               SBHYBRID_HASHTREE_DIGEST_LEN) != 0)
+    {
+        fprintf(stderr, "Hash tree data block %u mismatch\n", BlockNr);
+        res = SFZCRYPTO_SIGNATURE_CHECK_FAILED;
+    }
+
+    if (res != SFZCRYPTO_SUCCESS)
+        memset(Block_p, 0, BlockLen);
+
+    pthread_mutex_lock(&Tree_p->Lock);
+    Tree_p->DataBlockState_p[BlockNr] = (res == SFZCRYPTO_SUCCESS) ?
+                                        SBHYBRID_HASHTREE_BLOCK_VERIFIED :
+                                        SBHYBRID_HASHTREE_BLOCK_FAILED;
+    pthread_cond_broadcast(&Tree_p->BlockDone);
+    pthread_mutex_unlock(&Tree_p->Lock);
+
+    return res;
+}
+
+
+/*----------------------------------------------------------------------------
+ * SBHYBRID_HashTree_Worker
+ *
+ * Takes jobs until none are left, or until one fails.
+ * Runs on the worker threads and on the calling thread.
+ */
+static void *
+SBHYBRID_HashTree_Worker(void * Arg_p)
+{
+    SBHYBRID_HashTree_Worker_t * const Worker_p = Arg_p;
+    SBHYBRID_HashTree_Pool_t * const Pool_p = Worker_p->Pool_p;
+    SBHYBRID_HashTree_t * const Tree_p = Pool_p->Tree_p;
+
+    for (;;)
+    {
+        SfzCryptoStatus res = SFZCRYPTO_SUCCESS;
+        uint32_t BlockNr, BlockEnd;
+        uint32_t JobNr;
+
+        pthread_mutex_lock(&Pool_p->Lock);
+        JobNr = Pool_p->NextJob;
+        if (Pool_p->Result != SFZCRYPTO_SUCCESS || JobNr >= Pool_p->JobCount)
+        {
+            pthread_mutex_unlock(&Pool_p->Lock);
+            break;
+        }
+        Pool_p->NextJob++;
+        pthread_mutex_unlock(&Pool_p->Lock);
+
+        BlockNr  = JobNr * Tree_p->HashesPerBlock;
+        BlockEnd = BlockNr + Tree_p->HashesPerBlock;
+        if (BlockEnd > Tree_p->DataBlocks)
+            BlockEnd = Tree_p->DataBlocks;
+
+        for (; BlockNr < BlockEnd && res == SFZCRYPTO_SUCCESS; BlockNr++)
+        {
+            res = SBHYBRID_HashTree_VerifyDataBlock(
+                        Tree_p, Worker_p->UseCM, BlockNr);
+        }
+
+        if (res != SFZCRYPTO_SUCCESS)
+        {
+            pthread_mutex_lock(&Pool_p->Lock);
+            if (Pool_p->Result == SFZCRYPTO_SUCCESS)
+                Pool_p->Result = res;
+            pthread_mutex_unlock(&Pool_p->Lock);
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Public Functions
+*/
+
+/*----------------------------------------------------------------------------
+ * SBHYBRID_HashTree_Open
+ */
+SfzCryptoStatus
+SBHYBRID_HashTree_Open(
+        SBHYBRID_HashTree_t * const Tree_p,
+        const SBIF_HashTree_Header_t * const Header_p,
+        const uint32_t BlockShift,
+        const uint8_t * HashBlocks_p,
+        uint8_t * Data_p,
+        const SfzCryptoCipherKey * const Key_p,
+        const uint8_t * IV_p)
+{
+    const uint32_t TreeLen = Load_BE32(&Header_p->TreeLen);
+    uint64_t HashBlockCount = 0;
+    uint32_t Blocks;
+    uint32_t First = 0;
+    unsigned int Level;
+
+    assert(Tree_p != NULL);
+    assert(HashBlocks_p != NULL);
+    assert(Data_p != NULL);
+
+    memset(Tree_p, 0, sizeof(SBHYBRID_HashTree_t));
+
+    if (BlockShift < SBIF_HASHTREE_BLOCK_SHIFT_MIN ||
+        BlockShift > SBIF_HASHTREE_BLOCK_SHIFT_MAX ||
+        Header_p->Reserved[0] != 0 ||
+        Header_p->Reserved[1] != 0)
+    {
+        fprintf(stderr, "Hash tree header invalid\n");
+        return SFZCRYPTO_INVALID_PARAMETER;
+    }
+
+    Tree_p->BlockSize      = 1U << BlockShift;
+    Tree_p->HashesPerBlock = Tree_p->BlockSize / SBHYBRID_HASHTREE_DIGEST_LEN;
+    Tree_p->DataLen        = Load_BE32(&Header_p->DataLen);
+    Tree_p->DataBlocks     = (uint32_t)(((uint64_t)Tree_p->DataLen +
+                                         Tree_p->BlockSize - 1) >> BlockShift);
+
+    // CBC: whole AES blocks only
+    if (Tree_p->DataLen == 0 ||
+        (Key_p != NULL && (Tree_p->DataLen & 15) != 0))
+    {
+        fprintf(stderr, "Hash tree data length invalid\n");
+        return SFZCRYPTO_INVALID_LENGTH;
+    }
+
+    // levels, from the data up to a single hash block
+    Blocks = Tree_p->DataBlocks;
+    do
+    {
+        Blocks = (Blocks + Tree_p->HashesPerBlock - 1) / Tree_p->HashesPerBlock;
+        assert(Tree_p->LevelCount < 32);
+        Tree_p->LevelBlocks[Tree_p->LevelCount++] = Blocks;
+        HashBlockCount += Blocks;
+    }
+    while (Blocks > 1);
+
+    if (HashBlockCount << BlockShift != TreeLen)
+    {
+        fprintf(stderr,
+                "Hash tree length %u mismatch, expected %u\n",
+                TreeLen, (uint32_t)(HashBlockCount << BlockShift));
+        return SFZCRYPTO_INVALID_LENGTH;
+    }
+
+    // stored top level first
+    for (Level = Tree_p->LevelCount; Level > 0; Level--)
+    {
+        Tree_p->LevelFirst[Level - 1] = First;
+        First += Tree_p->LevelBlocks[Level - 1];
+    }
+
+    memcpy(Tree_p->RootHash, Header_p->RootHash, SBHYBRID_HASHTREE_DIGEST_LEN);
+    Tree_p->HashBlocks_p = HashBlocks_p;
+    Tree_p->Data_p       = Data_p;
+
+    Tree_p->HashBlockVerified_p = calloc((size_t)HashBlockCount, 1);
+    Tree_p->DataBlockState_p    = calloc(Tree_p->DataBlocks, 1);
+
+    if (Key_p != NULL)
+    {
+        uint32_t BlockNr;
+
+        Tree_p->DoDecrypt = true;
+        Tree_p->Key       = *Key_p;
+        Tree_p->IV_p      = malloc((size_t)Tree_p->DataBlocks * 16);
+
+        if (Tree_p->IV_p != NULL)
+        {
+            /* CBC: the IV of a block is the last ciphertext of the block
+               before it, keep these before anything is decrypted. */
+            memcpy(Tree_p->IV_p[0], IV_p, 16);
+            for (BlockNr = 1; BlockNr < Tree_p->DataBlocks; BlockNr++)
+            {
+                memcpy(Tree_p->IV_p[BlockNr],
+                       Data_p + (size_t)BlockNr * Tree_p->BlockSize - 16,
+                       16);
+            }
+        }
+    }
+
+    if (Tree_p->HashBlockVerified_p == NULL ||
+        Tree_p->DataBlockState_p == NULL ||
+        (Tree_p->DoDecrypt && Tree_p->IV_p == NULL))
+    {
+        fprintf(stderr, "Hash tree: out of memory\n");
+        free(Tree_p->HashBlockVerified_p);
+        free(Tree_p->DataBlockState_p);
+        free(Tree_p->IV_p);
+        memset(Tree_p, 0, sizeof(SBHYBRID_HashTree_t));
+        return SFZCRYPTO_NO_MEMORY;
+    }
+
+    pthread_mutex_init(&Tree_p->Lock, NULL);
+    pthread_cond_init(&Tree_p->BlockDone, NULL);
+
+    return SFZCRYPTO_SUCCESS;
+}
+
+
+/*----------------------------------------------------------------------------
+ * SBHYBRID_HashTree_VerifyRange
+ */
+SfzCryptoStatus
+SBHYBRID_HashTree_VerifyRange(
+        SBHYBRID_HashTree_t * const Tree_p,
+        const uint32_t Offset,
+        const uint32_t Length)
+{
+    SfzCryptoStatus res = SFZCRYPTO_SUCCESS;
+    uint32_t BlockNr, BlockEnd;
+
+    if (Length == 0)
+        return SFZCRYPTO_SUCCESS;
+
+    if (Offset >= Tree_p->DataLen ||
+        Length > Tree_p->DataLen - Offset)
+    {
+        return SFZCRYPTO_INVALID_PARAMETER;
+    }
+
+    BlockNr  = Offset / Tree_p->BlockSize;
+    BlockEnd = (uint32_t)(((uint64_t)Offset + Length + Tree_p->BlockSize - 1) /
+                          Tree_p->BlockSize);
+
+    for (; BlockNr < BlockEnd && res == SFZCRYPTO_SUCCESS; BlockNr++)
+        res = SBHYBRID_HashTree_VerifyDataBlock(Tree_p, true, BlockNr);
+
+    return res;
+}
+
+
+/*----------------------------------------------------------------------------
+ * SBHYBRID_HashTree_VerifyAll
+ */
+SfzCryptoStatus
+SBHYBRID_HashTree_VerifyAll(
+        SBHYBRID_HashTree_t * const Tree_p)
+{
+    SBHYBRID_HashTree_Pool_t   Pool;
+    SBHYBRID_HashTree_Worker_t Self;
+#if SBHYBRID_HASHTREE_THREADS > 0
+    SBHYBRID_HashTree_Worker_t Workers[SBHYBRID_HASHTREE_THREADS];
+    unsigned int               WorkerCount = 0;
+    unsigned int               i;
+#endif
+
+    pthread_mutex_init(&Pool.Lock, NULL);
+    Pool.Tree_p   = Tree_p;
+    Pool.NextJob  = 0;
+    Pool.JobCount = Tree_p->LevelBlocks[0];
+    Pool.Result   = SFZCRYPTO_SUCCESS;
+
+#if SBHYBRID_HASHTREE_THREADS > 0
+    for (i = 0; i < SBHYBRID_HASHTREE_THREADS && i + 1 < Pool.JobCount; i++)
+    {
+        Workers[WorkerCount].Pool_p = &Pool;
+        Workers[WorkerCount].UseCM  = i < SBHYBRID_HASHTREE_CM_THREADS;
+
+        if (pthread_create(&Workers[WorkerCount].Thread,
+                           NULL,
+                           SBHYBRID_HashTree_Worker,
+                           &Workers[WorkerCount]) != 0)
+        {
+            /* Not fatal, the calling thread takes the remaining jobs. */
+            break;
+        }
+
+        WorkerCount++;
+    }
+#endif
+
+    Self.Pool_p = &Pool;
+    Self.UseCM  = true;
+    SBHYBRID_HashTree_Worker(&Self);
+
+#if SBHYBRID_HASHTREE_THREADS > 0
+    while (WorkerCount > 0)
+    {
+        pthread_join(Workers[--WorkerCount].Thread, NULL);
+    }
+#endif
+
+    pthread_mutex_destroy(&Pool.Lock);
+
+    return Pool.Result;
+}
+
+
+/*----------------------------------------------------------------------------
+ * SBHYBRID_HashTree_Close
+ */
+void
+SBHYBRID_HashTree_Close(
+        SBHYBRID_HashTree_t * const Tree_p)
+{
+    pthread_cond_destroy(&Tree_p->BlockDone);
+    pthread_mutex_destroy(&Tree_p->Lock);
+
+    free(Tree_p->HashBlockVerified_p);
+    free(Tree_p->DataBlockState_p);
+    free(Tree_p->IV_p);
+
+    memset(&Tree_p->Key, 0, sizeof(Tree_p->Key));
+    Tree_p->HashBlockVerified_p = NULL;
+    Tree_p->DataBlockState_p    = NULL;
+    Tree_p->IV_p                = NULL;
+}
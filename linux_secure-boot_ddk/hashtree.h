@@ -0,0 +1,109 @@
+/*
+ * hashtree.h : block-level verification of hash tree images
+ *
+ * The data blocks of a hash tree image are decrypted and verified against
+ * the (signed) root hash on demand, so a partial load only decrypts and
+ * hashes the blocks it touches. See SBIF_HashTree_Header_t for the format.
+*/
+
+#ifndef __HASHTREE_H__
+#define __HASHTREE_H__
+
+/* -----------------
+ * Include
+* ------------------ */
+
+#include "secure_boot.h"
+#include <stdbool.h>
+#include <pthread.h>
+#include <sfzcryptoapi.h>
+
+/* -----------------
+ * Structures
+* ------------------ */
+
+typedef struct
+{
+    uint32_t BlockSize;
+    uint32_t HashesPerBlock;         /** Digests per hash block. */
+    uint32_t DataLen;
+    uint32_t DataBlocks;
+
+    unsigned int LevelCount;
+    uint32_t LevelBlocks[32];        /** Hash blocks per level, 0 = lowest. */
+    uint32_t LevelFirst[32];         /** Index of first hash block of level. */
+
+    uint8_t RootHash[SBIF_ECDSA_BYTES];
+    const uint8_t * HashBlocks_p;    /** All hash blocks, top level first. */
+    uint8_t * Data_p;                /** Data, decrypted in place. */
+
+    /* Decryption: key and the CBC IV of each data block. */
+    bool DoDecrypt;
+    SfzCryptoCipherKey Key;
+    uint8_t (* IV_p)[16];
+
+    /* Block states, protected by Lock. BlockDone is signalled when a data
+       block leaves the busy state. */
+    pthread_mutex_t Lock;
+    pthread_cond_t BlockDone;
+    uint8_t * HashBlockVerified_p;
+    uint8_t * DataBlockState_p;
+}
+SBHYBRID_HashTree_t;
+
+/* -----------------
+ * Functions
+* ------------------ */
+
+/*----------------------------------------------------------------------------
+ * SBHYBRID_HashTree_Open
+ *
+ * Header_p and HashBlocks_p must be in the clear. When Key_p is not NULL,
+ * Data_p is decrypted in place (AES-CBC), block by block when verified;
+ * IV_p is the IV for the first data block. The root hash must be trusted
+ * (signature verified) before the data is used.
+ */
+SfzCryptoStatus
+SBHYBRID_HashTree_Open(
+        SBHYBRID_HashTree_t * const Tree_p,
+        const SBIF_HashTree_Header_t * const Header_p,
+        const uint32_t BlockShift,
+        const uint8_t * HashBlocks_p,
+        uint8_t * Data_p,
+        const SfzCryptoCipherKey * const Key_p,
+        const uint8_t * IV_p);
+
+/*----------------------------------------------------------------------------
+ * SBHYBRID_HashTree_VerifyRange
+ *
+ * Decrypts and verifies the data blocks that overlap [Offset, Offset +
+ * Length), in the calling thread, for a loader that only uses part of the
+ * image. Blocks already verified are skipped; a block that another thread
+ * is verifying (for example SBHYBRID_HashTree_VerifyAll) is waited for.
+ * main.c writes out the whole image, so it uses SBHYBRID_HashTree_VerifyAll.
+ */
+SfzCryptoStatus
+SBHYBRID_HashTree_VerifyRange(
+        SBHYBRID_HashTree_t * const Tree_p,
+        const uint32_t Offset,
+        const uint32_t Length);
+
+/*----------------------------------------------------------------------------
+ * SBHYBRID_HashTree_VerifyAll
+ *
+ * Decrypts and verifies all data blocks not verified yet, on worker
+ * threads that hash through the CM and on the CPU
+ * (SBHYBRID_HASHTREE_CM_THREADS, SBHYBRID_HASHTREE_SW_THREADS).
+ */
+SfzCryptoStatus
+SBHYBRID_HashTree_VerifyAll(
+        SBHYBRID_HashTree_t * const Tree_p);
+
+/*----------------------------------------------------------------------------
+ * SBHYBRID_HashTree_Close
+ */
+void
+SBHYBRID_HashTree_Close(
+        SBHYBRID_HashTree_t * const Tree_p);
+
+#endif /* __HASHTREE_H__ */
@@ -15,12 +15,18 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#ifdef ECDSA_SW
+#include <pthread.h>
+#endif /* ECDSA_SW */
 #include <sfzcryptoapi.h>
 #include <sfzcrypto_context.h>
 #include "secure_boot.h"
 #ifdef ICC_IMAGE
 #include <icc.h>
 #endif /* ICC_IMAGE */
+#ifdef HASH_TREE_IMAGE
+#include "hashtree.h"
+#endif /* HASH_TREE_IMAGE */
 
 /*
  * Macro define
@@ -43,6 +49,13 @@
 
 #define SBLIB_CFG_STORAGE_SIZE         4096
 
+// last known non-extension attribute
+#ifdef HASH_TREE_IMAGE
+#define SBIF_ATTRIBUTE_LAST            SBIF_ATTRIBUTE_HASH_TREE
+#else
+#define SBIF_ATTRIBUTE_LAST            SBIF_ATTRIBUTE_ROLLBACK_ID
+#endif /* HASH_TREE_IMAGE */
+
 #if SBIF_ECDSA_WORDS == 7
 #define ECDSA_SHA2XX SFZCRYPTO_ALGO_HASH_SHA224;
 #elif SBIF_ECDSA_WORDS == 8
@@ -105,6 +118,30 @@ SBHYBRID_ECDSA_Verify_t;
 // Use count of error codes as internal PENDING status return code
 #define SFZCRYPTO_PENDING (SFZCRYPTO_INTERNAL_ERROR+1)
 
+#ifndef SBHYBRID_CERT_VERIFY_THREADS
+#define SBHYBRID_CERT_VERIFY_THREADS 0
+#endif
+
+// Certificate chain verification, one job per certificate.
+// The jobs only depend on the certificates and the public key,
+// so they run on worker threads while the image is decrypted and hashed.
+typedef struct
+{
+    SBHYBRID_ECDSA_Verify_t Verify[SBLIB_CFG_CERTIFICATES_MAX];
+    SfzCryptoStatus         Result[SBLIB_CFG_CERTIFICATES_MAX];
+    unsigned int            JobCount;
+
+    pthread_mutex_t         Lock;       // protects NextJob and Failed
+    unsigned int            NextJob;
+    bool                    Failed;     // skip remaining jobs
+
+#if SBHYBRID_CERT_VERIFY_THREADS > 0
+    pthread_t               Threads[SBHYBRID_CERT_VERIFY_THREADS];
+#endif
+    unsigned int            ThreadCount;
+}
+SBHYBRID_CertVerify_t;
+
 #endif /* ECDSA_SW */
 
 struct AES_IF_Ctx
@@ -445,7 +482,7 @@ SBIF_Attribute_Check(
                 return false;
 
             /* Check for unknown non-extension attributes. */
-            if (nextType > SBIF_ATTRIBUTE_ROLLBACK_ID &&
+            if (nextType > SBIF_ATTRIBUTE_LAST &&
                 (nextType & 0x80000000) == 0)
             {
                 return false;
@@ -649,6 +686,16 @@ Print_ImageInfo(
         {
             printf("  RollbackID: [not found]\n");
         }
+
+        #ifdef HASH_TREE_IMAGE
+        if (SBIF_Attribute_Fetch(
+                    &Header_p->ImageAttributes,
+                    SBIF_ATTRIBUTE_HASH_TREE,
+                    &Value32))
+        {
+            printf("  Hash tree: %u byte blocks\n", 1U << (Value32 & 31));
+        }
+        #endif /* HASH_TREE_IMAGE */
     }
     else
     {
@@ -869,75 +916,143 @@ SBIFTOOLS_Image_ConvertHeader(
 
 #ifdef ECDSA_SW
 /*----------------------------------------------------------------------------
- * SBHYBRID_Do_Asym_RunFsm
+ * SBHYBRID_CertVerify_Worker
  *
- * Single step of asymmetric processing:
- * Performs run EIP28 RunFsm. If the current certificate gets
- * handled, starts processing next certificate.
- * Assumes all digests have been precalculated.
- * Calls polling as appropriate.
+ * Takes certificate verify jobs until none are left, or until one fails.
+ * Runs on the worker threads and, when joining, on the calling thread.
  */
-static
-SfzCryptoStatus
-SBHYBRID_Do_Asym_RunFsm(AES_IF_Ctx_Ptr_t Context_p,
-                      const SBIF_ECDSA_Header_t * Header_p)
+static void *
+SBHYBRID_CertVerify_Worker(void * Arg_p)
 {
-    SfzCryptoStatus res;
+    SBHYBRID_CertVerify_t * const Pool_p = Arg_p;
 
-    res = SBHYBRID_SW_Ecdsa_Verify_RunFsm(&Context_p->EcdsaContext);
-    if (res == SFZCRYPTO_SUCCESS)
+    for (;;)
     {
-#ifdef SBLIB_CF_REMOVE_CERTIFICATE_SUPPORT
-        /* This is success from the final EcdsaVerify. */
-        return res;
-#else /* !SBLIB_CF_REMOVE_CERTIFICATE_SUPPORT */
-        /* A certificate has been processed, move to the next
-           certificate, with the previous certificates public key.
-        */
-        const SBIF_ECDSA_Certificate_t * Certificates_p =
-            (const SBIF_ECDSA_Certificate_t *) (Header_p + 1);
-        const SBIF_ECDSA_Certificate_t * Certificate_p;
-        const SBIF_ECDSA_Certificate_t * PrevCertificate_p;
-        int CertNr;
+        unsigned int JobNr;
+        SfzCryptoStatus res;
+
+        pthread_mutex_lock(&Pool_p->Lock);
+        JobNr = Pool_p->NextJob;
+        if (Pool_p->Failed || JobNr >= Pool_p->JobCount)
+        {
+            pthread_mutex_unlock(&Pool_p->Lock);
+            break;
+        }
+        Pool_p->NextJob++;
+        pthread_mutex_unlock(&Pool_p->Lock);
 
-        PrevCertificate_p = Certificates_p + Context_p->CertNr;
-        CertNr = ++Context_p->CertNr;
-        Certificate_p = Certificates_p + CertNr;
+        res = SBHYBRID_SW_Ecdsa_Verify_RunFsm(&Pool_p->Verify[JobNr]);
+        Pool_p->Result[JobNr] = res;
 
-        if (Context_p->CertNr == Context_p->CertificateCount + 1)
+        if (res != SFZCRYPTO_SUCCESS)
         {
-            /* This is success from the final EcdsaVerify. */
-            return res;
+            pthread_mutex_lock(&Pool_p->Lock);
+            Pool_p->Failed = true;
+            pthread_mutex_unlock(&Pool_p->Lock);
         }
-        else if (Context_p->CertNr == Context_p->CertificateCount)
+    }
+
+    return NULL;
+}
+
+
+/*----------------------------------------------------------------------------
+ * SBHYBRID_CertVerify_Start
+ *
+ * Sets up one verify job per certificate: certificate 0 is verified with
+ * the root public key, certificate n with the public key of certificate
+ * n-1. The digests must have been calculated. Starts the worker threads.
+ */
+static void
+SBHYBRID_CertVerify_Start(
+        SBHYBRID_CertVerify_t * const Pool_p,
+        const SBIF_ECDSA_PublicKey_t * const PublicKey_p,
+        const SBIF_ECDSA_Header_t * Header_p,
+        const unsigned int CertificateCount,
+        uint8_t (* const CertDigest_p)[SBIF_ECDSA_BYTES])
+{
+    const SBIF_ECDSA_Certificate_t * Certificates_p =
+        (const SBIF_ECDSA_Certificate_t *) (Header_p + 1);
+    unsigned int CertNr;
+
+    assert(CertificateCount <= SBLIB_CFG_CERTIFICATES_MAX);
+
+    pthread_mutex_init(&Pool_p->Lock, NULL);
+    Pool_p->JobCount    = CertificateCount;
+    Pool_p->NextJob     = 0;
+    Pool_p->Failed      = false;
+    Pool_p->ThreadCount = 0;
+
+    for (CertNr = 0; CertNr < CertificateCount; CertNr++)
+    {
+        SBHYBRID_SW_Ecdsa_Verify_Init(
+                &Pool_p->Verify[CertNr],
+                CertNr == 0 ? PublicKey_p :
+                              &Certificates_p[CertNr - 1].PublicKey,
+                &Certificates_p[CertNr].Signature);
+
+        SBHYBRID_SW_Ecdsa_Verify_SetDigest(
+                &Pool_p->Verify[CertNr],
+                CertDigest_p[CertNr]);
+
+        Pool_p->Result[CertNr] = SFZCRYPTO_PENDING;
+    }
+
+#if SBHYBRID_CERT_VERIFY_THREADS > 0
+    while (Pool_p->ThreadCount < SBHYBRID_CERT_VERIFY_THREADS &&
+           Pool_p->ThreadCount < CertificateCount)
+    {
+        if (pthread_create(&Pool_p->Threads[Pool_p->ThreadCount],
+                           NULL,
+                           SBHYBRID_CertVerify_Worker,
+                           Pool_p) != 0)
         {
-            /* Start the final EcdsaVerify */
-            SBHYBRID_SW_Ecdsa_Verify_Init(
-                    &Context_p->EcdsaContext,
-                    &PrevCertificate_p->PublicKey,
-                    &Header_p->Signature);
-
-            /* Final digest is available in my case,
-               I did the hash beforehand. */
-            SBHYBRID_SW_Ecdsa_Verify_SetDigest(
-                    &Context_p->EcdsaContext,
-                    Context_p->SymmContext.Digest);
+            /* Not fatal, the remaining jobs run when joining. */
+            break;
         }
-        else
+
+        Pool_p->ThreadCount++;
+    }
+#endif
+}
+
+
+/*----------------------------------------------------------------------------
+ * SBHYBRID_CertVerify_Join
+ *
+ * Helps with the jobs that have not been taken yet, waits for the worker
+ * threads and returns the result of the chain: SFZCRYPTO_SUCCESS or the
+ * result of the first certificate that failed.
+ */
+static SfzCryptoStatus
+SBHYBRID_CertVerify_Join(
+        SBHYBRID_CertVerify_t * const Pool_p)
+{
+    SfzCryptoStatus res = SFZCRYPTO_SUCCESS;
+    unsigned int CertNr;
+
+    SBHYBRID_CertVerify_Worker(Pool_p);
+
+#if SBHYBRID_CERT_VERIFY_THREADS > 0
+    while (Pool_p->ThreadCount > 0)
+    {
+        pthread_join(Pool_p->Threads[--Pool_p->ThreadCount], NULL);
+    }
+#endif
+
+    pthread_mutex_destroy(&Pool_p->Lock);
+
+    for (CertNr = 0; CertNr < Pool_p->JobCount; CertNr++)
+    {
+        if (Pool_p->Result[CertNr] != SFZCRYPTO_SUCCESS &&
+            Pool_p->Result[CertNr] != SFZCRYPTO_PENDING)
         {
-            /* Continue with the next certificate. */
-            SBHYBRID_SW_Ecdsa_Verify_Init(
-                    &Context_p->EcdsaContext,
-                    &PrevCertificate_p->PublicKey,
-                    &Certificate_p->Signature);
-
-            SBHYBRID_SW_Ecdsa_Verify_SetDigest(
-                    &Context_p->EcdsaContext,
-                    Context_p->SymmContext.CertDigest[CertNr]);
+            fprintf(stderr,
+                    "Certificate %u verify failed (res=%d)\n",
+                    CertNr, Pool_p->Result[CertNr]);
+            res = Pool_p->Result[CertNr];
+            break;
         }
-        /* Operation pending, with the next ecdsa verify started. */
-        return SFZCRYPTO_PENDING;
-#endif /* SBLIB_CF_REMOVE_CERTIFICATE_SUPPORT */
     }
 
     return res;
@@ -945,6 +1060,184 @@ SBHYBRID_Do_Asym_RunFsm(AES_IF_Ctx_Ptr_t Context_p,
 
 #endif /* ECDSA_SW */
 
+#ifdef HASH_TREE_IMAGE
+/*----------------------------------------------------------------------------
+ * SB_ECDSA_Image_DecryptInPlace
+ *
+ * Continues the CBC decryption of the image in aes_ctx, in jobs of at most
+ * SBHYBRID_MAX_SIZE_PE_JOB_BLOCKS.
+ */
+static SfzCryptoStatus
+SB_ECDSA_Image_DecryptInPlace(
+        SfzCryptoCipherContext * const aes_ctx_p,
+        SfzCryptoCipherKey * const     aes_key_p,
+        uint8_t *                      Data_p,
+        uint32_t                       DataLen)
+{
+    SfzCryptoStatus res = SFZCRYPTO_SUCCESS;
+
+    while (res == SFZCRYPTO_SUCCESS && DataLen)
+    {
+        uint32_t Blocklen = DataLen;
+        uint32_t tmp_dst_len;
+
+        if (Blocklen > SBHYBRID_MAX_SIZE_PE_JOB_BLOCKS)
+        {
+            Blocklen = SBHYBRID_MAX_SIZE_PE_JOB_BLOCKS;
+        }
+
+        tmp_dst_len = Blocklen;
+
+        res = sfzcrypto_symm_crypt( sfzcrypto_context_get(),
+                                    aes_ctx_p,
+                                    aes_key_p,
+                                    Data_p,
+                                    Blocklen,
+                                    Data_p,
+                                    (uint32_t * const) &tmp_dst_len,
+                                    SFZ_DECRYPT);
+
+        if (res == SFZCRYPTO_SUCCESS && Blocklen != tmp_dst_len)
+        {
+            res = SFZCRYPTO_INTERNAL_ERROR;
+        }
+
+        Data_p  += Blocklen;
+        DataLen -= Blocklen;
+    }
+
+    return res;
+}
+
+
+/*----------------------------------------------------------------------------
+ * SB_ECDSA_Image_HashTree_Verify
+ *
+ * Hash tree image: decrypts the hash tree header and the hash blocks,
+ * completes the signature digest in sha_ctx (attributes and hash tree
+ * header) and verifies all data blocks against the root hash.
+ * The data blocks are decrypted in place, in the output vector.
+ */
+static int
+SB_ECDSA_Image_HashTree_Verify(
+        const uint32_t                 BlockShift,
+        SfzCryptoHashContext * const   sha_ctx_p,
+        SfzCryptoCipherContext * const aes_ctx_p,
+        SfzCryptoCipherKey * const     aes_key_p,
+        const bool                     DoDecrypt,
+        const SBIF_SGVector_t *        VectorIn_p,
+        const SBIF_SGVector_t *        VectorOut_p,
+        const uint32_t                 ImageLen)
+{
+    const uint32_t           HeadLen = sizeof(SBIF_HashTree_Header_t);
+    uint8_t * const          Image_p = (uint8_t *)VectorOut_p->Data_p;
+    SBIF_HashTree_Header_t * TreeHeader_p = (SBIF_HashTree_Header_t *)Image_p;
+    SBHYBRID_HashTree_t      Tree;
+    SfzCryptoStatus          res;
+    uint32_t                 TreeLen;
+
+    #if defined(ICC_IMAGE)
+    if (icc_info.chunk_mode)
+    {
+        fprintf(stderr, "Hash tree image cannot be received in chunks\n");
+        return 4;
+    }
+    #endif /* defined(ICC_IMAGE) */
+
+    if (VectorIn_p->DataLen != ImageLen ||
+        VectorOut_p->DataLen != ImageLen ||
+        ImageLen < HeadLen)
+    {
+        return 4;
+    }
+
+    if (VectorOut_p->Data_p != VectorIn_p->Data_p)
+    {
+        memcpy(VectorOut_p->Data_p, VectorIn_p->Data_p, ImageLen);
+    }
+
+    // the hash tree header and the hash blocks start the CBC stream
+    res = SFZCRYPTO_SUCCESS;
+    if (DoDecrypt)
+    {
+        res = SB_ECDSA_Image_DecryptInPlace(aes_ctx_p, aes_key_p,
+                                            Image_p, HeadLen);
+    }
+
+    if (res != SFZCRYPTO_SUCCESS)
+    {
+        fprintf(stderr, "aes decrypt failed (res=%d)", res);
+        return 5;
+    }
+
+    TreeLen = Load_BE32(&TreeHeader_p->TreeLen);
+    if (TreeLen > ImageLen - HeadLen ||
+        Load_BE32(&TreeHeader_p->DataLen) != ImageLen - HeadLen - TreeLen)
+    {
+        fprintf(stderr, "Hash tree image length mismatch");
+        return 4;
+    }
+
+    if (DoDecrypt)
+    {
+        res = SB_ECDSA_Image_DecryptInPlace(aes_ctx_p, aes_key_p,
+                                            Image_p + HeadLen, TreeLen);
+    }
+
+    if (res != SFZCRYPTO_SUCCESS)
+    {
+        fprintf(stderr, "aes decrypt failed (res=%d)", res);
+        return 5;
+    }
+
+    // the signature covers the attributes and the hash tree header
+    res = sfzcrypto_hash_data( sfzcrypto_context_get(),
+                               sha_ctx_p,
+                               (uint8_t *) TreeHeader_p,
+                               HeadLen,
+                               false, // init
+                               true); // final
+
+    if (res != SFZCRYPTO_SUCCESS)
+    {
+        fprintf(stderr, "hash hash tree header failed (res=%d)", res);
+        return 3;
+    }
+
+    // the data blocks are decrypted with their own IV, aes_ctx holds the
+    // IV of the first one
+    res = SBHYBRID_HashTree_Open(&Tree,
+                                 TreeHeader_p,
+                                 BlockShift,
+                                 Image_p + HeadLen,
+                                 Image_p + HeadLen + TreeLen,
+                                 DoDecrypt ? aes_key_p : NULL,
+                                 (const uint8_t *) aes_ctx_p->iv);
+
+    if (res != SFZCRYPTO_SUCCESS)
+    {
+        return 4;
+    }
+
+    res = SBHYBRID_HashTree_VerifyAll(&Tree);
+    SBHYBRID_HashTree_Close(&Tree);
+
+    if (res == SFZCRYPTO_SIGNATURE_CHECK_FAILED)
+    {
+        fprintf(stderr, "Hash tree verify failed");
+        return 6;
+    }
+
+    if (res != SFZCRYPTO_SUCCESS)
+    {
+        fprintf(stderr, "Hash tree decrypt or hash failed (res=%d)", res);
+        return 3;
+    }
+
+    return 0;
+}
+#endif /* HASH_TREE_IMAGE */
+
 /*----------------------------------------------------------------------------
  * SB_ECDSA_Image_CopyOrDecrypt_Verify
  */
@@ -969,9 +1262,16 @@ SB_ECDSA_Image_CopyOrDecrypt_Verify(
     uint32_t               tmp_dst_len;
 
     #ifdef ECDSA_SW
-    SfzCryptoStatus  ecdsa_res;
+    SfzCryptoStatus       ecdsa_res;
+    SBHYBRID_CertVerify_t CertVerify;
+    bool                  CertVerifyStarted = false;
     #endif /* ECDSA_SW */
 
+    #ifdef HASH_TREE_IMAGE
+    uint32_t              HashTreeShift = 0;
+    bool                  HashTreeImage;
+    #endif /* HASH_TREE_IMAGE */
+
     // below used to be parameter in function call , i just hardcoded the expected value now,
     // so you can easily refer to original code
     uint32_t VectorCount = 1;
@@ -1081,6 +1381,13 @@ SB_ECDSA_Image_CopyOrDecrypt_Verify(
     }
     #endif /* CONFIG_ENCRYPT_ATTRIBUTE */
 
+    #ifdef HASH_TREE_IMAGE
+    // hash tree image: the data blocks are verified against a signed root hash
+    HashTreeImage = SBIF_Attribute_Fetch(&Header_p->ImageAttributes,
+                                         SBIF_ATTRIBUTE_HASH_TREE,
+                                         &HashTreeShift);
+    #endif /* HASH_TREE_IMAGE */
+
     // All sanity checks done
 
     printf("Initializing verify operation for image signature.\n");
@@ -1114,27 +1421,26 @@ SB_ECDSA_Image_CopyOrDecrypt_Verify(
 
             // successfully calculated the digest
             memcpy((void *)Context_p->SymmContext.CertDigest[CertNr] , (const void*)sha_ctx.digest, (size_t)SBIF_ECDSA_BYTES);
+        }
 
-            if (CertNr == 0)
-            {
-                /* 
-                             * start certificate verification , remember the chain start from nvm public key to verify first cert signature , well one thing they don't
-                             * mention is the use of SHA2 digest of first cert public key as initial ecdsa digest.
-                            */
-                #ifdef ECDSA_SW
-
-                /* Set first EcdsaVerify target. */
-                SBHYBRID_SW_Ecdsa_Verify_Init(
-                            &Context_p->EcdsaContext,
-                            PublicKey_p,
-                            &Certificate_p->Signature);
-
-                SBHYBRID_SW_Ecdsa_Verify_SetDigest(
-                            &Context_p->EcdsaContext,
-                            Context_p->SymmContext.CertDigest[CertNr]);
-                #endif /* ECDSA_SW */
-            }
+        #if defined(ECDSA_SW) && !defined(SBLIB_CF_REMOVE_CERTIFICATE_SUPPORT)
+        if (ret == 0)
+        {
+            /*
+             * start certificate verification, the chain starts from the nvm public key to verify the first cert signature,
+             * each certificate signs the SHA2 digest of the next certificate's public key.
+             * The verifies run on worker threads while the image is decrypted and hashed below.
+             */
+            SBHYBRID_CertVerify_Start(
+                        &CertVerify,
+                        PublicKey_p,
+                        Header_p,
+                        CertificateCount,
+                        Context_p->SymmContext.CertDigest);
+
+            CertVerifyStarted = true;
         }
+        #endif /* ECDSA_SW && !SBLIB_CF_REMOVE_CERTIFICATE_SUPPORT */
     }
 
     /* Keep track of ecdsa verify's certificate under processing. */
@@ -1162,6 +1468,10 @@ SB_ECDSA_Image_CopyOrDecrypt_Verify(
         {
             fprintf(stderr,
                     "hash image attribute failed (res=%d)", res);
+            #ifdef ECDSA_SW
+            if (CertVerifyStarted)
+                (void)SBHYBRID_CertVerify_Join(&CertVerify);
+            #endif /* ECDSA_SW */
             return 3;
         }
 
@@ -1180,6 +1490,26 @@ SB_ECDSA_Image_CopyOrDecrypt_Verify(
             aes_ctx.iv_loc      = SFZ_IN_CONTEXT;
         }
 
+        #ifdef HASH_TREE_IMAGE
+        if (HashTreeImage)
+        {
+            ret = SB_ECDSA_Image_HashTree_Verify(
+                        HashTreeShift,
+                        &sha_ctx,
+                        &aes_ctx,
+                        &aes_key,
+                        DoDecrypt,
+                        &DataVectorsIn_p[0],
+                        &DataVectorsOut_p[0],
+                        ImageLen);
+
+            if (ret == 0)
+            {
+                ImageLenLeft = 0;
+            }
+        }
+        else
+        #endif /* HASH_TREE_IMAGE */
         // add the image blocks
         // !<WW: I don't actually intend to support multiple vectors or mailbox ..... but oh well , just copying code as it is
         // who know those reading now will find a way to make use of it.
@@ -1301,6 +1631,21 @@ SB_ECDSA_Image_CopyOrDecrypt_Verify(
             }
         }
 
+        #ifdef ECDSA_SW
+        /* Wait for the certificate chain. */
+        if (CertVerifyStarted)
+        {
+            ecdsa_res = SBHYBRID_CertVerify_Join(&CertVerify);
+            CertVerifyStarted = false;
+
+            if (ret == 0 && ecdsa_res != SFZCRYPTO_SUCCESS)
+            {
+                fprintf(stderr, "Image signature verify failed (res=%d)", ecdsa_res);
+                return 6;
+            }
+        }
+        #endif /* ECDSA_SW */
+
         if (ret == 5 &&
             DoDecrypt &&
             res != SFZCRYPTO_SUCCESS)
@@ -1330,24 +1675,42 @@ SB_ECDSA_Image_CopyOrDecrypt_Verify(
 
             // do ecdsa processing ?
             #ifdef ECDSA_SW
-            do
             {
-                /* Continue Ecdsa processing. */
-                ecdsa_res = SBHYBRID_Do_Asym_RunFsm(Context_p, Header_p);
+                /* The certificate chain has been verified, the image signature is
+                   verified with the public key of the last certificate. */
+                const SBIF_ECDSA_PublicKey_t * SignerKey_p = PublicKey_p;
+
+                #ifndef SBLIB_CF_REMOVE_CERTIFICATE_SUPPORT
+                if (CertificateCount != 0)
+                {
+                    const SBIF_ECDSA_Certificate_t * Certificates_p =
+                        (const SBIF_ECDSA_Certificate_t *) (Header_p + 1);
+
+                    SignerKey_p = &Certificates_p[CertificateCount - 1].PublicKey;
+                }
+                #endif /* !SBLIB_CF_REMOVE_CERTIFICATE_SUPPORT */
+
+                SBHYBRID_SW_Ecdsa_Verify_Init(
+                        &Context_p->EcdsaContext,
+                        SignerKey_p,
+                        &Header_p->Signature);
+
+                SBHYBRID_SW_Ecdsa_Verify_SetDigest(
+                        &Context_p->EcdsaContext,
+                        Context_p->SymmContext.Digest);
+
+                ecdsa_res = SBHYBRID_SW_Ecdsa_Verify_RunFsm(&Context_p->EcdsaContext);
                 if (ecdsa_res == SFZCRYPTO_SUCCESS)
                 {
                     fprintf(stderr, "Image signature verify succcess");
                     ret = 0;
-                    break;
                 }
-				else if ( ecdsa_res != SFZCRYPTO_PENDING)
-				{
-					fprintf(stderr, "Image signature verify failed (res=%d)", ecdsa_res);
+                else
+                {
+                    fprintf(stderr, "Image signature verify failed (res=%d)", ecdsa_res);
                     ret = 6;
-                    break;
-				}
+                }
             }
-            while (ecdsa_res == SFZCRYPTO_PENDING);
             #endif /* ECDSA_SW */
         }
     }
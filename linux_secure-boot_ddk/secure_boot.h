@@ -110,6 +110,8 @@ typedef uint32_t SBIF_AttributeElementType_t;
 #define SBIF_ATTRIBUTE_UNUSED      0 /* All element positions not used. */
 #define SBIF_ATTRIBUTE_VERSION     1 /* Version field for attribute array. */
 #define SBIF_ATTRIBUTE_ROLLBACK_ID 2 /* Optional rollback identifier */
+#define SBIF_ATTRIBUTE_HASH_TREE   3 /* Optional: image is a hash tree image,
+                                        value is log2 of the block size. */
 
 /** Minimum attribute version. */
 #define SBIF_ATTRIBUTE_VERSION_CURRENT 0 /** First version. */
@@ -157,6 +159,31 @@ typedef struct {
 	uint32_t               CertificateCount;    /** Certificate count. */
 } SBIF_ECDSA_Header_t;
 
+/** Block size limits for hash tree images (log2). */
+#define SBIF_HASHTREE_BLOCK_SHIFT_MIN  9
+#define SBIF_HASHTREE_BLOCK_SHIFT_MAX  16
+
+/**
+	Hash tree header, at the start of the image data of a hash tree image.
+	The image signature covers the attributes and this header only.
+	The header is followed by TreeLen bytes of hash blocks and DataLen
+	bytes of data. Each hash block holds as many digests as fit in one
+	block, zero padded. Level 0 holds the digests of the data blocks,
+	each next level the digests of the hash blocks of the level below,
+	up to a level of one hash block; RootHash is the digest of that block.
+	The levels are stored top level first.
+ */
+typedef struct {
+	uint32_t               DataLen;             /** Data length. */
+	uint32_t               TreeLen;             /** Hash blocks length. */
+	uint32_t               Reserved[2];         /** Must be zero. */
+	uint8_t                RootHash[SBIF_ECDSA_BYTES]; /** Root digest. */
+#ifdef SBIF_ECDSA_PAD_BITS
+	/* Notice: keep the header size a multiple of the AES block size. */
+	uint8_t pad[SBIF_ECDSA_PAD_BITS/8];
+#endif /* SBIF_ECDSA_PAD_BITS */
+} SBIF_HashTree_Header_t;
+
 /*
   SBIF_ECDSA_GET_HEADER_SIZE
 
@@ -42,6 +42,11 @@
 // uncomment to enable Pre- and Post-DMA logging
 //#define HWPAL_TRACE_DMARESOURCE_PREPOSTDMA
 
+// map shared memory buffers of PMD_SIZE (typically 2MB) or more with huge
+// pages where possible, to reduce TLB misses; requires Linux 5.8 .. 5.19
+// with transparent huge pages, otherwise 4kB pages are used
+#define UMDEVXS_SMBUF_HUGE_PAGES
+
 #define UMDEVXS_LOG_PREFIX "UMDevXS_Mem: "
 
 #define UMDEVXS_MODULENAME "umdevxs"
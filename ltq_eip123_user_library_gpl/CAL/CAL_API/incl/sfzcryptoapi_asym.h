@@ -685,6 +685,12 @@ sfzcrypto_rsa_encrypt(
    @param p_plaintext
    Decrypted plaintext.
 
+   For SFZCRYPTO_ALGO_ASYMM_RSA_PKCS1 the software implementation does not
+   report a ciphertext with invalid padding: it returns a message derived
+   from the private key and the ciphertext instead (implicit rejection),
+   with the same status and timing as for valid padding. Protocols must
+   detect such a message themselves (e.g. as a wrong premaster secret).
+
    @return
    One of the SfzCryptoStatus values.
 
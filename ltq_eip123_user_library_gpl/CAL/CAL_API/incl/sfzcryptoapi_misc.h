@@ -243,6 +243,25 @@ sfzcrypto_nvm_publicdata_read(
         uint32_t * const DataLen_p);
 
 
+/*----------------------------------------------------------------------------
+ * sfzcrypto_nvm_publicdata_refresh
+ *
+ * The Public Data objects are read from the hardware once and then served
+ * from a cache by sfzcrypto_nvm_publicdata_read. This function reads the
+ * given object from the hardware again and updates the cached copy.
+ *
+ * ObjectNr
+ *     The identity number for the Public Data object to refresh.
+ *
+ * Special Return Values:
+ *     SFZCRYPTO_INVALID_PARAMETER = ObjectID not found
+ */
+SfzCryptoStatus
+sfzcrypto_nvm_publicdata_refresh(
+        SfzCryptoContext * const sfzcryptoctx_p,
+        uint32_t ObjectNr);
+
+
 /*
  Read the version of sfzcrypto provider.
 
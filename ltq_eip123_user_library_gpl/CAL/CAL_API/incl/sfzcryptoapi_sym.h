@@ -139,6 +139,26 @@ typedef struct
 }
 SfzCryptoCipherContext;
 
+/*
+   Structure to maintain an AES CTR/ICM stream that is processed in pieces
+   of any length with sfzcrypto_symm_crypt_ctr_stream.
+
+   cipher
+   The cipher context, with fbmode set to SFZCRYPTO_MODE_CTR or
+   SFZCRYPTO_MODE_ICM and the initial counter block in iv.
+
+   keystream, keystream_len
+   The last keystream_len bytes of keystream are not used yet.
+   Set keystream_len to 0 when starting a new message.
+*/
+typedef struct
+{
+    SfzCryptoCipherContext cipher;
+    uint8_t keystream[16];
+    uint32_t keystream_len;
+}
+SfzCryptoCtrStreamContext;
+
 // following can be used in SfzCryptoCipherContext.fbmode for ARC4 operations
 // (when SfzCryptoCipherKey.type == SFZCRYPTO_KEY_ARCFOUR)
 enum
@@ -392,6 +412,8 @@ sfzcrypto_cipher_mac_data(
    last chunk. Morover, the last chunk can be non-block size multiple
    if and only if either a padding scheme has been selected or the mode
    itself allows data to be non-block size. Such modes are AES-CTR and AES-ICM.
+   Use sfzcrypto_symm_crypt_ctr_stream for AES-CTR and AES-ICM streams
+   with non-block size chunks.
    The block lengths of AES, DES, 3DES and ARC4 are 16, 8, 8 and 1 respectively.
    This specification however deprecates the support for padding.
 
@@ -452,6 +474,59 @@ sfzcrypto_symm_crypt(
         uint32_t * const p_dst_len,
         SfzCipherOp direction);
 
+/*
+   Encrypt or decrypt a piece of an AES CTR/ICM stream.
+
+   Unlike sfzcrypto_symm_crypt, every piece may have any length: the
+   keystream left over from the last partial block of a piece is kept in
+   p_ctxt and used for the next piece, so the result equals that of
+   processing the whole stream in one call. The output length is always
+   the input length.
+
+   @pre p_ctxt->keystream_len was set to 0 for the first piece of the
+   message and p_ctxt is only updated by this function after that.
+
+   @param sfzcryptoctx_p
+   Pointer to a pre-allocated and setup SfzCryptoContext object.
+
+   @param p_ctxt
+   Stream state. See SfzCryptoCtrStreamContext.
+
+   @param p_key
+   Pointer to the AES key to use. See SfzCryptoCipherKey.
+
+   @param p_src
+   Pointer to the input data to be (en/de)crypted.
+
+   @param src_len
+   Length in bytes of the data to be (en/de)crypted.
+
+   @param p_dst
+   Pointer to the buffer that receives the resulting text.
+
+   @param p_dst_len
+   Pointer to the length of the destination buffer; see
+   sfzcrypto_symm_crypt.
+
+   @param direction
+   TRUE for encryption and FALSE for decryption.
+
+   @return
+   One of the SfzCryptoStatus values. SFZCRYPTO_INVALID_PARAMETER when
+   keystream_len is not below 16.
+
+*****************************************************************************/
+SfzCryptoStatus
+sfzcrypto_symm_crypt_ctr_stream(
+        SfzCryptoContext * const sfzcryptoctx_p,
+        SfzCryptoCtrStreamContext * const p_ctxt,
+        SfzCryptoCipherKey * const p_key,
+        uint8_t * p_src,
+        uint32_t src_len,
+        uint8_t * p_dst,
+        uint32_t * const p_dst_len,
+        SfzCipherOp direction);
+
 /*
    Encrypt or decrypt data using a authenticating encryption algorithm.
 
@@ -621,6 +696,61 @@ sfzcrypto_aes_wrap_unwrap(
         const uint8_t * initial_value_p);
 
 
+/* One key to wrap or unwrap with sfzcrypto_aes_wrap_unwrap_bulk. */
+typedef struct
+{
+    const uint8_t * src_p;      /* Data to wrap/unwrap from. */
+    uint32_t src_len;           /* Length of src_p in bytes. */
+    uint8_t * dst_p;            /* Data to wrap/unwrap to. */
+    uint32_t dst_len;           /* Size of dst_p; updated to bytes used. */
+    SfzCryptoStatus status;     /* Result for this key. */
+} SfzCryptoWrapItem;
+
+
+/*
+    AES Key Wrap for a series of keys, all with the same KEK and direction.
+
+    Each item is processed as by sfzcrypto_aes_wrap_unwrap with the default
+    initial value from RFC 3394. Implementations can share resources over
+    the items, which makes this considerably faster than separate calls
+    when many (small) keys are to be wrapped or unwrapped.
+
+    All items are processed, also when some of them fail.
+
+    @param sfzcryptoctx_p
+    Pointer to a pre-allocated and setup SfzCryptoContext object..
+
+    @param ctxt_p
+    Cipher Context for AES/Camellia processing.
+
+    @param kek_p
+    Contains the kek to use. See SfzCryptoCipherKey.
+
+    @param items_p
+    Array of item_count keys to wrap/unwrap. The status and dst_len of
+    each item are updated.
+
+    @param item_count
+    The number of items.
+
+    @param direction
+    TRUE for wrap, FALSE for unwrap.
+
+    @return
+    SFZCRYPTO_SUCCESS when all items succeeded, otherwise the status of
+    the first failing item (or the error that prevented processing).
+
+*****************************************************************************/
+SfzCryptoStatus
+sfzcrypto_aes_wrap_unwrap_bulk(
+        SfzCryptoContext * const sfzcryptoctx_p,
+        SfzCryptoCipherContext * const ctxt_p,
+        SfzCryptoCipherKey * const kek_p,
+        SfzCryptoWrapItem * const items_p,
+        uint32_t item_count,
+        SfzCipherOp direction);
+
+
 #endif /* Include Guard */
 
 /* end of file sfzcryptoapi_sym.h */
@@ -55,6 +55,123 @@
 #define CALCM_DMA_ALIGNMENT   4
 #endif
 
+// random pool is disabled unless configured
+#ifndef CALCM_RANDOM_POOL_SIZE
+#define CALCM_RANDOM_POOL_SIZE 0
+#endif
+
+#ifndef CALCM_RANDOM_POOL_LOW_WATERMARK
+#define CALCM_RANDOM_POOL_LOW_WATERMARK  (CALCM_RANDOM_POOL_SIZE / 4)
+#endif
+
+#ifndef CALCM_RANDOM_POOL_HIGH_WATERMARK
+#define CALCM_RANDOM_POOL_HIGH_WATERMARK CALCM_RANDOM_POOL_SIZE
+#endif
+
+#ifndef CALCM_RANDOM_POOL_MAX_REQUEST
+#define CALCM_RANDOM_POOL_MAX_REQUEST 64
+#endif
+
+#ifndef CALCM_RANDOM_POOL_REFILL_CHUNK
+#define CALCM_RANDOM_POOL_REFILL_CHUNK 1024
+#endif
+
+// random health tests are disabled unless configured
+#ifndef CALCM_RANDOM_HEALTH_RCT_CUTOFF
+#define CALCM_RANDOM_HEALTH_RCT_CUTOFF 6
+#endif
+
+#ifndef CALCM_RANDOM_HEALTH_APT_WINDOW
+#define CALCM_RANDOM_HEALTH_APT_WINDOW 512
+#endif
+
+#ifndef CALCM_RANDOM_HEALTH_APT_CUTOFF
+#define CALCM_RANDOM_HEALTH_APT_CUTOFF 19
+#endif
+
+#if CALCM_RANDOM_HEALTH_RCT_CUTOFF < 2
+#error "CALCM_RANDOM_HEALTH_RCT_CUTOFF must be at least 2"
+#endif
+
+#if CALCM_RANDOM_HEALTH_APT_CUTOFF < 2 || \
+    CALCM_RANDOM_HEALTH_APT_CUTOFF > CALCM_RANDOM_HEALTH_APT_WINDOW
+#error "CALCM_RANDOM_HEALTH_APT_CUTOFF must be in [2, APT_WINDOW]"
+#endif
+
+// HMAC precomputed-key cache is disabled unless configured
+#ifndef CALCM_HMAC_KEYCACHE_ENTRIES
+#define CALCM_HMAC_KEYCACHE_ENTRIES 0
+#endif
+
+// the fingerprint keys of the HMAC key cache are taken from the CM
+#if (CALCM_HMAC_KEYCACHE_ENTRIES > 0) && \
+    defined(SFZCRYPTO_CF_HMAC_DATA__CM) && \
+    !defined(SFZCRYPTO_CF_RAND_DATA__CM)
+#error "CALCM_HMAC_KEYCACHE_ENTRIES requires SFZCRYPTO_CF_RAND_DATA__CM"
+#endif
+
+// per-context token templates are disabled unless configured
+#ifndef CALCM_TOKEN_TEMPLATE_ENTRIES
+#define CALCM_TOKEN_TEMPLATE_ENTRIES 0
+#endif
+
+// segmented processing of bounced AES/DES data is disabled unless configured
+#ifndef CALCM_DMA_PIPELINE_SEGMENT_SIZE
+#define CALCM_DMA_PIPELINE_SEGMENT_SIZE 0
+#endif
+
+#ifndef CALCM_DMA_PIPELINE_MIN_SIZE
+#define CALCM_DMA_PIPELINE_MIN_SIZE (4 * CALCM_DMA_PIPELINE_SEGMENT_SIZE)
+#endif
+
+#if (CALCM_DMA_PIPELINE_SEGMENT_SIZE % 16) != 0
+#error "CALCM_DMA_PIPELINE_SEGMENT_SIZE must be a multiple of 16"
+#endif
+
+// streaming stores for bounce copies are disabled unless configured
+#ifndef CALCM_DMA_STREAMING_COPY_MIN
+#define CALCM_DMA_STREAMING_COPY_MIN 0
+#endif
+
+// the basic DMA test is run by every process unless configured
+#ifndef CALCM_WARMSTART_DMATEST_INTERVAL_S
+#define CALCM_WARMSTART_DMATEST_INTERVAL_S 0
+#endif
+
+// DMA tasks are not kept for reuse unless configured
+#ifndef CALCM_DMA_TASK_POOL_SIZE
+#define CALCM_DMA_TASK_POOL_SIZE 0
+#endif
+
+// descriptor chains are not kept for reuse unless configured
+#ifndef CALCM_DMA_DC_CACHE_ENTRIES
+#define CALCM_DMA_DC_CACHE_ENTRIES 0
+#endif
+
+// bulk buffers are not kept per thread unless configured
+#ifndef CALCM_DMA_THREAD_BULK_MAX
+#define CALCM_DMA_THREAD_BULK_MAX 0
+#endif
+
+// token scheduler: passes over a lower class before it is served anyway
+#ifndef CALCM_SCHED_AGING_LIMIT
+#define CALCM_SCHED_AGING_LIMIT 8
+#endif
+
+// token scheduler: data tokens from this size on are in the bulk class
+#ifndef CALCM_SCHED_BULK_MIN_SIZE
+#define CALCM_SCHED_BULK_MIN_SIZE (64 * 1024)
+#endif
+
+// AES/DES operations are not split in slices unless configured
+#ifndef CALCM_SCHED_BULK_SLICE_SIZE
+#define CALCM_SCHED_BULK_SLICE_SIZE 0
+#endif
+
+#if (CALCM_SCHED_BULK_SLICE_SIZE % 16) != 0
+#error "CALCM_SCHED_BULK_SLICE_SIZE must be a multiple of 16"
+#endif
+
 #ifndef LOG_SEVERITY_MAX
 #define LOG_SEVERITY_MAX  LOG_SEVERITY_WARN
 #endif
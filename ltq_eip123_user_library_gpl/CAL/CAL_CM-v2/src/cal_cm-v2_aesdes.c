@@ -35,6 +35,384 @@
 #include "cm_tokens_errdetails.h"
 
 
+/*----------------------------------------------------------------------------
+ * CAL_CM_AES_CTR_Stream
+ *
+ * AES CTR/ICM for data of any length. The CM only processes whole blocks,
+ * so the block-aligned bulk is processed by the CM and the remaining bytes
+ * use keystream generated by encrypting a zero block. The last
+ * *KeyStreamLen_p bytes of KeyStream_p are used first, and the unused
+ * keystream of the last partial block is left there for the next call.
+ */
+SfzCryptoStatus
+CAL_CM_AES_CTR_Stream(
+        SfzCryptoCipherContext * p_ctxt,
+        SfzCryptoCipherKey * p_key,
+        uint8_t * KeyStream_p,
+        uint32_t * const KeyStreamLen_p,
+        uint8_t * p_src,
+        uint32_t src_len,
+        uint8_t * p_dst,
+        uint32_t * const p_dst_len,
+        SfzCipherOp direction)
+{
+    SfzCryptoStatus funcres;
+    uint32_t done = 0;
+    uint32_t n;
+    uint32_t i;
+
+    if (*KeyStreamLen_p >= SFZCRYPTO_AES_BLOCK_LEN)
+        return SFZCRYPTO_INVALID_PARAMETER;
+
+    // check size of output buffer
+    if (src_len > *p_dst_len)
+    {
+        *p_dst_len = src_len;
+        return SFZCRYPTO_BUFFER_TOO_SMALL;
+    }
+
+    // use the leftover keystream first
+    n = MIN(src_len, *KeyStreamLen_p);
+    if (n > 0)
+    {
+        const uint8_t * const ks_p =
+            KeyStream_p + SFZCRYPTO_AES_BLOCK_LEN - *KeyStreamLen_p;
+
+        for (i = 0; i < n; i++)
+            p_dst[i] = p_src[i] ^ ks_p[i];
+
+        *KeyStreamLen_p -= n;
+        done = n;
+    }
+
+    // the whole blocks are processed by the CM
+    n = (src_len - done) & ~(uint32_t)(SFZCRYPTO_AES_BLOCK_LEN - 1);
+    if (n > 0)
+    {
+        uint32_t len = n;
+
+        funcres = CAL_CM_AESDES(
+                        p_ctxt,
+                        p_key,
+                        p_src + done,
+                        n,
+                        p_dst + done,
+                        &len,
+                        direction);
+
+        if (funcres != SFZCRYPTO_SUCCESS)
+            return funcres;
+
+        done += n;
+    }
+
+    // last partial block: generate one block of keystream
+    if (done < src_len)
+    {
+        uint32_t len = SFZCRYPTO_AES_BLOCK_LEN;
+
+        c_memset(KeyStream_p, 0, SFZCRYPTO_AES_BLOCK_LEN);
+
+        funcres = CAL_CM_AESDES(
+                        p_ctxt,
+                        p_key,
+                        KeyStream_p,
+                        SFZCRYPTO_AES_BLOCK_LEN,
+                        KeyStream_p,
+                        &len,
+                        SFZ_ENCRYPT);
+
+        if (funcres != SFZCRYPTO_SUCCESS)
+        {
+            c_memset(KeyStream_p, 0, SFZCRYPTO_AES_BLOCK_LEN);
+            return funcres;
+        }
+
+        n = src_len - done;
+        for (i = 0; i < n; i++)
+            p_dst[done + i] = p_src[done + i] ^ KeyStream_p[i];
+
+        // the used keystream is not kept
+        c_memset(KeyStream_p, 0, n);
+        *KeyStreamLen_p = SFZCRYPTO_AES_BLOCK_LEN - n;
+    }
+
+    *p_dst_len = src_len;
+
+    return SFZCRYPTO_SUCCESS;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_AESDES_MakeTemplate
+ *
+ * Fills the part of the token for CAL_CM_AESDES that only depends on the
+ * algorithm, mode and key (data length 0, no IV).
+ */
+static void
+CALCMLib_AESDES_MakeTemplate(
+        CMTokens_Command_t * const t_cmd_p,
+        const SfzCryptoCipherKey * p_key,
+        const uint8_t Mode,
+        const bool fEncrypt)
+{
+    if (p_key->type == SFZCRYPTO_KEY_AES)
+    {
+        CMTokens_MakeCommand_Crypto_AES(t_cmd_p, fEncrypt, Mode, 0);
+        CMTokens_MakeCommand_Crypto_AES_SetKeyLength(t_cmd_p, p_key->length);
+    }
+    else
+    {
+        bool fDES = false;
+
+        if (p_key->type == SFZCRYPTO_KEY_DES)
+            fDES = true;
+
+        CMTokens_MakeCommand_Crypto_3DES(t_cmd_p, fDES, fEncrypt, Mode, 0);
+    }
+
+    // key
+    if (p_key->asset_id == SFZCRYPTO_ASSETID_INVALID)
+    {
+        // put the key into the token
+        CMTokens_MakeCommand_Crypto_CopyKey(t_cmd_p, p_key->length, p_key->key);
+    }
+    else
+    {
+        // key will be taken from asset store
+        CMTokens_MakeCommand_Crypto_SetASLoadKey(t_cmd_p, p_key->asset_id);
+    }
+}
+
+
+#if CALCM_TOKEN_TEMPLATE_ENTRIES > 0
+// everything CALCMLib_AESDES_MakeTemplate depends on, for a key in the
+// Asset Store
+typedef struct
+{
+    uint32_t Opcode;
+    uint32_t KeyType;
+    uint32_t KeyLength;
+    uint32_t KeyAssetId;
+    uint32_t ModeEncrypt;
+} CALCM_AESDES_TemplateParams_t;
+#endif
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_AESDES_MakeToken
+ *
+ * Fills the token for CAL_CM_AESDES, except for the descriptors and TokenID.
+ * The key length must have been checked.
+ */
+static void
+CALCMLib_AESDES_MakeToken(
+        CMTokens_Command_t * const t_cmd_p,
+        const SfzCryptoCipherContext * p_ctxt,
+        const SfzCryptoCipherKey * p_key,
+        const uint8_t Mode,
+        const bool fEncrypt,
+        const unsigned int data_len,
+        const bool loadIvFromAsset,
+        const bool saveIvInAsset)
+{
+#if CALCM_TOKEN_TEMPLATE_ENTRIES > 0
+    CALCM_AESDES_TemplateParams_t Params;
+
+    // a template would hold a copy of a plaintext key
+    if (p_key->asset_id == SFZCRYPTO_ASSETID_INVALID)
+    {
+        CALCMLib_AESDES_MakeTemplate(t_cmd_p, p_key, Mode, fEncrypt);
+    }
+    else
+    {
+        c_memset(&Params, 0, sizeof(Params));
+        Params.Opcode = 1;      // Crypto
+        Params.KeyType = p_key->type;
+        Params.KeyLength = p_key->length;
+        Params.KeyAssetId = p_key->asset_id;
+        Params.ModeEncrypt = (Mode << 1) | (fEncrypt ? 1 : 0);
+
+        if (!CAL_CM_TokenTemplate_Get(
+                        p_ctxt,
+                        &Params,
+                        sizeof(Params),
+                        t_cmd_p))
+        {
+            CALCMLib_AESDES_MakeTemplate(t_cmd_p, p_key, Mode, fEncrypt);
+            CAL_CM_TokenTemplate_Put(
+                        p_ctxt,
+                        &Params,
+                        sizeof(Params),
+                        t_cmd_p);
+        }
+    }
+#else
+    CALCMLib_AESDES_MakeTemplate(t_cmd_p, p_key, Mode, fEncrypt);
+#endif /* CALCM_TOKEN_TEMPLATE_ENTRIES */
+
+    CMTokens_MakeCommand_Crypto_SetDataLength(t_cmd_p, data_len);
+
+    // IV
+    if (Mode != CMTOKENS_CRYPTO_MODE_ECB)
+    {
+        if (!loadIvFromAsset)
+        {
+            // IV in token
+            CMTokens_MakeCommand_Crypto_CopyIV(t_cmd_p, p_ctxt->iv);
+        }
+        else
+        {
+            // IV from Asset Store
+            CMTokens_MakeCommand_Crypto_SetASLoadIV(t_cmd_p, p_ctxt->iv_asset_id);
+        }
+
+        if (saveIvInAsset)
+            CMTokens_MakeCommand_Crypto_SetASSaveIV(t_cmd_p, p_ctxt->iv_asset_id);
+    }
+
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_AESDES_Pipeline
+ *
+ * CAL_CM_AESDES for large data that must be bounced, with the IV in the
+ * context. The data is processed in segments of
+ * CALCM_DMA_PIPELINE_SEGMENT_SIZE bytes, each with its own token that
+ * continues with the IV returned for the previous segment. While the CM
+ * processes segment k, the input of segment k+1 is copied in and the output
+ * of segment k-1 is copied out.
+ */
+#if CALCM_DMA_PIPELINE_SEGMENT_SIZE > 0
+static SfzCryptoStatus
+CALCMLib_AESDES_Pipeline(
+        SfzCryptoCipherContext * p_ctxt,
+        SfzCryptoCipherKey * p_key,
+        const uint8_t Mode,
+        const bool fEncrypt,
+        const unsigned int block_size,
+        const uint8_t * p_src,
+        uint8_t * p_dst,
+        const unsigned int data_len)
+{
+    const unsigned int SegSize = CALCM_DMA_PIPELINE_SEGMENT_SIZE;
+    const unsigned int SegCount = (data_len + SegSize - 1) / SegSize;
+    CALCM_DMA_Admin_t * Task_p = NULL;
+    CMTokens_Command_t t_cmd;
+    CMTokens_Response_t t_res;
+    SfzCryptoStatus funcres;
+    unsigned int k;
+
+    Task_p = CALCM_DMA_Alloc();
+    if (!Task_p)
+        return SFZCRYPTO_NO_MEMORY;
+
+    funcres = CALAdapter_Pipeline_Alloc(Task_p, SegSize);
+    if (funcres != SFZCRYPTO_SUCCESS)
+    {
+        CALCM_DMA_Free(Task_p);
+        return funcres;
+    }
+
+    CALAdapter_Pipeline_CopyIn(Task_p, 0, p_src, MIN(SegSize, data_len));
+
+    for (k = 0; k < SegCount; k++)
+    {
+        const unsigned int Slot = k & 1;
+        const unsigned int Ofs = k * SegSize;
+        const unsigned int Len = MIN(SegSize, data_len - Ofs);
+
+#ifdef CALCM_STRICT_ARGS
+        CMTokens_MakeToken_Clear(&t_cmd);
+#endif
+
+        CALCMLib_AESDES_MakeToken(
+                        &t_cmd,
+                        p_ctxt,
+                        p_key,
+                        Mode,
+                        fEncrypt,
+                        Len,
+                        false,
+                        false);
+
+        funcres = CALAdapter_Pipeline_PreDMA(Task_p, Slot, block_size, Len);
+        if (funcres != SFZCRYPTO_SUCCESS)
+            break;
+
+        CMTokens_MakeCommand_SetTokenID(&t_cmd, CAL_TOKENID_VALUE, /*WriteTokenID:*/true);
+        CMTokens_MakeCommand_Crypto_WriteInDescriptor(&t_cmd, &Task_p->InDescriptor);
+        CMTokens_MakeCommand_Crypto_WriteOutDescriptor(&t_cmd, &Task_p->OutDescriptor);
+
+        funcres = CAL_CM_SubmitToken(&t_cmd);
+        if (funcres != SFZCRYPTO_SUCCESS)
+            break;
+
+        // while the CM is busy: the other slot holds the output of segment
+        // k-1, which is copied out before it is reused for segment k+1
+        if (k > 0)
+            CALAdapter_Pipeline_CopyOut(Task_p, Slot ^ 1, p_dst + Ofs - SegSize, SegSize);
+
+        if (k + 1 < SegCount)
+        {
+            CALAdapter_Pipeline_CopyIn(
+                    Task_p,
+                    Slot ^ 1,
+                    p_src + Ofs + SegSize,
+                    MIN(SegSize, data_len - Ofs - SegSize));
+        }
+
+        funcres = CAL_CM_WaitToken(&t_res);
+        if (funcres != SFZCRYPTO_SUCCESS)
+            break;
+
+        // check for errors
+        {
+            int res;
+
+            res = CMTokens_ParseResponse_Generic(&t_res);
+
+            if (res != 0)
+            {
+                const char * ErrMsg_p;
+
+                res = CMTokens_ParseResponse_ErrorDetails(&t_res, &ErrMsg_p);
+
+                LOG_WARN(
+                    "CAL_CM_AESDES: "
+                    "Failed with error %d (%s)\n",
+                    res,
+                    ErrMsg_p);
+
+                funcres = SFZCRYPTO_INTERNAL_ERROR;
+                break;
+            }
+        }
+
+        funcres = CALAdapter_Pipeline_PostDMA(Task_p, Slot, Len);
+        if (funcres != SFZCRYPTO_SUCCESS)
+            break;
+
+        // the next segment continues with the updated IV
+        CMTokens_ParseResponse_Crypto_CopyIV(&t_res, p_ctxt->iv);
+
+        if (k + 1 == SegCount)
+            CALAdapter_Pipeline_CopyOut(Task_p, Slot, p_dst + Ofs, Len);
+    } // for
+
+    CALCM_DMA_Free(Task_p);
+
+    if (funcres != SFZCRYPTO_SUCCESS)
+        return funcres;
+
+    p_ctxt->iv_loc = SFZ_IN_CONTEXT;
+
+    return SFZCRYPTO_SUCCESS;
+}
+#endif /* CALCM_DMA_PIPELINE_SEGMENT_SIZE */
+
+
 /*----------------------------------------------------------------------------
  * CAL_CM_AESDES
  */
@@ -63,6 +441,32 @@ CAL_CM_AESDES(
     CMTokens_MakeToken_Clear(&t_cmd);
 #endif
 
+    // AES CTR/ICM with non-block length data: the last partial block ends
+    // the message (see CAL_CM_AES_CTR_Stream to continue it)
+    if (p_key->type == SFZCRYPTO_KEY_AES &&
+        (SFZCRYPTO_MODE_CTR == p_ctxt->fbmode ||
+         SFZCRYPTO_MODE_ICM == p_ctxt->fbmode) &&
+        (src_len % SFZCRYPTO_AES_BLOCK_LEN) != 0)
+    {
+        uint8_t KeyStream[SFZCRYPTO_AES_BLOCK_LEN];
+        uint32_t KeyStreamLen = 0;
+
+        funcres = CAL_CM_AES_CTR_Stream(
+                        p_ctxt,
+                        p_key,
+                        KeyStream,
+                        &KeyStreamLen,
+                        p_src,
+                        src_len,
+                        p_dst,
+                        p_dst_len,
+                        direction);
+
+        c_memset(KeyStream, 0, sizeof(KeyStream));
+
+        return funcres;
+    }
+
     switch (p_ctxt->iv_loc)
     {
         case SFZ_IN_CONTEXT:
@@ -111,22 +515,8 @@ CAL_CM_AESDES(
                 return SFZCRYPTO_INVALID_KEYSIZE;
             }
 
-            if (SFZCRYPTO_MODE_CTR == p_ctxt->fbmode ||
-                SFZCRYPTO_MODE_ICM == p_ctxt->fbmode)
-            {
-                // the HW AES engine accepts only block length data
-                // even for modes like CTR and ICM. So lets round up the length
-                // the caller must of course provide the extra space (up to 15 bytes)
-                if ((data_len % 16) != 0)
-                {
-                    data_len = ((data_len + 15) / 16) * 16;
-                    LOG_INFO("sfzcrypto_hw_symm_crypt: "
-                             "padding to block length %d -> %d\n",
-                             src_len, data_len);
-                }
-
-                // this length will be used in the buffer descriptors and for the token
-            }
+            // note: non-block length CTR and ICM data is handled by
+            // CALCMLib_AES_CTR_Stream, which only passes whole blocks
             break;
 
         default:
@@ -178,51 +568,67 @@ CAL_CM_AESDES(
             return SFZCRYPTO_INVALID_MODE;
     } // switch
 
-    // start filling the token
-    if (p_key->type == SFZCRYPTO_KEY_AES)
-    {
-        CMTokens_MakeCommand_Crypto_AES(&t_cmd, fEncrypt, Mode, data_len);
-        CMTokens_MakeCommand_Crypto_AES_SetKeyLength(&t_cmd, p_key->length);
-    }
-    else
-    {
-        bool fDES = false;
-
-        if (p_key->type == SFZCRYPTO_KEY_DES)
-            fDES = true;
-
-        CMTokens_MakeCommand_Crypto_3DES(&t_cmd, fDES, fEncrypt, Mode, data_len);
-    }
-
-    // key
-    if (p_key->asset_id == SFZCRYPTO_ASSETID_INVALID)
+#if CALCM_SCHED_BULK_SLICE_SIZE > 0
+    // split huge operations, so that other callers can use the CM in between
+    if (data_len > CALCM_SCHED_BULK_SLICE_SIZE &&
+        !loadIvFromAsset &&
+        !saveIvInAsset)
     {
-        // put the key into the token
-        CMTokens_MakeCommand_Crypto_CopyKey(&t_cmd, p_key->length, p_key->key);
-    }
-    else
-    {
-        // key will be taken from asset store
-        CMTokens_MakeCommand_Crypto_SetASLoadKey(&t_cmd, p_key->asset_id);
-    }
+        unsigned int Ofs;
 
-    // IV
-    if (Mode != CMTOKENS_CRYPTO_MODE_ECB)
-    {
-        if (!loadIvFromAsset)
+        for (Ofs = 0; Ofs < data_len; Ofs += CALCM_SCHED_BULK_SLICE_SIZE)
         {
-            // IV in token
-            CMTokens_MakeCommand_Crypto_CopyIV(&t_cmd, p_ctxt->iv);
-        }
-        else
-        {
-            // IV from Asset Store
-            CMTokens_MakeCommand_Crypto_SetASLoadIV(&t_cmd, p_ctxt->iv_asset_id);
+            uint32_t len = MIN(CALCM_SCHED_BULK_SLICE_SIZE, data_len - Ofs);
+
+            funcres = CAL_CM_AESDES(
+                            p_ctxt,
+                            p_key,
+                            p_src + Ofs,
+                            len,
+                            p_dst + Ofs,
+                            &len,
+                            direction);
+
+            if (funcres != SFZCRYPTO_SUCCESS)
+                return funcres;
         }
 
-        if (saveIvInAsset)
-            CMTokens_MakeCommand_Crypto_SetASSaveIV(&t_cmd, p_ctxt->iv_asset_id);
+        return SFZCRYPTO_SUCCESS;
+    }
+#endif /* CALCM_SCHED_BULK_SLICE_SIZE */
+
+#if CALCM_DMA_PIPELINE_SEGMENT_SIZE > 0
+    // large bounced data: overlap the bounce copies with the CM processing
+    if (data_len >= CALCM_DMA_PIPELINE_MIN_SIZE &&
+        !loadIvFromAsset &&
+        !saveIvInAsset &&
+        (p_src == p_dst ||
+         p_src + data_len <= p_dst ||
+         p_dst + data_len <= p_src) &&
+        (CALAdapter_IsBounced(p_src, data_len) ||
+         CALAdapter_IsBounced(p_dst, data_len)))
+    {
+        return CALCMLib_AESDES_Pipeline(
+                        p_ctxt,
+                        p_key,
+                        Mode,
+                        fEncrypt,
+                        block_size,
+                        p_src,
+                        p_dst,
+                        data_len);
     }
+#endif /* CALCM_DMA_PIPELINE_SEGMENT_SIZE */
+
+    CALCMLib_AESDES_MakeToken(
+                    &t_cmd,
+                    p_ctxt,
+                    p_key,
+                    Mode,
+                    fEncrypt,
+                    data_len,
+                    loadIvFromAsset,
+                    saveIvInAsset);
 
     Task_p = CALCM_DMA_Alloc();
     if (!Task_p)
@@ -0,0 +1,551 @@
+/* cal_cm-v2_aessiv.c
+ *
+ * Implementation of the CAL API for Crypto Module.
+ *
+ * This file implements S2V-CMAC and AES-SIV (RFC 5297). The CMAC values
+ * are calculated by the CM; doubling and XOR are done on the host.
+ */
+
+/*****************************************************************************
+* Copyright (c) 2007-2015 INSIDE Secure B.V. All Rights Reserved.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 2 of the License, or
+* any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "c_cal_cm-v2.h"
+
+#ifdef SFZCRYPTO_CF_CIPHER_MAC_DATA__CM
+
+#include "basic_defs.h"
+#include "clib.h"
+#include "log.h"
+
+#include "cal_cm-v2_internal.h" // CAL_CM_CipherMac, CAL_CM_AESDES
+#include "cal_cm-v2_dma.h"
+
+#define CALCM_S2V_BLOCK_LEN  SFZCRYPTO_AES_BLOCK_LEN
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_S2V_Dbl
+ *
+ * Multiplication by x in GF(2^128) (the dbl() function of RFC 5297).
+ */
+static void
+CALCMLib_S2V_Dbl(
+        uint8_t * Block_p)
+{
+    const uint8_t Carry = Block_p[0] >> 7;
+    unsigned int i;
+
+    for (i = 0; i < CALCM_S2V_BLOCK_LEN - 1; i++)
+        Block_p[i] = (uint8_t)((Block_p[i] << 1) | (Block_p[i + 1] >> 7));
+
+    Block_p[CALCM_S2V_BLOCK_LEN - 1] =
+        (uint8_t)((Block_p[CALCM_S2V_BLOCK_LEN - 1] << 1) ^ (Carry * 0x87));
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_S2V_Cmac
+ *
+ * AES-CMAC of (part of) a message using the shared DMA admin. The MAC is
+ * kept in MacCtx_p->iv; set init for the first part, final for the last.
+ */
+static SfzCryptoStatus
+CALCMLib_S2V_Cmac(
+        CALCM_DMA_Admin_t * const Task_p,
+        SfzCryptoCipherMacContext * const MacCtx_p,
+        SfzCryptoCipherKey * const p_key,
+        uint8_t * p_data,
+        uint32_t length,
+        bool init,
+        bool final)
+{
+    if (init)
+    {
+        c_memset(MacCtx_p, 0, sizeof(SfzCryptoCipherMacContext));
+        MacCtx_p->fbmode = SFZCRYPTO_MODE_CMAC;
+        MacCtx_p->iv_asset_id = SFZCRYPTO_ASSETID_INVALID;
+        MacCtx_p->iv_loc = SFZ_IN_CONTEXT;
+    }
+
+    return CAL_CM_CipherMac(
+                    Task_p,
+                    MacCtx_p,
+                    p_key,
+                    p_data,
+                    length,
+                    init,
+                    final);
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_S2V_Start
+ *
+ * D = CMAC(K, <zero>)
+ */
+static SfzCryptoStatus
+CALCMLib_S2V_Start(
+        CALCM_DMA_Admin_t * const Task_p,
+        SfzCryptoCipherMacContext * const MacCtx_p,
+        SfzCryptoCipherKey * const p_key,
+        uint8_t * D_p)
+{
+    uint8_t Zero[CALCM_S2V_BLOCK_LEN];
+    SfzCryptoStatus funcres;
+
+    c_memset(Zero, 0, sizeof(Zero));
+
+    funcres = CALCMLib_S2V_Cmac(
+                    Task_p, MacCtx_p, p_key,
+                    Zero, sizeof(Zero),
+                    true, true);
+
+    if (funcres == SFZCRYPTO_SUCCESS)
+        c_memcpy(D_p, MacCtx_p->iv, CALCM_S2V_BLOCK_LEN);
+
+    return funcres;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_S2V_Update
+ *
+ * D = dbl(D) xor CMAC(K, Si), for all but the last component.
+ */
+static SfzCryptoStatus
+CALCMLib_S2V_Update(
+        CALCM_DMA_Admin_t * const Task_p,
+        SfzCryptoCipherMacContext * const MacCtx_p,
+        SfzCryptoCipherKey * const p_key,
+        uint8_t * p_data,
+        uint32_t length,
+        uint8_t * D_p)
+{
+    SfzCryptoStatus funcres;
+    unsigned int i;
+
+    funcres = CALCMLib_S2V_Cmac(
+                    Task_p, MacCtx_p, p_key,
+                    p_data, length,
+                    true, true);
+
+    if (funcres == SFZCRYPTO_SUCCESS)
+    {
+        CALCMLib_S2V_Dbl(D_p);
+        for (i = 0; i < CALCM_S2V_BLOCK_LEN; i++)
+            D_p[i] ^= MacCtx_p->iv[i];
+    }
+
+    return funcres;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_S2V_Final
+ *
+ * V = CMAC(K, T) for the last component Sn, where T = Sn xorend D when
+ * Sn is at least one block, otherwise T = dbl(D) xor pad(Sn).
+ * Only the last (up to two) blocks of Sn are copied to apply the XOR;
+ * the block-aligned part before that is passed to the CM as is.
+ */
+static SfzCryptoStatus
+CALCMLib_S2V_Final(
+        CALCM_DMA_Admin_t * const Task_p,
+        SfzCryptoCipherMacContext * const MacCtx_p,
+        SfzCryptoCipherKey * const p_key,
+        uint8_t * p_data,
+        uint32_t length,
+        uint8_t * D_p,
+        uint8_t * V_p)
+{
+    uint8_t Tail[2 * CALCM_S2V_BLOCK_LEN];
+    SfzCryptoStatus funcres = SFZCRYPTO_SUCCESS;
+    uint32_t HeadLen = 0;
+    uint32_t TailLen;
+    unsigned int i;
+
+    if (length >= CALCM_S2V_BLOCK_LEN)
+    {
+        // leaves 16..31 bytes for the tail
+        HeadLen = (length - CALCM_S2V_BLOCK_LEN) &
+                  ~(uint32_t)(CALCM_S2V_BLOCK_LEN - 1);
+        TailLen = length - HeadLen;
+
+        c_memcpy(Tail, p_data + HeadLen, TailLen);
+        for (i = 0; i < CALCM_S2V_BLOCK_LEN; i++)
+            Tail[TailLen - CALCM_S2V_BLOCK_LEN + i] ^= D_p[i];
+
+        if (HeadLen > 0)
+        {
+            funcres = CALCMLib_S2V_Cmac(
+                            Task_p, MacCtx_p, p_key,
+                            p_data, HeadLen,
+                            true, false);
+        }
+    }
+    else
+    {
+        TailLen = CALCM_S2V_BLOCK_LEN;
+
+        c_memset(Tail, 0, CALCM_S2V_BLOCK_LEN);
+        c_memcpy(Tail, p_data, length);
+        Tail[length] = 0x80;
+
+        CALCMLib_S2V_Dbl(D_p);
+        for (i = 0; i < CALCM_S2V_BLOCK_LEN; i++)
+            Tail[i] ^= D_p[i];
+    }
+
+    if (funcres == SFZCRYPTO_SUCCESS)
+    {
+        funcres = CALCMLib_S2V_Cmac(
+                        Task_p, MacCtx_p, p_key,
+                        Tail, TailLen,
+                        (HeadLen == 0), true);
+    }
+
+    if (funcres == SFZCRYPTO_SUCCESS)
+        c_memcpy(V_p, MacCtx_p->iv, CALCM_S2V_BLOCK_LEN);
+
+    c_memset(Tail, 0, sizeof(Tail));
+
+    return funcres;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CAL_CM_S2V
+ *
+ * S2V-CMAC through sfzcrypto_cipher_mac_data: each call processes one
+ * complete component of the vector, the last one with final set.
+ * Between calls, p_ctxt->iv holds D; after the final call it holds V.
+ */
+SfzCryptoStatus
+CAL_CM_S2V(
+        SfzCryptoCipherMacContext * const p_ctxt,
+        SfzCryptoCipherKey * const p_key,
+        uint8_t * p_data,
+        uint32_t length,
+        bool init,
+        bool final)
+{
+    SfzCryptoCipherMacContext MacCtx;
+    CALCM_DMA_Admin_t * Task_p;
+    SfzCryptoStatus funcres = SFZCRYPTO_SUCCESS;
+
+    // D is kept in the context
+    if (p_ctxt->iv_loc != SFZ_IN_CONTEXT)
+        return SFZCRYPTO_INVALID_PARAMETER;
+
+    Task_p = CALCM_DMA_Alloc();
+    if (!Task_p)
+        return SFZCRYPTO_NO_MEMORY;
+
+    if (init)
+    {
+        funcres = CALCMLib_S2V_Start(Task_p, &MacCtx, p_key, p_ctxt->iv);
+    }
+
+    if (funcres == SFZCRYPTO_SUCCESS)
+    {
+        if (final)
+        {
+            funcres = CALCMLib_S2V_Final(
+                            Task_p, &MacCtx, p_key,
+                            p_data, length,
+                            p_ctxt->iv,
+                            p_ctxt->iv);
+        }
+        else
+        {
+            funcres = CALCMLib_S2V_Update(
+                            Task_p, &MacCtx, p_key,
+                            p_data, length,
+                            p_ctxt->iv);
+        }
+    }
+
+    CALCM_DMA_Free(Task_p);
+
+    c_memset(&MacCtx, 0, sizeof(MacCtx));
+
+    return funcres;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CAL_CM_S2V_Vector
+ *
+ * S2V-CMAC over Count components with one DMA admin: all CMAC tokens are
+ * submitted back-to-back, without per-component setup. V_p receives V.
+ */
+SfzCryptoStatus
+CAL_CM_S2V_Vector(
+        SfzCryptoCipherKey * const p_key,
+        const unsigned int Count,
+        uint8_t * const * Data_pp,
+        const uint32_t * Length_p,
+        uint8_t * V_p)
+{
+    SfzCryptoCipherMacContext MacCtx;
+    CALCM_DMA_Admin_t * Task_p;
+    SfzCryptoStatus funcres;
+    uint8_t D[CALCM_S2V_BLOCK_LEN];
+    unsigned int i;
+
+    Task_p = CALCM_DMA_Alloc();
+    if (!Task_p)
+        return SFZCRYPTO_NO_MEMORY;
+
+    if (Count == 0)
+    {
+        // V = CMAC(K, <one>)
+        c_memset(D, 0, sizeof(D));
+        D[CALCM_S2V_BLOCK_LEN - 1] = 1;
+
+        funcres = CALCMLib_S2V_Cmac(
+                        Task_p, &MacCtx, p_key,
+                        D, sizeof(D),
+                        true, true);
+
+        if (funcres == SFZCRYPTO_SUCCESS)
+            c_memcpy(V_p, MacCtx.iv, CALCM_S2V_BLOCK_LEN);
+    }
+    else
+    {
+        funcres = CALCMLib_S2V_Start(Task_p, &MacCtx, p_key, D);
+
+        for (i = 0; i + 1 < Count && funcres == SFZCRYPTO_SUCCESS; i++)
+        {
+            funcres = CALCMLib_S2V_Update(
+                            Task_p, &MacCtx, p_key,
+                            Data_pp[i], Length_p[i],
+                            D);
+        }
+
+        if (funcres == SFZCRYPTO_SUCCESS)
+        {
+            funcres = CALCMLib_S2V_Final(
+                            Task_p, &MacCtx, p_key,
+                            Data_pp[Count - 1], Length_p[Count - 1],
+                            D,
+                            V_p);
+        }
+    }
+
+    CALCM_DMA_Free(Task_p);
+
+    c_memset(&MacCtx, 0, sizeof(MacCtx));
+    c_memset(D, 0, sizeof(D));
+
+    return funcres;
+}
+
+
+#ifdef SFZCRYPTO_CF_AUTH_CRYPT__CM
+/*----------------------------------------------------------------------------
+ * CAL_CM_AESSIV
+ *
+ * AES-SIV in one part. p_key holds K1 (for S2V) followed by K2 (for CTR).
+ * The vector is the AAD (if aad_len > 0), the nonce (if nonce_len > 0)
+ * and the plaintext. The output of encryption is V followed by the
+ * ciphertext, so src_len/dst_len include the 16 bytes of V (mac_len).
+ */
+SfzCryptoStatus
+CAL_CM_AESSIV(
+        SfzCryptoAuthCryptContext * const p_actxt,
+        SfzCryptoCipherKey * const p_key,
+        uint8_t * p_nonce,
+        uint32_t nonce_len,
+        uint8_t * p_aad,
+        uint32_t aad_len,
+        uint32_t mac_len,
+        uint32_t data_len,
+        uint8_t * p_src,
+        uint32_t src_len,
+        uint8_t * p_dst,
+        uint32_t * const p_dst_len,
+        SfzCipherOp direction)
+{
+    SfzCryptoCipherKey MacKey;
+    SfzCryptoCipherKey CtrKey;
+    SfzCryptoCipherContext * const Ctx_p = &p_actxt->ctxt;
+    SfzCryptoStatus funcres;
+    uint8_t * Data_p[3];
+    uint32_t Length[3];
+    unsigned int Count = 0;
+    uint8_t * Text_p;
+    uint8_t * Out_p;
+    uint32_t dst_len;
+    uint32_t len;
+
+    // the key halves cannot be taken from an asset
+    if (p_key->asset_id != SFZCRYPTO_ASSETID_INVALID)
+        return SFZCRYPTO_UNSUPPORTED;
+
+    if (p_key->length != 256 / 8 &&
+        p_key->length != 384 / 8 &&
+        p_key->length != 512 / 8)
+    {
+        return SFZCRYPTO_INVALID_KEYSIZE;
+    }
+
+    if (mac_len != CALCM_S2V_BLOCK_LEN)
+        return SFZCRYPTO_INVALID_PARAMETER;
+
+    if (p_src == p_dst && src_len > 0)
+        return SFZCRYPTO_INVALID_PARAMETER;
+
+    if (direction == SFZ_ENCRYPT)
+    {
+        if (src_len != data_len)
+            return SFZCRYPTO_INVALID_LENGTH;
+
+        dst_len = data_len + CALCM_S2V_BLOCK_LEN;
+    }
+    else
+    {
+        if (src_len < CALCM_S2V_BLOCK_LEN ||
+            src_len - CALCM_S2V_BLOCK_LEN != data_len)
+        {
+            return SFZCRYPTO_INVALID_LENGTH;
+        }
+
+        dst_len = data_len;
+    }
+
+    if (*p_dst_len < dst_len)
+    {
+        *p_dst_len = dst_len;
+        return SFZCRYPTO_BUFFER_TOO_SMALL;
+    }
+
+    MacKey.type = SFZCRYPTO_KEY_AES;
+    MacKey.asset_id = SFZCRYPTO_ASSETID_INVALID;
+    MacKey.length = p_key->length / 2;
+    c_memcpy(MacKey.key, p_key->key, MacKey.length);
+
+    CtrKey = MacKey;
+    c_memcpy(CtrKey.key, p_key->key + MacKey.length, CtrKey.length);
+
+    if (aad_len > 0)
+    {
+        Data_p[Count] = p_aad;
+        Length[Count++] = aad_len;
+    }
+
+    if (nonce_len > 0)
+    {
+        Data_p[Count] = p_nonce;
+        Length[Count++] = nonce_len;
+    }
+
+    if (direction == SFZ_ENCRYPT)
+    {
+        // V = S2V(K1, AAD, nonce, P), output V || C
+        Data_p[Count] = p_src;
+        Length[Count++] = data_len;
+
+        funcres = CAL_CM_S2V_Vector(&MacKey, Count, Data_p, Length,
+                                    p_actxt->iv);
+        if (funcres != SFZCRYPTO_SUCCESS)
+            goto out;
+
+        c_memcpy(p_dst, p_actxt->iv, CALCM_S2V_BLOCK_LEN);
+        Text_p = p_src;
+        Out_p = p_dst + CALCM_S2V_BLOCK_LEN;
+    }
+    else
+    {
+        c_memcpy(p_actxt->iv, p_src, CALCM_S2V_BLOCK_LEN);
+        Text_p = p_src + CALCM_S2V_BLOCK_LEN;
+        Out_p = p_dst;
+    }
+
+    // CTR with Q = V, bits 63 and 31 cleared
+    c_memset(Ctx_p, 0, sizeof(SfzCryptoCipherContext));
+    Ctx_p->fbmode = SFZCRYPTO_MODE_CTR;
+    Ctx_p->iv_asset_id = SFZCRYPTO_ASSETID_INVALID;
+    Ctx_p->iv_loc = SFZ_IN_CONTEXT;
+    c_memcpy(Ctx_p->iv, p_actxt->iv, CALCM_S2V_BLOCK_LEN);
+    Ctx_p->iv[8] &= 0x7F;
+    Ctx_p->iv[12] &= 0x7F;
+    c_memcpy(p_actxt->counter, Ctx_p->iv, CALCM_S2V_BLOCK_LEN);
+
+    funcres = SFZCRYPTO_SUCCESS;
+    if (data_len > 0)
+    {
+        len = data_len;
+        funcres = CAL_CM_AESDES(
+                        Ctx_p,
+                        &CtrKey,
+                        Text_p,
+                        data_len,
+                        Out_p,
+                        &len,
+                        SFZ_ENCRYPT);
+    }
+
+
+    if (funcres == SFZCRYPTO_SUCCESS && direction != SFZ_ENCRYPT)
+    {
+        uint8_t T[CALCM_S2V_BLOCK_LEN];
+        uint8_t diff = 0;
+        unsigned int i;
+
+        // T = S2V(K1, AAD, nonce, P) must equal V
+        Data_p[Count] = p_dst;
+        Length[Count++] = data_len;
+
+        funcres = CAL_CM_S2V_Vector(&MacKey, Count, Data_p, Length, T);
+
+        if (funcres == SFZCRYPTO_SUCCESS)
+        {
+            for (i = 0; i < CALCM_S2V_BLOCK_LEN; i++)
+                diff |= T[i] ^ p_actxt->iv[i];
+
+            if (diff != 0)
+            {
+                LOG_INFO("sfzcrypto_cm_auth_crypt: SIV mismatch\n");
+                funcres = SFZCRYPTO_SIGNATURE_CHECK_FAILED;
+            }
+        }
+
+        // do not release unauthenticated plaintext
+        if (funcres != SFZCRYPTO_SUCCESS)
+            c_memset(p_dst, 0, data_len);
+    }
+
+    if (funcres == SFZCRYPTO_SUCCESS)
+        *p_dst_len = dst_len;
+
+out:
+    c_memset(&MacKey, 0, sizeof(MacKey));
+    c_memset(&CtrKey, 0, sizeof(CtrKey));
+
+    return funcres;
+}
+#endif /* SFZCRYPTO_CF_AUTH_CRYPT__CM */
+
+#else
+
+// avoid the "empty translation unit" warning
+extern const int _avoid_empty_translation_unit;
+
+#endif /* SFZCRYPTO_CF_CIPHER_MAC_DATA__CM */
+
+/* end of file cal_cm-v2_aessiv.c */
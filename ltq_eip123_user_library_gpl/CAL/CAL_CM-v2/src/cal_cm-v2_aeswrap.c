@@ -0,0 +1,402 @@
+/* cal_cm-v2_aeswrap.c
+ *
+ * Implementation of the CAL API for Crypto Module.
+ *
+ * This file implements AES Key Wrap (RFC 3394), for single keys and for
+ * a series of keys wrapped or unwrapped with the same KEK.
+ */
+
+/*****************************************************************************
+* Copyright (c) 2007-2015 INSIDE Secure B.V. All Rights Reserved.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 2 of the License, or
+* any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "c_cal_cm-v2.h"
+
+#ifdef SFZCRYPTO_CF_AES_WRAP_UNWRAP__CM
+
+#include "basic_defs.h"
+#include "clib.h"
+#include "log.h"
+
+#include "cal_cm.h"             // the API to implement
+
+#include "cal_cm-v2_internal.h" // CAL_CM_ExchangeToken
+#include "cal_cm-v2_dma.h"
+
+#include "cm_tokens_wrap.h"
+#include "cm_tokens_errdetails.h"
+
+// limits of the CM Wrap/Unwrap token (input data length)
+#define CALCM_AESWRAP_INPUT_MIN     16
+#define CALCM_AESWRAP_INPUT_MAX     1024
+
+// the integrity check value that is added by wrap
+#define CALCM_AESWRAP_ICV_LEN       8
+
+// default initial value from RFC 3394, the only one the CM supports
+static const uint8_t CALCM_AESWrap_DefaultIV[CALCM_AESWRAP_ICV_LEN] =
+{
+    0xA6, 0xA6, 0xA6, 0xA6, 0xA6, 0xA6, 0xA6, 0xA6
+};
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_AESWrap_CheckItem
+ *
+ * Checks the lengths of one item and returns the output length.
+ */
+static SfzCryptoStatus
+CALCMLib_AESWrap_CheckItem(
+        const SfzCryptoWrapItem * const Item_p,
+        const bool fWrap,
+        uint32_t * const OutputLen_p)
+{
+    uint32_t MinLen = CALCM_AESWRAP_INPUT_MIN;
+
+    if (!fWrap)
+        MinLen += CALCM_AESWRAP_ICV_LEN;
+
+    if (Item_p->src_len < MinLen ||
+        Item_p->src_len > CALCM_AESWRAP_INPUT_MAX ||
+        (Item_p->src_len & (CALCM_AESWRAP_ICV_LEN - 1)) != 0)
+    {
+        return SFZCRYPTO_INVALID_LENGTH;
+    }
+
+#ifdef CALCM_STRICT_ARGS
+    if (Item_p->src_p == NULL ||
+        Item_p->dst_p == NULL)
+    {
+        return SFZCRYPTO_INVALID_PARAMETER;
+    }
+#endif
+
+    if (fWrap)
+        *OutputLen_p = Item_p->src_len + CALCM_AESWRAP_ICV_LEN;
+    else
+        *OutputLen_p = Item_p->src_len - CALCM_AESWRAP_ICV_LEN;
+
+    return SFZCRYPTO_SUCCESS;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_AESWrap_Process
+ *
+ * Wraps or unwraps all items with one DMA admin and one shared DMA buffer,
+ * sized for the largest item. The tokens are submitted back-to-back; only
+ * the input and output data are copied per item.
+ */
+static SfzCryptoStatus
+CALCMLib_AESWrap_Process(
+        SfzCryptoCipherKey * const kek_p,
+        SfzCryptoWrapItem * const items_p,
+        uint32_t item_count,
+        const bool fWrap)
+{
+    CALCM_DMA_Admin_t * Task_p;
+    CMTokens_Command_t t_cmd;
+    CMTokens_Response_t t_res;
+    SfzCryptoStatus funcres = SFZCRYPTO_SUCCESS;
+    SfzCryptoStatus status;
+    uint32_t MaxInputLen = 0;
+    uint32_t OutputLen;
+    uint32_t i;
+
+#ifdef CALCM_STRICT_ARGS
+    CMTokens_MakeToken_Clear(&t_cmd);
+#endif
+
+    // check all items first, to size the shared buffer
+    for (i = 0; i < item_count; i++)
+    {
+        SfzCryptoWrapItem * const Item_p = items_p + i;
+
+        Item_p->status = CALCMLib_AESWrap_CheckItem(Item_p, fWrap, &OutputLen);
+
+        if (Item_p->status == SFZCRYPTO_SUCCESS &&
+            Item_p->dst_len < OutputLen)
+        {
+            Item_p->dst_len = OutputLen;
+            Item_p->status = SFZCRYPTO_BUFFER_TOO_SMALL;
+        }
+
+        if (Item_p->status != SFZCRYPTO_SUCCESS)
+        {
+            if (funcres == SFZCRYPTO_SUCCESS)
+                funcres = Item_p->status;
+            continue;
+        }
+
+        if (Item_p->src_len > MaxInputLen)
+            MaxInputLen = Item_p->src_len;
+    }
+
+    if (MaxInputLen == 0)
+        return funcres;         // nothing left to process
+
+    Task_p = CALCM_DMA_Alloc();
+    if (!Task_p)
+        return SFZCRYPTO_NO_MEMORY;
+
+    // the output is at most ICV_LEN larger than the input
+    status = CALAdapter_Bulk_Alloc(
+                    Task_p,
+                    MaxInputLen,
+                    MaxInputLen + CALCM_AESWRAP_ICV_LEN);
+
+    if (status != SFZCRYPTO_SUCCESS)
+    {
+        CALCM_DMA_Free(Task_p);
+        return status;
+    }
+
+    for (i = 0; i < item_count; i++)
+    {
+        SfzCryptoWrapItem * const Item_p = items_p + i;
+        unsigned int ResultLen;
+        int res;
+
+        if (Item_p->status != SFZCRYPTO_SUCCESS)
+            continue;
+
+        if (fWrap)
+            OutputLen = Item_p->src_len + CALCM_AESWRAP_ICV_LEN;
+        else
+            OutputLen = Item_p->src_len - CALCM_AESWRAP_ICV_LEN;
+
+        status = CALAdapter_Bulk_PreDMA(
+                        Task_p,
+                        /*AlgorithmicBlockSize:*/CALCM_AESWRAP_ICV_LEN,
+                        Item_p->src_len,
+                        Item_p->src_p,
+                        OutputLen);
+
+        if (status == SFZCRYPTO_SUCCESS)
+        {
+            CMTokens_MakeCommand_WrapUnwrap(&t_cmd, fWrap,
+                                            (uint16_t)Item_p->src_len);
+            CMTokens_MakeCommand_WrapUnwrap_SetKeyLength(&t_cmd,
+                                                         kek_p->length);
+
+            // copy the key into the token, or set the Asset Store reference
+            if (kek_p->asset_id == SFZCRYPTO_ASSETID_INVALID)
+            {
+                CMTokens_MakeCommand_WrapUnwrap_CopyKey(&t_cmd,
+                                                        kek_p->length,
+                                                        kek_p->key);
+            }
+            else
+            {
+                CMTokens_MakeCommand_WrapUnwrap_SetASLoadKey(&t_cmd,
+                                                             kek_p->asset_id);
+            }
+
+            CMTokens_MakeCommand_SetTokenID(&t_cmd, CAL_TOKENID_VALUE, true);
+            CMTokens_MakeCommand_WrapUnwrap_WriteInDescriptor(
+                                                    &t_cmd,
+                                                    &Task_p->InDescriptor);
+            CMTokens_MakeCommand_WrapUnwrap_WriteOutDescriptor(
+                                                    &t_cmd,
+                                                    &Task_p->OutDescriptor);
+
+            // exchange a message with the CM
+            status = CAL_CM_ExchangeToken(&t_cmd, &t_res);
+        }
+
+        if (status == SFZCRYPTO_SUCCESS)
+        {
+            // check for errors
+            res = CMTokens_ParseResponse_Generic(&t_res);
+            if (res != 0)
+            {
+                const char * ErrMsg_p;
+
+                res = CMTokens_ParseResponse_ErrorDetails(&t_res, &ErrMsg_p);
+
+                LOG_WARN(
+                    "sfzcrypto_cm_aes_wrap_unwrap: "
+                    "Failed with error %d (%s)\n",
+                    res,
+                    ErrMsg_p);
+
+                // map CM error code to CAL error code
+                if (res == CMTOKENS_RESULT_SEQ_UNWRAP_ERROR)
+                    status = SFZCRYPTO_SIGNATURE_CHECK_FAILED;
+                else if (res == CMTOKENS_RESULT_SEQ_INVALID_ASSET)
+                    status = SFZCRYPTO_OPERATION_FAILED;
+                else
+                    status = SFZCRYPTO_INTERNAL_ERROR;
+            }
+        }
+
+        if (status == SFZCRYPTO_SUCCESS)
+        {
+            CMTokens_ParseResponse_WrapUnwrap_GetDataLength(&t_res,
+                                                            &ResultLen);
+            if (ResultLen != OutputLen)
+                status = SFZCRYPTO_INTERNAL_ERROR;
+        }
+
+        if (status == SFZCRYPTO_SUCCESS)
+        {
+            status = CALAdapter_Bulk_PostDMA(
+                            Task_p,
+                            OutputLen,
+                            Item_p->dst_p);
+        }
+
+        if (status == SFZCRYPTO_SUCCESS)
+            Item_p->dst_len = OutputLen;
+
+        Item_p->status = status;
+        if (funcres == SFZCRYPTO_SUCCESS)
+            funcres = status;
+    }
+
+    // also clears the shared buffer
+    CALCM_DMA_Free(Task_p);
+
+    return funcres;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_AESWrap_CheckKek
+ */
+static SfzCryptoStatus
+CALCMLib_AESWrap_CheckKek(
+        SfzCryptoCipherKey * const kek_p,
+        SfzCipherOp direction)
+{
+    if (kek_p == NULL)
+        return SFZCRYPTO_INVALID_PARAMETER;
+
+    // the CM only supports AES as the wrap algorithm
+    if (kek_p->type != SFZCRYPTO_KEY_AES)
+        return SFZCRYPTO_INVALID_ALGORITHM;
+
+    if (kek_p->length != 128 / 8 &&
+        kek_p->length != 192 / 8 &&
+        kek_p->length != 256 / 8)
+    {
+        return SFZCRYPTO_INVALID_KEYSIZE;
+    }
+
+    if (direction != SFZ_ENCRYPT && direction != SFZ_DECRYPT)
+        return SFZCRYPTO_INVALID_PARAMETER;
+
+    return SFZCRYPTO_SUCCESS;
+}
+
+
+/*----------------------------------------------------------------------------
+ * sfzcrypto_cm_aes_wrap_unwrap
+ */
+SfzCryptoStatus
+sfzcrypto_cm_aes_wrap_unwrap(
+        SfzCryptoCipherContext * const ctxt_p,
+        SfzCryptoCipherKey * const kek_p,
+        const uint8_t * src_p,
+        uint32_t src_len,
+        uint8_t * dst_p,
+        uint32_t * const dst_len_p,
+        SfzCipherOp direction,
+        const uint8_t * initial_value_p)
+{
+    SfzCryptoWrapItem Item;
+    SfzCryptoStatus funcres;
+
+    // the CM does not keep state between calls
+    IDENTIFIER_NOT_USED(ctxt_p);
+
+#ifdef CALCM_STRICT_ARGS
+    if (src_p == NULL ||
+        dst_p == NULL ||
+        dst_len_p == NULL)
+    {
+        return SFZCRYPTO_INVALID_PARAMETER;
+    }
+#endif
+
+    funcres = CALCMLib_AESWrap_CheckKek(kek_p, direction);
+    if (funcres != SFZCRYPTO_SUCCESS)
+        return funcres;
+
+    if (initial_value_p != NULL &&
+        c_memcmp(initial_value_p,
+                 CALCM_AESWrap_DefaultIV,
+                 CALCM_AESWRAP_ICV_LEN) != 0)
+    {
+        return SFZCRYPTO_UNSUPPORTED;
+    }
+
+    Item.src_p = src_p;
+    Item.src_len = src_len;
+    Item.dst_p = dst_p;
+    Item.dst_len = *dst_len_p;
+
+    funcres = CALCMLib_AESWrap_Process(
+                    kek_p,
+                    &Item,
+                    1,
+                    (direction == SFZ_ENCRYPT));
+
+    // set on success and to report the required size
+    if (funcres == SFZCRYPTO_SUCCESS ||
+        funcres == SFZCRYPTO_BUFFER_TOO_SMALL)
+    {
+        *dst_len_p = Item.dst_len;
+    }
+
+    return funcres;
+}
+
+
+/*----------------------------------------------------------------------------
+ * sfzcrypto_cm_aes_wrap_unwrap_bulk
+ */
+SfzCryptoStatus
+sfzcrypto_cm_aes_wrap_unwrap_bulk(
+        SfzCryptoCipherKey * const kek_p,
+        SfzCryptoWrapItem * const items_p,
+        uint32_t item_count,
+        SfzCipherOp direction)
+{
+    SfzCryptoStatus funcres;
+
+    if (items_p == NULL && item_count > 0)
+        return SFZCRYPTO_INVALID_PARAMETER;
+
+    funcres = CALCMLib_AESWrap_CheckKek(kek_p, direction);
+    if (funcres != SFZCRYPTO_SUCCESS)
+        return funcres;
+
+    return CALCMLib_AESWrap_Process(
+                    kek_p,
+                    items_p,
+                    item_count,
+                    (direction == SFZ_ENCRYPT));
+}
+
+#else
+
+// avoid the "empty translation unit" warning
+extern const int _avoid_empty_translation_unit;
+
+#endif /* SFZCRYPTO_CF_AES_WRAP_UNWRAP__CM */
+
+/* end of file cal_cm-v2_aeswrap.c */
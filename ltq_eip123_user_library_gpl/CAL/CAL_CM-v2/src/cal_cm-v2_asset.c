@@ -442,6 +442,9 @@ sfzcrypto_cm_asset_free(
         }
     }
 
+    // the AssetId is no longer valid; forget cached search results for it
+    CAL_CM_AssetSearch_Invalidate(AssetId);
+
     return SFZCRYPTO_SUCCESS;
 }
 #endif /* SFZCRYPTO_CF_ASSET_FREE__CM */
@@ -458,13 +461,7 @@ sfzcrypto_cm_asset_search(
         uint32_t StaticAssetNumber,
         SfzCryptoAssetId * const NewAssetId_p)
 {
-    CMTokens_Response_t t_rsp;
-    CMTokens_Command_t t_cmd;
-    SfzCryptoStatus status;
-
 #ifdef CALCM_STRICT_ARGS
-    CMTokens_MakeToken_Clear(&t_cmd);
-
     if (NewAssetId_p == NULL)
         return SFZCRYPTO_BAD_ARGUMENT;
 
@@ -472,44 +469,8 @@ sfzcrypto_cm_asset_search(
         return SFZCRYPTO_INVALID_PARAMETER;
 #endif
 
-    CMTokens_MakeCommand_AssetSearch(&t_cmd, StaticAssetNumber);
-
-    // exchange a message with the CM
-    status = CAL_CM_ExchangeToken(&t_cmd, &t_rsp);
-    if (status != SFZCRYPTO_SUCCESS)
-    {
-        return status;
-    }
-
-    // check for errors
-    {
-        int res;
-
-        res = CMTokens_ParseResponse_Generic(&t_rsp);
-
-        if (res != 0)
-        {
-            const char * ErrMsg_p;
-
-            res = CMTokens_ParseResponse_ErrorDetails(&t_rsp, &ErrMsg_p);
-
-            LOG_WARN(
-                "sfzcrypto_cm_asset_search: "
-                "Failed with error %d (%s)\n",
-                res,
-                ErrMsg_p);
-
-            // map 'not found' by FW to invalid parameter
-            if (res == CMTOKENS_RESULT_SEQ_INVALID_ASSET)
-                return SFZCRYPTO_INVALID_PARAMETER;
-
-            return SFZCRYPTO_INTERNAL_ERROR;
-        }
-    }
-
-    CMTokens_ParseResponse_AssetSearch(&t_rsp, NewAssetId_p, NULL);
-
-    return SFZCRYPTO_SUCCESS;
+    // served from the cache when the asset was found before
+    return CAL_CM_AssetSearch(StaticAssetNumber, NewAssetId_p, NULL);
 }
 #endif /* SFZCRYPTO_CF_ASSET_SEARCH__CM */
 
@@ -0,0 +1,285 @@
+/* cal_cm-v2_assetsearch.c
+ *
+ * Implementation of the CAL API for Crypto Module.
+ *
+ * This file implements the static asset search, with a cache that maps the
+ * static asset numbers to the AssetId reported by the CM.
+ */
+
+/*****************************************************************************
+* Copyright (c) 2007-2015 INSIDE Secure B.V. All Rights Reserved.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 2 of the License, or
+* any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "c_cal_cm-v2.h"
+
+#include "basic_defs.h"
+#include "clib.h"
+#include "log.h"
+
+#include "cal_cm-v2_internal.h"     // the API to implement
+
+#include "cm_tokens_asset.h"
+#include "cm_tokens_errdetails.h"
+
+#include "cal_hw_api.h"             // CAL_HW_WarmState_Generation
+#include "spal_mutex.h"
+
+/*
+ * The static assets (typically NVM objects) and their AssetIds do not
+ * change while the CM is running, so the result of a successful search
+ * can be reused. The cache is emptied by CAL_CM_AssetSearch_Init (called
+ * when the CM is (re)initialized) and when another process has started to
+ * initialize the CM since (see CAL_HW_WarmState_Generation). Entries are
+ * removed when the referenced asset is freed.
+ */
+typedef struct
+{
+    bool fValid;
+    SfzCryptoAssetId AssetId;
+    uint32_t DataLen;
+} CALCM_AssetSearch_CacheEntry_t;
+
+static CALCM_AssetSearch_CacheEntry_t
+CALCM_AssetSearch_Cache[CMTOKENS_STATIC_ASSET_NUMBER_MAX + 1];
+
+static SPAL_Mutex_t CALCM_AssetSearch_Lock;
+static bool CALCM_AssetSearch_IsInitialized = false;
+
+// CM generation of the cached results
+static uint32_t CALCM_AssetSearch_Generation;
+
+#ifdef CALCM_ASSETSEARCH_PRELOAD_LIST
+static const uint8_t CALCM_AssetSearch_PreloadList[] =
+{
+    CALCM_ASSETSEARCH_PRELOAD_LIST
+};
+#endif
+
+
+/*----------------------------------------------------------------------------
+ * CAL_CM_AssetSearch_Init
+ */
+int
+CAL_CM_AssetSearch_Init(void)
+{
+    if (!CALCM_AssetSearch_IsInitialized)
+    {
+        if (SPAL_Mutex_Init(&CALCM_AssetSearch_Lock) != SPAL_SUCCESS)
+        {
+            LOG_WARN(
+                "CAL_CM_AssetSearch_Init: "
+                "Failed to create lock\n");
+            return -1;
+        }
+
+        CALCM_AssetSearch_IsInitialized = true;
+    }
+
+    // the CM was (re)started, forget all previous results
+    SPAL_Mutex_Lock(&CALCM_AssetSearch_Lock);
+    c_memset(CALCM_AssetSearch_Cache, 0, sizeof(CALCM_AssetSearch_Cache));
+    CALCM_AssetSearch_Generation = CAL_HW_WarmState_Generation();
+    SPAL_Mutex_UnLock(&CALCM_AssetSearch_Lock);
+
+    return 0;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CAL_CM_AssetSearch_Preload
+ */
+void
+CAL_CM_AssetSearch_Preload(void)
+{
+#ifdef CALCM_ASSETSEARCH_PRELOAD_LIST
+    unsigned int i;
+
+    for (i = 0; i < sizeof(CALCM_AssetSearch_PreloadList); i++)
+    {
+        SfzCryptoAssetId AssetId;
+        SfzCryptoStatus funcres;
+
+        funcres = CAL_CM_AssetSearch(
+                        CALCM_AssetSearch_PreloadList[i],
+                        &AssetId,
+                        NULL);
+
+        if (funcres != SFZCRYPTO_SUCCESS)
+        {
+            // not fatal; a later search reports the problem to the caller
+            LOG_INFO(
+                "CAL_CM_AssetSearch_Preload: "
+                "Static asset %u not found (%d)\n",
+                CALCM_AssetSearch_PreloadList[i],
+                funcres);
+        }
+    }
+#endif /* CALCM_ASSETSEARCH_PRELOAD_LIST */
+}
+
+
+/*----------------------------------------------------------------------------
+ * CAL_CM_AssetSearch_Invalidate
+ */
+void
+CAL_CM_AssetSearch_Invalidate(
+        const SfzCryptoAssetId AssetId)
+{
+    unsigned int i;
+
+    if (!CALCM_AssetSearch_IsInitialized)
+        return;
+
+    SPAL_Mutex_Lock(&CALCM_AssetSearch_Lock);
+
+    for (i = 0; i <= CMTOKENS_STATIC_ASSET_NUMBER_MAX; i++)
+    {
+        if (AssetId == SFZCRYPTO_ASSETID_INVALID ||
+            CALCM_AssetSearch_Cache[i].AssetId == AssetId)
+        {
+            CALCM_AssetSearch_Cache[i].fValid = false;
+        }
+    }
+
+    SPAL_Mutex_UnLock(&CALCM_AssetSearch_Lock);
+}
+
+
+/*----------------------------------------------------------------------------
+ * CAL_CM_AssetSearch
+ */
+SfzCryptoStatus
+CAL_CM_AssetSearch(
+        const uint32_t StaticAssetNumber,
+        SfzCryptoAssetId * const AssetId_p,
+        uint32_t * const DataLen_p)
+{
+    CMTokens_Response_t t_rsp;
+    CMTokens_Command_t t_cmd;
+    SfzCryptoStatus status;
+    SfzCryptoAssetId AssetId;
+    uint32_t DataLen;
+    uint32_t Generation = 0;
+
+    *AssetId_p = SFZCRYPTO_ASSETID_INVALID;
+
+    if (StaticAssetNumber > CMTOKENS_STATIC_ASSET_NUMBER_MAX)
+        return SFZCRYPTO_INVALID_PARAMETER;
+
+    if (CALCM_AssetSearch_IsInitialized)
+    {
+        bool fFound = false;
+
+        Generation = CAL_HW_WarmState_Generation();
+
+        SPAL_Mutex_Lock(&CALCM_AssetSearch_Lock);
+
+        // the CM was initialized again by another process
+        if (Generation != CALCM_AssetSearch_Generation)
+        {
+            c_memset(
+                CALCM_AssetSearch_Cache,
+                0,
+                sizeof(CALCM_AssetSearch_Cache));
+
+            CALCM_AssetSearch_Generation = Generation;
+        }
+
+        if (CALCM_AssetSearch_Cache[StaticAssetNumber].fValid)
+        {
+            AssetId = CALCM_AssetSearch_Cache[StaticAssetNumber].AssetId;
+            DataLen = CALCM_AssetSearch_Cache[StaticAssetNumber].DataLen;
+            fFound = true;
+        }
+
+        SPAL_Mutex_UnLock(&CALCM_AssetSearch_Lock);
+
+        if (fFound)
+        {
+            *AssetId_p = AssetId;
+            if (DataLen_p)
+                *DataLen_p = DataLen;
+
+            return SFZCRYPTO_SUCCESS;       // ## RETURN ##
+        }
+    }
+
+#ifdef CALCM_STRICT_ARGS
+    CMTokens_MakeToken_Clear(&t_cmd);
+#endif
+
+    CMTokens_MakeCommand_AssetSearch(&t_cmd, StaticAssetNumber);
+
+    // exchange a message with the CM
+    status = CAL_CM_ExchangeToken(&t_cmd, &t_rsp);
+    if (status != SFZCRYPTO_SUCCESS)
+        return status;
+
+    // check for errors
+    {
+        int res;
+
+        res = CMTokens_ParseResponse_Generic(&t_rsp);
+
+        if (res != 0)
+        {
+            const char * ErrMsg_p;
+
+            res = CMTokens_ParseResponse_ErrorDetails(&t_rsp, &ErrMsg_p);
+
+            // map 'not found' by FW to invalid parameter
+            // (not cached; the asset may be created later)
+            if (res == CMTOKENS_RESULT_SEQ_INVALID_ASSET)
+                return SFZCRYPTO_INVALID_PARAMETER;
+
+            LOG_WARN(
+                "CAL_CM_AssetSearch: "
+                "Failed with error %d (%s)\n",
+                res,
+                ErrMsg_p);
+
+            return SFZCRYPTO_INTERNAL_ERROR;
+        }
+    }
+
+    CMTokens_ParseResponse_AssetSearch(&t_rsp, &AssetId, &DataLen);
+
+    if (CALCM_AssetSearch_IsInitialized &&
+        AssetId != SFZCRYPTO_ASSETID_INVALID)
+    {
+        SPAL_Mutex_Lock(&CALCM_AssetSearch_Lock);
+
+        // not when the CM was initialized again during the search
+        if (Generation == CALCM_AssetSearch_Generation &&
+            Generation == CAL_HW_WarmState_Generation())
+        {
+            CALCM_AssetSearch_Cache[StaticAssetNumber].AssetId = AssetId;
+            CALCM_AssetSearch_Cache[StaticAssetNumber].DataLen = DataLen;
+            CALCM_AssetSearch_Cache[StaticAssetNumber].fValid = true;
+        }
+
+        SPAL_Mutex_UnLock(&CALCM_AssetSearch_Lock);
+    }
+
+    *AssetId_p = AssetId;
+    if (DataLen_p)
+        *DataLen_p = DataLen;
+
+    return SFZCRYPTO_SUCCESS;
+}
+
+
+/* end of file cal_cm-v2_assetsearch.c */
@@ -31,9 +31,8 @@
 #include "log.h"
 
 #include "cal_cm.h"             // the API to implement
-#include "cal_sw.h"             // sfzcrypto_sw_cipher_mac_data_s2v
 
-#include "cal_cm-v2_internal.h" // CAL_CM_ExchangeToken
+#include "cal_cm-v2_internal.h" // CAL_CM_ExchangeToken, CAL_CM_S2V
 #include "cal_cm-v2_dma.h"
 
 #include "cm_tokens_mac.h"
@@ -41,10 +40,15 @@
 
 
 /*----------------------------------------------------------------------------
- * sfzcrypto_cm_cipher_mac_data
+ * CAL_CM_CipherMac
+ *
+ * Implements sfzcrypto_cm_cipher_mac_data. When SharedTask_p is non-NULL,
+ * that DMA admin is used instead of allocating one for this call only; this
+ * allows a series of MAC operations to be done back-to-back.
  */
 SfzCryptoStatus
-sfzcrypto_cm_cipher_mac_data(
+CAL_CM_CipherMac(
+        CALCM_DMA_Admin_t * const SharedTask_p,
         SfzCryptoCipherMacContext * const p_ctxt,
         SfzCryptoCipherKey * const p_key,
         uint8_t * p_data,
@@ -177,7 +181,7 @@ sfzcrypto_cm_cipher_mac_data(
         switch (p_ctxt->fbmode)
         {
             case SFZCRYPTO_MODE_S2V_CMAC:
-                return sfzcrypto_sw_cipher_mac_data_s2v(
+                return CAL_CM_S2V(
                                 p_ctxt,
                                 p_key,
                                 p_data,
@@ -237,9 +241,13 @@ sfzcrypto_cm_cipher_mac_data(
         }
     }
 
-    Task_p = CALCM_DMA_Alloc();
-    if (!Task_p)
-        return SFZCRYPTO_NO_MEMORY;
+    Task_p = SharedTask_p;
+    if (Task_p == NULL)
+    {
+        Task_p = CALCM_DMA_Alloc();
+        if (!Task_p)
+            return SFZCRYPTO_NO_MEMORY;
+    }
 
     // prepare input data for processing by the CM
     {
@@ -265,7 +273,8 @@ sfzcrypto_cm_cipher_mac_data(
         {
             // there was a problem with the input data
             LOG_INFO("sfzcrypto_cipher_mac_data: Abort after prepare");
-            CALCM_DMA_Free(Task_p);
+            if (SharedTask_p == NULL)
+                CALCM_DMA_Free(Task_p);
             return funcres;     // ## RETURN ##
         }
     }
@@ -323,15 +332,14 @@ sfzcrypto_cm_cipher_mac_data(
 
     // exchange a message with the CM
     funcres = CAL_CM_ExchangeToken(&t_cmd, &t_res);
-    if (funcres != SFZCRYPTO_SUCCESS)
-    {
-        CALCM_DMA_Free(Task_p);
-        return funcres;
-    }
 
     // if a bounce buffer was used, release it
     CALAdapter_PostDMA(Task_p);
-    CALCM_DMA_Free(Task_p);
+    if (SharedTask_p == NULL)
+        CALCM_DMA_Free(Task_p);
+
+    if (funcres != SFZCRYPTO_SUCCESS)
+        return funcres;
 
     // check for errors
     res = CMTokens_ParseResponse_Generic(&t_res);
@@ -375,6 +383,29 @@ sfzcrypto_cm_cipher_mac_data(
     return SFZCRYPTO_SUCCESS;
 }
 
+
+/*----------------------------------------------------------------------------
+ * sfzcrypto_cm_cipher_mac_data
+ */
+SfzCryptoStatus
+sfzcrypto_cm_cipher_mac_data(
+        SfzCryptoCipherMacContext * const p_ctxt,
+        SfzCryptoCipherKey * const p_key,
+        uint8_t * p_data,
+        uint32_t length,
+        bool init,
+        bool final)
+{
+    return CAL_CM_CipherMac(
+                    NULL,
+                    p_ctxt,
+                    p_key,
+                    p_data,
+                    length,
+                    init,
+                    final);
+}
+
 #else
 
 // avoid the "empty translation unit" warning
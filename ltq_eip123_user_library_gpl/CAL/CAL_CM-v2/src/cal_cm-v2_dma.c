@@ -3,10 +3,10 @@
  * Implementation of the CAL API for Crypto Module.
  *
  * This file contains the DMA-safe buffer functionality:
- * - alloc/free
+ * - alloc/free, pool of released tasks
  * - pre/post DMA
  * - data bounce
- * - DMA descriptor chaining
+ * - DMA descriptor chaining, reuse of populated chains
  * - Synchronization: TokenID support
  */
 
@@ -44,6 +44,18 @@
 
 #include "spal_sleep.h"         // SPAL_SleepMS
 #include "spal_memory.h"
+#include "spal_mutex.h"
+
+#include "metrics.h"            // METRICS_*
+
+#ifdef CALCM_DMA_THREAD_CONTEXT
+#include <pthread.h>            // pthread_key_t
+#endif
+
+#if defined(__SSE2__) && (CALCM_DMA_STREAMING_COPY_MIN > 0)
+#include <emmintrin.h>          // _mm_stream_si128
+#define CALCM_DMA_STREAMING_COPY
+#endif
 
 // Is pointer `p' aligned at `a', i.e. are its log2(a) low bits zero?
 #define IS_ALIGNED(p, a)  (0 == ((((char *)(p)) - (char *)0) & ((a)-1)))
@@ -60,6 +72,257 @@
 
 #define LTQ_EIP123_TMP_HACK
 
+#if CALCM_DMA_TASK_POOL_SIZE > 0
+// released tasks, ready for CALCM_DMA_Alloc
+static CALCM_DMA_Admin_t * CALCM_DMA_Pool[CALCM_DMA_TASK_POOL_SIZE];
+static unsigned int CALCM_DMA_PoolCount = 0;
+static SPAL_Mutex_t CALCM_DMA_PoolLock;
+static bool CALCM_DMA_Pool_IsInitialized = false;
+#endif
+
+#ifdef CALCM_DMA_THREAD_CONTEXT
+// resources kept for the next operation of a thread
+typedef struct
+{
+    CALCM_DMA_Admin_t * Task_p;
+
+    // a released bulk buffer, see CALAdapter_Bulk_Alloc
+    DMAResource_Handle_t Bulk_DMAHandle;
+    uint8_t * BulkBuffer_p;
+    uint32_t Bulk_Addr;
+    unsigned int BulkSize;
+} CALCM_DMA_ThreadContext_t;
+
+static pthread_key_t CALCM_DMA_ThreadKey;
+static bool CALCM_DMA_ThreadKey_IsInitialized = false;
+#endif
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_DMA_Destroy
+ *
+ * Releases the resources allocated by CALCM_DMA_Alloc and frees the task.
+ */
+static void
+CALCMLib_DMA_Destroy(
+        CALCM_DMA_Admin_t * Task_p)
+{
+    if (Task_p->InDCDMAHandle)
+        DMAResource_Release(Task_p->InDCDMAHandle);
+
+    if (Task_p->OutDCDMAHandle)
+        DMAResource_Release(Task_p->OutDCDMAHandle);
+
+    if (Task_p->Std_DMAHandle)
+        DMAResource_Release(Task_p->Std_DMAHandle);
+
+    SPAL_Memory_Free(Task_p);
+}
+
+
+#if CALCM_DMA_TASK_POOL_SIZE > 0
+/*----------------------------------------------------------------------------
+ * CALCMLib_DMA_Pool_Get
+ *
+ * Returns a task from the pool, or NULL when the pool is empty.
+ */
+static CALCM_DMA_Admin_t *
+CALCMLib_DMA_Pool_Get(void)
+{
+    CALCM_DMA_Admin_t * Task_p = NULL;
+
+    if (!CALCM_DMA_Pool_IsInitialized)
+        return NULL;
+
+    SPAL_Mutex_Lock(&CALCM_DMA_PoolLock);
+
+    if (CALCM_DMA_PoolCount > 0)
+        Task_p = CALCM_DMA_Pool[--CALCM_DMA_PoolCount];
+
+    SPAL_Mutex_UnLock(&CALCM_DMA_PoolLock);
+
+    return Task_p;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_DMA_Pool_Put
+ *
+ * Keeps a released task, reset with CALCMLib_DMA_Reset, in the pool.
+ *
+ * Returns false when the pool is full; the task must then be destroyed.
+ */
+static bool
+CALCMLib_DMA_Pool_Put(
+        CALCM_DMA_Admin_t * Task_p)
+{
+    bool fPut = false;
+
+    if (!CALCM_DMA_Pool_IsInitialized)
+        return false;
+
+    SPAL_Mutex_Lock(&CALCM_DMA_PoolLock);
+
+    if (CALCM_DMA_PoolCount < CALCM_DMA_TASK_POOL_SIZE)
+    {
+        CALCM_DMA_Pool[CALCM_DMA_PoolCount++] = Task_p;
+        fPut = true;
+    }
+
+    SPAL_Mutex_UnLock(&CALCM_DMA_PoolLock);
+
+    return fPut;
+}
+#endif /* CALCM_DMA_TASK_POOL_SIZE */
+
+
+#if (CALCM_DMA_TASK_POOL_SIZE > 0) || defined(CALCM_DMA_THREAD_CONTEXT)
+/*----------------------------------------------------------------------------
+ * CALCMLib_DMA_Reset
+ *
+ * Resets the per-operation state of a released task, for reuse. The
+ * standard DMA buffer, with the descriptor chains, and the descriptor chain
+ * caches are kept.
+ */
+static void
+CALCMLib_DMA_Reset(
+        CALCM_DMA_Admin_t * Task_p)
+{
+    memset(&Task_p->InDescriptor, 0, sizeof(Task_p->InDescriptor));
+    memset(&Task_p->OutDescriptor, 0, sizeof(Task_p->OutDescriptor));
+
+    Task_p->InBufDMAHandle = NULL;
+    Task_p->OutBufDMAHandle = NULL;
+
+    Task_p->BounceInputBuffer_p = NULL;
+    Task_p->LastOutputBuffer_p = NULL;
+    Task_p->BounceOutputBuffer_p = NULL;
+    Task_p->LastARC4State_p = NULL;
+
+    Task_p->LastTokenID_ByteOfs = 0;
+    Task_p->LastOutputByteCount = 0;
+
+    Task_p->Bulk_DMAHandle = NULL;
+    Task_p->BulkBuffer_p = NULL;
+    Task_p->Bulk_Addr = 0;
+    Task_p->BulkSize = 0;
+    Task_p->BulkOutputOfs = 0;
+
+    // the ARC4 state must not outlive the operation
+    memset(Task_p->ARC4StateBuffer_p, 0, EIP123_ARC4_STATE_BUF_SIZE);
+}
+#endif /* CALCM_DMA_TASK_POOL_SIZE || CALCM_DMA_THREAD_CONTEXT */
+
+
+#ifdef CALCM_DMA_THREAD_CONTEXT
+/*----------------------------------------------------------------------------
+ * CALCMLib_DMA_ThreadContext_Get
+ *
+ * Returns the context of the calling thread. With fCreate, the context is
+ * created when the thread does not have one yet. Returns NULL when there is
+ * no context.
+ */
+static CALCM_DMA_ThreadContext_t *
+CALCMLib_DMA_ThreadContext_Get(
+        const bool fCreate)
+{
+    CALCM_DMA_ThreadContext_t * Ctx_p;
+
+    if (!CALCM_DMA_ThreadKey_IsInitialized)
+        return NULL;
+
+    Ctx_p = pthread_getspecific(CALCM_DMA_ThreadKey);
+    if (Ctx_p != NULL || !fCreate)
+        return Ctx_p;
+
+    Ctx_p = SPAL_Memory_Calloc(1, sizeof(CALCM_DMA_ThreadContext_t));
+    if (Ctx_p == NULL)
+        return NULL;
+
+    if (pthread_setspecific(CALCM_DMA_ThreadKey, Ctx_p) != 0)
+    {
+        SPAL_Memory_Free(Ctx_p);
+        return NULL;
+    }
+
+    return Ctx_p;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_DMA_ThreadContext_Release
+ *
+ * Called when a thread with a context exits. The task goes to the pool
+ * when there is room.
+ */
+static void
+CALCMLib_DMA_ThreadContext_Release(
+        void * p)
+{
+    CALCM_DMA_ThreadContext_t * Ctx_p = p;
+
+    if (Ctx_p->Bulk_DMAHandle != NULL)
+        DMAResource_Release(Ctx_p->Bulk_DMAHandle);
+
+    if (Ctx_p->Task_p != NULL)
+    {
+#if CALCM_DMA_TASK_POOL_SIZE > 0
+        if (!CALCMLib_DMA_Pool_Put(Ctx_p->Task_p))
+#endif
+            CALCMLib_DMA_Destroy(Ctx_p->Task_p);
+    }
+
+    SPAL_Memory_Free(Ctx_p);
+}
+#endif /* CALCM_DMA_THREAD_CONTEXT */
+
+
+/*----------------------------------------------------------------------------
+ * CALCM_DMA_Pool_Init
+ *
+ * Until this function is called, every task is allocated by CALCM_DMA_Alloc
+ * and freed by CALCM_DMA_Free.
+ */
+int
+CALCM_DMA_Pool_Init(void)
+{
+#if CALCM_DMA_TASK_POOL_SIZE > 0
+    if (!CALCM_DMA_Pool_IsInitialized)
+    {
+        if (SPAL_Mutex_Init(&CALCM_DMA_PoolLock) != SPAL_SUCCESS)
+        {
+            LOG_WARN(
+                "CALCM_DMA_Pool_Init: "
+                "Failed to create lock\n");
+            return -1;
+        }
+
+        CALCM_DMA_PoolCount = 0;
+        CALCM_DMA_Pool_IsInitialized = true;
+    }
+#endif
+
+#ifdef CALCM_DMA_THREAD_CONTEXT
+    if (!CALCM_DMA_ThreadKey_IsInitialized)
+    {
+        if (pthread_key_create(
+                    &CALCM_DMA_ThreadKey,
+                    CALCMLib_DMA_ThreadContext_Release) != 0)
+        {
+            LOG_WARN(
+                "CALCM_DMA_Pool_Init: "
+                "Failed to create thread key\n");
+            return -2;
+        }
+
+        CALCM_DMA_ThreadKey_IsInitialized = true;
+    }
+#endif
+
+    return 0;
+}
+
+
 /*----------------------------------------------------------------------------
  * CALCM_DMA_Alloc
  *
@@ -70,7 +333,8 @@
  * (DMA descriptor chains, TokenID Word and ARC4 state).
  *
  * Returns a pointer to the dynamically allocated instance that must be freed
- * by calling CALCM_DMA_Free(), or NULL in case of an error.
+ * by calling CALCM_DMA_Free(), or NULL in case of an error. When available,
+ * a task released earlier is taken from the pool instead.
  */
 CALCM_DMA_Admin_t *
 CALCM_DMA_Alloc(void)
@@ -93,6 +357,26 @@ CALCM_DMA_Alloc(void)
         return NULL;
     }
 
+#ifdef CALCM_DMA_THREAD_CONTEXT
+    {
+        CALCM_DMA_ThreadContext_t * const Ctx_p =
+                                CALCMLib_DMA_ThreadContext_Get(false);
+
+        if (Ctx_p != NULL && Ctx_p->Task_p != NULL)
+        {
+            Task_p = Ctx_p->Task_p;
+            Ctx_p->Task_p = NULL;
+            return Task_p;
+        }
+    }
+#endif
+
+#if CALCM_DMA_TASK_POOL_SIZE > 0
+    Task_p = CALCMLib_DMA_Pool_Get();
+    if (Task_p != NULL)
+        return Task_p;
+#endif
+
     // allocate the administration structure
     Task_p = SPAL_Memory_Calloc(1, sizeof(CALCM_DMA_Admin_t));
     if (Task_p == NULL)
@@ -191,7 +475,7 @@ CALCM_DMA_Alloc(void)
         result);
     IDENTIFIER_NOT_USED(AllocCase);     // avoids warning when LOG_CRIT is off
 
-    CALCM_DMA_Free(Task_p);
+    CALCMLib_DMA_Destroy(Task_p);
 
     return NULL;
 }
@@ -199,22 +483,154 @@ CALCM_DMA_Alloc(void)
 
 /*----------------------------------------------------------------------------
  * CALCM_DMA_Free
+ *
+ * The task is kept for the next operation of the calling thread, or in the
+ * pool, when there is room; otherwise it is freed. The bulk buffer is also
+ * kept for the calling thread (see CALCM_DMA_THREAD_BULK_MAX).
  */
 void
 CALCM_DMA_Free(
         CALCM_DMA_Admin_t * Task_p)
 {
+#ifdef CALCM_DMA_THREAD_CONTEXT
+    CALCM_DMA_ThreadContext_t * const Ctx_p =
+                                CALCMLib_DMA_ThreadContext_Get(true);
+#endif
+
+    if (Task_p->Bulk_DMAHandle)
+    {
+        // the shared buffer may have held key material
+        memset(Task_p->BulkBuffer_p, 0, Task_p->BulkSize);
+
+#if defined(CALCM_DMA_THREAD_CONTEXT) && (CALCM_DMA_THREAD_BULK_MAX > 0)
+        // keep the largest buffer that does not exceed the maximum
+        if (Ctx_p != NULL &&
+            Task_p->BulkSize <= CALCM_DMA_THREAD_BULK_MAX &&
+            (Ctx_p->Bulk_DMAHandle == NULL ||
+             Ctx_p->BulkSize < Task_p->BulkSize))
+        {
+            if (Ctx_p->Bulk_DMAHandle != NULL)
+                DMAResource_Release(Ctx_p->Bulk_DMAHandle);
+
+            Ctx_p->Bulk_DMAHandle = Task_p->Bulk_DMAHandle;
+            Ctx_p->BulkBuffer_p = Task_p->BulkBuffer_p;
+            Ctx_p->Bulk_Addr = Task_p->Bulk_Addr;
+            Ctx_p->BulkSize = Task_p->BulkSize;
+        }
+        else
+#endif
+        {
+            DMAResource_Release(Task_p->Bulk_DMAHandle);
+        }
+    }
+
+#ifdef CALCM_DMA_THREAD_CONTEXT
+    if (Ctx_p != NULL && Ctx_p->Task_p == NULL)
+    {
+        CALCMLib_DMA_Reset(Task_p);
+        Ctx_p->Task_p = Task_p;
+        return;
+    }
+#endif
+
+#if CALCM_DMA_TASK_POOL_SIZE > 0
+    CALCMLib_DMA_Reset(Task_p);
+    if (CALCMLib_DMA_Pool_Put(Task_p))
+        return;
+#endif
+
     // free the resources allocated by CALCM_DMA_Alloc
-    if (Task_p->InDCDMAHandle)
-        DMAResource_Release(Task_p->InDCDMAHandle);
+    CALCMLib_DMA_Destroy(Task_p);
+}
 
-    if (Task_p->OutDCDMAHandle)
-        DMAResource_Release(Task_p->OutDCDMAHandle);
 
-    if (Task_p->Std_DMAHandle)
-        DMAResource_Release(Task_p->Std_DMAHandle);
+/*----------------------------------------------------------------------------
+ * CALAdapterLib_PopulateDescriptorChain
+ *
+ * Populates the input (fIsInput) or output descriptor chain of the task for
+ * one fragment, see EIP123_DescriptorChain_Populate.
+ *
+ * With CALCM_DMA_DC_CACHE_ENTRIES, a chain populated earlier for the same
+ * fragment, block size and TokenID address is reused. The chain only
+ * depends on these parameters and on the (fixed) chain buffer of the task.
+ * A chain that continues in the chain buffer is only reused when the buffer
+ * was not written for another chain since (same generation).
+ */
+static EIP123_Status_t
+CALAdapterLib_PopulateDescriptorChain(
+        CALCM_DMA_Admin_t * const Task_p,
+        const bool fIsInput,
+        const EIP123_Fragment_t * const Fragment_p,
+        const unsigned int AlgorithmicBlockSize,
+        const uint32_t TokenIDPhysAddr)
+{
+    EIP123_DescriptorChain_t * const Descriptor_p =
+        fIsInput ? &Task_p->InDescriptor : &Task_p->OutDescriptor;
+    EIP123_Status_t res12x;
+#if CALCM_DMA_DC_CACHE_ENTRIES > 0
+    CALCM_DMA_DCCache_t * const Cache_p =
+        fIsInput ? &Task_p->InDCCache : &Task_p->OutDCCache;
+    CALCM_DMA_DCCacheEntry_t * Entry_p = NULL;
+    unsigned int i;
 
-    SPAL_Memory_Free(Task_p);
+    for (i = 0; i < CALCM_DMA_DC_CACHE_ENTRIES; i++)
+    {
+        CALCM_DMA_DCCacheEntry_t * const p = &Cache_p->Entries[i];
+
+        if (p->Length != 0 &&
+            p->Length == Fragment_p->Length &&
+            p->StartAddress == Fragment_p->StartAddress &&
+            p->AlgorithmicBlockSize == AlgorithmicBlockSize &&
+            p->TokenIDPhysAddr == TokenIDPhysAddr)
+        {
+            if (p->Descriptor.DMAHandle == NULL ||
+                p->Generation == Cache_p->Generation)
+            {
+                *Descriptor_p = p->Descriptor;
+                return EIP123_STATUS_SUCCESS;
+            }
+
+            // chain buffer was overwritten; populate into this entry
+            Entry_p = p;
+            break;
+        }
+    }
+#endif /* CALCM_DMA_DC_CACHE_ENTRIES */
+
+    res12x = EIP123_DescriptorChain_Populate(
+                    Descriptor_p,
+                    fIsInput ? Task_p->InDCDMAHandle : Task_p->OutDCDMAHandle,
+                    (uint32_t)(uintptr_t)
+                        (fIsInput ? Task_p->InDCAddr_p : Task_p->OutDCAddr_p),
+                    fIsInput,
+                    /*Fragment count:*/1,
+                    Fragment_p,
+                    AlgorithmicBlockSize,
+                    TokenIDPhysAddr);
+
+#if CALCM_DMA_DC_CACHE_ENTRIES > 0
+    if (res12x == EIP123_STATUS_SUCCESS)
+    {
+        if (Descriptor_p->DMAHandle != NULL)
+            Cache_p->Generation++;
+
+        if (Entry_p == NULL)
+        {
+            Entry_p = &Cache_p->Entries[Cache_p->NextEntry];
+            Cache_p->NextEntry =
+                (Cache_p->NextEntry + 1) % CALCM_DMA_DC_CACHE_ENTRIES;
+        }
+
+        Entry_p->Descriptor = *Descriptor_p;
+        Entry_p->StartAddress = Fragment_p->StartAddress;
+        Entry_p->Length = Fragment_p->Length;
+        Entry_p->AlgorithmicBlockSize = AlgorithmicBlockSize;
+        Entry_p->TokenIDPhysAddr = TokenIDPhysAddr;
+        Entry_p->Generation = Cache_p->Generation;
+    }
+#endif /* CALCM_DMA_DC_CACHE_ENTRIES */
+
+    return res12x;
 }
 
 
@@ -299,6 +715,9 @@ CALAdapter_InputBufferPreDMA(
             goto fail;
         }
 
+        METRICS_INC(BounceIn);
+        METRICS_ADD(BytesCopiedIn, InputByteCount);
+
         // Copy original buffer to the bounce buffer;
         // Input is seen as a raw byte stream, hence
         // DMAResource_WriteArray is not applicable.
@@ -354,12 +773,9 @@ CALAdapter_InputBufferPreDMA(
     Fragment_p->StartAddress = (uint32_t)(uintptr_t)DMAResAddrPair.Address_p;
     Fragment_p->Length = InputByteCount;
 
-    res12x = EIP123_DescriptorChain_Populate(
-                    &Task_p->InDescriptor,
-                    Task_p->InDCDMAHandle,
-                    (uint32_t)(uintptr_t)Task_p->InDCAddr_p,
+    res12x = CALAdapterLib_PopulateDescriptorChain(
+                    Task_p,
                     /*Input:*/true,
-                    /*Fragment count:*/1,
                     Fragment_p,
                     AlgorithmicBlockSize,
                     /*TokenID Address, not used:*/0);
@@ -497,6 +913,8 @@ CALAdapter_OutputBufferPreDMA(
                     goto fail;
                 }
 
+                METRICS_INC(BounceOut);
+
                 // Copy original buffer to the bounce buffer
                 Task_p->BounceOutputBuffer_p = DMAResAddrPair.Address_p;
             }
@@ -522,12 +940,9 @@ CALAdapter_OutputBufferPreDMA(
             Fragment_p->Length = OutputByteCount;
         }
 
-        res12x = EIP123_DescriptorChain_Populate(
-                      &Task_p->OutDescriptor,
-                      Task_p->OutDCDMAHandle,
-                      (uint32_t)(uintptr_t)Task_p->OutDCAddr_p,
+        res12x = CALAdapterLib_PopulateDescriptorChain(
+                      Task_p,
                       /*Input:*/false,
-                      /*Fragment count:*/1,
                       Fragment_p,
                       AlgorithmicBlockSize,
                       #ifdef LTQ_EIP123_TMP_HACK_CRYPTO_NOTOKENIDCHK
@@ -813,6 +1228,8 @@ CALAdapter_PostDMA(
                 Task_p->LastOutputBuffer_p,
                 Task_p->BounceOutputBuffer_p,
                 Task_p->LastOutputByteCount);
+
+            METRICS_ADD(BytesCopiedOut, Task_p->LastOutputByteCount);
         }
 
         // Release DMA resource for Output Buffer,
@@ -973,6 +1390,8 @@ CALAdapter_CryptoNopWrap_FinalizeOutput(
     if (Task_p->TokenID_DMAHandle == NULL)
         return SFZCRYPTO_INVALID_PARAMETER;
 
+    METRICS_INC(TokenIDWaits);
+
     // wait for the TokenID value to "arrive", in case DMA is delayed
     do
     {
@@ -988,6 +1407,7 @@ CALAdapter_CryptoNopWrap_FinalizeOutput(
             break;  // from the while
 
         // not yet arrived; sleep a bit
+        METRICS_INC(TokenIDWaitLoops);
         SPAL_SleepMS(CALCM_POLLING_DELAY_MS);
         LOG_INFO("CAL Adapter: Waiting for TokenID\n");
     }
@@ -1000,6 +1420,7 @@ CALAdapter_CryptoNopWrap_FinalizeOutput(
     }
     else
     {
+        METRICS_INC(TokenIDTimeouts);
         return SFZCRYPTO_INTERNAL_ERROR;
     }
 #endif /* LTQ_EIP123_TMP_HACK_CRYPTO_NOTOKENIDCHK */
@@ -1076,6 +1497,8 @@ CALAdapter_RandomWrapNvm_PrepareOutput(
 
         Task_p->BounceOutputBuffer_p = DMAResAddrPair.Address_p;
         Task_p->OutBufDMAHandle = DMAHandle;
+
+        METRICS_INC(BounceOut);
     }
 
     // translate Output Buffer address
@@ -1107,12 +1530,9 @@ CALAdapter_RandomWrapNvm_PrepareOutput(
         Frag.StartAddress = (uint32_t)(uintptr_t)DMAResAddrPair.Address_p;
         Frag.Length = OutBufSize_Aligned;
 
-        res12x = EIP123_DescriptorChain_Populate(
-                          &Task_p->OutDescriptor,
-                          Task_p->OutDCDMAHandle,
-                          (uint32_t)(uintptr_t)Task_p->OutDCAddr_p,
+        res12x = CALAdapterLib_PopulateDescriptorChain(
+                          Task_p,
                           /*Input:*/false,
-                          /*Fragment count:*/1,
                           &Frag,
                           /*AlgorithmicBlockSize:*/4,
                           /*TokenID Address:*/0);  // only output address needed
@@ -1155,46 +1575,29 @@ CALAdapter_RandomWrapNvm_PrepareOutput(
 
 
 /*----------------------------------------------------------------------------
- * CALAdapter_RandomWrapNvm_FinalizeOutput
- *
- * This routine is used by symm_crypt and nop services (that both have input
- * and output buffers) to finalize the output after the engine has completed
- * the operation and the DMA has written the output.
- *
- * First, the WriteTokenID word is polled until it is written. This proves
- * that all DMA-written data has actually reached system memory. This step is
- * protected with a timeout.
+ * CALAdapterLib_WaitOutputTokenID
  *
- * Memory coherency actions are initiated to make sure the output buffers are
- * not cached somewhere.
- *
- * If the output is unaligned, the data is copied from the bounce buffer to
- * the final output buffer.
- *
- * Returns SFZCRYPTO_SUCCESS upon success, otherwise one of the appropriate
- * error codes.
+ * Polls the TokenID word that the CM writes at ByteOfs in the output DMA
+ * buffer, directly after the output data. Once it has arrived, all
+ * DMA-written data has reached system memory. Protected with a timeout.
  */
-SfzCryptoStatus
-CALAdapter_RandomWrapNvm_FinalizeOutput(
-        CALCM_DMA_Admin_t * const Task_p)
+static bool
+CALAdapterLib_WaitOutputTokenID(
+        DMAResource_Handle_t Handle,
+        const unsigned int ByteOfs)
 {
     uint32_t value = 0; // Must not be equal to EIP123_TOKENID_VALUE
     int LoopsLimiter = CALCM_POLLING_MAXLOOPS;
 
-    IDENTIFIER_NOT_USED(Task_p);
+    METRICS_INC(TokenIDWaits);
 
     // wait for the TokenID value to "arrive", in case DMA is delayed
     do
     {
         // check TokenID (part of output buffer)
-        DMAResource_PostDMA(
-                    Task_p->OutBufDMAHandle,
-                    Task_p->LastTokenID_ByteOfs,
-                    4);
+        DMAResource_PostDMA(Handle, ByteOfs, 4);
 
-        value = DMAResource_Read32(
-                    Task_p->OutBufDMAHandle,
-                    (Task_p->LastTokenID_ByteOfs / 4));
+        value = DMAResource_Read32(Handle, (ByteOfs / 4));
 
         // see if the tokenID has arrived
         #ifdef LTQ_EIP123_TMP_HACK
@@ -1206,17 +1609,53 @@ CALAdapter_RandomWrapNvm_FinalizeOutput(
         #endif /* LTQ_EIP123_TMP_HACK */
 
         // not yet arrived; sleep a bit
+        METRICS_INC(TokenIDWaitLoops);
         SPAL_SleepMS(CALCM_POLLING_DELAY_MS);
         LOG_INFO("CAL Adapter: Waiting for TokenID\n");
     }
     while(--LoopsLimiter > 0);
 
+    if (LoopsLimiter == 0)
+        METRICS_INC(TokenIDTimeouts);
+
     #ifdef LTQ_EIP123_TMP_HACK
-    if (value != 0xFE5A0000)
+    return (value == 0xFE5A0000);
     #else /* LTQ_EIP123_TMP_HACK */
-    if (value != CAL_TOKENID_VALUE)
+    return (value == CAL_TOKENID_VALUE);
     #endif /* LTQ_EIP123_TMP_HACK */
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALAdapter_RandomWrapNvm_FinalizeOutput
+ *
+ * This routine is used by symm_crypt and nop services (that both have input
+ * and output buffers) to finalize the output after the engine has completed
+ * the operation and the DMA has written the output.
+ *
+ * First, the WriteTokenID word is polled until it is written. This proves
+ * that all DMA-written data has actually reached system memory. This step is
+ * protected with a timeout.
+ *
+ * Memory coherency actions are initiated to make sure the output buffers are
+ * not cached somewhere.
+ *
+ * If the output is unaligned, the data is copied from the bounce buffer to
+ * the final output buffer.
+ *
+ * Returns SFZCRYPTO_SUCCESS upon success, otherwise one of the appropriate
+ * error codes.
+ */
+SfzCryptoStatus
+CALAdapter_RandomWrapNvm_FinalizeOutput(
+        CALCM_DMA_Admin_t * const Task_p)
+{
+    if (!CALAdapterLib_WaitOutputTokenID(
+                    Task_p->OutBufDMAHandle,
+                    Task_p->LastTokenID_ByteOfs))
+    {
         return SFZCRYPTO_INTERNAL_ERROR;
+    }
 
     CALAdapter_PostDMA(Task_p);
 
@@ -1224,4 +1663,496 @@ CALAdapter_RandomWrapNvm_FinalizeOutput(
 }
 
 
+/*----------------------------------------------------------------------------
+ * CALAdapter_Bulk_Alloc
+ *
+ * This routine allocates one DMA buffer that is used for the input, the
+ * output and the TokenID of a series of operations, each with at most
+ * MaxInputByteCount bytes of input and MaxOutputByteCount bytes of output.
+ * This avoids allocating (or registering) and releasing buffers for every
+ * operation. The buffer is released by CALCM_DMA_Free, which can keep it
+ * for the next series of the calling thread.
+ */
+SfzCryptoStatus
+CALAdapter_Bulk_Alloc(
+        CALCM_DMA_Admin_t * const Task_p,
+        const unsigned int MaxInputByteCount,
+        const unsigned int MaxOutputByteCount)
+{
+    DMAResource_Properties_t DMAResProp = {0};
+    DMAResource_AddrPair_t DMAResAddrPair;
+    DMAResource_Handle_t DMAHandle = {0};
+    int result;
+
+    if (Task_p->Bulk_DMAHandle != NULL)
+        return SFZCRYPTO_INVALID_PARAMETER;
+
+    // input, output and TokenID each start at a 32bit word
+    Task_p->BulkOutputOfs = (MaxInputByteCount + 3) & (~3);
+
+    DMAResProp.Size = Task_p->BulkOutputOfs +
+                      ((MaxOutputByteCount + 3) & (~3)) + 4;
+    DMAResProp.Alignment = 4;
+    DMAResProp.Bank = CALCM_DMA_BANK;
+
+#if defined(CALCM_DMA_THREAD_CONTEXT) && (CALCM_DMA_THREAD_BULK_MAX > 0)
+    {
+        // use the buffer kept for the calling thread, when large enough
+        CALCM_DMA_ThreadContext_t * const Ctx_p =
+                                CALCMLib_DMA_ThreadContext_Get(false);
+
+        if (Ctx_p != NULL &&
+            Ctx_p->Bulk_DMAHandle != NULL &&
+            Ctx_p->BulkSize >= DMAResProp.Size)
+        {
+            Task_p->Bulk_DMAHandle = Ctx_p->Bulk_DMAHandle;
+            Task_p->BulkBuffer_p = Ctx_p->BulkBuffer_p;
+            Task_p->Bulk_Addr = Ctx_p->Bulk_Addr;
+            Task_p->BulkSize = Ctx_p->BulkSize;
+
+            Ctx_p->Bulk_DMAHandle = NULL;
+
+            return SFZCRYPTO_SUCCESS;
+        }
+    }
+#endif
+
+    result = DMAResource_Alloc(
+                        DMAResProp,
+                        &DMAResAddrPair,
+                        &DMAHandle);
+
+    if (result < 0)
+    {
+        LOG_INFO(
+            "CALAdapter_Bulk_Alloc: "
+            "Failed to allocate shared buffer: %d (Size=0x%x)\n",
+            result,
+            DMAResProp.Size);
+
+        return SFZCRYPTO_NO_MEMORY;
+    }
+
+    Task_p->Bulk_DMAHandle = DMAHandle;
+    Task_p->BulkBuffer_p = DMAResAddrPair.Address_p;
+    Task_p->BulkSize = DMAResProp.Size;
+
+    result = DMAResource_Translate(
+                            DMAHandle,
+                            DMARES_DOMAIN_EIP12xDMA,
+                            &DMAResAddrPair);
+    if (result < 0)
+    {
+        LOG_INFO(
+            "CALAdapter_Bulk_Alloc: "
+            "Address translation failed: %d\n",
+            result);
+
+        DMAResource_Release(DMAHandle);
+
+        Task_p->Bulk_DMAHandle = NULL;
+        Task_p->BulkBuffer_p = NULL;
+
+        return SFZCRYPTO_INTERNAL_ERROR;
+    }
+
+    Task_p->Bulk_Addr = (uint32_t)(uintptr_t)DMAResAddrPair.Address_p;
+
+    return SFZCRYPTO_SUCCESS;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALAdapter_Bulk_PreDMA
+ *
+ * This routine copies the input into the buffer allocated by
+ * CALAdapter_Bulk_Alloc and populates the input and output descriptor
+ * chains. As for CALAdapter_RandomWrapNvm_PrepareOutput, the TokenID is
+ * written by the CM directly after the output.
+ */
+SfzCryptoStatus
+CALAdapter_Bulk_PreDMA(
+        CALCM_DMA_Admin_t * const Task_p,
+        unsigned int AlgorithmicBlockSize,
+        const unsigned int InputByteCount,
+        const uint8_t * InputBuffer_p,
+        const unsigned int OutputByteCount)
+{
+    EIP123_Fragment_t Frag;
+    EIP123_Status_t res12x;
+    unsigned int OutBufSize_Aligned;
+
+    OutBufSize_Aligned = (OutputByteCount + 3) & (~3);
+
+    if (Task_p->Bulk_DMAHandle == NULL ||
+        InputByteCount > Task_p->BulkOutputOfs ||
+        Task_p->BulkOutputOfs + OutBufSize_Aligned + 4 > Task_p->BulkSize)
+    {
+        return SFZCRYPTO_INVALID_PARAMETER;
+    }
+
+    memcpy(Task_p->BulkBuffer_p, InputBuffer_p, InputByteCount);
+    METRICS_ADD(BytesCopiedIn, InputByteCount);
+
+    Frag.StartAddress = Task_p->Bulk_Addr;
+    Frag.Length = InputByteCount;
+
+    res12x = CALAdapterLib_PopulateDescriptorChain(
+                    Task_p,
+                    /*Input:*/true,
+                    &Frag,
+                    AlgorithmicBlockSize,
+                    /*TokenID Address, not used:*/0);
+
+    if (res12x == EIP123_STATUS_SUCCESS)
+    {
+        Frag.StartAddress = Task_p->Bulk_Addr + Task_p->BulkOutputOfs;
+        Frag.Length = OutBufSize_Aligned + 4;
+
+        res12x = CALAdapterLib_PopulateDescriptorChain(
+                        Task_p,
+                        /*Input:*/false,
+                        &Frag,
+                        /*AlgorithmicBlockSize:*/4,
+                        /*TokenID Address:*/0);  // only output address needed
+    }
+
+    if (res12x != EIP123_STATUS_SUCCESS)
+    {
+        LOG_INFO(
+            "CALAdapter_Bulk_PreDMA: "
+            "Populate descriptor chain failed: %d\n",
+            res12x);
+
+        return SFZCRYPTO_INTERNAL_ERROR;
+    }
+
+    // set the initial TokenID value, in the word after the output
+    Task_p->LastTokenID_ByteOfs = Task_p->BulkOutputOfs + OutBufSize_Aligned;
+
+    DMAResource_Write32(
+            Task_p->Bulk_DMAHandle,
+            (Task_p->LastTokenID_ByteOfs / 4),
+            (uint32_t)~CAL_TOKENID_VALUE);
+
+    // Ensure data coherence for the input, output and TokenID
+    DMAResource_PreDMA(
+            Task_p->Bulk_DMAHandle,
+            0,
+            Task_p->LastTokenID_ByteOfs + 4);
+
+    return SFZCRYPTO_SUCCESS;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALAdapter_Bulk_PostDMA
+ *
+ * This routine waits for the TokenID that follows the output and then
+ * copies the output from the buffer allocated by CALAdapter_Bulk_Alloc.
+ */
+SfzCryptoStatus
+CALAdapter_Bulk_PostDMA(
+        CALCM_DMA_Admin_t * const Task_p,
+        const unsigned int OutputByteCount,
+        uint8_t * OutputBuffer_p)
+{
+    if (!CALAdapterLib_WaitOutputTokenID(
+                    Task_p->Bulk_DMAHandle,
+                    Task_p->LastTokenID_ByteOfs))
+    {
+        return SFZCRYPTO_INTERNAL_ERROR;
+    }
+
+    // Ensure data coherence for the output
+    DMAResource_PostDMA(
+            Task_p->Bulk_DMAHandle,
+            Task_p->BulkOutputOfs,
+            OutputByteCount);
+
+    memcpy(
+        OutputBuffer_p,
+        Task_p->BulkBuffer_p + Task_p->BulkOutputOfs,
+        OutputByteCount);
+
+    METRICS_ADD(BytesCopiedOut, OutputByteCount);
+
+    return SFZCRYPTO_SUCCESS;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALAdapterLib_CopyLarge
+ *
+ * memcpy for (large) copies into or out of a bounce buffer. Where the CPU
+ * offers streaming stores, blocks of at least CALCM_DMA_STREAMING_COPY_MIN
+ * bytes are written around the cache: the data is not read back by the CPU
+ * soon, so it would only evict more useful cache lines.
+ */
+static void
+CALAdapterLib_CopyLarge(
+        uint8_t * Dst_p,
+        const uint8_t * Src_p,
+        unsigned int ByteCount)
+{
+#ifdef CALCM_DMA_STREAMING_COPY
+    if (ByteCount >= CALCM_DMA_STREAMING_COPY_MIN)
+    {
+        // copy up to the first 16-byte aligned destination address
+        unsigned int Head = (16 - ((uintptr_t)Dst_p & 15)) & 15;
+
+        memcpy(Dst_p, Src_p, Head);
+        Dst_p += Head;
+        Src_p += Head;
+        ByteCount -= Head;
+
+        while (ByteCount >= 64)
+        {
+            __m128i a = _mm_loadu_si128((const __m128i *)(Src_p + 0));
+            __m128i b = _mm_loadu_si128((const __m128i *)(Src_p + 16));
+            __m128i c = _mm_loadu_si128((const __m128i *)(Src_p + 32));
+            __m128i d = _mm_loadu_si128((const __m128i *)(Src_p + 48));
+
+            _mm_stream_si128((__m128i *)(Dst_p + 0), a);
+            _mm_stream_si128((__m128i *)(Dst_p + 16), b);
+            _mm_stream_si128((__m128i *)(Dst_p + 32), c);
+            _mm_stream_si128((__m128i *)(Dst_p + 48), d);
+
+            Dst_p += 64;
+            Src_p += 64;
+            ByteCount -= 64;
+        }
+
+        // make the streaming stores globally visible
+        _mm_sfence();
+    }
+#endif /* CALCM_DMA_STREAMING_COPY */
+
+    memcpy(Dst_p, Src_p, ByteCount);
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALAdapter_IsBounced
+ *
+ * Returns true when CALAdapter_PreDMA would bounce the buffer, i.e. it is
+ * not aligned or it cannot be registered for DMA.
+ */
+bool
+CALAdapter_IsBounced(
+        const uint8_t * Buffer_p,
+        const unsigned int ByteCount)
+{
+#ifdef CALCM_DMA_BOUNCE_ALWAYS
+    IDENTIFIER_NOT_USED(Buffer_p);
+    IDENTIFIER_NOT_USED(ByteCount);
+
+    return true;
+#else
+    DMAResource_Properties_t DMAResProp = {0};
+    DMAResource_AddrPair_t DMAResAddrPair;
+    DMAResource_Handle_t DMAHandle = {0};
+
+    if (!IS_ALIGNED(Buffer_p, CALCM_DMA_ALIGNMENT))
+        return true;
+
+    DMAResProp.Size = (ByteCount + 3) & (~3);
+    DMAResProp.Alignment = CALCM_DMA_ALIGNMENT;
+    DMAResProp.Bank = CALCM_DMA_BANK;
+
+    DMAResAddrPair.Address_p = (void *)Buffer_p;
+    DMAResAddrPair.Domain = DMARES_DOMAIN_HOST;
+
+    if (DMAResource_CheckAndRegister(
+                            DMAResProp,
+                            DMAResAddrPair,
+                            'R',
+                            &DMAHandle) < 0)
+    {
+        return true;
+    }
+
+    DMAResource_Release(DMAHandle);
+
+    return false;
+#endif /* CALCM_DMA_BOUNCE_ALWAYS */
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALAdapter_Pipeline_Alloc
+ *
+ * Allocates two segment buffers (slots) for processing bounced data in
+ * segments, with the CALAdapter_Bulk buffer: each slot holds at most
+ * SegmentByteCount bytes that are processed in place, followed by the
+ * TokenID. The input of the next segment is copied into one slot, and the
+ * output of the previous segment copied out of it, while the CM works on
+ * the segment in the other slot.
+ */
+SfzCryptoStatus
+CALAdapter_Pipeline_Alloc(
+        CALCM_DMA_Admin_t * const Task_p,
+        const unsigned int SegmentByteCount)
+{
+    // slot 0 is the Bulk input, slot 1 the Bulk output
+    return CALAdapter_Bulk_Alloc(
+                        Task_p,
+                        SegmentByteCount + 4,
+                        SegmentByteCount + 4);
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALAdapter_Pipeline_CopyIn
+ *
+ * Copies the input of a segment into a slot, see CALAdapter_Pipeline_Alloc.
+ * This can be done while the CM processes the other slot.
+ */
+void
+CALAdapter_Pipeline_CopyIn(
+        CALCM_DMA_Admin_t * const Task_p,
+        const unsigned int Slot,
+        const uint8_t * InputBuffer_p,
+        const unsigned int ByteCount)
+{
+    const unsigned int SlotOfs = Slot * Task_p->BulkOutputOfs;
+
+    CALAdapterLib_CopyLarge(
+            Task_p->BulkBuffer_p + SlotOfs,
+            InputBuffer_p,
+            ByteCount);
+
+    METRICS_ADD(BytesCopiedIn, ByteCount);
+
+    // Ensure data coherence for the input
+    DMAResource_PreDMA(Task_p->Bulk_DMAHandle, SlotOfs, ByteCount);
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALAdapter_Pipeline_PreDMA
+ *
+ * Populates the input and output descriptor chains for processing the
+ * segment in a slot in place, with the TokenID directly after the output.
+ * The descriptor chains are shared by both slots, so this can only be done
+ * when the CM has completed the previous segment.
+ */
+SfzCryptoStatus
+CALAdapter_Pipeline_PreDMA(
+        CALCM_DMA_Admin_t * const Task_p,
+        const unsigned int Slot,
+        unsigned int AlgorithmicBlockSize,
+        const unsigned int ByteCount)
+{
+    const unsigned int SlotOfs = Slot * Task_p->BulkOutputOfs;
+    const unsigned int BufSize_Aligned = (ByteCount + 3) & (~3);
+    EIP123_Fragment_t Frag;
+    EIP123_Status_t res12x;
+
+    if (Task_p->Bulk_DMAHandle == NULL ||
+        Slot > 1 ||
+        BufSize_Aligned + 4 > Task_p->BulkOutputOfs)
+    {
+        return SFZCRYPTO_INVALID_PARAMETER;
+    }
+
+    Frag.StartAddress = Task_p->Bulk_Addr + SlotOfs;
+    Frag.Length = ByteCount;
+
+    res12x = CALAdapterLib_PopulateDescriptorChain(
+                    Task_p,
+                    /*Input:*/true,
+                    &Frag,
+                    AlgorithmicBlockSize,
+                    /*TokenID Address, not used:*/0);
+
+    if (res12x == EIP123_STATUS_SUCCESS)
+    {
+        Frag.Length = BufSize_Aligned + 4;
+
+        res12x = CALAdapterLib_PopulateDescriptorChain(
+                        Task_p,
+                        /*Input:*/false,
+                        &Frag,
+                        /*AlgorithmicBlockSize:*/4,
+                        /*TokenID Address:*/0);  // only output address needed
+    }
+
+    if (res12x != EIP123_STATUS_SUCCESS)
+    {
+        LOG_INFO(
+            "CALAdapter_Pipeline_PreDMA: "
+            "Populate descriptor chain failed: %d\n",
+            res12x);
+
+        return SFZCRYPTO_INTERNAL_ERROR;
+    }
+
+    // set the initial TokenID value, in the word after the output
+    Task_p->LastTokenID_ByteOfs = SlotOfs + BufSize_Aligned;
+
+    DMAResource_Write32(
+            Task_p->Bulk_DMAHandle,
+            (Task_p->LastTokenID_ByteOfs / 4),
+            (uint32_t)~CAL_TOKENID_VALUE);
+
+    DMAResource_PreDMA(
+            Task_p->Bulk_DMAHandle,
+            Task_p->LastTokenID_ByteOfs,
+            4);
+
+    return SFZCRYPTO_SUCCESS;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALAdapter_Pipeline_PostDMA
+ *
+ * Waits for the TokenID that follows the output of the segment in a slot,
+ * after the CM has returned the result token for it.
+ */
+SfzCryptoStatus
+CALAdapter_Pipeline_PostDMA(
+        CALCM_DMA_Admin_t * const Task_p,
+        const unsigned int Slot,
+        const unsigned int ByteCount)
+{
+    const unsigned int SlotOfs = Slot * Task_p->BulkOutputOfs;
+
+    if (!CALAdapterLib_WaitOutputTokenID(
+                    Task_p->Bulk_DMAHandle,
+                    Task_p->LastTokenID_ByteOfs))
+    {
+        return SFZCRYPTO_INTERNAL_ERROR;
+    }
+
+    // Ensure data coherence for the output
+    DMAResource_PostDMA(Task_p->Bulk_DMAHandle, SlotOfs, ByteCount);
+
+    return SFZCRYPTO_SUCCESS;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALAdapter_Pipeline_CopyOut
+ *
+ * Copies the output of a completed segment out of a slot. This can be done
+ * while the CM processes the other slot.
+ */
+void
+CALAdapter_Pipeline_CopyOut(
+        CALCM_DMA_Admin_t * const Task_p,
+        const unsigned int Slot,
+        uint8_t * OutputBuffer_p,
+        const unsigned int ByteCount)
+{
+    CALAdapterLib_CopyLarge(
+            OutputBuffer_p,
+            Task_p->BulkBuffer_p + Slot * Task_p->BulkOutputOfs,
+            ByteCount);
+
+    METRICS_ADD(BytesCopiedOut, ByteCount);
+}
+
+
 /* end of file cal_cm-v2_dma.c */
@@ -23,11 +23,40 @@
 #ifndef INCLUDE_GUARD_CAL_CM_DMA_H
 #define INCLUDE_GUARD_CAL_CM_DMA_H
 
+#include "c_cal_cm-v2.h"            // CALCM_DMA_DC_CACHE_ENTRIES
+
 #include "eip123_dma.h"
 #include "cm_tokens_common.h"       // CMTokens_*
 
 #include "sfzcryptoapi.h"           // SfzCryptoStatus
 
+#if CALCM_DMA_DC_CACHE_ENTRIES > 0
+// descriptor chain kept for reuse, see CALCM_DMA_DC_CACHE_ENTRIES
+typedef struct
+{
+    EIP123_DescriptorChain_t Descriptor;
+
+    // the fragment and parameters the chain was populated for
+    uint32_t StartAddress;
+    uint32_t Length;                    // 0 = entry not used
+    unsigned int AlgorithmicBlockSize;
+    uint32_t TokenIDPhysAddr;
+
+    // generation of the chain buffer that holds the rest of the chain
+    unsigned int Generation;
+} CALCM_DMA_DCCacheEntry_t;
+
+typedef struct
+{
+    CALCM_DMA_DCCacheEntry_t Entries[CALCM_DMA_DC_CACHE_ENTRIES];
+
+    // incremented each time the chain buffer is (re)written
+    unsigned int Generation;
+
+    unsigned int NextEntry;             // entry to replace
+} CALCM_DMA_DCCache_t;
+#endif
+
 typedef struct
 {
     EIP123_DescriptorChain_t InDescriptor;
@@ -63,9 +92,27 @@ typedef struct
 
     unsigned int LastOutputByteCount;
 
+    // shared buffer for a series of operations (CALAdapter_Bulk_*)
+    DMAResource_Handle_t Bulk_DMAHandle;
+    uint8_t * BulkBuffer_p;
+    uint32_t Bulk_Addr;
+    unsigned int BulkSize;
+    unsigned int BulkOutputOfs;
+
+#if CALCM_DMA_DC_CACHE_ENTRIES > 0
+    // descriptor chains of the previous operations, kept while the task is
+    // in the pool (see CALCM_DMA_TASK_POOL_SIZE)
+    CALCM_DMA_DCCache_t InDCCache;
+    CALCM_DMA_DCCache_t OutDCCache;
+#endif
+
 } CALCM_DMA_Admin_t;
 
 
+// prepares the pool of DMA tasks; returns 0 on success
+int
+CALCM_DMA_Pool_Init(void);
+
 CALCM_DMA_Admin_t *
 CALCM_DMA_Alloc(void);
 
@@ -142,6 +189,64 @@ SfzCryptoStatus
 CALAdapter_RandomWrapNvm_FinalizeOutput(
         CALCM_DMA_Admin_t * const Task_p);
 
+SfzCryptoStatus
+CALAdapter_Bulk_Alloc(
+        CALCM_DMA_Admin_t * const Task_p,
+        const unsigned int MaxInputByteCount,
+        const unsigned int MaxOutputByteCount);
+
+SfzCryptoStatus
+CALAdapter_Bulk_PreDMA(
+        CALCM_DMA_Admin_t * const Task_p,
+        unsigned int AlgorithmicBlockSize,
+        const unsigned int InputByteCount,
+        const uint8_t * InputBuffer_p,
+        const unsigned int OutputByteCount);
+
+SfzCryptoStatus
+CALAdapter_Bulk_PostDMA(
+        CALCM_DMA_Admin_t * const Task_p,
+        const unsigned int OutputByteCount,
+        uint8_t * OutputBuffer_p);
+
+bool
+CALAdapter_IsBounced(
+        const uint8_t * Buffer_p,
+        const unsigned int ByteCount);
+
+// segmented processing of bounced data, using the Bulk buffer (two slots)
+SfzCryptoStatus
+CALAdapter_Pipeline_Alloc(
+        CALCM_DMA_Admin_t * const Task_p,
+        const unsigned int SegmentByteCount);
+
+void
+CALAdapter_Pipeline_CopyIn(
+        CALCM_DMA_Admin_t * const Task_p,
+        const unsigned int Slot,
+        const uint8_t * InputBuffer_p,
+        const unsigned int ByteCount);
+
+SfzCryptoStatus
+CALAdapter_Pipeline_PreDMA(
+        CALCM_DMA_Admin_t * const Task_p,
+        const unsigned int Slot,
+        unsigned int AlgorithmicBlockSize,
+        const unsigned int ByteCount);
+
+SfzCryptoStatus
+CALAdapter_Pipeline_PostDMA(
+        CALCM_DMA_Admin_t * const Task_p,
+        const unsigned int Slot,
+        const unsigned int ByteCount);
+
+void
+CALAdapter_Pipeline_CopyOut(
+        CALCM_DMA_Admin_t * const Task_p,
+        const unsigned int Slot,
+        uint8_t * OutputBuffer_p,
+        const unsigned int ByteCount);
+
 // TokenID value is given to EIP-123 for writing to the
 // TokenID memory location pointed out when calling
 // EIP123_DescriptorChain_Populate
@@ -38,6 +38,569 @@
 #include "cm_tokens_mac.h"
 #include "cm_tokens_errdetails.h"
 
+#if CALCM_HMAC_KEYCACHE_ENTRIES > 0
+#include "cal_hw_api.h"         // CAL_HW_WarmState_Generation
+#include "spal_mutex.h"
+#endif
+
+
+#if CALCM_HMAC_KEYCACHE_ENTRIES > 0
+
+/*----------------------------------------------------------------------------
+ * HMAC precomputed-key cache
+ *
+ * For applications that compute many HMACs with the same (plaintext) key,
+ * the key is loaded once into a key asset and the initial operation (the
+ * inner ipad block) is performed once, with the resulting intermediate
+ * digest saved in a temporary MAC asset. Subsequent messages with the same
+ * key continue from that saved state and reference the key asset instead
+ * of copying the key into each token.
+ *
+ * The CM cannot save the outer (opad) state, so the final operation still
+ * processes the key, but it is taken from the key asset.
+ *
+ * The cache does not keep the key itself. Entries are found via a 128-bit
+ * fingerprint of the key: two SipHash-2-4 values with secret keys taken from
+ * the CM when the cache is initialized. The fingerprints are compared in
+ * constant time. Only keys up to one hash block (64 bytes) are cached and
+ * MD5 is excluded because the Asset Store has no HMAC-MD5 key policy.
+ *
+ * The assets are created without holding the cache lock; the entry is
+ * marked as being populated meanwhile. The assets are lost when another
+ * process initializes the CM again (see CAL_HW_WarmState_Generation); the
+ * entries of an earlier generation are not used.
+ */
+#define CALCM_HMAC_KEYCACHE_MAX_KEYLEN  64
+
+typedef enum
+{
+    CALCM_HMAC_KEYCACHE_FREE = 0,
+    CALCM_HMAC_KEYCACHE_POPULATING,
+    CALCM_HMAC_KEYCACHE_READY
+} CALCM_HmacKeyCache_State_t;
+
+typedef struct
+{
+    CALCM_HmacKeyCache_State_t State;
+    uint64_t Fingerprint[2];
+    uint32_t KeyLength;
+    SfzCryptoHashAlgo Algo;
+    SfzCryptoAssetId KeyAssetId;
+    SfzCryptoAssetId StateAssetId;
+    uint32_t Generation;            // of the CM that holds the assets
+    uint32_t UseCount;              // operations currently using the assets
+    uint32_t LastUsed;              // for least-recently-used replacement
+} CALCM_HmacKeyCache_Entry_t;
+
+static CALCM_HmacKeyCache_Entry_t
+CALCM_HmacKeyCache[CALCM_HMAC_KEYCACHE_ENTRIES];
+
+// SipHash keys for the two halves of the fingerprint
+static uint64_t CALCM_HmacKeyCache_SipKey[2][2];
+
+static SPAL_Mutex_t CALCM_HmacKeyCache_Lock;
+static uint32_t CALCM_HmacKeyCache_UseTick;
+static bool CALCM_HmacKeyCache_IsInitialized = false;
+
+#define CALCM_SIPHASH_ROTL(_x, _b)  (((_x) << (_b)) | ((_x) >> (64 - (_b))))
+
+#define CALCM_SIPHASH_ROUND \
+    do { \
+        v0 += v1; v1 = CALCM_SIPHASH_ROTL(v1, 13); v1 ^= v0; \
+        v0 = CALCM_SIPHASH_ROTL(v0, 32); \
+        v2 += v3; v3 = CALCM_SIPHASH_ROTL(v3, 16); v3 ^= v2; \
+        v0 += v3; v3 = CALCM_SIPHASH_ROTL(v3, 21); v3 ^= v0; \
+        v2 += v1; v1 = CALCM_SIPHASH_ROTL(v1, 17); v1 ^= v2; \
+        v2 = CALCM_SIPHASH_ROTL(v2, 32); \
+    } while (0)
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_HmacKeyCache_SipHash
+ *
+ * SipHash-2-4 of Data_p with the 128-bit key K (little-endian words).
+ */
+static uint64_t
+CALCMLib_HmacKeyCache_SipHash(
+        const uint64_t K[2],
+        const uint8_t * Data_p,
+        const uint32_t Length)
+{
+    uint64_t v0 = K[0] ^ 0x736F6D6570736575ULL;
+    uint64_t v1 = K[1] ^ 0x646F72616E646F6DULL;
+    uint64_t v2 = K[0] ^ 0x6C7967656E657261ULL;
+    uint64_t v3 = K[1] ^ 0x7465646279746573ULL;
+    uint64_t m;
+    uint32_t i;
+    uint32_t j;
+
+    for (i = 0; i + 8 <= Length; i += 8)
+    {
+        m = 0;
+        for (j = 8; j > 0; j--)
+            m = (m << 8) | Data_p[i + j - 1];
+
+        v3 ^= m;
+        CALCM_SIPHASH_ROUND;
+        CALCM_SIPHASH_ROUND;
+        v0 ^= m;
+    }
+
+    // last block: remaining bytes and the length
+    m = (uint64_t)(Length & 0xFF) << 56;
+    for (j = 0; i + j < Length; j++)
+        m |= (uint64_t)Data_p[i + j] << (8 * j);
+
+    v3 ^= m;
+    CALCM_SIPHASH_ROUND;
+    CALCM_SIPHASH_ROUND;
+    v0 ^= m;
+
+    v2 ^= 0xFF;
+    CALCM_SIPHASH_ROUND;
+    CALCM_SIPHASH_ROUND;
+    CALCM_SIPHASH_ROUND;
+    CALCM_SIPHASH_ROUND;
+
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_HmacKeyCache_IsMatch
+ *
+ * Compares an entry with the key, without branching on the fingerprints.
+ */
+static bool
+CALCMLib_HmacKeyCache_IsMatch(
+        const CALCM_HmacKeyCache_Entry_t * const Entry_p,
+        const SfzCryptoHashAlgo Algo,
+        const uint32_t KeyLength,
+        const uint64_t Fingerprint[2])
+{
+    uint64_t Diff;
+
+    Diff = (Entry_p->Fingerprint[0] ^ Fingerprint[0]) |
+           (Entry_p->Fingerprint[1] ^ Fingerprint[1]);
+
+    return (Entry_p->State == CALCM_HMAC_KEYCACHE_READY) &
+           (Entry_p->Algo == Algo) &
+           (Entry_p->KeyLength == KeyLength) &
+           (Diff == 0);
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_HmacKeyCache_FreeAssets
+ *
+ * Releases the assets of a cache entry. Called without the cache lock.
+ */
+static void
+CALCMLib_HmacKeyCache_FreeAssets(
+        const SfzCryptoAssetId KeyAssetId,
+        const SfzCryptoAssetId StateAssetId)
+{
+    if (StateAssetId != SFZCRYPTO_ASSETID_INVALID)
+        (void)sfzcrypto_cm_asset_free(StateAssetId);
+
+    if (KeyAssetId != SFZCRYPTO_ASSETID_INVALID)
+        (void)sfzcrypto_cm_asset_free(KeyAssetId);
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_HmacKeyCache_Clear
+ *
+ * Marks an entry as unused. The cache lock must be held.
+ */
+static void
+CALCMLib_HmacKeyCache_Clear(
+        CALCM_HmacKeyCache_Entry_t * const Entry_p)
+{
+    c_memset(Entry_p, 0, sizeof(CALCM_HmacKeyCache_Entry_t));
+    Entry_p->KeyAssetId = SFZCRYPTO_ASSETID_INVALID;
+    Entry_p->StateAssetId = SFZCRYPTO_ASSETID_INVALID;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_HmacKeyCache_Populate
+ *
+ * Creates the key asset and the temporary MAC asset for the given key and
+ * performs the initial HMAC operation, saving the inner state in the
+ * temporary MAC asset. Called without the cache lock.
+ */
+static SfzCryptoStatus
+CALCMLib_HmacKeyCache_Populate(
+        const SfzCryptoHashAlgo Algo,
+        SfzCryptoCipherKey * const p_key,
+        SfzCryptoAssetId * const KeyAssetId_p,
+        SfzCryptoAssetId * const StateAssetId_p)
+{
+    SfzCryptoHmacContext PreCtx;
+    SfzCryptoCipherKey AssetKey;
+    SfzCryptoPolicyMask Policy = SFZCRYPTO_POLICY_FUNCTION_MAC;
+    SfzCryptoStatus funcres;
+    uint8_t Dummy = 0;
+
+    *KeyAssetId_p = SFZCRYPTO_ASSETID_INVALID;
+    *StateAssetId_p = SFZCRYPTO_ASSETID_INVALID;
+
+    switch (Algo)
+    {
+        case SFZCRYPTO_ALGO_HASH_SHA160:
+            Policy |= SFZCRYPTO_POLICY_ALGO_HMAC_SHA1;
+            break;
+
+        case SFZCRYPTO_ALGO_HASH_SHA224:
+            Policy |= SFZCRYPTO_POLICY_ALGO_HMAC_SHA224;
+            break;
+
+        case SFZCRYPTO_ALGO_HASH_SHA256:
+            Policy |= SFZCRYPTO_POLICY_ALGO_HMAC_SHA256;
+            break;
+
+        default:
+            return SFZCRYPTO_INVALID_ALGORITHM;
+    } // switch
+
+    funcres = sfzcrypto_cm_asset_alloc(
+                        Policy,
+                        p_key->length,
+                        KeyAssetId_p);
+
+    if (funcres == SFZCRYPTO_SUCCESS)
+    {
+        funcres = sfzcrypto_cm_asset_load_key(
+                        *KeyAssetId_p,
+                        p_key->key,
+                        p_key->length);
+    }
+
+    if (funcres == SFZCRYPTO_SUCCESS)
+    {
+        funcres = sfzcrypto_cm_asset_alloc_temporary(
+                        SFZCRYPTO_KEY_HMAC,
+                        SFZCRYPTO_MODE_ECB,     // ignored for HMAC
+                        Algo,
+                        *KeyAssetId_p,
+                        StateAssetId_p);
+    }
+
+    if (funcres == SFZCRYPTO_SUCCESS)
+    {
+        // process the inner key block only and save the state in the asset
+        c_memset(&PreCtx, 0, sizeof(PreCtx));
+        PreCtx.hashCtx.algo = Algo;
+        PreCtx.mac_asset_id = *StateAssetId_p;
+        PreCtx.mac_loc = SFZ_TO_ASSET;
+
+        c_memset(&AssetKey, 0, sizeof(AssetKey));
+        AssetKey.type = SFZCRYPTO_KEY_HMAC;
+        AssetKey.asset_id = *KeyAssetId_p;
+        AssetKey.length = p_key->length;
+
+        funcres = sfzcrypto_cm_hmac_data(
+                        &PreCtx,
+                        &AssetKey,
+                        &Dummy,
+                        /*length:*/0,
+                        /*init:*/true,
+                        /*final:*/false);
+    }
+
+    if (funcres != SFZCRYPTO_SUCCESS)
+    {
+        LOG_INFO(
+            "CALCMLib_HmacKeyCache_Populate: "
+            "Failed with error %d\n",
+            funcres);
+
+        CALCMLib_HmacKeyCache_FreeAssets(*KeyAssetId_p, *StateAssetId_p);
+        *KeyAssetId_p = SFZCRYPTO_ASSETID_INVALID;
+        *StateAssetId_p = SFZCRYPTO_ASSETID_INVALID;
+    }
+
+    return funcres;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_HmacKeyCache_Acquire
+ *
+ * Finds (or, when fCreate is set, creates) the cache entry for the given
+ * algorithm and plaintext key. The returned entry is marked in use and
+ * must be released with CALCMLib_HmacKeyCache_Release.
+ *
+ * Returns NULL when the key is not (and could not be) cached; the caller
+ * then falls back to the key-in-token path.
+ */
+static CALCM_HmacKeyCache_Entry_t *
+CALCMLib_HmacKeyCache_Acquire(
+        const SfzCryptoHashAlgo Algo,
+        SfzCryptoCipherKey * const p_key,
+        const bool fCreate)
+{
+    CALCM_HmacKeyCache_Entry_t * Entry_p = NULL;
+    CALCM_HmacKeyCache_Entry_t * Victim_p = NULL;
+    SfzCryptoAssetId OldKeyAssetId = SFZCRYPTO_ASSETID_INVALID;
+    SfzCryptoAssetId OldStateAssetId = SFZCRYPTO_ASSETID_INVALID;
+    SfzCryptoAssetId KeyAssetId;
+    SfzCryptoAssetId StateAssetId;
+    uint64_t Fingerprint[2];
+    uint32_t Generation;
+    int i;
+
+    if (!CALCM_HmacKeyCache_IsInitialized ||
+        p_key->length == 0 ||
+        p_key->length > CALCM_HMAC_KEYCACHE_MAX_KEYLEN)
+    {
+        return NULL;
+    }
+
+    Fingerprint[0] = CALCMLib_HmacKeyCache_SipHash(
+                                    CALCM_HmacKeyCache_SipKey[0],
+                                    p_key->key,
+                                    p_key->length);
+
+    Fingerprint[1] = CALCMLib_HmacKeyCache_SipHash(
+                                    CALCM_HmacKeyCache_SipKey[1],
+                                    p_key->key,
+                                    p_key->length);
+
+    Generation = CAL_HW_WarmState_Generation();
+
+    SPAL_Mutex_Lock(&CALCM_HmacKeyCache_Lock);
+
+    for (i = 0; i < CALCM_HMAC_KEYCACHE_ENTRIES; i++)
+    {
+        CALCM_HmacKeyCache_Entry_t * const e_p = &CALCM_HmacKeyCache[i];
+
+        // the assets of an earlier CM generation no longer exist
+        if (e_p->State == CALCM_HMAC_KEYCACHE_READY &&
+            e_p->Generation != Generation &&
+            e_p->UseCount == 0)
+        {
+            CALCMLib_HmacKeyCache_Clear(e_p);
+        }
+
+        if (CALCMLib_HmacKeyCache_IsMatch(
+                                    e_p,
+                                    Algo,
+                                    p_key->length,
+                                    Fingerprint))
+        {
+            Entry_p = e_p;
+        }
+
+        // select a replacement candidate: unused first, then LRU
+        if (e_p->UseCount == 0)
+        {
+            if (Victim_p == NULL ||
+                (Victim_p->State != CALCM_HMAC_KEYCACHE_FREE &&
+                 (e_p->State == CALCM_HMAC_KEYCACHE_FREE ||
+                  e_p->LastUsed < Victim_p->LastUsed)))
+            {
+                Victim_p = e_p;
+            }
+        }
+    } // for
+
+    if (Entry_p != NULL && Entry_p->Generation == Generation)
+    {
+        Entry_p->UseCount++;
+        Entry_p->LastUsed = ++CALCM_HmacKeyCache_UseTick;
+
+        SPAL_Mutex_UnLock(&CALCM_HmacKeyCache_Lock);
+        return Entry_p;                 // ## RETURN ##
+    }
+
+    if (Entry_p != NULL || !fCreate || Victim_p == NULL)
+    {
+        SPAL_Mutex_UnLock(&CALCM_HmacKeyCache_Lock);
+        return NULL;                    // ## RETURN ##
+    }
+
+    // take over the victim; its assets are released below
+    if (Victim_p->State == CALCM_HMAC_KEYCACHE_READY &&
+        Victim_p->Generation == Generation)
+    {
+        OldKeyAssetId = Victim_p->KeyAssetId;
+        OldStateAssetId = Victim_p->StateAssetId;
+    }
+
+    CALCMLib_HmacKeyCache_Clear(Victim_p);
+    Victim_p->State = CALCM_HMAC_KEYCACHE_POPULATING;
+    Victim_p->UseCount = 1;
+
+    SPAL_Mutex_UnLock(&CALCM_HmacKeyCache_Lock);
+
+    // the token exchanges are done without holding the cache lock
+    CALCMLib_HmacKeyCache_FreeAssets(OldKeyAssetId, OldStateAssetId);
+
+    if (CALCMLib_HmacKeyCache_Populate(
+                            Algo,
+                            p_key,
+                            &KeyAssetId,
+                            &StateAssetId) != SFZCRYPTO_SUCCESS)
+    {
+        SPAL_Mutex_Lock(&CALCM_HmacKeyCache_Lock);
+        CALCMLib_HmacKeyCache_Clear(Victim_p);
+        SPAL_Mutex_UnLock(&CALCM_HmacKeyCache_Lock);
+
+        return NULL;
+    }
+
+    SPAL_Mutex_Lock(&CALCM_HmacKeyCache_Lock);
+
+    Victim_p->Fingerprint[0] = Fingerprint[0];
+    Victim_p->Fingerprint[1] = Fingerprint[1];
+    Victim_p->KeyLength = p_key->length;
+    Victim_p->Algo = Algo;
+    Victim_p->KeyAssetId = KeyAssetId;
+    Victim_p->StateAssetId = StateAssetId;
+    Victim_p->Generation = Generation;
+    Victim_p->LastUsed = ++CALCM_HmacKeyCache_UseTick;
+    Victim_p->State = CALCM_HMAC_KEYCACHE_READY;
+
+    SPAL_Mutex_UnLock(&CALCM_HmacKeyCache_Lock);
+
+    return Victim_p;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_HmacKeyCache_Release
+ */
+static void
+CALCMLib_HmacKeyCache_Release(
+        CALCM_HmacKeyCache_Entry_t * const Entry_p)
+{
+    if (Entry_p == NULL)
+        return;
+
+    SPAL_Mutex_Lock(&CALCM_HmacKeyCache_Lock);
+    Entry_p->UseCount--;
+    SPAL_Mutex_UnLock(&CALCM_HmacKeyCache_Lock);
+}
+
+
+/*----------------------------------------------------------------------------
+ * CAL_CM_HmacKeyCache_Init
+ */
+int
+CAL_CM_HmacKeyCache_Init(void)
+{
+    SfzCryptoStatus funcres;
+    uint8_t SipKeys[sizeof(CALCM_HmacKeyCache_SipKey)];
+    unsigned int i;
+
+    if (CALCM_HmacKeyCache_IsInitialized)
+        return 0;
+
+    c_memset(
+        CALCM_HmacKeyCache_SipKey,
+        0,
+        sizeof(CALCM_HmacKeyCache_SipKey));
+
+    funcres = CAL_CM_RandomGenerate(sizeof(SipKeys), SipKeys);
+    if (funcres != SFZCRYPTO_SUCCESS)
+    {
+        LOG_WARN(
+            "CAL_CM_HmacKeyCache_Init: "
+            "Failed to get the fingerprint keys (%d)\n",
+            funcres);
+        return -1;
+    }
+
+    for (i = 0; i < sizeof(SipKeys); i++)
+    {
+        CALCM_HmacKeyCache_SipKey[i / 16][(i / 8) % 2] |=
+                                (uint64_t)SipKeys[i] << (8 * (i % 8));
+    }
+
+    c_memset(SipKeys, 0, sizeof(SipKeys));
+
+    if (SPAL_Mutex_Init(&CALCM_HmacKeyCache_Lock) != SPAL_SUCCESS)
+    {
+        LOG_WARN(
+            "CAL_CM_HmacKeyCache_Init: "
+            "Failed to create lock\n");
+        c_memset(
+            CALCM_HmacKeyCache_SipKey,
+            0,
+            sizeof(CALCM_HmacKeyCache_SipKey));
+        return -2;
+    }
+
+    for (i = 0; i < CALCM_HMAC_KEYCACHE_ENTRIES; i++)
+        CALCMLib_HmacKeyCache_Clear(&CALCM_HmacKeyCache[i]);
+
+    CALCM_HmacKeyCache_UseTick = 0;
+    CALCM_HmacKeyCache_IsInitialized = true;
+
+    return 0;
+}
+
+
+/*----------------------------------------------------------------------------
+ * sfzcrypto_cm_hmac_keycache_flush
+ *
+ * Releases all cached HMAC keys and their assets. Entries that are in use
+ * by an ongoing operation are left alone; the function then returns
+ * SFZCRYPTO_OPERATION_FAILED and can be retried.
+ */
+SfzCryptoStatus
+sfzcrypto_cm_hmac_keycache_flush(void)
+{
+    SfzCryptoStatus funcres = SFZCRYPTO_SUCCESS;
+    SfzCryptoAssetId KeyAssetIds[CALCM_HMAC_KEYCACHE_ENTRIES];
+    SfzCryptoAssetId StateAssetIds[CALCM_HMAC_KEYCACHE_ENTRIES];
+    uint32_t Generation;
+    int i;
+
+    if (!CALCM_HmacKeyCache_IsInitialized)
+        return SFZCRYPTO_SUCCESS;
+
+    Generation = CAL_HW_WarmState_Generation();
+
+    SPAL_Mutex_Lock(&CALCM_HmacKeyCache_Lock);
+
+    for (i = 0; i < CALCM_HMAC_KEYCACHE_ENTRIES; i++)
+    {
+        CALCM_HmacKeyCache_Entry_t * const e_p = &CALCM_HmacKeyCache[i];
+
+        KeyAssetIds[i] = SFZCRYPTO_ASSETID_INVALID;
+        StateAssetIds[i] = SFZCRYPTO_ASSETID_INVALID;
+
+        if (e_p->State == CALCM_HMAC_KEYCACHE_FREE)
+            continue;
+
+        if (e_p->UseCount != 0)
+        {
+            funcres = SFZCRYPTO_OPERATION_FAILED;
+            continue;
+        }
+
+        if (e_p->Generation == Generation)
+        {
+            KeyAssetIds[i] = e_p->KeyAssetId;
+            StateAssetIds[i] = e_p->StateAssetId;
+        }
+
+        CALCMLib_HmacKeyCache_Clear(e_p);
+    } // for
+
+    SPAL_Mutex_UnLock(&CALCM_HmacKeyCache_Lock);
+
+    for (i = 0; i < CALCM_HMAC_KEYCACHE_ENTRIES; i++)
+        CALCMLib_HmacKeyCache_FreeAssets(KeyAssetIds[i], StateAssetIds[i]);
+
+    return funcres;
+}
+
+#endif /* CALCM_HMAC_KEYCACHE_ENTRIES > 0 */
+
 
 /*----------------------------------------------------------------------------
  * sfzcrypto_cm_hmac_data
@@ -59,6 +622,12 @@ sfzcrypto_cm_hmac_data(
     uint8_t DigestNBytes = 0;
     bool loadDigestFromAsset = false;
     bool saveDigestInAsset = false;
+    bool tokenInit = init;
+    SfzCryptoAssetId LoadDigestAssetId;
+    SfzCryptoAssetId KeyAssetId = SFZCRYPTO_ASSETID_INVALID;
+#if CALCM_HMAC_KEYCACHE_ENTRIES > 0
+    CALCM_HmacKeyCache_Entry_t * CacheEntry_p = NULL;
+#endif
     int res;
 
 #ifdef CALCM_STRICT_ARGS
@@ -196,19 +765,56 @@ sfzcrypto_cm_hmac_data(
             return SFZCRYPTO_INVALID_ALGORITHM;     // ## RETURN ##
     } // switch
 
+    LoadDigestAssetId = p_ctxt->mac_asset_id;
+    if (p_key != NULL && (init || final))
+        KeyAssetId = p_key->asset_id;
+
+#if CALCM_HMAC_KEYCACHE_ENTRIES > 0
+    // use the precomputed key state for plaintext keys, when possible
+    if (p_key != NULL &&
+        p_key->asset_id == SFZCRYPTO_ASSETID_INVALID &&
+        MacAlgo != CMTOKENS_MAC_ALGORITHM_HMAC_MD5 &&
+        (init || final) &&
+        !saveDigestInAsset)
+    {
+        CacheEntry_p = CALCMLib_HmacKeyCache_Acquire(
+                                        p_ctxt->hashCtx.algo,
+                                        p_key,
+                                        /*fCreate:*/init);
+
+        if (CacheEntry_p)
+        {
+            KeyAssetId = CacheEntry_p->KeyAssetId;
+
+            if (init)
+            {
+                // continue from the saved inner state
+                tokenInit = false;
+                loadDigestFromAsset = true;
+                LoadDigestAssetId = CacheEntry_p->StateAssetId;
+            }
+        }
+    }
+#endif /* CALCM_HMAC_KEYCACHE_ENTRIES > 0 */
+
     Task_p = CALCM_DMA_Alloc();
     if (!Task_p)
+    {
+#if CALCM_HMAC_KEYCACHE_ENTRIES > 0
+        CALCMLib_HmacKeyCache_Release(CacheEntry_p);
+#endif
         return SFZCRYPTO_NO_MEMORY;
+    }
 
     CMTokens_MakeCommand_Mac_SetLengthAlgoMode(
                                     &t_cmd,
                                     length,
                                     MacAlgo,
-                                    init,
+                                    tokenInit,
                                     final);
 
     // copy the Digest into the token, or set the Asset Store reference
-    if (!loadDigestFromAsset && !init)
+    if (!loadDigestFromAsset && !tokenInit)
     {
         // copy intermediate MAC from hashCtx.digest to token
         CMTokens_MakeCommand_Mac_CopyDigest(&t_cmd, DigestNBytes,
@@ -216,10 +822,10 @@ sfzcrypto_cm_hmac_data(
     }
     else
     {
-        if (!init)
+        if (!tokenInit)
         {
             // IV from asset store
-            CMTokens_MakeCommand_Mac_SetASLoadDigest(&t_cmd, p_ctxt->mac_asset_id);
+            CMTokens_MakeCommand_Mac_SetASLoadDigest(&t_cmd, LoadDigestAssetId);
         }
     }
 
@@ -233,7 +839,7 @@ sfzcrypto_cm_hmac_data(
     // key is optional, except for Initial and Final operations
     if (init || final)
     {
-        if (p_key->asset_id == SFZCRYPTO_ASSETID_INVALID)
+        if (KeyAssetId == SFZCRYPTO_ASSETID_INVALID)
         {
             // key in token
             if (p_key->length <= 64)
@@ -279,7 +885,7 @@ sfzcrypto_cm_hmac_data(
         else
         {
             // key from asset store
-            CMTokens_MakeCommand_Mac_SetASLoadKey(&t_cmd, p_key->asset_id, p_key->length);
+            CMTokens_MakeCommand_Mac_SetASLoadKey(&t_cmd, KeyAssetId, p_key->length);
         }
     }
 
@@ -316,6 +922,9 @@ sfzcrypto_cm_hmac_data(
             // there was a problem with the input data
             LOG_INFO("sfzcrypto_cm_hmac_data: Abort after prepare");
             CALCM_DMA_Free(Task_p);
+#if CALCM_HMAC_KEYCACHE_ENTRIES > 0
+            CALCMLib_HmacKeyCache_Release(CacheEntry_p);
+#endif
             return funcres;     // ## RETURN ##
         }
 
@@ -324,6 +933,13 @@ sfzcrypto_cm_hmac_data(
 
     // exchange a message with the CM
     funcres = CAL_CM_ExchangeToken(&t_cmd, &t_res);
+
+#if CALCM_HMAC_KEYCACHE_ENTRIES > 0
+    // the cached assets are no longer referenced
+    CALCMLib_HmacKeyCache_Release(CacheEntry_p);
+    CacheEntry_p = NULL;
+#endif
+
     if (funcres != SFZCRYPTO_SUCCESS)
         return funcres;
 
@@ -31,7 +31,20 @@
 #include "cal_cm.h"                     // the API to implement
 
 #include "cal_cm-v2_internal.h"         // CAL_CM_Init
-#include "cal_cm-v2_dma.h"              // CALCM_DMA_Alloc
+#include "cal_cm-v2_dma.h"              // CALCM_DMA_Pool_Init
+#include "cal_hw_api.h"                 // CAL_HW_WarmState_*
+#include "metrics.h"                    // Metrics_Init
+
+#if defined(CALCM_INIT_TIMING) || (CALCM_WARMSTART_DMATEST_INTERVAL_S > 0)
+#include <time.h>                       // clock_gettime
+#define CALCM_INIT_USE_CLOCK
+#endif
+
+#ifdef CALCM_INIT_TIMING
+#define CALCM_TIMESTAMP(_t)  (_t) = (uint32_t)CALCMLib_TimeUS()
+#else
+#define CALCM_TIMESTAMP(_t)
+#endif
 
 #define CALCM_ISINITIALIZED_SIGNATURE (uint32_t)0xCA1CA1CA
 #define CALCM_INIT_ONGOING_SIGNATURE  (uint32_t)0xCA1DD1CA
@@ -114,6 +127,73 @@ CALCMLib_BasicDMATest(void)
 }
 
 
+#ifdef CALCM_INIT_USE_CLOCK
+/*----------------------------------------------------------------------------
+ * CALCMLib_TimeUS
+ *
+ * Returns the CLOCK_MONOTONIC time, which is the same for all processes,
+ * in microseconds. Returns 0 on error.
+ */
+static uint64_t
+CALCMLib_TimeUS(void)
+{
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+        return 0;
+
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+#endif /* CALCM_INIT_USE_CLOCK */
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_DMATest
+ *
+ * This function runs CALCMLib_BasicDMATest, unless the CAL_HW warm start
+ * record shows that the test passed less than
+ * CALCM_WARMSTART_DMATEST_INTERVAL_S seconds ago (in any process).
+ *
+ * Returns true on success, false on error.
+ */
+static bool
+CALCMLib_DMATest(void)
+{
+#if CALCM_WARMSTART_DMATEST_INTERVAL_S > 0
+    const uint32_t Now_s = (uint32_t)(CALCMLib_TimeUS() / 1000000);
+    CAL_HW_WarmState_t WarmState;
+    int WarmStart;
+
+    WarmStart = CAL_HW_WarmState_Get(&WarmState);
+    if (WarmStart > 0 &&
+        WarmState.LastDMATest_s != 0 &&
+        Now_s != 0 &&
+        Now_s - WarmState.LastDMATest_s < CALCM_WARMSTART_DMATEST_INTERVAL_S)
+    {
+        LOG_INFO(
+            "sfzcrypto_cm_init: "
+            "Basic DMA test skipped (passed %u s ago)\n",
+            Now_s - WarmState.LastDMATest_s);
+
+        return true;
+    }
+
+    if (!CALCMLib_BasicDMATest())
+        return false;
+
+    if (WarmStart >= 0 && Now_s != 0)
+    {
+        WarmState.LastDMATest_s = Now_s;
+        CAL_HW_WarmState_Update(&WarmState);
+    }
+
+    return true;
+#else
+    return CALCMLib_BasicDMATest();
+#endif /* CALCM_WARMSTART_DMATEST_INTERVAL_S */
+}
+
+
 /*----------------------------------------------------------------------------
  * sfzcrypto_cm_init
  *
@@ -126,6 +206,7 @@ CALCMLib_BasicDMATest(void)
 SfzCryptoStatus
 sfzcrypto_cm_init(void)
 {
+    uint32_t T[5] = { 0 };
     int res;
 
     if (CAL_CM_IsInitialized == CALCM_ISINITIALIZED_SIGNATURE)
@@ -147,6 +228,20 @@ sfzcrypto_cm_init(void)
 
     // there is a theoretical situation where two applications end up here
 
+#ifdef CFG_ENABLE_METRICS
+    // not fatal: the counters are then kept in the process only
+    res = Metrics_Init();
+    if (res != 0)
+    {
+        LOG_WARN(
+            "sfzcrypto_cm_init: "
+            "Metrics_Init returned %d\n",
+            res);
+    }
+#endif
+
+    CALCM_TIMESTAMP(T[0]);
+
     res = CAL_CM_Init();
     if (res != 0)
     {
@@ -158,7 +253,73 @@ sfzcrypto_cm_init(void)
         goto fail;
     }
 
-    if (!CALCMLib_BasicDMATest())
+    CALCM_TIMESTAMP(T[1]);
+
+    res = CALCM_DMA_Pool_Init();
+    if (res != 0)
+    {
+        LOG_INFO(
+            "sfzcrypto_cm_init: "
+            "CALCM_DMA_Pool_Init returned %d\n",
+            res);
+
+        goto fail;
+    }
+
+    res = CAL_CM_AssetSearch_Init();
+    if (res != 0)
+    {
+        LOG_INFO(
+            "sfzcrypto_cm_init: "
+            "CAL_CM_AssetSearch_Init returned %d\n",
+            res);
+
+        goto fail;
+    }
+
+#ifdef SFZCRYPTO_CF_NVM_PUBLICDATA_READ__CM
+    res = CAL_CM_NvmCache_Init();
+    if (res != 0)
+    {
+        LOG_INFO(
+            "sfzcrypto_cm_init: "
+            "CAL_CM_NvmCache_Init returned %d\n",
+            res);
+
+        goto fail;
+    }
+#endif
+
+#if CALCM_TOKEN_TEMPLATE_ENTRIES > 0
+    res = CAL_CM_TokenTemplate_Init();
+    if (res != 0)
+    {
+        LOG_INFO(
+            "sfzcrypto_cm_init: "
+            "CAL_CM_TokenTemplate_Init returned %d\n",
+            res);
+
+        goto fail;
+    }
+#endif
+
+#if defined(SFZCRYPTO_CF_RAND_DATA__CM) && defined(CALCM_RANDOM_HEALTH_TESTS)
+    // before the first random numbers are retrieved (random pool)
+    res = CAL_CM_RandomHealth_Init();
+    if (res != 0)
+    {
+        LOG_INFO(
+            "sfzcrypto_cm_init: "
+            "CAL_CM_RandomHealth_Init returned %d\n",
+            res);
+
+        goto fail;
+    }
+#endif
+
+    CALCM_TIMESTAMP(T[2]);
+
+    if (!CALCMLib_DMATest())
     {
         LOG_CRIT(
             "sfzcrypto_cm_init: "
@@ -167,6 +328,54 @@ sfzcrypto_cm_init(void)
         goto fail;
     }
 
+    CALCM_TIMESTAMP(T[3]);
+
+    // fill the asset search cache for the well-known static assets
+    CAL_CM_AssetSearch_Preload();
+
+#if defined(SFZCRYPTO_CF_HMAC_DATA__CM) && (CALCM_HMAC_KEYCACHE_ENTRIES > 0)
+    // takes random numbers from the CM (after the DMA test succeeded)
+    res = CAL_CM_HmacKeyCache_Init();
+    if (res != 0)
+    {
+        LOG_INFO(
+            "sfzcrypto_cm_init: "
+            "CAL_CM_HmacKeyCache_Init returned %d\n",
+            res);
+
+        goto fail;
+    }
+#endif
+
+#if defined(SFZCRYPTO_CF_RAND_DATA__CM) && (CALCM_RANDOM_POOL_SIZE > 0)
+    // start filling the random pool (after the DMA test succeeded)
+    res = CAL_CM_RandomPool_Init();
+    if (res != 0)
+    {
+        LOG_INFO(
+            "sfzcrypto_cm_init: "
+            "CAL_CM_RandomPool_Init returned %d\n",
+            res);
+
+        goto fail;
+    }
+#endif
+
+    CALCM_TIMESTAMP(T[4]);
+
+#ifdef CALCM_INIT_TIMING
+    LOG_INFO(
+        "sfzcrypto_cm_init (us): "
+        "CM %u, caches %u, DMA test %u, preload %u\n",
+        T[1] - T[0],
+        T[2] - T[1],
+        T[3] - T[2],
+        T[4] - T[3]);
+#endif
+
+    // avoids warning when the timing or LOG_INFO is off
+    IDENTIFIER_NOT_USED(T[0]);
+
     CAL_CM_IsInitialized = CALCM_ISINITIALIZED_SIGNATURE;
 
     return SFZCRYPTO_SUCCESS;
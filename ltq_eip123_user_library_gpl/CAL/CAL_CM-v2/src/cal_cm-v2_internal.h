@@ -28,6 +28,8 @@
 
 #include "sfzcryptoapi.h"           // SfzCryptoStatus, SfzCryptoCipher*
 
+#include "cal_cm-v2_dma.h"          // CALCM_DMA_Admin_t
+
 int
 CAL_CM_Init(void);
 
@@ -36,6 +38,26 @@ CAL_CM_ExchangeToken(
         CMTokens_Command_t * const CommandToken_p,
         CMTokens_Response_t * const ResponseToken_p);
 
+// token scheduler (exclusive access to the CM)
+int
+CAL_CM_Sched_Init(void);
+
+SfzCryptoStatus
+CAL_CM_Sched_Acquire(
+        const CMTokens_Command_t * const CommandToken_p);
+
+void
+CAL_CM_Sched_Release(void);
+
+// CAL_CM_ExchangeToken in two steps; the CM stays locked in between
+SfzCryptoStatus
+CAL_CM_SubmitToken(
+        CMTokens_Command_t * const CommandToken_p);
+
+SfzCryptoStatus
+CAL_CM_WaitToken(
+        CMTokens_Response_t * const ResponseToken_p);
+
 
 /* Symmetric Crypto */
 
@@ -52,6 +74,26 @@ CAL_CM_AESDES(
         uint32_t * const p_dst_len,
         SfzCipherOp direction);
 
+/*----------------------------------------------------------------------------
+ * CAL_CM_AES_CTR_Stream
+ *
+ * AES CTR/ICM for data of any length, continuing the keystream of the
+ * previous call: KeyStream_p (SFZCRYPTO_AES_BLOCK_LEN bytes) ends with
+ * *KeyStreamLen_p unused bytes, which are used first and are replaced by
+ * the unused bytes of the last partial block.
+ */
+SfzCryptoStatus
+CAL_CM_AES_CTR_Stream(
+        SfzCryptoCipherContext * p_ctxt,
+        SfzCryptoCipherKey * p_key,
+        uint8_t * KeyStream_p,
+        uint32_t * const KeyStreamLen_p,
+        uint8_t * p_src,
+        uint32_t src_len,
+        uint8_t * p_dst,
+        uint32_t * const p_dst_len,
+        SfzCipherOp direction);
+
 SfzCryptoStatus
 CAL_CM_ARC4(
         SfzCryptoCipherContext * p_ctxt,
@@ -101,6 +143,60 @@ CM_CAL_C2_H(
         bool init,
         bool final);
 
+/*----------------------------------------------------------------------------
+ * sfzcrypto_cipher_mac_data
+ *
+ * CAL_CM_CipherMac uses SharedTask_p, if non-NULL, instead of allocating a
+ * DMA admin for the call.
+ */
+SfzCryptoStatus
+CAL_CM_CipherMac(
+        CALCM_DMA_Admin_t * const SharedTask_p,
+        SfzCryptoCipherMacContext * const p_ctxt,
+        SfzCryptoCipherKey * const p_key,
+        uint8_t * p_data,
+        uint32_t length,
+        bool init,
+        bool final);
+
+// S2V-CMAC (RFC 5297); each call processes one complete component
+SfzCryptoStatus
+CAL_CM_S2V(
+        SfzCryptoCipherMacContext * const p_ctxt,
+        SfzCryptoCipherKey * const p_key,
+        uint8_t * p_data,
+        uint32_t length,
+        bool init,
+        bool final);
+
+// S2V-CMAC over all Count components in one sequence of CMAC tokens
+SfzCryptoStatus
+CAL_CM_S2V_Vector(
+        SfzCryptoCipherKey * const p_key,
+        const unsigned int Count,
+        uint8_t * const * Data_pp,
+        const uint32_t * Length_p,
+        uint8_t * V_p);
+
+/*----------------------------------------------------------------------------
+ * sfzcrypto_auth_crypt
+ */
+SfzCryptoStatus
+CAL_CM_AESSIV(
+        SfzCryptoAuthCryptContext * const p_actxt,
+        SfzCryptoCipherKey * const p_key,
+        uint8_t * p_nonce,
+        uint32_t nonce_len,
+        uint8_t * p_aad,
+        uint32_t aad_len,
+        uint32_t mac_len,
+        uint32_t data_len,
+        uint8_t * p_src,
+        uint32_t src_len,
+        uint8_t * p_dst,
+        uint32_t * const p_dst_len,
+        SfzCipherOp direction);
+
 SfzCryptoStatus
 CAL_CM_MULTI2(
         SfzCryptoCipherContext * p_ctxt,
@@ -111,6 +207,108 @@ CAL_CM_MULTI2(
         uint32_t * const p_dst_len,
         SfzCipherOp direction);
 
+/*----------------------------------------------------------------------------
+ * CAL_CM_AssetSearch
+ *
+ * Returns the AssetId (and optionally the data length) of the static asset
+ * with the given number. Results are cached until CAL_CM_AssetSearch_Init
+ * is called again or the asset is freed (CAL_CM_AssetSearch_Invalidate).
+ */
+SfzCryptoStatus
+CAL_CM_AssetSearch(
+        const uint32_t StaticAssetNumber,
+        SfzCryptoAssetId * const AssetId_p,
+        uint32_t * const DataLen_p);
+
+int
+CAL_CM_AssetSearch_Init(void);
+
+// searches the static assets listed in CALCM_ASSETSEARCH_PRELOAD_LIST
+void
+CAL_CM_AssetSearch_Preload(void);
+
+// SFZCRYPTO_ASSETID_INVALID invalidates all entries
+void
+CAL_CM_AssetSearch_Invalidate(
+        const SfzCryptoAssetId AssetId);
+
+/*----------------------------------------------------------------------------
+ * CAL_CM_RandomGenerate
+ *
+ * Single RandomNumber_Generate token; rand_num_size_bytes is limited to
+ * EIP123_LIMIT_RANDOM_GENERATE.
+ */
+SfzCryptoStatus
+CAL_CM_RandomGenerate(
+        uint32_t rand_num_size_bytes,
+        uint8_t * p_rand_num);
+
+// starts the random pool refill thread; returns 0 on success
+int
+CAL_CM_RandomPool_Init(void);
+
+// returns false when the request could not be served from the pool
+bool
+CAL_CM_RandomPool_Get(
+        const uint32_t Size,
+        uint8_t * Data_p);
+
+// prepares the random health tests; returns 0 on success
+int
+CAL_CM_RandomHealth_Init(void);
+
+// runs the random health tests on the random bytes retrieved from the CM;
+// returns false when the bytes must not be used
+bool
+CAL_CM_RandomHealth_Check(
+        const uint8_t * const Data_p,
+        const unsigned int ByteCount);
+
+// prepares the NVM Public Data cache; returns 0 on success
+int
+CAL_CM_NvmCache_Init(void);
+
+/*----------------------------------------------------------------------------
+ * CAL_CM_HmacKeyCache_Init
+ *
+ * Prepares the HMAC precomputed-key cache (see CALCM_HMAC_KEYCACHE_ENTRIES).
+ * Returns 0 on success.
+ */
+int
+CAL_CM_HmacKeyCache_Init(void);
+
+/*----------------------------------------------------------------------------
+ * CAL_CM_TokenTemplate_Get
+ *
+ * Starts CommandToken_p from the token template of the cipher context,
+ * provided it was made for the same parameters. Params_p holds all inputs
+ * that the template depends on (opcode first) and is compared bytewise, so
+ * it may not contain uninitialized padding. The templates are kept for the
+ * life of the process, so neither the token nor the parameters may contain a
+ * plaintext key.
+ * Returns false when there is no such template; CommandToken_p may then be
+ * partly written and the caller makes the whole token and offers it with
+ * CAL_CM_TokenTemplate_Put.
+ */
+bool
+CAL_CM_TokenTemplate_Get(
+        const void * const Context_p,
+        const void * const Params_p,
+        const unsigned int ParamsSize,
+        CMTokens_Command_t * const CommandToken_p);
+
+void
+CAL_CM_TokenTemplate_Put(
+        const void * const Context_p,
+        const void * const Params_p,
+        const unsigned int ParamsSize,
+        const CMTokens_Command_t * const CommandToken_p);
+
+// prepares the token templates (see CALCM_TOKEN_TEMPLATE_ENTRIES);
+// returns 0 on success
+int
+CAL_CM_TokenTemplate_Init(void);
+
 int
 CAL_CM_SysInfo_Get(
         CMTokens_SystemInfo_t * const SysInfo_p);
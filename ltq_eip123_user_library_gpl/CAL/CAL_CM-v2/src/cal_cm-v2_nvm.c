@@ -39,23 +39,50 @@
 #include "cm_tokens_asset.h"
 #include "cm_tokens_errdetails.h"
 
+#include "spal_memory.h"
+#include "spal_mutex.h"
+
 #define CAL_CM_NVM_DATASIZE_MAX 512   // must be a multiple of 4
-static uint8_t CAL_CM_nvm_data[CAL_CM_NVM_DATASIZE_MAX];
+
+/*
+ * NVM Public Data is programmed once (OTP), so each object is read from the
+ * CM only once and kept in a per-object cache entry. The entries are
+ * allocated on first use and never released, which allows the readers to
+ * access them without taking a lock. An update of an existing entry (see
+ * sfzcrypto_cm_nvm_publicdata_refresh) is published with a sequence counter
+ * that is odd while the update is ongoing; readers retry their copy when
+ * the counter changed.
+ */
+typedef struct
+{
+    volatile uint32_t Sequence;
+    uint32_t DataLen;
+    uint8_t Data[CAL_CM_NVM_DATASIZE_MAX];
+} CALCM_NvmCache_Entry_t;
+
+static CALCM_NvmCache_Entry_t * volatile
+CALCM_NvmCache[CMTOKENS_STATIC_ASSET_NUMBER_MAX + 1];
+
+// serializes the cache updates (not used by the readers)
+static SPAL_Mutex_t CALCM_NvmCache_Lock;
+static bool CALCM_NvmCache_IsInitialized = false;
+
 
 /*----------------------------------------------------------------------------
  * CAL_CM_get_hw_nvmdata
  *
- * This function reads all NVM data from the CM into the global buffer named
- * CAL_CM_nvm_data and returns the length of the NVM data.
+ * This function reads all NVM data from the CM into the provided buffer of
+ * CAL_CM_NVM_DATASIZE_MAX bytes and returns the length of the NVM data.
  */
 static SfzCryptoStatus
 CAL_CM_get_hw_nvmdata(
         SfzCryptoAssetId StaticAssetId,
+        uint8_t * const Buffer_p,
         uint32_t * const p_len)
 {
 #define DUMMY_ASSETID 0xa55e71d
 
-    uint32_t datalen = sizeof(CAL_CM_nvm_data);
+    uint32_t datalen = CAL_CM_NVM_DATASIZE_MAX;
     CALCM_DMA_Admin_t * Task_p = NULL;
     CMTokens_Command_t t_cmd;
     CMTokens_Response_t t_res;
@@ -77,7 +104,7 @@ CAL_CM_get_hw_nvmdata(
     funcres = CALAdapter_RandomWrapNvm_PrepareOutput(
                         Task_p,
                         datalen,
-                        CAL_CM_nvm_data,
+                        Buffer_p,
                         /*fOutputByteCount_Includes_TokenId:*/true);
 
     if (funcres != SFZCRYPTO_SUCCESS)
@@ -147,64 +174,194 @@ CAL_CM_get_hw_nvmdata(
 
 
 /*----------------------------------------------------------------------------
- * CAL_CM_find_nvm_object
+ * CALCMLib_NvmCache_Update
+ *
+ * Reads the NVM object from the CM and stores it in the cache, either in a
+ * new entry or by updating the existing entry. Must be called with
+ * CALCM_NvmCache_Lock held.
  */
 static SfzCryptoStatus
-CAL_CM_find_nvm_object(
-        uint8_t ObjectNr,
-        uint32_t * const AssetId_p,
-        uint32_t * const DataLen_p)
+CALCMLib_NvmCache_Update(
+        const uint32_t ObjectNr)
 {
-    CMTokens_Command_t t_cmd;
-    CMTokens_Response_t t_res;
+    CALCM_NvmCache_Entry_t * Entry_p = CALCM_NvmCache[ObjectNr];
     SfzCryptoStatus funcres;
+    SfzCryptoAssetId AssetId = SFZCRYPTO_ASSETID_INVALID;
+    uint32_t FoundLen = 0;
+    uint32_t datalen = 0;
+    uint8_t * Buffer_p;
 
-    *AssetId_p = SFZCRYPTO_ASSETID_INVALID;
+    // the search result is cached, the NVM objects do not move
+    funcres = CAL_CM_AssetSearch(ObjectNr, &AssetId, &FoundLen);
+    if (funcres != SFZCRYPTO_SUCCESS)
+        return funcres;
 
-    CMTokens_MakeToken_Clear(&t_cmd);
-    CMTokens_MakeCommand_AssetSearch(&t_cmd, (uint8_t)ObjectNr);
+    // return error code when NVM object was not found
+    if (AssetId == SFZCRYPTO_ASSETID_INVALID)
+        return SFZCRYPTO_INVALID_PARAMETER;
+
+    if (Entry_p == NULL)
+    {
+        // new entry; it is only published after it has been filled
+        Entry_p = SPAL_Memory_Calloc(1, sizeof(CALCM_NvmCache_Entry_t));
+        if (Entry_p == NULL)
+            return SFZCRYPTO_NO_MEMORY;
+
+        funcres = CAL_CM_get_hw_nvmdata(AssetId, Entry_p->Data, &datalen);
+        if (funcres != SFZCRYPTO_SUCCESS)
+        {
+            SPAL_Memory_Free(Entry_p);
+            return funcres;
+        }
+
+        Entry_p->DataLen = MIN(datalen, CAL_CM_NVM_DATASIZE_MAX);
+
+        __sync_synchronize();
+        CALCM_NvmCache[ObjectNr] = Entry_p;
+
+        return SFZCRYPTO_SUCCESS;
+    }
+
+    // existing entry: read into a temporary buffer first, to keep the
+    // window in which readers have to retry as short as possible
+    Buffer_p = SPAL_Memory_Alloc(CAL_CM_NVM_DATASIZE_MAX);
+    if (Buffer_p == NULL)
+        return SFZCRYPTO_NO_MEMORY;
+
+    funcres = CAL_CM_get_hw_nvmdata(AssetId, Buffer_p, &datalen);
+    if (funcres == SFZCRYPTO_SUCCESS)
+    {
+        Entry_p->Sequence++;            // odd: update ongoing
+        __sync_synchronize();
+
+        Entry_p->DataLen = MIN(datalen, CAL_CM_NVM_DATASIZE_MAX);
+        c_memcpy(Entry_p->Data, Buffer_p, Entry_p->DataLen);
+
+        __sync_synchronize();
+        Entry_p->Sequence++;            // even: stable
+    }
+
+    SPAL_Memory_Free(Buffer_p);
+
+    return funcres;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_NvmCache_Get
+ *
+ * Returns the cache entry for the NVM object, reading it from the CM when
+ * it is not yet cached (or when fRefresh is set).
+ */
+static SfzCryptoStatus
+CALCMLib_NvmCache_Get(
+        const uint32_t ObjectNr,
+        const bool fRefresh,
+        CALCM_NvmCache_Entry_t ** const Entry_pp)
+{
+    CALCM_NvmCache_Entry_t * Entry_p;
+    SfzCryptoStatus funcres = SFZCRYPTO_SUCCESS;
+
+    // lock-free fast path
+    Entry_p = CALCM_NvmCache[ObjectNr];
+    __sync_synchronize();
+
+    if (Entry_p != NULL && !fRefresh)
+    {
+        *Entry_pp = Entry_p;
+        return SFZCRYPTO_SUCCESS;
+    }
+
+    if (!CALCM_NvmCache_IsInitialized)
+        return SFZCRYPTO_NOT_INITIALISED;
+
+    SPAL_Mutex_Lock(&CALCM_NvmCache_Lock);
+
+    // another thread might have filled the entry in the meantime
+    if (CALCM_NvmCache[ObjectNr] == NULL || fRefresh)
+        funcres = CALCMLib_NvmCache_Update(ObjectNr);
+
+    Entry_p = CALCM_NvmCache[ObjectNr];
+
+    SPAL_Mutex_UnLock(&CALCM_NvmCache_Lock);
 
-    // exchange a message with the CM
-    funcres = CAL_CM_ExchangeToken(&t_cmd, &t_res);
     if (funcres != SFZCRYPTO_SUCCESS)
         return funcres;
 
-    // check for errors
+    __sync_synchronize();
+    *Entry_pp = Entry_p;
+
+    return SFZCRYPTO_SUCCESS;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_NvmCache_Copy
+ *
+ * Copies up to BufferLen bytes of the cached object data to Data_p (when
+ * not NULL) and returns the length of the object. Retries when the entry
+ * was updated during the copy.
+ */
+static uint32_t
+CALCMLib_NvmCache_Copy(
+        const CALCM_NvmCache_Entry_t * const Entry_p,
+        uint8_t * const Data_p,
+        const uint32_t BufferLen)
+{
+    uint32_t Seq;
+    uint32_t DataLen;
+
+    for (;;)
     {
-        int res;
+        Seq = Entry_p->Sequence;
+        if (Seq & 1)
+            continue;           // update ongoing
 
-        res = CMTokens_ParseResponse_Generic(&t_res);
+        __sync_synchronize();
 
-        if (res != 0)
-        {
-            const char * ErrMsg_p;
+        DataLen = Entry_p->DataLen;
+        if (Data_p != NULL)
+            c_memcpy(Data_p, Entry_p->Data, MIN(BufferLen, DataLen));
 
-            res = CMTokens_ParseResponse_ErrorDetails(&t_res, &ErrMsg_p);
+        __sync_synchronize();
 
-            // special situation: object not found
-            if (res == CMTOKENS_RESULT_SEQ_INVALID_ASSET)
-                return SFZCRYPTO_INVALID_PARAMETER;
+        if (Seq == Entry_p->Sequence)
+            break;
+    } // for
 
-            LOG_WARN(
-                "CAL_CM_find_nvm_object: "
-                "Failed with error %d (%s)\n",
-                res,
-                ErrMsg_p);
+    return DataLen;
+}
 
-            return SFZCRYPTO_INTERNAL_ERROR;
-        }
+
+/*----------------------------------------------------------------------------
+ * CAL_CM_NvmCache_Init
+ */
+int
+CAL_CM_NvmCache_Init(void)
+{
+    // cached data remains valid when the CM is re-initialized
+    if (CALCM_NvmCache_IsInitialized)
+        return 0;
+
+    if (SPAL_Mutex_Init(&CALCM_NvmCache_Lock) != SPAL_SUCCESS)
+    {
+        LOG_WARN(
+            "CAL_CM_NvmCache_Init: "
+            "Failed to create lock\n");
+        return -1;
     }
 
-    CMTokens_ParseResponse_AssetSearch(&t_res, AssetId_p, DataLen_p);
+    CALCM_NvmCache_IsInitialized = true;
 
-    return SFZCRYPTO_SUCCESS;
+    return 0;
 }
 
 
 /*----------------------------------------------------------------------------
  * sfzcrypto_cm_nvm_publicdata_read
  *
- * Uses the NVM_Read token to retrieve NVM data from the CM.
+ * Uses the NVM_Read token to retrieve NVM data from the CM, the first time
+ * an object is requested. Later requests are served from the cache.
  */
 SfzCryptoStatus
 sfzcrypto_cm_nvm_publicdata_read(
@@ -212,52 +369,59 @@ sfzcrypto_cm_nvm_publicdata_read(
         SfzCryptoOctetsOut * Data_p,
         uint32_t * const DataLen_p)
 {
-    SfzCryptoStatus funcres = SFZCRYPTO_SUCCESS;
-    SfzCryptoAssetId AssetId = SFZCRYPTO_ASSETID_INVALID;
-    uint32_t FoundLen = 0;
+    CALCM_NvmCache_Entry_t * Entry_p = NULL;
+    SfzCryptoStatus funcres;
     uint32_t datalen;
 
 #ifdef CALCM_STRICT_ARGS
     if (DataLen_p == NULL)
         return SFZCRYPTO_INVALID_PARAMETER;
 
-    if (ObjectNr > 255)
+    if (Data_p != NULL && *DataLen_p < 1)
         return SFZCRYPTO_INVALID_PARAMETER;
 #endif /* CALCM_STRICT_ARGS */
 
-    funcres = CAL_CM_find_nvm_object((uint8_t)ObjectNr, &AssetId, &FoundLen);
+    // static asset numbers are limited by the token format
+    if (ObjectNr > CMTOKENS_STATIC_ASSET_NUMBER_MAX)
+        return SFZCRYPTO_INVALID_PARAMETER;
+
+    funcres = CALCMLib_NvmCache_Get(ObjectNr, /*fRefresh:*/false, &Entry_p);
     if (funcres != SFZCRYPTO_SUCCESS)
         return funcres;
 
-    // return error code when NVM object was not found
-    if (AssetId == SFZCRYPTO_ASSETID_INVALID)
-        return SFZCRYPTO_INVALID_PARAMETER;
-
     if (Data_p == NULL)
     {
         // only update the length
-        *DataLen_p = FoundLen;
+        *DataLen_p = CALCMLib_NvmCache_Copy(Entry_p, NULL, 0);
         return SFZCRYPTO_SUCCESS;
     }
 
-    funcres = CAL_CM_get_hw_nvmdata(AssetId, &datalen);
-    if (funcres != SFZCRYPTO_SUCCESS)
-        return funcres;
-
-#ifdef CALCM_STRICT_ARGS
-    if (*DataLen_p < 1)
-        return SFZCRYPTO_INVALID_PARAMETER;
-#endif /* CALCM_STRICT_ARGS */
+    datalen = CALCMLib_NvmCache_Copy(Entry_p, Data_p, *DataLen_p);
 
     /* return requested amount, but never more then is available. */
-    datalen = MIN(*DataLen_p, datalen);
-
-    c_memcpy(Data_p, CAL_CM_nvm_data, datalen);
-    *DataLen_p = datalen;
+    *DataLen_p = MIN(*DataLen_p, datalen);
 
     return SFZCRYPTO_SUCCESS;
 }
 
+
+/*----------------------------------------------------------------------------
+ * sfzcrypto_cm_nvm_publicdata_refresh
+ *
+ * Reads the NVM object from the CM again and updates the cached copy.
+ */
+SfzCryptoStatus
+sfzcrypto_cm_nvm_publicdata_refresh(
+        uint32_t ObjectNr)
+{
+    CALCM_NvmCache_Entry_t * Entry_p = NULL;
+
+    if (ObjectNr > CMTOKENS_STATIC_ASSET_NUMBER_MAX)
+        return SFZCRYPTO_INVALID_PARAMETER;
+
+    return CALCMLib_NvmCache_Get(ObjectNr, /*fRefresh:*/true, &Entry_p);
+}
+
 #else
 
 // avoid the "empty translation unit" warning
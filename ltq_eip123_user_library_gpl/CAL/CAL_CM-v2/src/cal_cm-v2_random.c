@@ -92,13 +92,14 @@ sfzcrypto_cm_random_reseed(void)
 
 
 /*----------------------------------------------------------------------------
- * sfzcrypto_cm_rand_data
+ * CAL_CM_RandomGenerate
  *
- * p_rand_num required.
+ * Retrieves up to EIP123_LIMIT_RANDOM_GENERATE random bytes from the CM,
+ * using a single RandomNumber_Generate token.
  */
 #ifdef SFZCRYPTO_CF_RAND_DATA__CM
 SfzCryptoStatus
-sfzcrypto_cm_rand_data(
+CAL_CM_RandomGenerate(
         uint32_t rand_num_size_bytes,
         uint8_t * p_rand_num)
 {
@@ -107,16 +108,11 @@ sfzcrypto_cm_rand_data(
     CMTokens_Command_t t_cmd;
     CMTokens_Response_t t_res;
 
-#ifdef CALCM_STRICT_ARGS
-    if (p_rand_num == NULL)
-        return SFZCRYPTO_BAD_ARGUMENT;
-
     if (rand_num_size_bytes == 0 ||
         rand_num_size_bytes > EIP123_LIMIT_RANDOM_GENERATE)
     {
         return SFZCRYPTO_INVALID_LENGTH;
     }
-#endif
 
 #ifdef CALCM_STRICT_ARGS
     CMTokens_MakeToken_Clear(&t_cmd);
@@ -139,7 +135,7 @@ sfzcrypto_cm_rand_data(
     if (funcres != SFZCRYPTO_SUCCESS)
     {
         // there was a problem with the output buffer
-        LOG_INFO("sfzcrypto_cm_rand_data: Abort after prepare");
+        LOG_INFO("CAL_CM_RandomGenerate: Abort after prepare");
         CALCM_DMA_Free(Task_p);
         return funcres;                // ## RETURN ##
     }
@@ -170,7 +166,7 @@ sfzcrypto_cm_rand_data(
             res = CMTokens_ParseResponse_ErrorDetails(&t_res, &ErrMsg_p);
 
             LOG_WARN(
-                "sfzcrypto_cm_rand_data: "
+                "CAL_CM_RandomGenerate: "
                 "Failed with error %d (%s)\n",
                 res,
                 ErrMsg_p);
@@ -186,7 +182,7 @@ sfzcrypto_cm_rand_data(
         if (res > 0)
         {
             LOG_WARN(
-                "sfzcrypto_cm_rand_data: "
+                "CAL_CM_RandomGenerate: "
                 "quality warning=%d \n",
                 res);
         }
@@ -198,6 +194,60 @@ sfzcrypto_cm_rand_data(
 
     CALCM_DMA_Free(Task_p);
 
+#ifdef CALCM_RANDOM_HEALTH_TESTS
+    if (funcres == SFZCRYPTO_SUCCESS &&
+        !CAL_CM_RandomHealth_Check(p_rand_num, rand_num_size_bytes))
+    {
+        // do not hand out random numbers that failed the health tests
+        c_memset(p_rand_num, 0, rand_num_size_bytes);
+        return SFZCRYPTO_INTERNAL_ERROR;
+    }
+#endif
+
+    return funcres;
+}
+
+
+/*----------------------------------------------------------------------------
+ * sfzcrypto_cm_rand_data
+ *
+ * p_rand_num required.
+ *
+ * Small requests are served from the random pool, when enabled (see
+ * CALCM_RANDOM_POOL_SIZE). Other requests are retrieved from the CM
+ * directly, split in multiple tokens when they exceed the per-token limit.
+ */
+SfzCryptoStatus
+sfzcrypto_cm_rand_data(
+        uint32_t rand_num_size_bytes,
+        uint8_t * p_rand_num)
+{
+    SfzCryptoStatus funcres = SFZCRYPTO_SUCCESS;
+
+#ifdef CALCM_STRICT_ARGS
+    if (p_rand_num == NULL)
+        return SFZCRYPTO_BAD_ARGUMENT;
+
+    if (rand_num_size_bytes == 0)
+        return SFZCRYPTO_INVALID_LENGTH;
+#endif
+
+#if CALCM_RANDOM_POOL_SIZE > 0
+    if (CAL_CM_RandomPool_Get(rand_num_size_bytes, p_rand_num))
+        return SFZCRYPTO_SUCCESS;       // ## RETURN ##
+#endif
+
+    while (rand_num_size_bytes > 0 && funcres == SFZCRYPTO_SUCCESS)
+    {
+        uint32_t ChunkSize = MIN(rand_num_size_bytes,
+                                 EIP123_LIMIT_RANDOM_GENERATE);
+
+        funcres = CAL_CM_RandomGenerate(ChunkSize, p_rand_num);
+
+        p_rand_num += ChunkSize;
+        rand_num_size_bytes -= ChunkSize;
+    } // while
+
     return funcres;
 }
 #endif /* SFZCRYPTO_CF_RAND_DATA__CM */
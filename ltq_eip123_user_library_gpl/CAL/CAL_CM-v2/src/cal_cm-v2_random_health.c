@@ -0,0 +1,680 @@
+/* cal_cm-v2_random_health.c
+ *
+ * Implementation of the CAL API for Crypto Module.
+ *
+ * This file implements the continuous health tests on the random numbers
+ * retrieved from the CM.
+ */
+
+/*****************************************************************************
+* Copyright (c) 2007-2015 INSIDE Secure B.V. All Rights Reserved.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 2 of the License, or
+* any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "c_cal_cm-v2.h"
+
+#if defined(SFZCRYPTO_CF_RAND_DATA__CM) && defined(CALCM_RANDOM_HEALTH_TESTS)
+
+#include "basic_defs.h"
+#include "clib.h"
+#include "log.h"
+
+#include "cal_cm.h"             // the API to implement
+
+#include "cal_cm-v2_internal.h" // CAL_CM_RandomHealth_*
+
+#include "spal_mutex.h"
+
+#ifdef __SSSE3__
+#include <tmmintrin.h>          // _mm_shuffle_epi8
+#endif
+
+/*
+ * All random bytes delivered by CAL_CM_RandomGenerate form one stream, on
+ * which the following tests run:
+ *
+ * - Repetition Count and Adaptive Proportion (NIST SP 800-90B, 4.4), with
+ *   bytes as samples and full entropy assumed; see the cutoffs in
+ *   cs_cal_cm-v2.h.
+ * - Monobit, Poker, Runs and Long Run (FIPS 140-2, 4.9.1) on each block of
+ *   20000 bits. These have a false alarm rate of about 10^-4 per block
+ *   (mostly from the Monobit bounds), so they are only reported.
+ *
+ * The kernels process 64 bits at a time: bytes are compared in parallel
+ * (SWAR), the Poker histogram is counted from bit-sliced nibbles and runs
+ * are found from the bit transitions. The Monobit count uses SSSE3 where
+ * available.
+ */
+#define CALCM_HEALTH_BLOCK_BYTES    (20000 / 8)
+#define CALCM_HEALTH_LONG_RUN       26
+
+#define CALCM_HEALTH_ONES           0x0101010101010101ULL
+#define CALCM_HEALTH_LOW7           0x7F7F7F7F7F7F7F7FULL
+#define CALCM_HEALTH_NIBBLE_BIT0    0x1111111111111111ULL
+
+// tests that cause the random numbers to be rejected
+#define CALCM_HEALTH_REJECT_MASK \
+    ((1U << CALCM_RANDOM_HEALTH_REPETITION_COUNT) | \
+     (1U << CALCM_RANDOM_HEALTH_ADAPTIVE_PROPORTION))
+
+static struct
+{
+    // Repetition Count Test
+    uint8_t RCT_Last;
+    unsigned int RCT_Count;
+
+    // Adaptive Proportion Test
+    uint8_t APT_Ref;
+    unsigned int APT_Count;
+    unsigned int APT_Samples;       // 0 = window not started
+
+    // FIPS 140-2 tests, current block
+    unsigned int BlockBytes;
+    uint32_t Ones;
+    uint32_t Nibbles[16];
+    uint32_t Runs[2][6];            // per bit value, lengths 1..5 and 6+
+    bool fLongRun;
+    unsigned int RunBit;
+    unsigned int RunLength;         // 0 = no bits in the block yet
+
+    CALCM_RandomHealth_Stats_t Stats;
+
+    CALCM_RandomHealth_FailFunc_t FailFunc_p;
+    void * FailArg_p;
+} CALCM_Health;
+
+static SPAL_Mutex_t CALCM_Health_Lock;
+static bool CALCM_Health_IsInitialized = false;
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_Health_Load64
+ *
+ * Loads 8 bytes; the first byte is the most significant one, so that the
+ * bits are in stream order, most significant bit first.
+ */
+static inline uint64_t
+CALCMLib_Health_Load64(
+        const uint8_t * const p)
+{
+    uint64_t w;
+
+    c_memcpy(&w, p, sizeof(w));
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+    w = __builtin_bswap64(w);
+#endif
+
+    return w;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_Health_CountZeroBytes
+ *
+ * Returns the number of zero bytes in w.
+ */
+static inline unsigned int
+CALCMLib_Health_CountZeroBytes(
+        const uint64_t w)
+{
+    // bit 7 of a byte is set when the byte is zero
+    const uint64_t z = ~(((w & CALCM_HEALTH_LOW7) + CALCM_HEALTH_LOW7) |
+                         w | CALCM_HEALTH_LOW7);
+
+    return (unsigned int)__builtin_popcountll(z);
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_Health_PopCount
+ *
+ * Returns the number of 1 bits in the ByteCount bytes at Data_p.
+ */
+static uint32_t
+CALCMLib_Health_PopCount(
+        const uint8_t * Data_p,
+        unsigned int ByteCount)
+{
+    uint32_t Count = 0;
+
+#ifdef __SSSE3__
+    {
+        // number of 1 bits per nibble value
+        const __m128i Table = _mm_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3,
+                                            1, 2, 2, 3, 2, 3, 3, 4);
+        const __m128i LowNibbles = _mm_set1_epi8(0x0F);
+        __m128i Sum = _mm_setzero_si128();
+
+        while (ByteCount >= 16)
+        {
+            const __m128i v = _mm_loadu_si128((const __m128i *)Data_p);
+            const __m128i Lo = _mm_and_si128(v, LowNibbles);
+            const __m128i Hi = _mm_and_si128(_mm_srli_epi16(v, 4), LowNibbles);
+            const __m128i c = _mm_add_epi8(_mm_shuffle_epi8(Table, Lo),
+                                           _mm_shuffle_epi8(Table, Hi));
+
+            // add the byte counts to the two 64-bit sums
+            Sum = _mm_add_epi64(Sum, _mm_sad_epu8(c, _mm_setzero_si128()));
+
+            Data_p += 16;
+            ByteCount -= 16;
+        }
+
+        Count = (uint32_t)_mm_cvtsi128_si32(Sum) +
+                (uint32_t)_mm_cvtsi128_si32(_mm_unpackhi_epi64(Sum, Sum));
+    }
+#endif /* __SSSE3__ */
+
+    while (ByteCount >= 8)
+    {
+        uint64_t w;
+
+        c_memcpy(&w, Data_p, sizeof(w));
+        Count += (uint32_t)__builtin_popcountll(w);
+
+        Data_p += 8;
+        ByteCount -= 8;
+    }
+
+    while (ByteCount > 0)
+    {
+        Count += (uint32_t)__builtin_popcount(*Data_p++);
+        ByteCount--;
+    }
+
+    return Count;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_Health_Poker
+ *
+ * Adds the 4-bit values in the ByteCount bytes at Data_p to the histogram.
+ * Per 64-bit word, the four bits of all 16 nibbles are separated into bit
+ * planes; the number of nibbles with value v is then the population count
+ * of the AND of the (inverted where v has a 0) planes.
+ */
+static void
+CALCMLib_Health_Poker(
+        const uint8_t * Data_p,
+        unsigned int ByteCount)
+{
+    uint32_t * const Nibbles_p = CALCM_Health.Nibbles;
+
+    while (ByteCount >= 8)
+    {
+        uint64_t w;
+        uint64_t Lo[4];         // planes of bits 1:0, for values 0..3
+        uint64_t Hi[4];         // planes of bits 3:2, for values 0..3
+        uint64_t b0, b1, b2, b3;
+        unsigned int v;
+
+        c_memcpy(&w, Data_p, sizeof(w));
+
+        b0 = w & CALCM_HEALTH_NIBBLE_BIT0;
+        b1 = (w >> 1) & CALCM_HEALTH_NIBBLE_BIT0;
+        b2 = (w >> 2) & CALCM_HEALTH_NIBBLE_BIT0;
+        b3 = (w >> 3) & CALCM_HEALTH_NIBBLE_BIT0;
+
+        Lo[0] = ~b1 & ~b0 & CALCM_HEALTH_NIBBLE_BIT0;
+        Lo[1] = ~b1 & b0;
+        Lo[2] = b1 & ~b0;
+        Lo[3] = b1 & b0;
+
+        Hi[0] = ~b3 & ~b2 & CALCM_HEALTH_NIBBLE_BIT0;
+        Hi[1] = ~b3 & b2;
+        Hi[2] = b3 & ~b2;
+        Hi[3] = b3 & b2;
+
+        for (v = 0; v < 16; v++)
+            Nibbles_p[v] += (uint32_t)__builtin_popcountll(Hi[v >> 2] &
+                                                           Lo[v & 3]);
+
+        Data_p += 8;
+        ByteCount -= 8;
+    }
+
+    while (ByteCount > 0)
+    {
+        Nibbles_p[*Data_p >> 4]++;
+        Nibbles_p[*Data_p & 15]++;
+
+        Data_p++;
+        ByteCount--;
+    }
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_Health_EndRun
+ */
+static inline void
+CALCMLib_Health_EndRun(void)
+{
+    const unsigned int Length = CALCM_Health.RunLength;
+
+    if (Length >= CALCM_HEALTH_LONG_RUN)
+        CALCM_Health.fLongRun = true;
+
+    CALCM_Health.Runs[CALCM_Health.RunBit][MIN(Length, 6) - 1]++;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_Health_RunsWord
+ *
+ * Processes the BitCount (1..64) most significant bits of w for the Runs
+ * tests. Only the bit transitions are visited, not every bit.
+ */
+static void
+CALCMLib_Health_RunsWord(
+        const uint64_t w,
+        const unsigned int BitCount)
+{
+    uint64_t Transitions;
+    unsigned int Pos = 0;
+
+    if (CALCM_Health.RunLength == 0)
+        CALCM_Health.RunBit = (unsigned int)(w >> 63);
+
+    // bit set where a bit differs from the bit before it
+    Transitions = w ^ ((w >> 1) | ((uint64_t)CALCM_Health.RunBit << 63));
+
+    if (BitCount < 64)
+        Transitions &= ~(~(uint64_t)0 >> BitCount);
+
+    while (Transitions != 0)
+    {
+        const unsigned int t = (unsigned int)__builtin_clzll(Transitions);
+
+        CALCM_Health.RunLength += t - Pos;
+        CALCMLib_Health_EndRun();
+
+        CALCM_Health.RunBit ^= 1;
+        CALCM_Health.RunLength = 0;
+        Pos = t;
+
+        Transitions ^= (uint64_t)1 << (63 - t);
+    }
+
+    CALCM_Health.RunLength += BitCount - Pos;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_Health_Runs
+ */
+static void
+CALCMLib_Health_Runs(
+        const uint8_t * Data_p,
+        unsigned int ByteCount)
+{
+    while (ByteCount >= 8)
+    {
+        CALCMLib_Health_RunsWord(CALCMLib_Health_Load64(Data_p), 64);
+
+        Data_p += 8;
+        ByteCount -= 8;
+    }
+
+    while (ByteCount > 0)
+    {
+        CALCMLib_Health_RunsWord((uint64_t)*Data_p << 56, 8);
+
+        Data_p++;
+        ByteCount--;
+    }
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_Health_EndBlock
+ *
+ * Evaluates the FIPS 140-2 tests on a completed block of 20000 bits and
+ * starts the next block. Returns the mask of failed tests.
+ */
+static unsigned int
+CALCMLib_Health_EndBlock(void)
+{
+    // FIPS 140-2, 4.9.1: allowed number of runs of length 1..5 and 6+
+    static const uint16_t RunsMin[6] = { 2315, 1114, 527, 240, 103, 103 };
+    static const uint16_t RunsMax[6] = { 2685, 1386, 723, 384, 209, 209 };
+    unsigned int FailMask = 0;
+    uint32_t SumSquares = 0;
+    int32_t Poker;
+    unsigned int i;
+
+    CALCMLib_Health_EndRun();
+
+    if (CALCM_Health.Ones <= 9725 || CALCM_Health.Ones >= 10275)
+        FailMask |= 1U << CALCM_RANDOM_HEALTH_MONOBIT;
+
+    // X = 16/5000 * sum(f(i)^2) - 5000, must be in (2.16, 46.17);
+    // multiplied by 5000 here
+    for (i = 0; i < 16; i++)
+        SumSquares += CALCM_Health.Nibbles[i] * CALCM_Health.Nibbles[i];
+
+    Poker = (int32_t)(16 * SumSquares) - 5000 * 5000;
+    if (Poker <= 10800 || Poker >= 230850)
+        FailMask |= 1U << CALCM_RANDOM_HEALTH_POKER;
+
+    for (i = 0; i < 6; i++)
+    {
+        if (CALCM_Health.Runs[0][i] < RunsMin[i] ||
+            CALCM_Health.Runs[0][i] > RunsMax[i] ||
+            CALCM_Health.Runs[1][i] < RunsMin[i] ||
+            CALCM_Health.Runs[1][i] > RunsMax[i])
+        {
+            FailMask |= 1U << CALCM_RANDOM_HEALTH_RUNS;
+        }
+    }
+
+    if (CALCM_Health.fLongRun)
+        FailMask |= 1U << CALCM_RANDOM_HEALTH_LONG_RUN;
+
+    CALCM_Health.Stats.Blocks++;
+
+    CALCM_Health.BlockBytes = 0;
+    CALCM_Health.Ones = 0;
+    c_memset(CALCM_Health.Nibbles, 0, sizeof(CALCM_Health.Nibbles));
+    c_memset(CALCM_Health.Runs, 0, sizeof(CALCM_Health.Runs));
+    CALCM_Health.fLongRun = false;
+    CALCM_Health.RunLength = 0;
+
+    return FailMask;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_Health_RepetitionCount
+ *
+ * Returns the mask of failed tests. Eight byte pairs are compared at once;
+ * only when one of them is equal, the bytes are checked one by one.
+ */
+static unsigned int
+CALCMLib_Health_RepetitionCount(
+        const uint8_t * const Data_p,
+        const unsigned int ByteCount)
+{
+    unsigned int FailMask = 0;
+    unsigned int i = 0;
+
+    while (i < ByteCount)
+    {
+        if (ByteCount - i >= 9 && Data_p[i] != CALCM_Health.RCT_Last)
+        {
+            uint64_t a, b;
+
+            c_memcpy(&a, Data_p + i, sizeof(a));
+            c_memcpy(&b, Data_p + i + 1, sizeof(b));
+
+            if (CALCMLib_Health_CountZeroBytes(a ^ b) == 0)
+            {
+                // Data_p[i..i+8] has no repetitions
+                CALCM_Health.RCT_Last = Data_p[i + 8];
+                CALCM_Health.RCT_Count = 1;
+                i += 9;
+                continue;
+            }
+        }
+
+        if (CALCM_Health.RCT_Count > 0 &&
+            Data_p[i] == CALCM_Health.RCT_Last)
+        {
+            if (++CALCM_Health.RCT_Count == CALCM_RANDOM_HEALTH_RCT_CUTOFF)
+                FailMask |= 1U << CALCM_RANDOM_HEALTH_REPETITION_COUNT;
+        }
+        else
+        {
+            CALCM_Health.RCT_Last = Data_p[i];
+            CALCM_Health.RCT_Count = 1;
+        }
+
+        i++;
+    }
+
+    return FailMask;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_Health_AdaptiveProportion
+ *
+ * Returns the mask of failed tests. The bytes equal to the first byte of
+ * the window are counted eight at a time.
+ */
+static unsigned int
+CALCMLib_Health_AdaptiveProportion(
+        const uint8_t * Data_p,
+        unsigned int ByteCount)
+{
+    unsigned int FailMask = 0;
+
+    while (ByteCount > 0)
+    {
+        unsigned int Chunk;
+        unsigned int Count = 0;
+        unsigned int i = 0;
+
+        if (CALCM_Health.APT_Samples == 0)
+        {
+            // start a window
+            CALCM_Health.APT_Ref = *Data_p++;
+            CALCM_Health.APT_Count = 1;
+            CALCM_Health.APT_Samples = 1;
+            ByteCount--;
+            continue;
+        }
+
+        Chunk = MIN(ByteCount,
+                    CALCM_RANDOM_HEALTH_APT_WINDOW - CALCM_Health.APT_Samples);
+
+        if (Chunk >= 8)
+        {
+            const uint64_t Ref = CALCM_Health.APT_Ref * CALCM_HEALTH_ONES;
+
+            for (; i + 8 <= Chunk; i += 8)
+            {
+                uint64_t w;
+
+                c_memcpy(&w, Data_p + i, sizeof(w));
+                Count += CALCMLib_Health_CountZeroBytes(w ^ Ref);
+            }
+        }
+
+        for (; i < Chunk; i++)
+            if (Data_p[i] == CALCM_Health.APT_Ref)
+                Count++;
+
+        if (CALCM_Health.APT_Count < CALCM_RANDOM_HEALTH_APT_CUTOFF &&
+            CALCM_Health.APT_Count + Count >= CALCM_RANDOM_HEALTH_APT_CUTOFF)
+        {
+            FailMask |= 1U << CALCM_RANDOM_HEALTH_ADAPTIVE_PROPORTION;
+        }
+
+        CALCM_Health.APT_Count += Count;
+        CALCM_Health.APT_Samples += Chunk;
+
+        if (CALCM_Health.APT_Samples == CALCM_RANDOM_HEALTH_APT_WINDOW)
+        {
+            CALCM_Health.APT_Samples = 0;
+            CALCM_Health.Stats.Windows++;
+        }
+
+        Data_p += Chunk;
+        ByteCount -= Chunk;
+    }
+
+    return FailMask;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CAL_CM_RandomHealth_Check
+ */
+bool
+CAL_CM_RandomHealth_Check(
+        const uint8_t * const Data_p,
+        const unsigned int ByteCount)
+{
+    CALCM_RandomHealth_FailFunc_t FailFunc_p;
+    void * FailArg_p;
+    unsigned int FailMask;
+    unsigned int Done = 0;
+    bool fReject = false;
+    int t;
+
+    if (!CALCM_Health_IsInitialized)
+        return true;
+
+    SPAL_Mutex_Lock(&CALCM_Health_Lock);
+
+    FailMask = CALCMLib_Health_RepetitionCount(Data_p, ByteCount);
+    FailMask |= CALCMLib_Health_AdaptiveProportion(Data_p, ByteCount);
+
+    while (Done < ByteCount)
+    {
+        const unsigned int Chunk =
+                    MIN(ByteCount - Done,
+                        CALCM_HEALTH_BLOCK_BYTES - CALCM_Health.BlockBytes);
+
+        CALCM_Health.Ones += CALCMLib_Health_PopCount(Data_p + Done, Chunk);
+        CALCMLib_Health_Poker(Data_p + Done, Chunk);
+        CALCMLib_Health_Runs(Data_p + Done, Chunk);
+
+        CALCM_Health.BlockBytes += Chunk;
+        Done += Chunk;
+
+        if (CALCM_Health.BlockBytes == CALCM_HEALTH_BLOCK_BYTES)
+            FailMask |= CALCMLib_Health_EndBlock();
+    }
+
+    CALCM_Health.Stats.Bytes += ByteCount;
+
+    for (t = 0; t < CALCM_RANDOM_HEALTH_TEST_COUNT; t++)
+        if (FailMask & (1U << t))
+            CALCM_Health.Stats.Failures[t]++;
+
+#ifdef CALCM_RANDOM_HEALTH_REJECT
+    if (FailMask & CALCM_HEALTH_REJECT_MASK)
+    {
+        CALCM_Health.Stats.Rejects++;
+        fReject = true;
+    }
+#endif
+
+    FailFunc_p = CALCM_Health.FailFunc_p;
+    FailArg_p = CALCM_Health.FailArg_p;
+
+    SPAL_Mutex_UnLock(&CALCM_Health_Lock);
+
+    if (FailMask != 0)
+    {
+        LOG_WARN(
+            "CAL_CM_RandomHealth_Check: "
+            "Failed tests 0x%x%s\n",
+            FailMask,
+            fReject ? ", output rejected" : "");
+
+        if (FailFunc_p != NULL)
+        {
+            for (t = 0; t < CALCM_RANDOM_HEALTH_TEST_COUNT; t++)
+                if (FailMask & (1U << t))
+                    FailFunc_p((CALCM_RandomHealth_Test_t)t, FailArg_p);
+        }
+    }
+
+    return !fReject;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CAL_CM_RandomHealth_Init
+ */
+int
+CAL_CM_RandomHealth_Init(void)
+{
+    if (CALCM_Health_IsInitialized)
+        return 0;
+
+    if (SPAL_Mutex_Init(&CALCM_Health_Lock) != SPAL_SUCCESS)
+    {
+        LOG_WARN(
+            "CAL_CM_RandomHealth_Init: "
+            "Failed to create lock\n");
+        return -1;
+    }
+
+    // keeps a callback installed before sfzcrypto_cm_init
+    CALCM_Health.RCT_Count = 0;
+    CALCM_Health.APT_Samples = 0;
+    CALCM_Health.BlockBytes = 0;
+    CALCM_Health.RunLength = 0;
+
+    CALCM_Health_IsInitialized = true;
+
+    return 0;
+}
+
+
+/*----------------------------------------------------------------------------
+ * sfzcrypto_cm_random_health_set_callback
+ */
+SfzCryptoStatus
+sfzcrypto_cm_random_health_set_callback(
+        CALCM_RandomHealth_FailFunc_t FailFunc_p,
+        void * FailArg_p)
+{
+    if (!CALCM_Health_IsInitialized)
+        return SFZCRYPTO_NOT_INITIALISED;
+
+    SPAL_Mutex_Lock(&CALCM_Health_Lock);
+    CALCM_Health.FailFunc_p = FailFunc_p;
+    CALCM_Health.FailArg_p = FailArg_p;
+    SPAL_Mutex_UnLock(&CALCM_Health_Lock);
+
+    return SFZCRYPTO_SUCCESS;
+}
+
+
+/*----------------------------------------------------------------------------
+ * sfzcrypto_cm_random_health_stats
+ */
+SfzCryptoStatus
+sfzcrypto_cm_random_health_stats(
+        CALCM_RandomHealth_Stats_t * const Stats_p)
+{
+    if (Stats_p == NULL)
+        return SFZCRYPTO_BAD_ARGUMENT;
+
+    if (!CALCM_Health_IsInitialized)
+        return SFZCRYPTO_NOT_INITIALISED;
+
+    SPAL_Mutex_Lock(&CALCM_Health_Lock);
+    *Stats_p = CALCM_Health.Stats;
+    SPAL_Mutex_UnLock(&CALCM_Health_Lock);
+
+    return SFZCRYPTO_SUCCESS;
+}
+
+#else
+
+// avoid the "empty translation unit" warning
+extern const int _avoid_empty_translation_unit;
+
+#endif /* SFZCRYPTO_CF_RAND_DATA__CM && CALCM_RANDOM_HEALTH_TESTS */
+
+/* end of file cal_cm-v2_random_health.c */
@@ -0,0 +1,534 @@
+/* cal_cm-v2_randompool.c
+ *
+ * Implementation of the CAL API for Crypto Module.
+ *
+ * This file implements the random number pool, which is refilled from the
+ * CM by a background thread and serves the small random number requests.
+ */
+
+/*****************************************************************************
+* Copyright (c) 2007-2015 INSIDE Secure B.V. All Rights Reserved.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 2 of the License, or
+* any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "c_cal_cm-v2.h"
+
+#if defined(SFZCRYPTO_CF_RAND_DATA__CM) && (CALCM_RANDOM_POOL_SIZE > 0)
+
+#include "basic_defs.h"
+#include "clib.h"
+#include "log.h"
+
+#include "cal_cm.h"             // the API to implement
+
+#include "cal_cm-v2_internal.h" // CAL_CM_RandomGenerate
+
+#include "spal_mutex.h"
+#include "spal_semaphore.h"
+#include "spal_thread.h"
+
+#ifdef CALCM_RANDOM_POOL_USE_POSIX
+#include <pthread.h>            // pthread_atfork
+#include <time.h>               // clock_gettime
+#endif
+
+#if (CALCM_RANDOM_POOL_LOW_WATERMARK >= CALCM_RANDOM_POOL_HIGH_WATERMARK) || \
+    (CALCM_RANDOM_POOL_HIGH_WATERMARK > CALCM_RANDOM_POOL_SIZE)
+#error "CALCM_RANDOM_POOL: invalid watermarks"
+#endif
+
+#if CALCM_RANDOM_POOL_REFILL_CHUNK > EIP123_LIMIT_RANDOM_GENERATE
+#error "CALCM_RANDOM_POOL_REFILL_CHUNK exceeds EIP123_LIMIT_RANDOM_GENERATE"
+#endif
+
+/*
+ * The pool is a ring buffer. Random bytes are handed out only once: they
+ * are wiped from the ring when taken. The lock only covers the ring
+ * administration and the copy; the CM is accessed by the refill thread
+ * without holding it.
+ */
+static uint8_t CALCM_RandomPool_Ring[CALCM_RANDOM_POOL_SIZE];
+static unsigned int CALCM_RandomPool_ReadIndex;
+static unsigned int CALCM_RandomPool_Level;     // bytes available
+
+// only used by the refill thread
+static uint8_t CALCM_RandomPool_Chunk[CALCM_RANDOM_POOL_REFILL_CHUNK];
+
+static SPAL_Mutex_t CALCM_RandomPool_Lock;
+static SPAL_Semaphore_t CALCM_RandomPool_RefillRequest;
+static bool CALCM_RandomPool_fRefillRequested;
+static bool CALCM_RandomPool_fThreadRunning;
+static bool CALCM_RandomPool_IsInitialized = false;
+
+static CALCM_RandomPool_Stats_t CALCM_RandomPool_Stats;
+
+#ifdef CALCM_RANDOM_POOL_USE_POSIX
+// set in a child process created with fork(), see CALCMLib_RandomPool_Restart
+static bool CALCM_RandomPool_fForked;
+#endif
+
+static void *
+CALCMLib_RandomPool_Thread(
+        void * const Param_p);
+
+
+#ifdef CALCM_RANDOM_POOL_USE_POSIX
+/*----------------------------------------------------------------------------
+ * CALCMLib_RandomPool_TimeUS
+ */
+static uint32_t
+CALCMLib_RandomPool_TimeUS(void)
+{
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+        return 0;
+
+    return (uint32_t)(ts.tv_sec * 1000000UL + ts.tv_nsec / 1000);
+}
+#endif /* CALCM_RANDOM_POOL_USE_POSIX */
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_RandomPool_RequestRefill
+ *
+ * Wakes up the refill thread. Must be called with the lock held.
+ */
+static void
+CALCMLib_RandomPool_RequestRefill(void)
+{
+    if (!CALCM_RandomPool_fRefillRequested)
+    {
+        CALCM_RandomPool_fRefillRequested = true;
+        SPAL_Semaphore_Post(&CALCM_RandomPool_RefillRequest);
+    }
+}
+
+
+#ifdef CALCM_RANDOM_POOL_USE_POSIX
+/*----------------------------------------------------------------------------
+ * CALCMLib_RandomPool_AtFork_Prepare
+ *
+ * Takes the lock, so that no other thread holds it while the process is
+ * copied by fork().
+ */
+static void
+CALCMLib_RandomPool_AtFork_Prepare(void)
+{
+    SPAL_Mutex_Lock(&CALCM_RandomPool_Lock);
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_RandomPool_AtFork_Parent
+ */
+static void
+CALCMLib_RandomPool_AtFork_Parent(void)
+{
+    SPAL_Mutex_UnLock(&CALCM_RandomPool_Lock);
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_RandomPool_AtFork_Child
+ *
+ * The child has a copy of the pool of the parent, but not the refill
+ * thread. The copied random bytes are discarded (both processes would
+ * otherwise use the same numbers) and the lock taken by
+ * CALCMLib_RandomPool_AtFork_Prepare is released. The semaphore is kept:
+ * at most it still holds a request of the parent, which only causes an
+ * extra refill round. The CM is reseeded and the refill thread is started by
+ * the first request in the child, see CALCMLib_RandomPool_Restart.
+ */
+static void
+CALCMLib_RandomPool_AtFork_Child(void)
+{
+    c_memset(CALCM_RandomPool_Ring, 0, sizeof(CALCM_RandomPool_Ring));
+    CALCM_RandomPool_ReadIndex = 0;
+    CALCM_RandomPool_Level = 0;
+    CALCM_RandomPool_Stats.Discards++;
+
+    CALCM_RandomPool_fRefillRequested = false;
+    CALCM_RandomPool_fThreadRunning = false;
+    CALCM_RandomPool_fForked = true;
+
+    SPAL_Mutex_UnLock(&CALCM_RandomPool_Lock);
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_RandomPool_Restart
+ *
+ * Reseeds the CM and starts the refill thread in a child process. Called
+ * by the first request after fork(), without the lock.
+ */
+static void
+CALCMLib_RandomPool_Restart(void)
+{
+    SPAL_Thread_t Thread;
+
+    LOG_INFO(
+        "CALCMLib_RandomPool_Restart: "
+        "Process changed, pool discarded\n");
+
+#ifdef SFZCRYPTO_CF_RANDOM_RESEED__CM
+    (void)sfzcrypto_cm_random_reseed();
+#endif
+
+    if (SPAL_Thread_Create(
+                &Thread,
+                NULL,
+                CALCMLib_RandomPool_Thread,
+                NULL) != SPAL_SUCCESS)
+    {
+        return;
+    }
+
+    SPAL_Thread_Detach(Thread);
+
+    SPAL_Mutex_Lock(&CALCM_RandomPool_Lock);
+    CALCM_RandomPool_fThreadRunning = true;
+    CALCMLib_RandomPool_RequestRefill();
+    SPAL_Mutex_UnLock(&CALCM_RandomPool_Lock);
+}
+#endif /* CALCM_RANDOM_POOL_USE_POSIX */
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_RandomPool_Refill
+ *
+ * Tops up the pool to the high watermark. Called by the refill thread.
+ * Returns false when the CM failed to provide random numbers.
+ */
+static bool
+CALCMLib_RandomPool_Refill(void)
+{
+    bool fSuccess = true;
+
+    for (;;)
+    {
+        unsigned int Needed;
+        unsigned int ChunkSize;
+        SfzCryptoStatus funcres;
+#ifdef CALCM_RANDOM_POOL_USE_POSIX
+        uint32_t StartUS;
+        uint32_t LatencyUS;
+#endif
+
+        SPAL_Mutex_Lock(&CALCM_RandomPool_Lock);
+        Needed = 0;
+        if (CALCM_RandomPool_Level < CALCM_RANDOM_POOL_HIGH_WATERMARK)
+            Needed = CALCM_RANDOM_POOL_HIGH_WATERMARK - CALCM_RandomPool_Level;
+        SPAL_Mutex_UnLock(&CALCM_RandomPool_Lock);
+
+        if (Needed == 0)
+            break;
+
+        ChunkSize = MIN(Needed, CALCM_RANDOM_POOL_REFILL_CHUNK);
+
+#ifdef CALCM_RANDOM_POOL_USE_POSIX
+        StartUS = CALCMLib_RandomPool_TimeUS();
+#endif
+
+        funcres = CAL_CM_RandomGenerate(ChunkSize, CALCM_RandomPool_Chunk);
+
+#ifdef CALCM_RANDOM_POOL_USE_POSIX
+        LatencyUS = CALCMLib_RandomPool_TimeUS() - StartUS;
+#endif
+
+        if (funcres != SFZCRYPTO_SUCCESS)
+        {
+            LOG_WARN(
+                "CALCMLib_RandomPool_Refill: "
+                "Failed with error %d\n",
+                funcres);
+
+            SPAL_Mutex_Lock(&CALCM_RandomPool_Lock);
+            CALCM_RandomPool_Stats.RefillErrors++;
+            SPAL_Mutex_UnLock(&CALCM_RandomPool_Lock);
+
+            fSuccess = false;
+            break;
+        }
+
+        SPAL_Mutex_Lock(&CALCM_RandomPool_Lock);
+        {
+            unsigned int Free = CALCM_RANDOM_POOL_SIZE - CALCM_RandomPool_Level;
+            unsigned int WriteIndex;
+            unsigned int n;
+            unsigned int i = 0;
+
+            ChunkSize = MIN(ChunkSize, Free);
+
+            WriteIndex = (CALCM_RandomPool_ReadIndex + CALCM_RandomPool_Level) %
+                         CALCM_RANDOM_POOL_SIZE;
+
+            while (i < ChunkSize)
+            {
+                n = MIN(ChunkSize - i, CALCM_RANDOM_POOL_SIZE - WriteIndex);
+                c_memcpy(CALCM_RandomPool_Ring + WriteIndex,
+                         CALCM_RandomPool_Chunk + i,
+                         n);
+                WriteIndex = (WriteIndex + n) % CALCM_RANDOM_POOL_SIZE;
+                i += n;
+            }
+
+            CALCM_RandomPool_Level += ChunkSize;
+
+            CALCM_RandomPool_Stats.Refills++;
+            CALCM_RandomPool_Stats.RefillBytes += ChunkSize;
+#ifdef CALCM_RANDOM_POOL_USE_POSIX
+            CALCM_RandomPool_Stats.RefillLatencyTotalUS += LatencyUS;
+            if (LatencyUS > CALCM_RandomPool_Stats.RefillLatencyMaxUS)
+                CALCM_RandomPool_Stats.RefillLatencyMaxUS = LatencyUS;
+#endif
+        }
+        SPAL_Mutex_UnLock(&CALCM_RandomPool_Lock);
+    } // for
+
+    c_memset(CALCM_RandomPool_Chunk, 0, sizeof(CALCM_RandomPool_Chunk));
+
+    return fSuccess;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_RandomPool_Thread
+ */
+static void *
+CALCMLib_RandomPool_Thread(
+        void * const Param_p)
+{
+    IDENTIFIER_NOT_USED(Param_p);
+
+    // refills can wait for the callers that missed the pool
+    (void)sfzcrypto_cm_sched_set_class(CALCM_SCHED_CLASS_NORMAL);
+
+    for (;;)
+    {
+        bool fSuccess;
+
+        SPAL_Semaphore_Wait(&CALCM_RandomPool_RefillRequest);
+
+        fSuccess = CALCMLib_RandomPool_Refill();
+
+        SPAL_Mutex_Lock(&CALCM_RandomPool_Lock);
+        CALCM_RandomPool_fRefillRequested = false;
+
+        // consumers might have drained the pool during the refill
+        // (after a failure, wait for the next consumer to ask again)
+        if (fSuccess &&
+            CALCM_RandomPool_Level < CALCM_RANDOM_POOL_LOW_WATERMARK)
+        {
+            CALCMLib_RandomPool_RequestRefill();
+        }
+        SPAL_Mutex_UnLock(&CALCM_RandomPool_Lock);
+    } // for
+
+    return NULL;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CAL_CM_RandomPool_Init
+ */
+int
+CAL_CM_RandomPool_Init(void)
+{
+    SPAL_Thread_t Thread;
+
+    if (CALCM_RandomPool_IsInitialized)
+        return 0;
+
+    if (SPAL_Mutex_Init(&CALCM_RandomPool_Lock) != SPAL_SUCCESS)
+    {
+        LOG_WARN(
+            "CAL_CM_RandomPool_Init: "
+            "Failed to create lock\n");
+        return -1;
+    }
+
+    if (SPAL_Semaphore_Init(&CALCM_RandomPool_RefillRequest, 0) != SPAL_SUCCESS)
+    {
+        LOG_WARN(
+            "CAL_CM_RandomPool_Init: "
+            "Failed to create semaphore\n");
+        SPAL_Mutex_Destroy(&CALCM_RandomPool_Lock);
+        return -2;
+    }
+
+    CALCM_RandomPool_ReadIndex = 0;
+    CALCM_RandomPool_Level = 0;
+    CALCM_RandomPool_fRefillRequested = false;
+    c_memset(&CALCM_RandomPool_Stats, 0, sizeof(CALCM_RandomPool_Stats));
+
+#ifdef CALCM_RANDOM_POOL_USE_POSIX
+    CALCM_RandomPool_fForked = false;
+
+    if (pthread_atfork(
+            CALCMLib_RandomPool_AtFork_Prepare,
+            CALCMLib_RandomPool_AtFork_Parent,
+            CALCMLib_RandomPool_AtFork_Child) != 0)
+    {
+        LOG_WARN(
+            "CAL_CM_RandomPool_Init: "
+            "Failed to install the fork handlers\n");
+        SPAL_Semaphore_Destroy(&CALCM_RandomPool_RefillRequest);
+        SPAL_Mutex_Destroy(&CALCM_RandomPool_Lock);
+        return -3;
+    }
+#endif
+
+    if (SPAL_Thread_Create(
+                &Thread,
+                NULL,
+                CALCMLib_RandomPool_Thread,
+                NULL) != SPAL_SUCCESS)
+    {
+        // not fatal: all requests are then served directly by the CM
+        LOG_WARN(
+            "CAL_CM_RandomPool_Init: "
+            "Failed to start refill thread\n");
+
+        CALCM_RandomPool_fThreadRunning = false;
+    }
+    else
+    {
+        SPAL_Thread_Detach(Thread);
+        CALCM_RandomPool_fThreadRunning = true;
+    }
+
+    CALCM_RandomPool_IsInitialized = true;
+
+    // initial fill
+    SPAL_Mutex_Lock(&CALCM_RandomPool_Lock);
+    if (CALCM_RandomPool_fThreadRunning)
+        CALCMLib_RandomPool_RequestRefill();
+    SPAL_Mutex_UnLock(&CALCM_RandomPool_Lock);
+
+    return 0;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CAL_CM_RandomPool_Get
+ *
+ * Serves the request from the pool. Returns false when the request is too
+ * large for the pool or the pool does not hold enough bytes; the caller
+ * must then retrieve the random bytes from the CM directly.
+ */
+bool
+CAL_CM_RandomPool_Get(
+        const uint32_t Size,
+        uint8_t * Data_p)
+{
+    bool fServed = false;
+#ifdef CALCM_RANDOM_POOL_USE_POSIX
+    bool fForked;
+#endif
+
+    if (!CALCM_RandomPool_IsInitialized)
+        return false;
+
+    if (Size > CALCM_RANDOM_POOL_MAX_REQUEST)
+    {
+        SPAL_Mutex_Lock(&CALCM_RandomPool_Lock);
+        CALCM_RandomPool_Stats.Bypasses++;
+        SPAL_Mutex_UnLock(&CALCM_RandomPool_Lock);
+        return false;
+    }
+
+    SPAL_Mutex_Lock(&CALCM_RandomPool_Lock);
+
+#ifdef CALCM_RANDOM_POOL_USE_POSIX
+    // the first request after fork() restarts the pool
+    fForked = CALCM_RandomPool_fForked;
+    CALCM_RandomPool_fForked = false;
+#endif
+
+    if (CALCM_RandomPool_Level >= Size)
+    {
+        unsigned int Remain = Size;
+
+        while (Remain > 0)
+        {
+            unsigned int n = MIN(Remain,
+                                 CALCM_RANDOM_POOL_SIZE - CALCM_RandomPool_ReadIndex);
+            uint8_t * const Src_p = CALCM_RandomPool_Ring + CALCM_RandomPool_ReadIndex;
+
+            c_memcpy(Data_p, Src_p, n);
+            c_memset(Src_p, 0, n);
+
+            Data_p += n;
+            Remain -= n;
+            CALCM_RandomPool_ReadIndex =
+                (CALCM_RandomPool_ReadIndex + n) % CALCM_RANDOM_POOL_SIZE;
+        }
+
+        CALCM_RandomPool_Level -= Size;
+        CALCM_RandomPool_Stats.Hits++;
+        fServed = true;
+    }
+    else
+    {
+        CALCM_RandomPool_Stats.Misses++;
+    }
+
+    if (CALCM_RandomPool_Level < CALCM_RANDOM_POOL_LOW_WATERMARK &&
+        CALCM_RandomPool_fThreadRunning)
+    {
+        CALCMLib_RandomPool_RequestRefill();
+    }
+
+    SPAL_Mutex_UnLock(&CALCM_RandomPool_Lock);
+
+#ifdef CALCM_RANDOM_POOL_USE_POSIX
+    if (fForked)
+        CALCMLib_RandomPool_Restart();
+#endif
+
+    return fServed;
+}
+
+
+/*----------------------------------------------------------------------------
+ * sfzcrypto_cm_random_pool_stats
+ */
+SfzCryptoStatus
+sfzcrypto_cm_random_pool_stats(
+        CALCM_RandomPool_Stats_t * const Stats_p)
+{
+    if (Stats_p == NULL)
+        return SFZCRYPTO_BAD_ARGUMENT;
+
+    if (!CALCM_RandomPool_IsInitialized)
+        return SFZCRYPTO_NOT_INITIALISED;
+
+    SPAL_Mutex_Lock(&CALCM_RandomPool_Lock);
+    *Stats_p = CALCM_RandomPool_Stats;
+    Stats_p->Level = CALCM_RandomPool_Level;
+    SPAL_Mutex_UnLock(&CALCM_RandomPool_Lock);
+
+    return SFZCRYPTO_SUCCESS;
+}
+
+#else
+
+// avoid the "empty translation unit" warning
+extern const int _avoid_empty_translation_unit;
+
+#endif /* SFZCRYPTO_CF_RAND_DATA__CM && CALCM_RANDOM_POOL_SIZE > 0 */
+
+/* end of file cal_cm-v2_randompool.c */
@@ -187,4 +187,57 @@ sfzcrypto_cm_symm_crypt(
 }
 
 
+/*----------------------------------------------------------------------------
+ * sfzcrypto_cm_symm_crypt_ctr_stream
+ */
+SfzCryptoStatus
+sfzcrypto_cm_symm_crypt_ctr_stream(
+        SfzCryptoCtrStreamContext * const p_ctxt,
+        SfzCryptoCipherKey * const p_key,
+        uint8_t * p_src,
+        uint32_t src_len,
+        uint8_t * p_dst,
+        uint32_t * const p_dst_len,
+        SfzCipherOp direction)
+{
+#ifdef CALCM_STRICT_ARGS
+    if (p_dst_len == NULL ||
+        p_ctxt == NULL ||
+        p_key == NULL ||
+        p_src == NULL)
+    {
+        return SFZCRYPTO_INVALID_PARAMETER;
+    }
+
+    if (direction != SFZ_ENCRYPT)
+        if (direction != SFZ_DECRYPT)
+            return SFZCRYPTO_BAD_ARGUMENT;
+#endif /* CALCM_STRICT_ARGS */
+
+    if (p_key->type != SFZCRYPTO_KEY_AES ||
+        (p_ctxt->cipher.fbmode != SFZCRYPTO_MODE_CTR &&
+         p_ctxt->cipher.fbmode != SFZCRYPTO_MODE_ICM))
+    {
+        return SFZCRYPTO_INVALID_ALGORITHM;
+    }
+
+    if (src_len == 0)
+    {
+        *p_dst_len = 0;
+        return SFZCRYPTO_SUCCESS;
+    }
+
+    return CAL_CM_AES_CTR_Stream(
+                    &p_ctxt->cipher,
+                    p_key,
+                    p_ctxt->keystream,
+                    &p_ctxt->keystream_len,
+                    p_src,
+                    src_len,
+                    p_dst,
+                    p_dst_len,
+                    direction);
+}
+
+
 /* end of file cal_cm-v2_symm_crypto.c */
@@ -28,11 +28,17 @@
 
 #include "cal_cm-v2_internal.h"     // the API to implement
 
-#include "spal_semaphore.h"         // SPAL_Semaphore*
 #include "cal_hw_api.h"             // CAL_HW_*
+#include "metrics.h"                // METRICS_*
 
-// we use a semaphore because API has timeout option
-static SPAL_Semaphore_t CAL_CM_TokenExchange_ExclusiveLock;
+#ifdef CFG_ENABLE_METRICS
+// opcode of a command token, see CALCMLib_DecodeOpcode
+#define CALCM_TOKEN_OPCODE(_token_p)  (MASK_4_BITS & ((_token_p)->W[0] >> 24))
+
+// submitted token, see CAL_CM_SubmitToken; protected by the exclusive lock
+static uint32_t CALCM_Metrics_SubmitUS;
+static unsigned int CALCM_Metrics_SubmitOpcode;
+#endif
 
 
 /*----------------------------------------------------------------------------
@@ -246,7 +252,7 @@ CALCMLib_DecodeOpcode(
  *
  * This function exchanges a token with the EIP-123 Crypto Module using the
  * following steps, using a single statically linked mailbox.
- *  1.  Get exclusive access to CM
+ *  1.  Get exclusive access to CM (in turn, see CAL_CM_Sched_Acquire)
  *  2a. Check that the IN mailbox is empty
  *  2b. Write command token to IN mailbox
  *  2c. Hand over IN mailbox to CM
@@ -261,6 +267,9 @@ CAL_CM_ExchangeToken(
         CMTokens_Response_t * const ResponseToken_p)
 {
     int res;
+#ifdef CFG_ENABLE_METRICS
+    uint32_t StartUS;
+#endif
 
     if (CommandToken_p == NULL ||
         ResponseToken_p == NULL)
@@ -279,10 +288,12 @@ CAL_CM_ExchangeToken(
     }
 #endif
 
-    if (SPAL_Semaphore_TimedWait(
-                &CAL_CM_TokenExchange_ExclusiveLock,
-                CALCM_WAIT_LIMIT_MS) != SPAL_SUCCESS)
+    METRICS_TIMESTAMP(StartUS);
+
+    if (CAL_CM_Sched_Acquire(CommandToken_p) != SFZCRYPTO_SUCCESS)
     {
+        METRICS_INC(LockFailures);
+
         LOG_CRIT(
             "CAL_CM_ExchangeToken: "
             "Failed to acquire lock\n");
@@ -290,12 +301,19 @@ CAL_CM_ExchangeToken(
         return SFZCRYPTO_INTERNAL_ERROR;
     }
 
+    METRICS_LATENCY(LockWait, StartUS);
+    METRICS_TIMESTAMP(StartUS);
+
     res = CAL_HW_ExchangeToken(CommandToken_p, ResponseToken_p);
 
-    SPAL_Semaphore_Post(&CAL_CM_TokenExchange_ExclusiveLock);
+    METRICS_LATENCY(Token[CALCM_TOKEN_OPCODE(CommandToken_p)], StartUS);
+
+    CAL_CM_Sched_Release();
 
     if (res != 0)
     {
+        METRICS_INC(TokenErrors);
+
         LOG_WARN(
             "CAL_CM_ExchangeToken: "
             "Failed to exchange token (error %d)\n",
@@ -314,13 +332,151 @@ CAL_CM_ExchangeToken(
 }
 
 
+/*----------------------------------------------------------------------------
+ * CAL_CM_SubmitToken
+ *
+ * Steps 1 and 2 of CAL_CM_ExchangeToken: the token is handed over to the CM
+ * and the exclusive lock is kept until CAL_CM_WaitToken has been called.
+ * The caller can prepare the next operation while the CM is busy.
+ */
+SfzCryptoStatus
+CAL_CM_SubmitToken(
+        CMTokens_Command_t * const CommandToken_p)
+{
+    int res;
+#ifdef CFG_ENABLE_METRICS
+    uint32_t StartUS;
+#endif
+
+    if (CommandToken_p == NULL)
+        return SFZCRYPTO_INTERNAL_ERROR;
+
+#ifdef CALCM_TRACE_TOKENS
+    {
+        const char * p1 = "?";
+        const char * p2 = p1;
+        CALCMLib_DecodeOpcode(CommandToken_p->W[0], &p1, &p2);
+        LOG_INFO("IN: Opcode=%s, Subcode=%s\n", p1, p2);
+
+        CALCMLib_PrintToken("IN: ", CommandToken_p->W, CMTOKENS_COMMAND_WORDS);
+    }
+#endif
+
+    METRICS_TIMESTAMP(StartUS);
+
+    if (CAL_CM_Sched_Acquire(CommandToken_p) != SFZCRYPTO_SUCCESS)
+    {
+        METRICS_INC(LockFailures);
+
+        LOG_CRIT(
+            "CAL_CM_SubmitToken: "
+            "Failed to acquire lock\n");
+
+        return SFZCRYPTO_INTERNAL_ERROR;
+    }
+
+    METRICS_LATENCY(LockWait, StartUS);
+#ifdef CFG_ENABLE_METRICS
+    CALCM_Metrics_SubmitOpcode = CALCM_TOKEN_OPCODE(CommandToken_p);
+    CALCM_Metrics_SubmitUS = Metrics_TimeUS();
+#endif
+
+    res = CAL_HW_SubmitToken(CommandToken_p);
+    if (res != 0)
+    {
+        METRICS_INC(TokenErrors);
+
+        CAL_CM_Sched_Release();
+
+        LOG_WARN(
+            "CAL_CM_SubmitToken: "
+            "Failed to submit token (error %d)\n",
+            res);
+
+        return SFZCRYPTO_INTERNAL_ERROR;
+    }
+
+    return SFZCRYPTO_SUCCESS;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CAL_CM_WaitToken
+ *
+ * Steps 3 to 5 of CAL_CM_ExchangeToken, for a token submitted with
+ * CAL_CM_SubmitToken. Must be called exactly once per submitted token, also
+ * when the caller has run into an error meanwhile.
+ */
+SfzCryptoStatus
+CAL_CM_WaitToken(
+        CMTokens_Response_t * const ResponseToken_p)
+{
+    int res;
+
+    res = CAL_HW_WaitToken(ResponseToken_p);
+
+    METRICS_LATENCY(
+            Token[CALCM_Metrics_SubmitOpcode],
+            CALCM_Metrics_SubmitUS);
+
+    CAL_CM_Sched_Release();
+
+    if (res != 0)
+    {
+        METRICS_INC(TokenErrors);
+
+        LOG_WARN(
+            "CAL_CM_WaitToken: "
+            "Failed to receive token (error %d)\n",
+            res);
+
+        return SFZCRYPTO_INTERNAL_ERROR;
+    }
+
+#ifdef CALCM_TRACE_TOKENS
+    CALCMLib_PrintToken("OUT: ", ResponseToken_p->W, CMTOKENS_RESPONSE_WORDS);
+#endif
+
+    return SFZCRYPTO_SUCCESS;
+}
+
+
 /*----------------------------------------------------------------------------
  * CAL_CM_PrintSystemInfo
+ *
+ * For a warm start (see CAL_HW_WarmState_Get), the system info recorded by
+ * the earlier process is reported, without a token exchange.
  */
 static int
 CAL_CM_PrintSystemInfo(void)
 {
     CMTokens_SystemInfo_t SysInfo;
+    CAL_HW_WarmState_t WarmState;
+    int WarmStart;
+
+    WarmStart = CAL_HW_WarmState_Get(&WarmState);
+    if (WarmStart > 0 &&
+        (WarmState.HardwareVersion | WarmState.FirmwareVersion) != 0)
+    {
+        Log_FormattedMessageINFO(
+            "CM SysInfo: HW%u.%u.%u FW%u.%u.%u Mem:0x%04X (warm start)\n",
+            (WarmState.HardwareVersion >> 16) & MASK_8_BITS,
+            (WarmState.HardwareVersion >> 8) & MASK_8_BITS,
+            WarmState.HardwareVersion & MASK_8_BITS,
+            (WarmState.FirmwareVersion >> 16) & MASK_8_BITS,
+            (WarmState.FirmwareVersion >> 8) & MASK_8_BITS,
+            WarmState.FirmwareVersion & MASK_8_BITS,
+            WarmState.MemorySizeInBytes);
+
+        if (WarmState.fIsTestFW)
+        {
+            Log_FormattedMessageCRIT(
+                "CM SysInfo: "
+                "Detected TEST firmware!\n");
+        }
+
+        return 0;
+    }
 
     // get the system info (using a token exchange)
     {
@@ -357,6 +513,25 @@ CAL_CM_PrintSystemInfo(void)
             SysInfo.NVM.ErrorLocation);
     }
 
+    // record the system info for the next processes
+    if (WarmStart >= 0)
+    {
+        WarmState.HardwareVersion =
+            ((uint32_t)SysInfo.Hardware.Major << 16) |
+            ((uint32_t)SysInfo.Hardware.Minor << 8) |
+            SysInfo.Hardware.Patch;
+
+        WarmState.FirmwareVersion =
+            ((uint32_t)SysInfo.Firmware.Major << 16) |
+            ((uint32_t)SysInfo.Firmware.Minor << 8) |
+            SysInfo.Firmware.Patch;
+
+        WarmState.MemorySizeInBytes = SysInfo.Hardware.MemorySizeInBytes;
+        WarmState.fIsTestFW = SysInfo.Firmware.fIsTestFW;
+
+        CAL_HW_WarmState_Update(&WarmState);
+    }
+
     return 0;
 }
 
@@ -371,8 +546,8 @@ CAL_CM_Init(void)
 {
     int res;
 
-    // create the synchronization lock used in this file
-    if (SPAL_Semaphore_Init(&CAL_CM_TokenExchange_ExclusiveLock, 1) != SPAL_SUCCESS)
+    // set up the token scheduler (exclusive access to the CM)
+    if (CAL_CM_Sched_Init() != 0)
     {
         LOG_WARN(
             "CAL_CM_Init: "
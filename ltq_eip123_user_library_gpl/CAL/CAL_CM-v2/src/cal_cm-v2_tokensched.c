@@ -0,0 +1,424 @@
+/* cal_cm-v2_tokensched.c
+ *
+ * Implementation of the CAL API for Crypto Module.
+ *
+ * This file implements the token scheduler, which decides which caller gets
+ * the (single) CM mailbox next.
+ */
+
+/*****************************************************************************
+* Copyright (c) 2007-2015 INSIDE Secure B.V. All Rights Reserved.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 2 of the License, or
+* any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "c_cal_cm-v2.h"
+
+#include "basic_defs.h"
+#include "clib.h"
+#include "log.h"
+
+#include "cal_cm.h"                 // CALCM_Sched_*, the API to implement
+#include "cal_cm-v2_internal.h"     // CAL_CM_Sched_*
+
+#include "spal_mutex.h"
+#include "spal_semaphore.h"
+
+#ifdef CALCM_SCHED_USE_POSIX
+#include <pthread.h>                // pthread_key_t
+#include <time.h>                   // clock_gettime
+#endif
+
+/*
+ * Callers that find the CM busy queue up in the FIFO of their class and
+ * sleep on a semaphore of their own. When the CM is released it is handed
+ * directly to the first waiter of the highest class, except when a lower
+ * class has been passed over CALCM_SCHED_AGING_LIMIT times; then the lower
+ * class is served first.
+ */
+typedef struct CALCMLib_Sched_Waiter
+{
+    struct CALCMLib_Sched_Waiter * Next_p;
+    SPAL_Semaphore_t Wakeup;
+    bool fGranted;
+} CALCMLib_Sched_Waiter_t;
+
+static struct
+{
+    SPAL_Mutex_t Lock;
+    bool fBusy;
+
+    CALCMLib_Sched_Waiter_t * Head_p[CALCM_SCHED_CLASS_COUNT];
+    CALCMLib_Sched_Waiter_t * Tail_p[CALCM_SCHED_CLASS_COUNT];
+
+    // times the first waiter of the class was passed over
+    unsigned int PassedOver[CALCM_SCHED_CLASS_COUNT];
+
+    CALCM_Sched_Stats_t Stats[CALCM_SCHED_CLASS_COUNT];
+
+#ifdef CALCM_SCHED_USE_POSIX
+    pthread_key_t ThreadClassKey;
+#endif
+} CALCM_Sched;
+
+static bool CALCM_Sched_IsInitialized = false;
+
+
+#ifdef CALCM_SCHED_USE_POSIX
+/*----------------------------------------------------------------------------
+ * CALCMLib_Sched_TimeUS
+ */
+static uint32_t
+CALCMLib_Sched_TimeUS(void)
+{
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+        return 0;
+
+    return (uint32_t)(ts.tv_sec * 1000000UL + ts.tv_nsec / 1000);
+}
+#endif /* CALCM_SCHED_USE_POSIX */
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_Sched_Classify
+ *
+ * Class of a token when the caller did not select one: the TRNG, asset
+ * management and system tokens are short and typically on a latency
+ * critical path; data tokens of at least CALCM_SCHED_BULK_MIN_SIZE bytes
+ * are bulk.
+ */
+static CALCM_Sched_Class_t
+CALCMLib_Sched_Classify(
+        const CMTokens_Command_t * const CommandToken_p)
+{
+    unsigned int Opcode = MASK_4_BITS & (CommandToken_p->W[0] >> 24);
+
+    switch(Opcode)
+    {
+        case 1:     // Crypto
+        case 2:     // Hash
+        case 3:     // MAC
+            if (CommandToken_p->W[2] >= CALCM_SCHED_BULK_MIN_SIZE)
+                return CALCM_SCHED_CLASS_BULK;
+            break;
+
+        case 4:     // TRNG
+        case 7:     // Asset Management
+        case 14:    // Service
+        case 15:    // System Info
+            return CALCM_SCHED_CLASS_INTERACTIVE;
+
+        default:
+            break;
+    } // switch
+
+    return CALCM_SCHED_CLASS_NORMAL;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_Sched_GetClass
+ */
+static CALCM_Sched_Class_t
+CALCMLib_Sched_GetClass(
+        const CMTokens_Command_t * const CommandToken_p)
+{
+#ifdef CALCM_SCHED_USE_POSIX
+    // class selected by the calling thread, stored as Class + 1
+    uintptr_t Value;
+
+    Value = (uintptr_t)pthread_getspecific(CALCM_Sched.ThreadClassKey);
+    if (Value != 0)
+        return (CALCM_Sched_Class_t)(Value - 1);
+#endif /* CALCM_SCHED_USE_POSIX */
+
+    return CALCMLib_Sched_Classify(CommandToken_p);
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_Sched_HandOver
+ *
+ * Hands the CM to the next waiter, if any. Must be called with the lock
+ * held.
+ */
+static void
+CALCMLib_Sched_HandOver(void)
+{
+    CALCMLib_Sched_Waiter_t * Waiter_p;
+    int Next = -1;
+    int c;
+
+    // highest class with waiters
+    for (c = 0; c < CALCM_SCHED_CLASS_COUNT; c++)
+    {
+        if (CALCM_Sched.Head_p[c] != NULL)
+        {
+            Next = c;
+            break;
+        }
+    }
+
+    if (Next < 0)
+    {
+        CALCM_Sched.fBusy = false;
+        return;
+    }
+
+    // aging: a lower class that was passed over too often goes first
+    for (c = CALCM_SCHED_CLASS_COUNT - 1; c > Next; c--)
+    {
+        if (CALCM_Sched.Head_p[c] != NULL &&
+            CALCM_Sched.PassedOver[c] >= CALCM_SCHED_AGING_LIMIT)
+        {
+            CALCM_Sched.Stats[c].AgedGrants++;
+            Next = c;
+            break;
+        }
+    }
+
+    for (c = 0; c < CALCM_SCHED_CLASS_COUNT; c++)
+    {
+        if (c != Next && CALCM_Sched.Head_p[c] != NULL)
+            CALCM_Sched.PassedOver[c]++;
+    }
+
+    Waiter_p = CALCM_Sched.Head_p[Next];
+    CALCM_Sched.Head_p[Next] = Waiter_p->Next_p;
+    if (CALCM_Sched.Head_p[Next] == NULL)
+        CALCM_Sched.Tail_p[Next] = NULL;
+
+    CALCM_Sched.PassedOver[Next] = 0;
+    CALCM_Sched.Stats[Next].QueueDepth--;
+
+    // the CM stays busy; it now belongs to the waiter
+    Waiter_p->fGranted = true;
+    SPAL_Semaphore_Post(&Waiter_p->Wakeup);
+}
+
+
+/*----------------------------------------------------------------------------
+ * CAL_CM_Sched_Init
+ */
+int
+CAL_CM_Sched_Init(void)
+{
+    if (CALCM_Sched_IsInitialized)
+        return 0;
+
+    c_memset(&CALCM_Sched, 0, sizeof(CALCM_Sched));
+
+    if (SPAL_Mutex_Init(&CALCM_Sched.Lock) != SPAL_SUCCESS)
+        return -1;
+
+#ifdef CALCM_SCHED_USE_POSIX
+    if (pthread_key_create(&CALCM_Sched.ThreadClassKey, NULL) != 0)
+    {
+        SPAL_Mutex_Destroy(&CALCM_Sched.Lock);
+        return -2;
+    }
+#endif
+
+    CALCM_Sched_IsInitialized = true;
+
+    return 0;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CAL_CM_Sched_Acquire
+ *
+ * Waits (at most CALCM_WAIT_LIMIT_MS) until the calling thread has exclusive
+ * use of the CM, in turn with the other callers of the token's class.
+ */
+SfzCryptoStatus
+CAL_CM_Sched_Acquire(
+        const CMTokens_Command_t * const CommandToken_p)
+{
+    const CALCM_Sched_Class_t Class = CALCMLib_Sched_GetClass(CommandToken_p);
+    CALCM_Sched_Stats_t * const Stats_p = &CALCM_Sched.Stats[Class];
+    CALCMLib_Sched_Waiter_t Waiter;
+    SPAL_Result_t spalres;
+    int c;
+#ifdef CALCM_SCHED_USE_POSIX
+    uint32_t StartUS;
+    uint32_t WaitUS;
+#endif
+
+    SPAL_Mutex_Lock(&CALCM_Sched.Lock);
+
+    Stats_p->Grants++;
+
+    if (!CALCM_Sched.fBusy)
+    {
+        bool fQueued = false;
+
+        for (c = 0; c < CALCM_SCHED_CLASS_COUNT; c++)
+            if (CALCM_Sched.Head_p[c] != NULL)
+                fQueued = true;
+
+        if (!fQueued)
+        {
+            CALCM_Sched.fBusy = true;
+            SPAL_Mutex_UnLock(&CALCM_Sched.Lock);
+            return SFZCRYPTO_SUCCESS;
+        }
+    }
+
+    if (SPAL_Semaphore_Init(&Waiter.Wakeup, 0) != SPAL_SUCCESS)
+    {
+        Stats_p->Grants--;
+        SPAL_Mutex_UnLock(&CALCM_Sched.Lock);
+        return SFZCRYPTO_INTERNAL_ERROR;
+    }
+
+    Waiter.Next_p = NULL;
+    Waiter.fGranted = false;
+
+    if (CALCM_Sched.Tail_p[Class] != NULL)
+        CALCM_Sched.Tail_p[Class]->Next_p = &Waiter;
+    else
+        CALCM_Sched.Head_p[Class] = &Waiter;
+    CALCM_Sched.Tail_p[Class] = &Waiter;
+
+    Stats_p->Waits++;
+    Stats_p->QueueDepth++;
+    if (Stats_p->QueueDepth > Stats_p->QueueDepthMax)
+        Stats_p->QueueDepthMax = Stats_p->QueueDepth;
+
+    SPAL_Mutex_UnLock(&CALCM_Sched.Lock);
+
+#ifdef CALCM_SCHED_USE_POSIX
+    StartUS = CALCMLib_Sched_TimeUS();
+#endif
+
+    spalres = SPAL_Semaphore_TimedWait(&Waiter.Wakeup, CALCM_WAIT_LIMIT_MS);
+
+#ifdef CALCM_SCHED_USE_POSIX
+    WaitUS = CALCMLib_Sched_TimeUS() - StartUS;
+#endif
+
+    SPAL_Mutex_Lock(&CALCM_Sched.Lock);
+
+    // the CM might have been handed over just after the timeout
+    if (spalres != SPAL_SUCCESS && !Waiter.fGranted)
+    {
+        CALCMLib_Sched_Waiter_t * Prev_p = NULL;
+        CALCMLib_Sched_Waiter_t * p = CALCM_Sched.Head_p[Class];
+
+        while (p != &Waiter)
+        {
+            Prev_p = p;
+            p = p->Next_p;
+        }
+
+        if (Prev_p != NULL)
+            Prev_p->Next_p = Waiter.Next_p;
+        else
+            CALCM_Sched.Head_p[Class] = Waiter.Next_p;
+
+        if (CALCM_Sched.Tail_p[Class] == &Waiter)
+            CALCM_Sched.Tail_p[Class] = Prev_p;
+
+        Stats_p->QueueDepth--;
+        Stats_p->Grants--;
+        Stats_p->Timeouts++;
+
+        SPAL_Mutex_UnLock(&CALCM_Sched.Lock);
+        SPAL_Semaphore_Destroy(&Waiter.Wakeup);
+
+        return SFZCRYPTO_INTERNAL_ERROR;
+    }
+
+#ifdef CALCM_SCHED_USE_POSIX
+    Stats_p->WaitTotalUS += WaitUS;
+    if (WaitUS > Stats_p->WaitMaxUS)
+        Stats_p->WaitMaxUS = WaitUS;
+#endif
+
+    SPAL_Mutex_UnLock(&CALCM_Sched.Lock);
+    SPAL_Semaphore_Destroy(&Waiter.Wakeup);
+
+    return SFZCRYPTO_SUCCESS;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CAL_CM_Sched_Release
+ */
+void
+CAL_CM_Sched_Release(void)
+{
+    SPAL_Mutex_Lock(&CALCM_Sched.Lock);
+    CALCMLib_Sched_HandOver();
+    SPAL_Mutex_UnLock(&CALCM_Sched.Lock);
+}
+
+
+/*----------------------------------------------------------------------------
+ * sfzcrypto_cm_sched_set_class
+ */
+SfzCryptoStatus
+sfzcrypto_cm_sched_set_class(
+        CALCM_Sched_Class_t Class)
+{
+    if (Class > CALCM_SCHED_CLASS_AUTO)
+        return SFZCRYPTO_BAD_ARGUMENT;
+
+    if (!CALCM_Sched_IsInitialized)
+        return SFZCRYPTO_NOT_INITIALISED;
+
+#ifdef CALCM_SCHED_USE_POSIX
+    {
+        uintptr_t Value = 0;
+
+        if (Class != CALCM_SCHED_CLASS_AUTO)
+            Value = (uintptr_t)Class + 1;
+
+        if (pthread_setspecific(CALCM_Sched.ThreadClassKey, (void *)Value) != 0)
+            return SFZCRYPTO_INTERNAL_ERROR;
+    }
+
+    return SFZCRYPTO_SUCCESS;
+#else
+    return SFZCRYPTO_UNSUPPORTED;
+#endif /* CALCM_SCHED_USE_POSIX */
+}
+
+
+/*----------------------------------------------------------------------------
+ * sfzcrypto_cm_sched_stats
+ */
+SfzCryptoStatus
+sfzcrypto_cm_sched_stats(
+        CALCM_Sched_Class_t Class,
+        CALCM_Sched_Stats_t * const Stats_p)
+{
+    if (Stats_p == NULL || Class >= CALCM_SCHED_CLASS_COUNT)
+        return SFZCRYPTO_BAD_ARGUMENT;
+
+    if (!CALCM_Sched_IsInitialized)
+        return SFZCRYPTO_NOT_INITIALISED;
+
+    SPAL_Mutex_Lock(&CALCM_Sched.Lock);
+    *Stats_p = CALCM_Sched.Stats[Class];
+    SPAL_Mutex_UnLock(&CALCM_Sched.Lock);
+
+    return SFZCRYPTO_SUCCESS;
+}
+
+
+/* end of file cal_cm-v2_tokensched.c */
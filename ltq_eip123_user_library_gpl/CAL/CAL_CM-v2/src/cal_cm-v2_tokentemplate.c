@@ -0,0 +1,228 @@
+/* cal_cm-v2_tokentemplate.c
+ *
+ * Implementation of the CAL API for Crypto Module.
+ *
+ * This file implements the per-context token templates.
+ */
+
+/*****************************************************************************
+* Copyright (c) 2007-2015 INSIDE Secure B.V. All Rights Reserved.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 2 of the License, or
+* any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "c_cal_cm-v2.h"
+
+#if CALCM_TOKEN_TEMPLATE_ENTRIES > 0
+
+#include "basic_defs.h"
+#include "clib.h"
+
+#include "cal_cm-v2_internal.h"
+
+#include "cm_tokens_template.h"
+
+
+/*----------------------------------------------------------------------------
+ * Token template table
+ *
+ * The templates are kept here rather than in the cipher contexts, because
+ * these are public structures that applications allocate (and may not
+ * initialize). The table is indexed by the address of the context; an entry
+ * is only used when the context and all parameters that the template
+ * depends on match, so a template can never be applied to another key or
+ * mode, even when a context is reused or moved. Contexts that share a slot
+ * replace each other's template.
+ *
+ * There is no lock: each entry has a sequence number that is odd while the
+ * entry is written. A writer that finds the entry busy does not store its
+ * template, and a reader that sees the sequence number change treats the
+ * entry as a miss, so a template costs at most one copy of the token.
+ *
+ * The templates must not hold secrets: the callers only use them for keys
+ * in the Asset Store. The parameters are still compared without an early
+ * exit.
+ */
+#define CALCM_TOKEN_TEMPLATE_PARAMS_MAX  64
+
+typedef struct
+{
+    volatile uint32_t Sequence;     // odd = entry is being written
+    const void * Context_p;         // NULL = entry not used
+    unsigned int ParamsSize;
+    uint8_t Params[CALCM_TOKEN_TEMPLATE_PARAMS_MAX];
+    CMTokens_Template_t Template;
+} CALCM_TokenTemplate_Entry_t;
+
+static CALCM_TokenTemplate_Entry_t
+CALCM_TokenTemplate[CALCM_TOKEN_TEMPLATE_ENTRIES];
+
+static bool CALCM_TokenTemplate_IsInitialized = false;
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_TokenTemplate_Entry
+ */
+static inline CALCM_TokenTemplate_Entry_t *
+CALCMLib_TokenTemplate_Entry(
+        const void * const Context_p)
+{
+    // contexts are at least word aligned
+    const uintptr_t Index = ((uintptr_t)Context_p) / sizeof(uint32_t);
+
+    return &CALCM_TokenTemplate[Index % CALCM_TOKEN_TEMPLATE_ENTRIES];
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALCMLib_TokenTemplate_IsEqual
+ *
+ * Compares the parameters, taking the same time for all values.
+ */
+static bool
+CALCMLib_TokenTemplate_IsEqual(
+        const uint8_t * const A_p,
+        const uint8_t * const B_p,
+        const unsigned int Size)
+{
+    uint8_t Diff = 0;
+    unsigned int i;
+
+    for (i = 0; i < Size; i++)
+        Diff |= A_p[i] ^ B_p[i];
+
+    return Diff == 0;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CAL_CM_TokenTemplate_Get
+ */
+bool
+CAL_CM_TokenTemplate_Get(
+        const void * const Context_p,
+        const void * const Params_p,
+        const unsigned int ParamsSize,
+        CMTokens_Command_t * const CommandToken_p)
+{
+    CALCM_TokenTemplate_Entry_t * Entry_p;
+    uint32_t Sequence;
+    bool fFound = false;
+
+    if (!CALCM_TokenTemplate_IsInitialized ||
+        Context_p == NULL ||
+        ParamsSize > CALCM_TOKEN_TEMPLATE_PARAMS_MAX)
+    {
+        return false;
+    }
+
+    Entry_p = CALCMLib_TokenTemplate_Entry(Context_p);
+
+    Sequence = Entry_p->Sequence;
+    if (Sequence & 1)
+        return false;       // being written
+
+    __sync_synchronize();
+
+    if (Entry_p->Context_p == Context_p &&
+        Entry_p->ParamsSize == ParamsSize &&
+        CALCMLib_TokenTemplate_IsEqual(
+                                Entry_p->Params,
+                                Params_p,
+                                ParamsSize))
+    {
+        // the caller makes the whole token again on a miss, so a copy
+        // that overlapped with a writer is harmless
+        CMTokens_Template_Instantiate(CommandToken_p, &Entry_p->Template);
+        fFound = true;
+    }
+
+    __sync_synchronize();
+
+    if (Entry_p->Sequence != Sequence)
+        return false;       // replaced while reading
+
+    return fFound;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CAL_CM_TokenTemplate_Put
+ */
+void
+CAL_CM_TokenTemplate_Put(
+        const void * const Context_p,
+        const void * const Params_p,
+        const unsigned int ParamsSize,
+        const CMTokens_Command_t * const CommandToken_p)
+{
+    CALCM_TokenTemplate_Entry_t * Entry_p;
+    uint32_t Sequence;
+
+    if (!CALCM_TokenTemplate_IsInitialized ||
+        Context_p == NULL ||
+        ParamsSize > CALCM_TOKEN_TEMPLATE_PARAMS_MAX)
+    {
+        return;
+    }
+
+    Entry_p = CALCMLib_TokenTemplate_Entry(Context_p);
+
+    // claim the entry; leave it to the other writer when busy
+    Sequence = Entry_p->Sequence;
+    if ((Sequence & 1) ||
+        !__sync_bool_compare_and_swap(
+                                &Entry_p->Sequence,
+                                Sequence,
+                                Sequence + 1))
+    {
+        return;
+    }
+
+    c_memset(Entry_p->Params, 0, sizeof(Entry_p->Params));
+    c_memcpy(Entry_p->Params, Params_p, ParamsSize);
+    Entry_p->ParamsSize = ParamsSize;
+    CMTokens_Template_Compile(&Entry_p->Template, CommandToken_p);
+    Entry_p->Context_p = Context_p;
+
+    // publish (the builtin is a full barrier)
+    __sync_synchronize();
+    Entry_p->Sequence = Sequence + 2;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CAL_CM_TokenTemplate_Init
+ */
+int
+CAL_CM_TokenTemplate_Init(void)
+{
+    if (CALCM_TokenTemplate_IsInitialized)
+        return 0;
+
+    c_memset(CALCM_TokenTemplate, 0, sizeof(CALCM_TokenTemplate));
+
+    CALCM_TokenTemplate_IsInitialized = true;
+
+    return 0;
+}
+
+#else
+
+// avoid the "empty translation unit" warning
+extern const int _avoid_empty_translation_unit;
+
+#endif /* CALCM_TOKEN_TEMPLATE_ENTRIES */
+
+/* end of file cal_cm-v2_tokentemplate.c */
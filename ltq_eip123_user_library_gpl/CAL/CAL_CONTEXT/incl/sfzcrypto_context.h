@@ -29,8 +29,9 @@
 /** Gets pointer to sfzcrypto context that may be passed to sfzcrypto_init
     or other sfzcrypto functions.
 
-    There is no way to release this object. However, only single
-    instance of the object is created.
+    Each thread gets its own object, created on the first call from that
+    thread. The object is released when the thread exits; it must not be
+    used by other threads.
 
     @return
     Pointer to SfzCryptoContext
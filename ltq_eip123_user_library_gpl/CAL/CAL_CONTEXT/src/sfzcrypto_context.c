@@ -2,7 +2,8 @@
  *
  * This file provides the SfzCryptoContext memory. It can be customized for
  * the concurrent-use needs of the application. The default implementation
- * provides one context.
+ * provides one context per thread, created on first use and freed when the
+ * thread exits.
  */
 
 /*****************************************************************************
@@ -28,23 +29,53 @@
 #include "sfzcryptoapi_init.h"         // SfzCryptoContext
 #include "sfzcrypto_context.h"         // API to implement
 
+#include <pthread.h>                   // pthread_key_t, pthread_once
+
+static pthread_key_t sfzcrypto_context_key;
+static pthread_once_t sfzcrypto_context_once = PTHREAD_ONCE_INIT;
+
+
+/* Frees the context of an exiting thread. */
+static void
+sfzcrypto_context_release(
+        void * ctx_p)
+{
+    SPAL_Memory_Free(ctx_p);
+}
+
+
+static void
+sfzcrypto_context_init(void)
+{
+    int res;
+
+    res = pthread_key_create(
+                &sfzcrypto_context_key,
+                sfzcrypto_context_release);
+    ASSERT(res == 0);
+}
+
+
 /* Helper function for acquiring crypto context. */
 SfzCryptoContext *
 sfzcrypto_context_get(void)
 {
-    static uint32_t DummyContext;            /* Note: static! */
-    static SfzCryptoContext * ctx_p = NULL;  /* Note: static! */
+    SfzCryptoContext * ctx_p;
+
+    pthread_once(&sfzcrypto_context_once, sfzcrypto_context_init);
 
+    ctx_p = pthread_getspecific(sfzcrypto_context_key);
     if (ctx_p == NULL)
     {
-        // since context is not used by the implementation
-        // return some non-NULL pointer
-        ctx_p = (SfzCryptoContext *)&DummyContext;
-
-        // alternative implementation for implementations that need the context
-        //ctx_p = SPAL_Memory_Alloc(sizeof(SfzCryptoContext));
-        //ASSERT(ctx_p != NULL);
-        //c_memset(ctx_p, 0, sizeof(SfzCryptoContext));
+        ctx_p = SPAL_Memory_Alloc(sizeof(SfzCryptoContext));
+        ASSERT(ctx_p != NULL);
+        c_memset(ctx_p, 0, sizeof(SfzCryptoContext));
+
+        if (pthread_setspecific(sfzcrypto_context_key, ctx_p) != 0)
+        {
+            SPAL_Memory_Free(ctx_p);
+            ctx_p = NULL;
+        }
     }
 
     return ctx_p;
@@ -21,6 +21,9 @@
 * along with this program. If not, see <http://www.gnu.org/licenses/>.
 *****************************************************************************/
 
+#ifndef INCLUDE_GUARD_CAL_CM_H
+#define INCLUDE_GUARD_CAL_CM_H
+
 #include "sfzcryptoapi.h"
 
 SfzCryptoStatus
@@ -51,6 +54,11 @@ sfzcrypto_cm_hmac_data(
         bool init,
         bool final);
 
+// releases the keys cached by sfzcrypto_cm_hmac_data
+// (only available when CALCM_HMAC_KEYCACHE_ENTRIES > 0)
+SfzCryptoStatus
+sfzcrypto_cm_hmac_keycache_flush(void);
+
 SfzCryptoStatus
 sfzcrypto_cm_symm_crypt(
         SfzCryptoCipherContext * const ctxt_p,
@@ -61,6 +69,16 @@ sfzcrypto_cm_symm_crypt(
         uint32_t * const dst_len_p,
         SfzCipherOp direction);
 
+SfzCryptoStatus
+sfzcrypto_cm_symm_crypt_ctr_stream(
+        SfzCryptoCtrStreamContext * const ctxt_p,
+        SfzCryptoCipherKey * const key_p,
+        uint8_t * src_p,
+        uint32_t src_len,
+        uint8_t * dst_p,
+        uint32_t * const dst_len_p,
+        SfzCipherOp direction);
+
 SfzCryptoStatus
 sfzcrypto_cm_cipher_mac_data(
         SfzCryptoCipherMacContext * const ctxt_p,
@@ -83,6 +101,100 @@ sfzcrypto_cm_random_selftest(
 SfzCryptoStatus
 sfzcrypto_cm_random_reseed(void);
 
+// random pool statistics (see CALCM_RANDOM_POOL_SIZE)
+typedef struct
+{
+    uint32_t Hits;                  // requests served from the pool
+    uint32_t Misses;                // pool did not hold enough bytes
+    uint32_t Bypasses;              // requests too large for the pool
+    uint32_t Refills;               // tokens used to refill the pool
+    uint32_t RefillBytes;
+    uint32_t RefillErrors;
+    uint32_t RefillLatencyTotalUS;  // only with CALCM_RANDOM_POOL_USE_POSIX
+    uint32_t RefillLatencyMaxUS;    // only with CALCM_RANDOM_POOL_USE_POSIX
+    uint32_t Discards;              // pool emptied after fork()
+    uint32_t Level;                 // bytes currently in the pool
+} CALCM_RandomPool_Stats_t;
+
+// only available when CALCM_RANDOM_POOL_SIZE > 0
+SfzCryptoStatus
+sfzcrypto_cm_random_pool_stats(
+        CALCM_RandomPool_Stats_t * const Stats_p);
+
+// random health tests (see CALCM_RANDOM_HEALTH_TESTS)
+typedef enum
+{
+    CALCM_RANDOM_HEALTH_REPETITION_COUNT = 0,   // SP 800-90B 4.4.1
+    CALCM_RANDOM_HEALTH_ADAPTIVE_PROPORTION,    // SP 800-90B 4.4.2
+    CALCM_RANDOM_HEALTH_MONOBIT,                // FIPS 140-2 4.9.1
+    CALCM_RANDOM_HEALTH_POKER,
+    CALCM_RANDOM_HEALTH_RUNS,
+    CALCM_RANDOM_HEALTH_LONG_RUN
+} CALCM_RandomHealth_Test_t;
+
+#define CALCM_RANDOM_HEALTH_TEST_COUNT  6
+
+typedef struct
+{
+    uint32_t Bytes;                 // random bytes tested
+    uint32_t Blocks;                // FIPS 140-2 blocks of 20000 bits
+    uint32_t Windows;               // Adaptive Proportion windows
+    uint32_t Failures[CALCM_RANDOM_HEALTH_TEST_COUNT];
+    uint32_t Rejects;               // random requests failed as a result
+} CALCM_RandomHealth_Stats_t;
+
+// invoked for each failed test, outside the CAL locks; must not block
+typedef void (* CALCM_RandomHealth_FailFunc_t)(
+        CALCM_RandomHealth_Test_t Test,
+        void * Arg_p);
+
+// only available with CALCM_RANDOM_HEALTH_TESTS, after sfzcrypto_cm_init
+// FailFunc_p = NULL removes the callback
+SfzCryptoStatus
+sfzcrypto_cm_random_health_set_callback(
+        CALCM_RandomHealth_FailFunc_t FailFunc_p,
+        void * FailArg_p);
+
+SfzCryptoStatus
+sfzcrypto_cm_random_health_stats(
+        CALCM_RandomHealth_Stats_t * const Stats_p);
+
+// token scheduler priority classes
+// callers waiting for the CM are served by class, FIFO within a class
+typedef enum
+{
+    CALCM_SCHED_CLASS_INTERACTIVE = 0,
+    CALCM_SCHED_CLASS_NORMAL,
+    CALCM_SCHED_CLASS_BULK,
+    CALCM_SCHED_CLASS_AUTO          // derived from the token (default)
+} CALCM_Sched_Class_t;
+
+#define CALCM_SCHED_CLASS_COUNT  3
+
+// token scheduler statistics, per class
+typedef struct
+{
+    uint32_t Grants;                // token exchanges
+    uint32_t Waits;                 // exchanges that had to wait for the CM
+    uint32_t Timeouts;              // gave up after CALCM_WAIT_LIMIT_MS
+    uint32_t AgedGrants;            // served before a higher class (aging)
+    uint32_t QueueDepth;            // callers currently waiting
+    uint32_t QueueDepthMax;
+    uint32_t WaitTotalUS;           // only with CALCM_SCHED_USE_POSIX
+    uint32_t WaitMaxUS;             // only with CALCM_SCHED_USE_POSIX
+} CALCM_Sched_Stats_t;
+
+// selects the class of the tokens of the calling thread
+// (only available with CALCM_SCHED_USE_POSIX)
+SfzCryptoStatus
+sfzcrypto_cm_sched_set_class(
+        CALCM_Sched_Class_t Class);
+
+SfzCryptoStatus
+sfzcrypto_cm_sched_stats(
+        CALCM_Sched_Class_t Class,
+        CALCM_Sched_Stats_t * const Stats_p);
+
 SfzCryptoStatus
 sfzcrypto_cm_nop(
         SfzCryptoOctetsOut * dst_p,
@@ -95,6 +207,10 @@ sfzcrypto_cm_nvm_publicdata_read(
         SfzCryptoOctetsOut * Data_p,
         uint32_t * const DataLen_p);
 
+SfzCryptoStatus
+sfzcrypto_cm_nvm_publicdata_refresh(
+        uint32_t ObjectNr);
+
 SfzCryptoStatus
 sfzcrypto_cm_asset_alloc(
         SfzCryptoPolicyMask DesiredPolicy,
@@ -216,6 +332,24 @@ sfzcrypto_cm_auth_crypt(
         bool init,
         bool finish);
 
+SfzCryptoStatus
+sfzcrypto_cm_aes_wrap_unwrap(
+        SfzCryptoCipherContext * const ctxt_p,
+        SfzCryptoCipherKey * const kek_p,
+        const uint8_t * src_p,
+        uint32_t src_len,
+        uint8_t * dst_p,
+        uint32_t * const dst_len_p,
+        SfzCipherOp direction,
+        const uint8_t * initial_value_p);
+
+SfzCryptoStatus
+sfzcrypto_cm_aes_wrap_unwrap_bulk(
+        SfzCryptoCipherKey * const kek_p,
+        SfzCryptoWrapItem * const items_p,
+        uint32_t item_count,
+        SfzCipherOp direction);
+
 SfzCryptoStatus
 sfzcrypto_cm_authenticated_unlock_start(
         const uint16_t AuthKeyNumber,
@@ -236,4 +370,6 @@ sfzcrypto_cm_secure_debug(
         const SfzCryptoAssetId AuthStateASId,
         const bool bSet);
 
+#endif /* Include Guard */
+
 /* end of file cal_cm.h */
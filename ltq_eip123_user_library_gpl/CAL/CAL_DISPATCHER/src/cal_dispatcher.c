@@ -289,6 +289,42 @@ sfzcrypto_symm_crypt(
 #endif /* !SFZCRYPTO_CF_SYMM_CRYPT__REMOVE */
 
 
+/*---------------------------------------------------------------------------*/
+#ifndef SFZCRYPTO_CF_SYMM_CRYPT__REMOVE
+SfzCryptoStatus
+sfzcrypto_symm_crypt_ctr_stream(
+        SfzCryptoContext * const sfzcryptoctx_p,
+        SfzCryptoCtrStreamContext * const p_ctxt,
+        SfzCryptoCipherKey * const p_key,
+        uint8_t * p_src,
+        uint32_t src_len,
+        uint8_t * p_dst,
+        uint32_t * const p_dst_len,
+        SfzCipherOp direction)
+{
+    IDENTIFIER_NOT_USED(sfzcryptoctx_p);
+#if defined(SFZCRYPTO_CF_SYMM_CRYPT__STUB) || \
+    defined(SFZCRYPTO_CF_SYMM_CRYPT__SW)
+    IDENTIFIER_NOT_USED(p_ctxt);
+    IDENTIFIER_NOT_USED(p_key);
+    IDENTIFIER_NOT_USED(p_src);
+    IDENTIFIER_NOT_USED(src_len);
+    IDENTIFIER_NOT_USED(p_dst);
+    IDENTIFIER_NOT_USED(p_dst_len);
+    IDENTIFIER_NOT_USED(direction);
+    return SFZCRYPTO_UNSUPPORTED;
+#endif
+#ifdef SFZCRYPTO_CF_SYMM_CRYPT__CM
+    return sfzcrypto_cm_symm_crypt_ctr_stream(
+                p_ctxt, p_key,
+                p_src, src_len,
+                p_dst, p_dst_len,
+                direction);
+#endif
+}
+#endif /* !SFZCRYPTO_CF_SYMM_CRYPT__REMOVE */
+
+
 /*---------------------------------------------------------------------------*/
 #ifndef SFZCRYPTO_CF_CIPHER_MAC_DATA__REMOVE
 SfzCryptoStatus
@@ -431,6 +467,74 @@ sfzcrypto_aes_wrap_unwrap(
                     direction,
                     initial_value_p);
 #endif
+#ifdef SFZCRYPTO_CF_AES_WRAP_UNWRAP__CM
+    return sfzcrypto_cm_aes_wrap_unwrap(
+                    ctxt_p,
+                    kek_p,
+                    src_p, src_len,
+                    dst_p, dst_len_p,
+                    direction,
+                    initial_value_p);
+#endif
+}
+#endif /* !SFZCRYPTO_CF_AES_WRAP_UNWRAP__REMOVE */
+
+
+/*---------------------------------------------------------------------------*/
+#ifndef SFZCRYPTO_CF_AES_WRAP_UNWRAP__REMOVE
+SfzCryptoStatus
+sfzcrypto_aes_wrap_unwrap_bulk(
+        SfzCryptoContext * const sfzcryptoctx_p,
+        SfzCryptoCipherContext * const ctxt_p,
+        SfzCryptoCipherKey * const kek_p,
+        SfzCryptoWrapItem * const items_p,
+        uint32_t item_count,
+        SfzCipherOp direction)
+{
+    IDENTIFIER_NOT_USED(sfzcryptoctx_p);
+#ifdef SFZCRYPTO_CF_AES_WRAP_UNWRAP__STUB
+    IDENTIFIER_NOT_USED(ctxt_p);
+    IDENTIFIER_NOT_USED(kek_p);
+    IDENTIFIER_NOT_USED(items_p);
+    IDENTIFIER_NOT_USED(item_count);
+    IDENTIFIER_NOT_USED(direction);
+    return SFZCRYPTO_UNSUPPORTED;
+#endif
+#ifdef SFZCRYPTO_CF_AES_WRAP_UNWRAP__SW
+    {
+        SfzCryptoStatus funcres = SFZCRYPTO_SUCCESS;
+        uint32_t i;
+
+        if (items_p == NULL && item_count > 0)
+            return SFZCRYPTO_INVALID_PARAMETER;
+
+        for (i = 0; i < item_count; i++)
+        {
+            items_p[i].status = sfzcrypto_sw_aes_wrap_unwrap(
+                                        ctxt_p,
+                                        kek_p,
+                                        items_p[i].src_p,
+                                        items_p[i].src_len,
+                                        items_p[i].dst_p,
+                                        &items_p[i].dst_len,
+                                        direction,
+                                        NULL);
+
+            if (funcres == SFZCRYPTO_SUCCESS)
+                funcres = items_p[i].status;
+        }
+
+        return funcres;
+    }
+#endif
+#ifdef SFZCRYPTO_CF_AES_WRAP_UNWRAP__CM
+    IDENTIFIER_NOT_USED(ctxt_p);
+    return sfzcrypto_cm_aes_wrap_unwrap_bulk(
+                    kek_p,
+                    items_p,
+                    item_count,
+                    direction);
+#endif
 }
 #endif /* !SFZCRYPTO_CF_AES_WRAP_UNWRAP__REMOVE */
 
@@ -1094,6 +1198,30 @@ sfzcrypto_nvm_publicdata_read(
 #endif /* !SFZCRYPTO_CF_NVM_PUBLICDATA_READ__REMOVE */
 
 
+/*---------------------------------------------------------------------------*/
+#ifndef SFZCRYPTO_CF_NVM_PUBLICDATA_READ__REMOVE
+SfzCryptoStatus
+sfzcrypto_nvm_publicdata_refresh(
+        SfzCryptoContext * const sfzcryptoctx_p,
+        uint32_t ObjectNr)
+{
+    IDENTIFIER_NOT_USED(sfzcryptoctx_p);
+#ifdef SFZCRYPTO_CF_NVM_PUBLICDATA_READ__STUB
+    IDENTIFIER_NOT_USED(ObjectNr);
+    return SFZCRYPTO_UNSUPPORTED;
+#endif
+#ifdef SFZCRYPTO_CF_NVM_PUBLICDATA_READ__SW
+    // nothing is cached by the software implementation
+    IDENTIFIER_NOT_USED(ObjectNr);
+    return SFZCRYPTO_SUCCESS;
+#endif
+#ifdef SFZCRYPTO_CF_NVM_PUBLICDATA_READ__CM
+    return sfzcrypto_cm_nvm_publicdata_refresh(ObjectNr);
+#endif
+}
+#endif /* !SFZCRYPTO_CF_NVM_PUBLICDATA_READ__REMOVE */
+
+
 /*---------------------------------------------------------------------------*/
 #ifndef SFZCRYPTO_CF_ASSET_ALLOC__REMOVE
 SfzCryptoStatus
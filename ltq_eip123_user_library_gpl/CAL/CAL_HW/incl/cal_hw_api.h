@@ -68,6 +68,29 @@ CAL_HW_ExchangeToken(
         CMTokens_Response_t * const ResponseToken_p);
 
 
+/*----------------------------------------------------------------------------
+ * CAL_HW_SubmitToken
+ * CAL_HW_WaitToken
+ *
+ * CAL_HW_ExchangeToken in two steps, so the caller can do other work while
+ * the Crypto Module processes the token. Every CAL_HW_SubmitToken must be
+ * followed by one CAL_HW_WaitToken before the next token is submitted.
+ *
+ * NOTE: These functions are not reentrant!
+ *
+ * Return Value:
+ *     0    Success
+ *    <0    Error code
+ */
+int
+CAL_HW_SubmitToken(
+        const CMTokens_Command_t * const CmdToken_p);
+
+int
+CAL_HW_WaitToken(
+        CMTokens_Response_t * const ResponseToken_p);
+
+
 /*----------------------------------------------------------------------------
  * CAL_HW_WaitForPKADone_WithTimeout
  *
@@ -85,6 +108,68 @@ CAL_HW_WaitForPKADone_WithTimeout(
         void * const EIP28_IOArea_p);
 
 
+/*----------------------------------------------------------------------------
+ * CAL_HW_WarmState_t
+ *
+ * State of the Crypto Module that is shared by the processes that use it,
+ * see CALHW_WARMSTART_SHM_NAME. Fields that are 0 are not known (yet).
+ */
+typedef struct
+{
+    // system info, (Major << 16) | (Minor << 8) | Patch
+    uint32_t HardwareVersion;
+    uint32_t FirmwareVersion;
+    uint32_t MemorySizeInBytes;
+    bool fIsTestFW;
+
+    // CLOCK_MONOTONIC time (seconds) of the last successful DMA test
+    uint32_t LastDMATest_s;
+} CAL_HW_WarmState_t;
+
+
+/*----------------------------------------------------------------------------
+ * CAL_HW_WarmState_Get
+ *
+ * This function returns the shared state of the Crypto Module as recorded
+ * so far, after CAL_HW_Init.
+ *
+ * Return Value:
+ *     1    Warm start: the CM was initialized by an earlier process.
+ *     0    Cold start: the CM was initialized by this process.
+ *    <0    No shared state (not configured or not available).
+ */
+int
+CAL_HW_WarmState_Get(
+        CAL_HW_WarmState_t * const State_p);
+
+
+/*----------------------------------------------------------------------------
+ * CAL_HW_WarmState_Update
+ *
+ * This function stores the shared state of the Crypto Module, for the next
+ * processes. It is ignored when there is no shared state, or when another
+ * process has initialized the CM again since CAL_HW_Init.
+ */
+void
+CAL_HW_WarmState_Update(
+        const CAL_HW_WarmState_t * const State_p);
+
+
+/*----------------------------------------------------------------------------
+ * CAL_HW_WarmState_Generation
+ *
+ * This function returns the generation of the shared state, which changes
+ * each time a process starts to initialize (reset) the Crypto Module. A
+ * change means that the state kept in the CM, such as the assets, is lost.
+ * This function takes no lock and can be called for each operation.
+ *
+ * Return Value:
+ *     The generation, or 0 when there is no shared state.
+ */
+uint32_t
+CAL_HW_WarmState_Generation(void);
+
+
 #endif /* Include Guard */
 
 /* end of file cal_hw_api.h */
@@ -53,8 +53,38 @@
 #include "eip28.h"                  // EIP28_CheckIfDone
 #endif
 
+#ifdef CALHW_WARMSTART_SHM_NAME
+#include <fcntl.h>                  // O_*
+#include <sys/mman.h>               // shm_open, mmap
+#include <sys/file.h>               // flock
+#include <unistd.h>                 // ftruncate, close
+#endif
+
+#ifdef CALHW_INIT_TIMING
+#include <time.h>                   // clock_gettime
+#endif
+
 #define LTQ_FORCE_NO_IDENTITY
 
+#ifdef CALHW_WARMSTART_SHM_NAME
+#define CALHW_WARMSTART_MAGIC  0xCA1A5A4D
+
+// shared state record, see CALHW_WARMSTART_SHM_NAME
+typedef struct
+{
+    volatile uint32_t Magic;        // CALHW_WARMSTART_MAGIC when valid
+    uint32_t ConfigID;              // see CALHWLib_WarmStart_ConfigID
+    volatile uint32_t Generation;   // incremented for each cold start
+    CAL_HW_WarmState_t State;
+} CALHW_WarmRecord_t;
+#endif
+
+#ifdef CALHW_INIT_TIMING
+#define CALHW_TIMESTAMP(_t)  (_t) = CALHWLib_TimeUS()
+#else
+#define CALHW_TIMESTAMP(_t)
+#endif
+
 static struct
 {
     bool fIsInitialized;
@@ -62,6 +92,8 @@ static struct
     struct
     {
         Device_Handle_t Device123;
+        // response words used for the token in the IN mailbox
+        unsigned int ResponseWordCount;
 #ifdef CALHW_USE_INTERRUPTS
         SPAL_Semaphore_t WaitInterruptSem;
         IntDispatch_Handle_t IntDispatch_Handle;
@@ -79,6 +111,16 @@ static struct
     } PKA;
 #endif /* !CALHW_REMOVE_PKA_SUPPORT */
 
+#ifdef CALHW_WARMSTART_SHM_NAME
+    struct
+    {
+        CALHW_WarmRecord_t * Record_p;  // NULL = not available
+        int fd;                         // to lock the record
+        uint32_t Generation;            // of the record this process uses
+        bool fIsWarm;
+    } WarmStart;
+#endif
+
 } CAL_HW;
 
 
@@ -256,14 +298,13 @@ CALHWLib_WaitForOutToken_Polling(void)
 
 
 /*----------------------------------------------------------------------------
- * CALHWLib_ExchangeToken_Sub
+ * CALHWLib_SubmitToken
  *
- * Inner steps of token exchange.
+ * Writes the command token to the IN mailbox and hands it off to the CM.
  */
 static int
-CALHWLib_ExchangeToken_Sub(
-        CMTokens_Command_t * const CommandToken_p,
-        CMTokens_Response_t * const ResponseToken_p)
+CALHWLib_SubmitToken(
+        CMTokens_Command_t * const CommandToken_p)
 {
     int res;
 
@@ -276,6 +317,23 @@ CALHWLib_ExchangeToken_Sub(
     if (res != 0)
         return -1;
 
+    CAL_HW.CM.ResponseWordCount = CommandToken_p->ResponseWordCount;
+
+    return 0;   // success
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALHWLib_WaitToken
+ *
+ * Waits for the OUT mailbox to be full and reads the result token.
+ */
+static int
+CALHWLib_WaitToken(
+        CMTokens_Response_t * const ResponseToken_p)
+{
+    int res;
+
     // wait for the result token to be available
 #ifdef CALHW_USE_INTERRUPTS
     res = CALHWLib_WaitForOutToken_Interrupt();
@@ -286,10 +344,12 @@ CALHWLib_ExchangeToken_Sub(
         return -2;
 
     // copy the OUT token
+    // only the words used for the submitted command
     res = EIP123_ReadToken(
                 CAL_HW.CM.Device123,
                 CALHW_CM_MAILBOX_NR,
-                ResponseToken_p);
+                ResponseToken_p,
+                CAL_HW.CM.ResponseWordCount);
     if (res != 0)
         return -3;
 
@@ -297,6 +357,26 @@ CALHWLib_ExchangeToken_Sub(
 }
 
 
+/*----------------------------------------------------------------------------
+ * CALHWLib_ExchangeToken_Sub
+ *
+ * Inner steps of token exchange.
+ */
+static int
+CALHWLib_ExchangeToken_Sub(
+        CMTokens_Command_t * const CommandToken_p,
+        CMTokens_Response_t * const ResponseToken_p)
+{
+    int res;
+
+    res = CALHWLib_SubmitToken(CommandToken_p);
+    if (res != 0)
+        return res;
+
+    return CALHWLib_WaitToken(ResponseToken_p);
+}
+
+
 /*----------------------------------------------------------------------------
  * CALHWLib_PrintToken
  *
@@ -503,6 +583,41 @@ CALHWLib_DecodeOpcode(
 #endif /* CALHW_TRACE_TOKENS */
 
 
+/*----------------------------------------------------------------------------
+ * CALHWLib_TraceCommand / CALHWLib_TraceResponse
+ */
+#ifdef CALHW_TRACE_TOKENS
+static void
+CALHWLib_TraceCommand(
+        const CMTokens_Command_t * const CommandToken_p)
+{
+    const char * p1 = "?";
+    const char * p2 = p1;
+
+    CALHWLib_DecodeOpcode(CommandToken_p->W[0], &p1, &p2);
+
+    Log_FormattedMessage("IN: Opcode=%s, Subcode=%s\n", p1, p2);
+
+    CALHWLib_PrintToken(
+            "IN: ",
+            CommandToken_p->W,
+            MIN(CommandToken_p->WordCount, CMTOKENS_COMMAND_WORDS));
+}
+
+
+static void
+CALHWLib_TraceResponse(
+        const CMTokens_Response_t * const ResponseToken_p)
+{
+    // only the words read from the mailbox are valid
+    CALHWLib_PrintToken(
+            "OUT: ",
+            ResponseToken_p->W,
+            MIN(CAL_HW.CM.ResponseWordCount, CMTOKENS_RESPONSE_WORDS));
+}
+#endif /* CALHW_TRACE_TOKENS */
+
+
 /*----------------------------------------------------------------------------
  * CALHWLib_ExchangeToken
  *
@@ -518,31 +633,14 @@ CALHWLib_ExchangeToken(
     int res;
 
 #ifdef CALHW_TRACE_TOKENS
-    {
-        const char * p1 = "?";
-        const char * p2 = p1;
-
-        CALHWLib_DecodeOpcode(CommandToken_p->W[0], &p1, &p2);
-
-        Log_FormattedMessage("IN: Opcode=%s, Subcode=%s\n", p1, p2);
-
-        CALHWLib_PrintToken(
-                "IN: ",
-                CommandToken_p->W,
-                CMTOKENS_COMMAND_WORDS);
-    }
+    CALHWLib_TraceCommand(CommandToken_p);
 #endif /* CALHW_TRACE_TOKENS */
 
     res = CALHWLib_ExchangeToken_Sub(CommandToken_p, ResponseToken_p);
 
 #ifdef CALHW_TRACE_TOKENS
     if (res == 0)
-    {
-        CALHWLib_PrintToken(
-                "OUT: ",
-                ResponseToken_p->W,
-                CMTOKENS_RESPONSE_WORDS);
-    }
+        CALHWLib_TraceResponse(ResponseToken_p);
 #endif /* CALHW_TRACE_TOKENS */
 
     return res;
@@ -552,11 +650,13 @@ CALHWLib_ExchangeToken(
 /*----------------------------------------------------------------------------
  * CALHWLib_CM_Init
  *
- * Initialize the communication with the Crypto Module.
+ * Initialize the communication with the Crypto Module. The device
+ * communication test is skipped for a warm start.
  * Returns <0 on error.
  */
 static int
-CALHWLib_CM_Init(void)
+CALHWLib_CM_Init(
+        const bool fVerifyComms)
 {
     int res;
 
@@ -565,8 +665,11 @@ CALHWLib_CM_Init(void)
     if (CAL_HW.CM.Device123 == NULL)
         return -1;
 
-    if (EIP123_VerifyDeviceComms(CAL_HW.CM.Device123, CALHW_CM_MAILBOX_NR) != 0)
+    if (fVerifyComms &&
+        EIP123_VerifyDeviceComms(CAL_HW.CM.Device123, CALHW_CM_MAILBOX_NR) != 0)
+    {
         return -2;
+    }
 
     // get exclusive access to the requested mailbox
     if (EIP123_Link(CAL_HW.CM.Device123, CALHW_CM_MAILBOX_NR) != 0)
@@ -823,6 +926,78 @@ CAL_HW_ExchangeToken(
 }
 
 
+/*----------------------------------------------------------------------------
+ * CAL_HW_SubmitToken
+ *
+ * First half of CAL_HW_ExchangeToken: fills in the identity fields and hands
+ * the token to the Crypto Module, without waiting for the result.
+ *
+ * Return Value:
+ *     0    Success
+ *    <0    Error code
+ */
+int
+CAL_HW_SubmitToken(
+        const CMTokens_Command_t * const CmdToken_p)
+{
+    CMTokens_Command_t t_cmd;
+
+    if (CmdToken_p == NULL)
+        return -1;
+
+    if (CAL_HW.fIsInitialized == false)
+        return -2;
+
+    // make a copy of the token, to prevent the caller from modifying it
+    memcpy(&t_cmd, CmdToken_p, sizeof(CMTokens_Command_t));
+
+    // add the identities
+    #ifndef LTQ_FORCE_NO_IDENTITY
+    CALHWLib_SetIdentityFields(&t_cmd);
+    #endif /* LTQ_FORCE_NO_IDENTITY */
+
+#ifdef CALHW_TRACE_TOKENS
+    CALHWLib_TraceCommand(&t_cmd);
+#endif /* CALHW_TRACE_TOKENS */
+
+    // the token is copied into the IN mailbox
+    return CALHWLib_SubmitToken(&t_cmd);
+}
+
+
+/*----------------------------------------------------------------------------
+ * CAL_HW_WaitToken
+ *
+ * Second half of CAL_HW_ExchangeToken: waits for the result of the token
+ * handed off with CAL_HW_SubmitToken and reads it.
+ *
+ * Return Value:
+ *     0    Success
+ *    <0    Error code
+ */
+int
+CAL_HW_WaitToken(
+        CMTokens_Response_t * const ResponseToken_p)
+{
+    int res;
+
+    if (ResponseToken_p == NULL)
+        return -1;
+
+    if (CAL_HW.fIsInitialized == false)
+        return -2;
+
+    res = CALHWLib_WaitToken(ResponseToken_p);
+
+#ifdef CALHW_TRACE_TOKENS
+    if (res == 0)
+        CALHWLib_TraceResponse(ResponseToken_p);
+#endif /* CALHW_TRACE_TOKENS */
+
+    return res;
+}
+
+
 /*----------------------------------------------------------------------------
  * CALHWLib_InterruptHandler_EIP28
  *
@@ -1040,25 +1215,294 @@ CALHWLib_PKA_Init(void)
 #endif /* !CALHW_REMOVE_PKA_SUPPORT */
 
 
+#ifdef CALHW_INIT_TIMING
 /*----------------------------------------------------------------------------
- * CAL_HW_Init
+ * CALHWLib_TimeUS
+ */
+static uint32_t
+CALHWLib_TimeUS(void)
+{
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+        return 0;
+
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+}
+#endif /* CALHW_INIT_TIMING */
+
+
+#ifdef CALHW_WARMSTART_SHM_NAME
+/*----------------------------------------------------------------------------
+ * CALHWLib_WarmStart_ConfigID
  *
- * This function initializes this implementation.
+ * Identifies the configuration that CAL_HW_Init applies to the CM. A record
+ * written with another configuration is not used.
+ */
+static uint32_t
+CALHWLib_WarmStart_ConfigID(void)
+{
+    uint32_t ID = CALHW_CM_MAILBOX_NR;
+
+#ifdef CALHW_DMACONFIG_RUNPARAMS
+    ID = ID * 31 + CALHW_DMACONFIG_RUNPARAMS;
+#endif
+
+#ifdef CALHW_ENABLE_TRNGCONFIG
+    ID = ID * 31 + 1;
+#ifdef CALHW_TRNGCONFIG_STARTTIME
+    ID = ID * 31 + CALHW_TRNGCONFIG_STARTTIME;
+#endif
+#ifdef CALHW_TRNGCONFIG_AUTOSEED
+    ID = ID * 31 + CALHW_TRNGCONFIG_AUTOSEED;
+#endif
+#ifdef CALHW_TRNGCONFIG_MAXREFILLTIME
+    ID = ID * 31 + CALHW_TRNGCONFIG_MAXREFILLTIME;
+#endif
+#ifdef CALHW_TRNGCONFIG_SAMPLEDIV
+    ID = ID * 31 + CALHW_TRNGCONFIG_SAMPLEDIV;
+#endif
+#ifdef CALHW_TRNGCONFIG_MINREFILLTIME
+    ID = ID * 31 + CALHW_TRNGCONFIG_MINREFILLTIME;
+#endif
+#endif /* CALHW_ENABLE_TRNGCONFIG */
+
+    return ID;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALHWLib_WarmStart_Invalidate
+ *
+ * Invalidates the (locked) shared state record before this process
+ * initializes the CM. The new generation tells the other processes that the
+ * state in the CM is lost.
+ */
+static void
+CALHWLib_WarmStart_Invalidate(void)
+{
+    CALHW_WarmRecord_t * const Record_p = CAL_HW.WarmStart.Record_p;
+
+    // invalid until this process has initialized the CM
+    Record_p->Magic = 0;
+    __sync_synchronize();
+
+    Record_p->Generation++;
+    memset(&Record_p->State, 0, sizeof(CAL_HW_WarmState_t));
+
+    CAL_HW.WarmStart.Generation = Record_p->Generation;
+    CAL_HW.WarmStart.fIsWarm = false;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALHWLib_WarmStart_Open
+ *
+ * Maps the shared state record (creating it when needed) and locks it, so
+ * that only one process at a time initializes the CM. Without the record,
+ * the CM is initialized fully.
+ */
+static void
+CALHWLib_WarmStart_Open(void)
+{
+    void * p;
+    int fd;
+
+    CAL_HW.WarmStart.Record_p = NULL;
+    CAL_HW.WarmStart.fd = -1;
+    CAL_HW.WarmStart.fIsWarm = false;
+
+    // only accessible for the user that initializes the CM
+    fd = shm_open(CALHW_WARMSTART_SHM_NAME, O_RDWR | O_CREAT, 0600);
+    if (fd < 0)
+    {
+        LOG_WARN("CAL_HW: Failed to open the warm start record\n");
+        return;
+    }
+
+    // a new record is all zero (not valid)
+    if (flock(fd, LOCK_EX) != 0 ||
+        ftruncate(fd, sizeof(CALHW_WarmRecord_t)) != 0)
+    {
+        LOG_WARN("CAL_HW: Failed to lock the warm start record\n");
+        close(fd);
+        return;
+    }
+
+    p = mmap(
+            NULL,
+            sizeof(CALHW_WarmRecord_t),
+            PROT_READ | PROT_WRITE,
+            MAP_SHARED,
+            fd,
+            0);
+
+    if (p == MAP_FAILED)
+    {
+        LOG_WARN("CAL_HW: Failed to map the warm start record\n");
+        close(fd);
+        return;
+    }
+
+    CAL_HW.WarmStart.Record_p = p;
+    CAL_HW.WarmStart.fd = fd;
+
+    if (CAL_HW.WarmStart.Record_p->Magic == CALHW_WARMSTART_MAGIC &&
+        CAL_HW.WarmStart.Record_p->ConfigID == CALHWLib_WarmStart_ConfigID())
+    {
+        CAL_HW.WarmStart.fIsWarm = true;
+        CAL_HW.WarmStart.Generation = CAL_HW.WarmStart.Record_p->Generation;
+    }
+    else
+    {
+        CALHWLib_WarmStart_Invalidate();
+    }
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALHWLib_WarmStart_IsLive
+ *
+ * Checks that the CM still has the state that the shared state record
+ * describes. The earlier process left the mailbox linked; a reset of the
+ * CM (by another driver or after a reload of the kernel driver) unlinks
+ * it.
+ */
+static bool
+CALHWLib_WarmStart_IsLive(void)
+{
+    Device_Handle_t Device123;
+
+    Device123 = Device_Find("EIP123");
+    if (Device123 == NULL)
+        return false;
+
+    return EIP123_IsLinked(Device123, CALHW_CM_MAILBOX_NR);
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALHWLib_WarmStart_Close
+ *
+ * Validates the shared state record after a successful cold start, or
+ * invalidates it when the initialization failed, and unlocks it. The record
+ * stays mapped for CAL_HW_WarmState_Get/Update.
+ */
+static void
+CALHWLib_WarmStart_Close(
+        const bool fSuccess)
+{
+    CALHW_WarmRecord_t * const Record_p = CAL_HW.WarmStart.Record_p;
+
+    if (Record_p == NULL)
+        return;
+
+    if (!fSuccess)
+    {
+        // next process must initialize the CM fully
+        Record_p->Magic = 0;
+    }
+    else if (!CAL_HW.WarmStart.fIsWarm)
+    {
+        Record_p->ConfigID = CALHWLib_WarmStart_ConfigID();
+
+        __sync_synchronize();
+        Record_p->Magic = CALHW_WARMSTART_MAGIC;
+    }
+
+    __sync_synchronize();
+    flock(CAL_HW.WarmStart.fd, LOCK_UN);
+}
+#endif /* CALHW_WARMSTART_SHM_NAME */
+
+
+/*----------------------------------------------------------------------------
+ * CAL_HW_WarmState_Get
  */
 int
-CAL_HW_Init(void)
+CAL_HW_WarmState_Get(
+        CAL_HW_WarmState_t * const State_p)
 {
-    int res;
+#ifdef CALHW_WARMSTART_SHM_NAME
+    CALHW_WarmRecord_t * const Record_p = CAL_HW.WarmStart.Record_p;
 
-    // already initialized?
-    if (CAL_HW.fIsInitialized)
+    if (State_p == NULL || Record_p == NULL || !CAL_HW.fIsInitialized)
+        return -1;
+
+    flock(CAL_HW.WarmStart.fd, LOCK_SH);
+    *State_p = Record_p->State;
+    flock(CAL_HW.WarmStart.fd, LOCK_UN);
+
+    return CAL_HW.WarmStart.fIsWarm ? 1 : 0;
+#else
+    IDENTIFIER_NOT_USED(State_p);
+    return -1;
+#endif /* CALHW_WARMSTART_SHM_NAME */
+}
+
+
+/*----------------------------------------------------------------------------
+ * CAL_HW_WarmState_Update
+ */
+void
+CAL_HW_WarmState_Update(
+        const CAL_HW_WarmState_t * const State_p)
+{
+#ifdef CALHW_WARMSTART_SHM_NAME
+    CALHW_WarmRecord_t * const Record_p = CAL_HW.WarmStart.Record_p;
+
+    if (State_p == NULL || Record_p == NULL || !CAL_HW.fIsInitialized)
+        return;
+
+    flock(CAL_HW.WarmStart.fd, LOCK_EX);
+
+    // the state belongs to the initialization of this process
+    if (Record_p->Magic == CALHW_WARMSTART_MAGIC &&
+        Record_p->Generation == CAL_HW.WarmStart.Generation)
+    {
+        Record_p->State = *State_p;
+    }
+
+    flock(CAL_HW.WarmStart.fd, LOCK_UN);
+#else
+    IDENTIFIER_NOT_USED(State_p);
+#endif /* CALHW_WARMSTART_SHM_NAME */
+}
+
+
+/*----------------------------------------------------------------------------
+ * CAL_HW_WarmState_Generation
+ */
+uint32_t
+CAL_HW_WarmState_Generation(void)
+{
+#ifdef CALHW_WARMSTART_SHM_NAME
+    CALHW_WarmRecord_t * const Record_p = CAL_HW.WarmStart.Record_p;
+
+    if (Record_p == NULL || !CAL_HW.fIsInitialized)
         return 0;
 
-#ifdef CALHW_USE_INTERRUPTS
-    Log_FormattedMessageINFO("CAL_HW: Interrupt mode\n");
+    return Record_p->Generation;
 #else
-    Log_FormattedMessageINFO("CAL_HW: Polling mode\n");
-#endif /* CALHW_USE_INTERRUPTS */
+    return 0;
+#endif /* CALHW_WARMSTART_SHM_NAME */
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALHWLib_Init
+ *
+ * Initialization steps of CAL_HW_Init, in order. For a warm start, the steps
+ * that the earlier process has done for the CM are skipped.
+ */
+static int
+CALHWLib_Init(
+        bool fIsWarm)
+{
+    uint32_t T[6] = { 0 };
+    int res;
+
+    CALHW_TIMESTAMP(T[0]);
 
     // Initialize (user mode) Device, DMA-Resource and interrupt access
     // layer, unless already done.
@@ -1066,17 +1510,34 @@ CAL_HW_Init(void)
     if (res != 0)
         return -1;
 
-    res = CAL_HW_ClockAndReset();
-    if (res < 0)
+#ifdef CALHW_WARMSTART_SHM_NAME
+    if (fIsWarm && !CALHWLib_WarmStart_IsLive())
     {
-        LOG_CRIT(
-            "CAL_HW: Clock and Reset error %d\n",
-            res);
+        LOG_WARN("CAL_HW: CM was reset, ignoring the warm start record\n");
 
-        return -2;
+        CALHWLib_WarmStart_Invalidate();
+        fIsWarm = false;
+    }
+#endif
+
+    CALHW_TIMESTAMP(T[1]);
+
+    if (!fIsWarm)
+    {
+        res = CAL_HW_ClockAndReset();
+        if (res < 0)
+        {
+            LOG_CRIT(
+                "CAL_HW: Clock and Reset error %d\n",
+                res);
+
+            return -2;
+        }
     }
 
-    res = CALHWLib_CM_Init();
+    CALHW_TIMESTAMP(T[2]);
+
+    res = CALHWLib_CM_Init(/*fVerifyComms:*/!fIsWarm);
     if (res < 0)
     {
         LOG_CRIT(
@@ -1086,16 +1547,23 @@ CAL_HW_Init(void)
         return -3;
     }
 
-    res = CALHWLib_CM_Configure();
-    if (res < 0)
+    CALHW_TIMESTAMP(T[3]);
+
+    if (!fIsWarm)
     {
-        LOG_CRIT(
-            "CAL_HW: CM configure error %d\n",
-            res);
+        res = CALHWLib_CM_Configure();
+        if (res < 0)
+        {
+            LOG_CRIT(
+                "CAL_HW: CM configure error %d\n",
+                res);
 
-        return -4;
+            return -4;
+        }
     }
 
+    CALHW_TIMESTAMP(T[4]);
+
 #ifndef CALHW_REMOVE_PKA_SUPPORT
     res = CALHWLib_PKA_Init();
     if (res < 0)
@@ -1108,6 +1576,63 @@ CAL_HW_Init(void)
     }
 #endif /* !CALHW_REMOVE_PKA_SUPPORT */
 
+    CALHW_TIMESTAMP(T[5]);
+
+#ifdef CALHW_INIT_TIMING
+    LOG_INFO(
+        "CAL_HW: %s start (us): "
+        "shared libs %u, reset %u, CM %u, configure %u, PKA %u\n",
+        fIsWarm ? "Warm" : "Cold",
+        T[1] - T[0],
+        T[2] - T[1],
+        T[3] - T[2],
+        T[4] - T[3],
+        T[5] - T[4]);
+#endif
+
+    // avoids warning when the timing or LOG_INFO is off
+    IDENTIFIER_NOT_USED(T[0]);
+
+    // success
+    return 0;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CAL_HW_Init
+ *
+ * This function initializes this implementation.
+ */
+int
+CAL_HW_Init(void)
+{
+    bool fIsWarm = false;
+    int res;
+
+    // already initialized?
+    if (CAL_HW.fIsInitialized)
+        return 0;
+
+#ifdef CALHW_USE_INTERRUPTS
+    Log_FormattedMessageINFO("CAL_HW: Interrupt mode\n");
+#else
+    Log_FormattedMessageINFO("CAL_HW: Polling mode\n");
+#endif /* CALHW_USE_INTERRUPTS */
+
+#ifdef CALHW_WARMSTART_SHM_NAME
+    CALHWLib_WarmStart_Open();
+    fIsWarm = CAL_HW.WarmStart.fIsWarm;
+#endif
+
+    res = CALHWLib_Init(fIsWarm);
+
+#ifdef CALHW_WARMSTART_SHM_NAME
+    CALHWLib_WarmStart_Close(res == 0);
+#endif
+
+    if (res < 0)
+        return res;
+
     CAL_HW.fIsInitialized = true;
 
     // success
@@ -0,0 +1,61 @@
+/* c_cal_sw.h
+ *
+ * Configuration options for CAL_SW module
+ * The project-specific cs_cal_sw.h file is included,
+ * whereafter defaults are provided for missing parameters.
+ */
+
+/*****************************************************************************
+* Copyright (c) 2007-2015 INSIDE Secure B.V. All Rights Reserved.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 2 of the License, or
+* any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+/*----------------------------------------------------------------
+ * inclusion of cs_cal_sw.h
+ */
+#include "cs_cal_sw.h"
+#include "cf_cal.h"             // expected implementation
+
+#ifndef CALSW_ECDSA_FIXED_WINDOW
+#define CALSW_ECDSA_FIXED_WINDOW  6
+#endif
+
+#ifndef CALSW_ECDSA_VAR_WINDOW
+#define CALSW_ECDSA_VAR_WINDOW  4
+#endif
+
+#ifndef CALSW_RSA_WINDOW_MAX
+#define CALSW_RSA_WINDOW_MAX  5
+#endif
+
+// CALSW_RSA_CRT_CHECK: RSA-CRT results are not checked unless configured
+
+#if CALSW_ECDSA_FIXED_WINDOW < 2 || CALSW_ECDSA_FIXED_WINDOW > 8
+#error "CALSW_ECDSA_FIXED_WINDOW out of range (2..8)"
+#endif
+
+#if CALSW_ECDSA_VAR_WINDOW < 2 || CALSW_ECDSA_VAR_WINDOW > 8
+#error "CALSW_ECDSA_VAR_WINDOW out of range (2..8)"
+#endif
+
+#if CALSW_RSA_WINDOW_MAX < 1 || CALSW_RSA_WINDOW_MAX > 7
+#error "CALSW_RSA_WINDOW_MAX out of range (1..7)"
+#endif
+
+#ifndef LOG_SEVERITY_MAX
+#define LOG_SEVERITY_MAX  LOG_SEVERITY_WARN
+#endif
+
+/* end of file c_cal_sw.h */
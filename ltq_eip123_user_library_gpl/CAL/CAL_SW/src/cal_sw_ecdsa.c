@@ -0,0 +1,1209 @@
+/* cal_sw_ecdsa.c
+ *
+ * Implementation of the CAL API in software.
+ *
+ * This file implements ECDSA signature verification for the NIST P-224 and
+ * P-256 curves, as used for the secure boot images.
+ */
+
+/*****************************************************************************
+* Copyright (c) 2007-2015 INSIDE Secure B.V. All Rights Reserved.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 2 of the License, or
+* any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "c_cal_sw.h"
+
+#ifdef SFZCRYPTO_CF_ECDSA_VERIFY__SW
+
+#include "basic_defs.h"
+#include "clib.h"
+#include "log.h"
+
+#include "cal_sw.h"                 // the API to implement
+#include "cal_sw_internal.h"
+
+#include "spal_memory.h"
+
+/*
+ * Implementation notes
+ *
+ * Numbers are kept as little-endian arrays of limbs (see
+ * cal_sw_internal.h), wide enough for 256 bits.
+ *
+ * Arithmetic modulo the field prime p and modulo the group order n uses
+ * Montgomery multiplication (R = 2^256), so one routine serves both curves
+ * and both moduli.
+ *
+ * Points are kept in Jacobian coordinates (X, Y, Z) with x = X/Z^2 and
+ * y = Y/Z^3, in the Montgomery domain. Both curves have a = -3, which
+ * allows a cheaper point doubling.
+ *
+ * u1*G + u2*Q is computed with an interleaved wNAF (Shamir's trick): one
+ * chain of doublings, with additions of odd multiples of G and Q. The odd
+ * multiples of G are computed once per curve, converted to affine form and
+ * kept for later verifies. The odd multiples of Q are computed per verify.
+ *
+ * The final comparison avoids an inversion: x(R) mod n == r is checked as
+ * X == r * Z^2 (mod p), and X == (r + n) * Z^2 when r + n < p.
+ *
+ * Only public values are processed, so the code is not constant-time.
+ */
+
+#define CALSW_ECC_BYTES   32
+#define CALSW_ECC_LIMBS   (CALSW_ECC_BYTES / CALSW_LIMB_BYTES)
+
+// wNAF digits for a 256-bit scalar
+#define CALSW_ECC_NAF_MAX  (CALSW_ECC_BYTES * 8 + 1)
+
+#define CALSW_ECC_FIXED_POINTS  (1 << (CALSW_ECDSA_FIXED_WINDOW - 2))
+#define CALSW_ECC_VAR_POINTS    (1 << (CALSW_ECDSA_VAR_WINDOW - 2))
+
+typedef CALSW_Limb_t CALSW_BigNum_t[CALSW_ECC_LIMBS];
+
+// modulus with its Montgomery constants
+typedef struct
+{
+    CALSW_BigNum_t m;
+    CALSW_BigNum_t One;             // R mod m
+    CALSW_BigNum_t R2;              // R^2 mod m
+    CALSW_Limb_t m0inv;             // -m^-1 mod 2^CALSW_LIMB_BITS
+} CALSW_Mod_t;
+
+typedef struct
+{
+    CALSW_BigNum_t X;
+    CALSW_BigNum_t Y;
+    CALSW_BigNum_t Z;
+} CALSW_PointJ_t;
+
+typedef struct
+{
+    CALSW_BigNum_t x;
+    CALSW_BigNum_t y;
+} CALSW_PointA_t;
+
+// curve parameters, big-endian as passed through the CAL API
+typedef struct
+{
+    const char * Name_p;
+    uint32_t ByteLen;
+    const uint8_t * p_p;
+    const uint8_t * a_p;
+    const uint8_t * b_p;
+    const uint8_t * n_p;
+    const uint8_t * Gx_p;
+    const uint8_t * Gy_p;
+} CALSW_CurveParams_t;
+
+// curve state prepared on first use
+typedef struct
+{
+    const CALSW_CurveParams_t * Params_p;
+    CALSW_Mod_t P;
+    CALSW_Mod_t N;
+    CALSW_BigNum_t bM;              // b, Montgomery domain (mod p)
+    CALSW_BigNum_t nPlain;          // n, for the r + n < p check
+    CALSW_PointA_t GTable[CALSW_ECC_FIXED_POINTS];  // G, 3G, 5G, ...
+} CALSW_Curve_t;
+
+#ifdef CALSW_ECDSA_CURVE_P224
+static const CALSW_CurveParams_t CALSW_Curve_P224 =
+{
+    "P-224",
+    28,
+    (const uint8_t *)
+    "\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
+    "\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x01",
+    (const uint8_t *)
+    "\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFE"
+    "\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFE",
+    (const uint8_t *)
+    "\xB4\x05\x0A\x85\x0C\x04\xB3\xAB\xF5\x41\x32\x56\x50\x44\xB0\xB7"
+    "\xD7\xBF\xD8\xBA\x27\x0B\x39\x43\x23\x55\xFF\xB4",
+    (const uint8_t *)
+    "\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x16\xA2"
+    "\xE0\xB8\xF0\x3E\x13\xDD\x29\x45\x5C\x5C\x2A\x3D",
+    (const uint8_t *)
+    "\xB7\x0E\x0C\xBD\x6B\xB4\xBF\x7F\x32\x13\x90\xB9\x4A\x03\xC1\xD3"
+    "\x56\xC2\x11\x22\x34\x32\x80\xD6\x11\x5C\x1D\x21",
+    (const uint8_t *)
+    "\xBD\x37\x63\x88\xB5\xF7\x23\xFB\x4C\x22\xDF\xE6\xCD\x43\x75\xA0"
+    "\x5A\x07\x47\x64\x44\xD5\x81\x99\x85\x00\x7E\x34"
+};
+
+static CALSW_Curve_t * volatile CALSW_Curve_P224_p = NULL;
+#endif /* CALSW_ECDSA_CURVE_P224 */
+
+#ifdef CALSW_ECDSA_CURVE_P256
+static const CALSW_CurveParams_t CALSW_Curve_P256 =
+{
+    "P-256",
+    32,
+    (const uint8_t *)
+    "\xFF\xFF\xFF\xFF\x00\x00\x00\x01\x00\x00\x00\x00\x00\x00\x00\x00"
+    "\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF",
+    (const uint8_t *)
+    "\xFF\xFF\xFF\xFF\x00\x00\x00\x01\x00\x00\x00\x00\x00\x00\x00\x00"
+    "\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFC",
+    (const uint8_t *)
+    "\x5A\xC6\x35\xD8\xAA\x3A\x93\xE7\xB3\xEB\xBD\x55\x76\x98\x86\xBC"
+    "\x65\x1D\x06\xB0\xCC\x53\xB0\xF6\x3B\xCE\x3C\x3E\x27\xD2\x60\x4B",
+    (const uint8_t *)
+    "\xFF\xFF\xFF\xFF\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
+    "\xBC\xE6\xFA\xAD\xA7\x17\x9E\x84\xF3\xB9\xCA\xC2\xFC\x63\x25\x51",
+    (const uint8_t *)
+    "\x6B\x17\xD1\xF2\xE1\x2C\x42\x47\xF8\xBC\xE6\xE5\x63\xA4\x40\xF2"
+    "\x77\x03\x7D\x81\x2D\xEB\x33\xA0\xF4\xA1\x39\x45\xD8\x98\xC2\x96",
+    (const uint8_t *)
+    "\x4F\xE3\x42\xE2\xFE\x1A\x7F\x9B\x8E\xE7\xEB\x4A\x7C\x0F\x9E\x16"
+    "\x2B\xCE\x33\x57\x6B\x31\x5E\xCE\xCB\xB6\x40\x68\x37\xBF\x51\xF5"
+};
+
+static CALSW_Curve_t * volatile CALSW_Curve_P256_p = NULL;
+#endif /* CALSW_ECDSA_CURVE_P256 */
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_BigNum_FromBytes
+ *
+ * Converts a big-endian octet string to a BigNum. Leading zero bytes are
+ * allowed. Returns false when the value does not fit in MaxBytes.
+ */
+static bool
+CALSWLib_BigNum_FromBytes(
+        CALSW_BigNum_t r,
+        const uint8_t * Data_p,
+        uint32_t DataLen,
+        const uint32_t MaxBytes)
+{
+    unsigned int i;
+
+    if (Data_p == NULL)
+        return false;
+
+    while (DataLen > MaxBytes)
+    {
+        if (*Data_p != 0)
+            return false;
+
+        Data_p++;
+        DataLen--;
+    }
+
+    c_memset(r, 0, sizeof(CALSW_BigNum_t));
+
+    for (i = 0; i < DataLen; i++)
+    {
+        const unsigned int ByteNr = DataLen - 1 - i;
+
+        r[ByteNr / CALSW_LIMB_BYTES] |=
+            (CALSW_Limb_t)Data_p[i] << (8 * (ByteNr % CALSW_LIMB_BYTES));
+    }
+
+    return true;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_BigNum_Cmp
+ */
+static int
+CALSWLib_BigNum_Cmp(
+        const CALSW_BigNum_t a,
+        const CALSW_BigNum_t b)
+{
+    int i;
+
+    for (i = CALSW_ECC_LIMBS - 1; i >= 0; i--)
+    {
+        if (a[i] != b[i])
+            return (a[i] > b[i]) ? 1 : -1;
+    }
+
+    return 0;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_BigNum_IsZero
+ */
+static bool
+CALSWLib_BigNum_IsZero(
+        const CALSW_BigNum_t a)
+{
+    CALSW_Limb_t Acc = 0;
+    unsigned int i;
+
+    for (i = 0; i < CALSW_ECC_LIMBS; i++)
+        Acc |= a[i];
+
+    return (Acc == 0);
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_BigNum_Add
+ *
+ * r = a + b, returns the carry.
+ */
+static CALSW_Limb_t
+CALSWLib_BigNum_Add(
+        CALSW_BigNum_t r,
+        const CALSW_BigNum_t a,
+        const CALSW_BigNum_t b)
+{
+    CALSW_DLimb_t Acc = 0;
+    unsigned int i;
+
+    for (i = 0; i < CALSW_ECC_LIMBS; i++)
+    {
+        Acc += (CALSW_DLimb_t)a[i] + b[i];
+        r[i] = (CALSW_Limb_t)Acc;
+        Acc >>= CALSW_LIMB_BITS;
+    }
+
+    return (CALSW_Limb_t)Acc;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_BigNum_Sub
+ *
+ * r = a - b, returns the borrow.
+ */
+static CALSW_Limb_t
+CALSWLib_BigNum_Sub(
+        CALSW_BigNum_t r,
+        const CALSW_BigNum_t a,
+        const CALSW_BigNum_t b)
+{
+    CALSW_Limb_t Borrow = 0;
+    unsigned int i;
+
+    for (i = 0; i < CALSW_ECC_LIMBS; i++)
+    {
+        const CALSW_Limb_t ai = a[i];
+        const CALSW_Limb_t d = ai - b[i];
+
+        r[i] = d - Borrow;
+        Borrow = (ai < b[i]) | (d < Borrow);
+    }
+
+    return Borrow;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Mod_Add
+ *
+ * r = a + b mod m, for a, b < m.
+ */
+static void
+CALSWLib_Mod_Add(
+        CALSW_BigNum_t r,
+        const CALSW_BigNum_t a,
+        const CALSW_BigNum_t b,
+        const CALSW_Mod_t * const M_p)
+{
+    if (CALSWLib_BigNum_Add(r, a, b) ||
+        CALSWLib_BigNum_Cmp(r, M_p->m) >= 0)
+    {
+        CALSWLib_BigNum_Sub(r, r, M_p->m);
+    }
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Mod_Sub
+ *
+ * r = a - b mod m, for a, b < m.
+ */
+static void
+CALSWLib_Mod_Sub(
+        CALSW_BigNum_t r,
+        const CALSW_BigNum_t a,
+        const CALSW_BigNum_t b,
+        const CALSW_Mod_t * const M_p)
+{
+    if (CALSWLib_BigNum_Sub(r, a, b))
+        CALSWLib_BigNum_Add(r, r, M_p->m);
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Mod_Mul
+ *
+ * Montgomery multiplication: r = a * b / R mod m, for a, b < m.
+ * r may overlap with a or b.
+ */
+static void
+CALSWLib_Mod_Mul(
+        CALSW_BigNum_t r,
+        const CALSW_BigNum_t a,
+        const CALSW_BigNum_t b,
+        const CALSW_Mod_t * const M_p)
+{
+    CALSW_Limb_t t[CALSW_ECC_LIMBS + 2];
+    unsigned int i, j;
+
+    c_memset(t, 0, sizeof(t));
+
+    for (i = 0; i < CALSW_ECC_LIMBS; i++)
+    {
+        CALSW_DLimb_t Acc = 0;
+        CALSW_Limb_t q;
+
+        // t += a * b[i]
+        for (j = 0; j < CALSW_ECC_LIMBS; j++)
+        {
+            Acc += (CALSW_DLimb_t)a[j] * b[i] + t[j];
+            t[j] = (CALSW_Limb_t)Acc;
+            Acc >>= CALSW_LIMB_BITS;
+        }
+
+        Acc += t[CALSW_ECC_LIMBS];
+        t[CALSW_ECC_LIMBS] = (CALSW_Limb_t)Acc;
+        t[CALSW_ECC_LIMBS + 1] = (CALSW_Limb_t)(Acc >> CALSW_LIMB_BITS);
+
+        // t = (t + q * m) / 2^CALSW_LIMB_BITS
+        q = t[0] * M_p->m0inv;
+
+        Acc = (CALSW_DLimb_t)q * M_p->m[0] + t[0];
+        Acc >>= CALSW_LIMB_BITS;
+
+        for (j = 1; j < CALSW_ECC_LIMBS; j++)
+        {
+            Acc += (CALSW_DLimb_t)q * M_p->m[j] + t[j];
+            t[j - 1] = (CALSW_Limb_t)Acc;
+            Acc >>= CALSW_LIMB_BITS;
+        }
+
+        Acc += t[CALSW_ECC_LIMBS];
+        t[CALSW_ECC_LIMBS - 1] = (CALSW_Limb_t)Acc;
+        t[CALSW_ECC_LIMBS] =
+            t[CALSW_ECC_LIMBS + 1] + (CALSW_Limb_t)(Acc >> CALSW_LIMB_BITS);
+    }
+
+    // t < 2m
+    if (t[CALSW_ECC_LIMBS] != 0 || CALSWLib_BigNum_Cmp(t, M_p->m) >= 0)
+        CALSWLib_BigNum_Sub(r, t, M_p->m);
+    else
+        c_memcpy(r, t, sizeof(CALSW_BigNum_t));
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Mod_Inv
+ *
+ * r = a^-1 (Montgomery domain), using a^(m-2) for prime m.
+ */
+static void
+CALSWLib_Mod_Inv(
+        CALSW_BigNum_t r,
+        const CALSW_BigNum_t a,
+        const CALSW_Mod_t * const M_p)
+{
+    CALSW_BigNum_t e;
+    CALSW_BigNum_t Acc;
+    CALSW_BigNum_t Two;
+    int Bit;
+
+    c_memset(Two, 0, sizeof(Two));
+    Two[0] = 2;
+    CALSWLib_BigNum_Sub(e, M_p->m, Two);
+
+    c_memcpy(Acc, M_p->One, sizeof(Acc));
+
+    for (Bit = CALSW_ECC_LIMBS * CALSW_LIMB_BITS - 1; Bit >= 0; Bit--)
+    {
+        CALSWLib_Mod_Mul(Acc, Acc, Acc, M_p);
+
+        if ((e[Bit / CALSW_LIMB_BITS] >> (Bit % CALSW_LIMB_BITS)) & 1)
+            CALSWLib_Mod_Mul(Acc, Acc, a, M_p);
+    }
+
+    c_memcpy(r, Acc, sizeof(Acc));
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Mod_Setup
+ *
+ * Prepares the Montgomery constants for the odd modulus m.
+ */
+static void
+CALSWLib_Mod_Setup(
+        CALSW_Mod_t * const M_p,
+        const CALSW_BigNum_t m)
+{
+    CALSW_BigNum_t x;
+    CALSW_Limb_t Inv;
+    unsigned int i;
+
+    c_memcpy(M_p->m, m, sizeof(CALSW_BigNum_t));
+
+    // m^-1 mod 2^CALSW_LIMB_BITS by Newton iteration
+    // each step doubles the number of correct bits (starting with 3)
+    Inv = m[0];
+    for (i = 0; i < 5; i++)
+        Inv *= 2 - m[0] * Inv;
+
+    M_p->m0inv = (CALSW_Limb_t)0 - Inv;
+
+    // x = 2^i mod m, for i up to 2 * 256
+    c_memset(x, 0, sizeof(x));
+    x[0] = 1;
+
+    for (i = 0; i < 2 * CALSW_ECC_LIMBS * CALSW_LIMB_BITS; i++)
+    {
+        CALSWLib_Mod_Add(x, x, x, M_p);
+
+        if (i == CALSW_ECC_LIMBS * CALSW_LIMB_BITS - 1)
+            c_memcpy(M_p->One, x, sizeof(x));
+    }
+
+    c_memcpy(M_p->R2, x, sizeof(x));
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Point_Double
+ *
+ * P = 2 * P (Jacobian, a = -3).
+ */
+static void
+CALSWLib_Point_Double(
+        CALSW_PointJ_t * const P_p,
+        const CALSW_Mod_t * const F_p)
+{
+    CALSW_BigNum_t Delta, Gamma, Beta, Alpha, t1, t2;
+
+    if (CALSWLib_BigNum_IsZero(P_p->Z))
+        return;
+
+    CALSWLib_Mod_Mul(Delta, P_p->Z, P_p->Z, F_p);
+    CALSWLib_Mod_Mul(Gamma, P_p->Y, P_p->Y, F_p);
+    CALSWLib_Mod_Mul(Beta, P_p->X, Gamma, F_p);
+
+    // Alpha = 3 * (X - Delta) * (X + Delta)
+    CALSWLib_Mod_Sub(t1, P_p->X, Delta, F_p);
+    CALSWLib_Mod_Add(t2, P_p->X, Delta, F_p);
+    CALSWLib_Mod_Mul(Alpha, t1, t2, F_p);
+    CALSWLib_Mod_Add(t1, Alpha, Alpha, F_p);
+    CALSWLib_Mod_Add(Alpha, t1, Alpha, F_p);
+
+    // Z3 = (Y + Z)^2 - Gamma - Delta
+    CALSWLib_Mod_Add(t1, P_p->Y, P_p->Z, F_p);
+    CALSWLib_Mod_Mul(t1, t1, t1, F_p);
+    CALSWLib_Mod_Sub(t1, t1, Gamma, F_p);
+    CALSWLib_Mod_Sub(P_p->Z, t1, Delta, F_p);
+
+    // X3 = Alpha^2 - 8 * Beta
+    CALSWLib_Mod_Add(Beta, Beta, Beta, F_p);
+    CALSWLib_Mod_Add(Beta, Beta, Beta, F_p);        // 4 * Beta
+    CALSWLib_Mod_Add(t2, Beta, Beta, F_p);
+    CALSWLib_Mod_Mul(t1, Alpha, Alpha, F_p);
+    CALSWLib_Mod_Sub(P_p->X, t1, t2, F_p);
+
+    // Y3 = Alpha * (4 * Beta - X3) - 8 * Gamma^2
+    CALSWLib_Mod_Sub(t1, Beta, P_p->X, F_p);
+    CALSWLib_Mod_Mul(t1, Alpha, t1, F_p);
+    CALSWLib_Mod_Mul(t2, Gamma, Gamma, F_p);
+    CALSWLib_Mod_Add(t2, t2, t2, F_p);
+    CALSWLib_Mod_Add(t2, t2, t2, F_p);
+    CALSWLib_Mod_Add(t2, t2, t2, F_p);
+    CALSWLib_Mod_Sub(P_p->Y, t1, t2, F_p);
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Point_Add
+ *
+ * P = P + Q (Jacobian + Jacobian), with Q negated when fNegate is set.
+ */
+static void
+CALSWLib_Point_Add(
+        CALSW_PointJ_t * const P_p,
+        const CALSW_PointJ_t * const Q_p,
+        const bool fNegate,
+        const CALSW_Mod_t * const F_p)
+{
+    CALSW_BigNum_t Z1Z1, Z2Z2, U1, U2, S1, S2, H, I, J, r, V, t;
+
+    if (CALSWLib_BigNum_IsZero(Q_p->Z))
+        return;
+
+    if (CALSWLib_BigNum_IsZero(P_p->Z))
+    {
+        *P_p = *Q_p;
+        if (fNegate)
+        {
+            c_memset(t, 0, sizeof(t));
+            CALSWLib_Mod_Sub(P_p->Y, t, Q_p->Y, F_p);
+        }
+        return;
+    }
+
+    CALSWLib_Mod_Mul(Z1Z1, P_p->Z, P_p->Z, F_p);
+    CALSWLib_Mod_Mul(Z2Z2, Q_p->Z, Q_p->Z, F_p);
+    CALSWLib_Mod_Mul(U1, P_p->X, Z2Z2, F_p);
+    CALSWLib_Mod_Mul(U2, Q_p->X, Z1Z1, F_p);
+    CALSWLib_Mod_Mul(S1, P_p->Y, Q_p->Z, F_p);
+    CALSWLib_Mod_Mul(S1, S1, Z2Z2, F_p);
+    CALSWLib_Mod_Mul(S2, Q_p->Y, P_p->Z, F_p);
+    CALSWLib_Mod_Mul(S2, S2, Z1Z1, F_p);
+
+    if (fNegate)
+    {
+        c_memset(t, 0, sizeof(t));
+        CALSWLib_Mod_Sub(S2, t, S2, F_p);
+    }
+
+    CALSWLib_Mod_Sub(H, U2, U1, F_p);
+    CALSWLib_Mod_Sub(r, S2, S1, F_p);
+
+    if (CALSWLib_BigNum_IsZero(H))
+    {
+        if (CALSWLib_BigNum_IsZero(r))
+            CALSWLib_Point_Double(P_p, F_p);
+        else
+            c_memset(P_p, 0, sizeof(CALSW_PointJ_t));   // infinity
+
+        return;
+    }
+
+    CALSWLib_Mod_Add(r, r, r, F_p);
+
+    // I = (2 * H)^2, J = H * I, V = U1 * I
+    CALSWLib_Mod_Add(I, H, H, F_p);
+    CALSWLib_Mod_Mul(I, I, I, F_p);
+    CALSWLib_Mod_Mul(J, H, I, F_p);
+    CALSWLib_Mod_Mul(V, U1, I, F_p);
+
+    // Z3 = ((Z1 + Z2)^2 - Z1Z1 - Z2Z2) * H
+    CALSWLib_Mod_Add(t, P_p->Z, Q_p->Z, F_p);
+    CALSWLib_Mod_Mul(t, t, t, F_p);
+    CALSWLib_Mod_Sub(t, t, Z1Z1, F_p);
+    CALSWLib_Mod_Sub(t, t, Z2Z2, F_p);
+    CALSWLib_Mod_Mul(P_p->Z, t, H, F_p);
+
+    // X3 = r^2 - J - 2 * V
+    CALSWLib_Mod_Mul(t, r, r, F_p);
+    CALSWLib_Mod_Sub(t, t, J, F_p);
+    CALSWLib_Mod_Sub(t, t, V, F_p);
+    CALSWLib_Mod_Sub(P_p->X, t, V, F_p);
+
+    // Y3 = r * (V - X3) - 2 * S1 * J
+    CALSWLib_Mod_Sub(t, V, P_p->X, F_p);
+    CALSWLib_Mod_Mul(t, r, t, F_p);
+    CALSWLib_Mod_Mul(S1, S1, J, F_p);
+    CALSWLib_Mod_Add(S1, S1, S1, F_p);
+    CALSWLib_Mod_Sub(P_p->Y, t, S1, F_p);
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Point_AddAffine
+ *
+ * P = P + A (Jacobian + affine), with A negated when fNegate is set.
+ */
+static void
+CALSWLib_Point_AddAffine(
+        CALSW_PointJ_t * const P_p,
+        const CALSW_PointA_t * const A_p,
+        const bool fNegate,
+        const CALSW_Mod_t * const F_p)
+{
+    CALSW_BigNum_t y2, Z1Z1, U2, S2, H, HH, I, J, r, V, t;
+
+    if (fNegate)
+    {
+        c_memset(t, 0, sizeof(t));
+        CALSWLib_Mod_Sub(y2, t, A_p->y, F_p);
+    }
+    else
+    {
+        c_memcpy(y2, A_p->y, sizeof(y2));
+    }
+
+    if (CALSWLib_BigNum_IsZero(P_p->Z))
+    {
+        c_memcpy(P_p->X, A_p->x, sizeof(P_p->X));
+        c_memcpy(P_p->Y, y2, sizeof(P_p->Y));
+        c_memcpy(P_p->Z, F_p->One, sizeof(P_p->Z));
+        return;
+    }
+
+    CALSWLib_Mod_Mul(Z1Z1, P_p->Z, P_p->Z, F_p);
+    CALSWLib_Mod_Mul(U2, A_p->x, Z1Z1, F_p);
+    CALSWLib_Mod_Mul(S2, y2, P_p->Z, F_p);
+    CALSWLib_Mod_Mul(S2, S2, Z1Z1, F_p);
+
+    CALSWLib_Mod_Sub(H, U2, P_p->X, F_p);
+    CALSWLib_Mod_Sub(r, S2, P_p->Y, F_p);
+
+    if (CALSWLib_BigNum_IsZero(H))
+    {
+        if (CALSWLib_BigNum_IsZero(r))
+            CALSWLib_Point_Double(P_p, F_p);
+        else
+            c_memset(P_p, 0, sizeof(CALSW_PointJ_t));   // infinity
+
+        return;
+    }
+
+    CALSWLib_Mod_Add(r, r, r, F_p);
+
+    // I = 4 * H^2, J = H * I, V = X1 * I
+    CALSWLib_Mod_Mul(HH, H, H, F_p);
+    CALSWLib_Mod_Add(I, HH, HH, F_p);
+    CALSWLib_Mod_Add(I, I, I, F_p);
+    CALSWLib_Mod_Mul(J, H, I, F_p);
+    CALSWLib_Mod_Mul(V, P_p->X, I, F_p);
+
+    // Z3 = (Z1 + H)^2 - Z1Z1 - HH
+    CALSWLib_Mod_Add(t, P_p->Z, H, F_p);
+    CALSWLib_Mod_Mul(t, t, t, F_p);
+    CALSWLib_Mod_Sub(t, t, Z1Z1, F_p);
+    CALSWLib_Mod_Sub(P_p->Z, t, HH, F_p);
+
+    // X3 = r^2 - J - 2 * V
+    CALSWLib_Mod_Mul(t, r, r, F_p);
+    CALSWLib_Mod_Sub(t, t, J, F_p);
+    CALSWLib_Mod_Sub(t, t, V, F_p);
+    CALSWLib_Mod_Sub(t, t, V, F_p);
+
+    // Y3 = r * (V - X3) - 2 * Y1 * J
+    CALSWLib_Mod_Mul(J, P_p->Y, J, F_p);
+    CALSWLib_Mod_Add(J, J, J, F_p);
+    CALSWLib_Mod_Sub(V, V, t, F_p);
+    CALSWLib_Mod_Mul(V, r, V, F_p);
+    CALSWLib_Mod_Sub(P_p->Y, V, J, F_p);
+
+    c_memcpy(P_p->X, t, sizeof(t));
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Point_OddMultiples
+ *
+ * T[i] = (2 * i + 1) * P, for i in 0..Count-1.
+ */
+static void
+CALSWLib_Point_OddMultiples(
+        CALSW_PointJ_t * const T_p,
+        const CALSW_PointJ_t * const P_p,
+        const unsigned int Count,
+        const CALSW_Mod_t * const F_p)
+{
+    CALSW_PointJ_t P2;
+    unsigned int i;
+
+    T_p[0] = *P_p;
+
+    P2 = *P_p;
+    CALSWLib_Point_Double(&P2, F_p);
+
+    for (i = 1; i < Count; i++)
+    {
+        T_p[i] = T_p[i - 1];
+        CALSWLib_Point_Add(&T_p[i], &P2, false, F_p);
+    }
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Point_ToAffineBatch
+ *
+ * Converts Count points (none at infinity) to affine form, sharing a single
+ * inversion between all of them.
+ */
+static void
+CALSWLib_Point_ToAffineBatch(
+        CALSW_PointA_t * const A_p,
+        const CALSW_PointJ_t * const J_p,
+        const unsigned int Count,
+        const CALSW_Mod_t * const F_p)
+{
+    CALSW_BigNum_t Acc[CALSW_ECC_FIXED_POINTS];
+    CALSW_BigNum_t Inv, ZInv, ZInv2;
+    int i;
+
+    c_memcpy(Acc[0], J_p[0].Z, sizeof(Acc[0]));
+    for (i = 1; i < (int)Count; i++)
+        CALSWLib_Mod_Mul(Acc[i], Acc[i - 1], J_p[i].Z, F_p);
+
+    CALSWLib_Mod_Inv(Inv, Acc[Count - 1], F_p);
+
+    for (i = (int)Count - 1; i >= 0; i--)
+    {
+        if (i > 0)
+        {
+            CALSWLib_Mod_Mul(ZInv, Inv, Acc[i - 1], F_p);
+            CALSWLib_Mod_Mul(Inv, Inv, J_p[i].Z, F_p);
+        }
+        else
+        {
+            c_memcpy(ZInv, Inv, sizeof(ZInv));
+        }
+
+        CALSWLib_Mod_Mul(ZInv2, ZInv, ZInv, F_p);
+        CALSWLib_Mod_Mul(A_p[i].x, J_p[i].X, ZInv2, F_p);
+        CALSWLib_Mod_Mul(ZInv2, ZInv2, ZInv, F_p);
+        CALSWLib_Mod_Mul(A_p[i].y, J_p[i].Y, ZInv2, F_p);
+    }
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Scalar_ToNaf
+ *
+ * Recodes k to width-w NAF: odd digits in -(2^(w-1)-1)..2^(w-1)-1, least
+ * significant first, with at least w-1 zeros after each non-zero digit.
+ * Returns the number of digits.
+ */
+static unsigned int
+CALSWLib_Scalar_ToNaf(
+        int8_t * const Naf_p,
+        const CALSW_BigNum_t k,
+        const unsigned int Window)
+{
+    CALSW_Limb_t t[CALSW_ECC_LIMBS + 1];
+    const int Mod = 1 << Window;
+    unsigned int Len = 0;
+    unsigned int i;
+
+    c_memcpy(t, k, sizeof(CALSW_BigNum_t));
+    t[CALSW_ECC_LIMBS] = 0;
+
+    for (;;)
+    {
+        CALSW_Limb_t Acc = 0;
+        int d = 0;
+
+        for (i = 0; i <= CALSW_ECC_LIMBS; i++)
+            Acc |= t[i];
+
+        if (Acc == 0)
+            break;
+
+        if (t[0] & 1)
+        {
+            d = (int)(t[0] & (CALSW_Limb_t)(Mod - 1));
+            if (d >= Mod / 2)
+                d -= Mod;
+
+            if (d > 0)
+            {
+                // the low bits of t are d, so no borrow
+                t[0] -= (CALSW_Limb_t)d;
+            }
+            else
+            {
+                CALSW_Limb_t Carry = (CALSW_Limb_t)-d;
+
+                for (i = 0; i <= CALSW_ECC_LIMBS && Carry != 0; i++)
+                {
+                    t[i] += Carry;
+                    Carry = (t[i] < Carry);
+                }
+            }
+        }
+
+        Naf_p[Len++] = (int8_t)d;
+
+        // t >>= 1
+        for (i = 0; i < CALSW_ECC_LIMBS; i++)
+            t[i] = (t[i] >> 1) | (t[i + 1] << (CALSW_LIMB_BITS - 1));
+        t[CALSW_ECC_LIMBS] >>= 1;
+    }
+
+    return Len;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Curve_Setup
+ */
+static bool
+CALSWLib_Curve_Setup(
+        CALSW_Curve_t * const Curve_p,
+        const CALSW_CurveParams_t * const Params_p)
+{
+    CALSW_PointJ_t * T_p;
+    CALSW_PointJ_t G;
+    CALSW_BigNum_t t;
+    const uint32_t Len = Params_p->ByteLen;
+
+    T_p = SPAL_Memory_Alloc(CALSW_ECC_FIXED_POINTS * sizeof(CALSW_PointJ_t));
+    if (T_p == NULL)
+        return false;
+
+    Curve_p->Params_p = Params_p;
+
+    CALSWLib_BigNum_FromBytes(t, Params_p->p_p, Len, Len);
+    CALSWLib_Mod_Setup(&Curve_p->P, t);
+
+    CALSWLib_BigNum_FromBytes(t, Params_p->n_p, Len, Len);
+    CALSWLib_Mod_Setup(&Curve_p->N, t);
+    c_memcpy(Curve_p->nPlain, t, sizeof(t));
+
+    CALSWLib_BigNum_FromBytes(t, Params_p->b_p, Len, Len);
+    CALSWLib_Mod_Mul(Curve_p->bM, t, Curve_p->P.R2, &Curve_p->P);
+
+    CALSWLib_BigNum_FromBytes(t, Params_p->Gx_p, Len, Len);
+    CALSWLib_Mod_Mul(G.X, t, Curve_p->P.R2, &Curve_p->P);
+    CALSWLib_BigNum_FromBytes(t, Params_p->Gy_p, Len, Len);
+    CALSWLib_Mod_Mul(G.Y, t, Curve_p->P.R2, &Curve_p->P);
+    c_memcpy(G.Z, Curve_p->P.One, sizeof(G.Z));
+
+    CALSWLib_Point_OddMultiples(
+            T_p,
+            &G,
+            CALSW_ECC_FIXED_POINTS,
+            &Curve_p->P);
+
+    CALSWLib_Point_ToAffineBatch(
+            Curve_p->GTable,
+            T_p,
+            CALSW_ECC_FIXED_POINTS,
+            &Curve_p->P);
+
+    SPAL_Memory_Free(T_p);
+
+    return true;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Curve_Get
+ *
+ * Returns the prepared state for the curve, preparing it on first use.
+ * The state is never freed. When two threads race, the first one to
+ * publish its copy wins and the other copy is discarded.
+ */
+static const CALSW_Curve_t *
+CALSWLib_Curve_Get(
+        const CALSW_CurveParams_t * const Params_p,
+        CALSW_Curve_t * volatile * const Curve_pp)
+{
+    CALSW_Curve_t * Curve_p = *Curve_pp;
+
+    if (Curve_p != NULL)
+        return Curve_p;
+
+    Curve_p = SPAL_Memory_Alloc(sizeof(CALSW_Curve_t));
+    if (Curve_p == NULL)
+        return NULL;
+
+    if (!CALSWLib_Curve_Setup(Curve_p, Params_p))
+    {
+        SPAL_Memory_Free(Curve_p);
+        return NULL;
+    }
+
+    LOG_INFO(
+        "CALSWLib_Curve_Get: "
+        "Prepared %s (%d point table)\n",
+        Params_p->Name_p,
+        CALSW_ECC_FIXED_POINTS);
+
+    // make the table visible before the pointer
+    __sync_synchronize();
+
+    if (!__sync_bool_compare_and_swap(Curve_pp, NULL, Curve_p))
+    {
+        SPAL_Memory_Free(Curve_p);
+        Curve_p = *Curve_pp;
+    }
+
+    return Curve_p;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_BigInt_Equals
+ */
+static bool
+CALSWLib_BigInt_Equals(
+        const SfzCryptoBigInt * const BigInt_p,
+        const uint8_t * const Value_p,
+        const uint32_t ValueLen)
+{
+    const uint8_t * Data_p = BigInt_p->p_num;
+    uint32_t DataLen = BigInt_p->byteLen;
+
+    if (Data_p == NULL)
+        return false;
+
+    while (DataLen > ValueLen && *Data_p == 0)
+    {
+        Data_p++;
+        DataLen--;
+    }
+
+    if (DataLen != ValueLen)
+        return false;
+
+    return (c_memcmp(Data_p, Value_p, ValueLen) == 0);
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Curve_Matches
+ *
+ * Checks that the domain parameters passed by the caller are exactly those
+ * of the known curve.
+ */
+static bool
+CALSWLib_Curve_Matches(
+        const SfzCryptoECPDomainParam * const Domain_p,
+        const CALSW_CurveParams_t * const Params_p)
+{
+    const uint32_t Len = Params_p->ByteLen;
+
+    return CALSWLib_BigInt_Equals(&Domain_p->modulus, Params_p->p_p, Len) &&
+           CALSWLib_BigInt_Equals(&Domain_p->a, Params_p->a_p, Len) &&
+           CALSWLib_BigInt_Equals(&Domain_p->b, Params_p->b_p, Len) &&
+           CALSWLib_BigInt_Equals(&Domain_p->g_order, Params_p->n_p, Len) &&
+           CALSWLib_BigInt_Equals(&Domain_p->G.x_cord, Params_p->Gx_p, Len) &&
+           CALSWLib_BigInt_Equals(&Domain_p->G.y_cord, Params_p->Gy_p, Len);
+}
+
+
+/*----------------------------------------------------------------------------
+ * sfzcrypto_sw_ecdsa_verify
+ */
+SfzCryptoStatus
+sfzcrypto_sw_ecdsa_verify(
+        SfzCryptoAsymKey * const p_sigctx,
+        SfzCryptoSign * const p_signature,
+        uint8_t * p_hash_msg,
+        uint32_t hash_msglen)
+{
+    const SfzCryptoECPDomainParam * Domain_p;
+    const CALSW_CurveParams_t * Params_p = NULL;
+    const CALSW_Curve_t * Curve_p = NULL;
+    const CALSW_Mod_t * F_p;
+    CALSW_PointJ_t QTable[CALSW_ECC_VAR_POINTS];
+    CALSW_PointJ_t Q;
+    CALSW_PointJ_t R;
+    CALSW_BigNum_t r, s, e, u1, u2, t1, t2;
+    int8_t Naf1[CALSW_ECC_NAF_MAX];
+    int8_t Naf2[CALSW_ECC_NAF_MAX];
+    unsigned int Len1, Len2;
+    int i;
+
+    if (p_sigctx == NULL ||
+        p_signature == NULL ||
+        p_hash_msg == NULL)
+    {
+        return SFZCRYPTO_INVALID_PARAMETER;
+    }
+
+    if (hash_msglen == 0)
+        return SFZCRYPTO_INVALID_LENGTH;
+
+    switch (p_sigctx->algo_type)
+    {
+        case SFZCRYPTO_ALGO_ASYMM_ECDSA_WITH_SHA1:
+        case SFZCRYPTO_ALGO_ASYMM_ECDSA_WITH_SHA224:
+        case SFZCRYPTO_ALGO_ASYMM_ECDSA_WITH_SHA256:
+            break;
+
+        default:
+            return SFZCRYPTO_INVALID_ALGORITHM;
+    }
+
+    Domain_p = &p_sigctx->Key.ecPubKey.domainParam;
+
+#ifdef CALSW_ECDSA_CURVE_P256
+    if (Curve_p == NULL &&
+        CALSWLib_Curve_Matches(Domain_p, &CALSW_Curve_P256))
+    {
+        Params_p = &CALSW_Curve_P256;
+        Curve_p = CALSWLib_Curve_Get(Params_p, &CALSW_Curve_P256_p);
+        if (Curve_p == NULL)
+            return SFZCRYPTO_NO_MEMORY;
+    }
+#endif
+
+#ifdef CALSW_ECDSA_CURVE_P224
+    if (Curve_p == NULL &&
+        CALSWLib_Curve_Matches(Domain_p, &CALSW_Curve_P224))
+    {
+        Params_p = &CALSW_Curve_P224;
+        Curve_p = CALSWLib_Curve_Get(Params_p, &CALSW_Curve_P224_p);
+        if (Curve_p == NULL)
+            return SFZCRYPTO_NO_MEMORY;
+    }
+#endif
+
+    if (Curve_p == NULL)
+    {
+        LOG_INFO(
+            "sfzcrypto_sw_ecdsa_verify: "
+            "Unsupported curve\n");
+
+        return SFZCRYPTO_UNSUPPORTED;
+    }
+
+    F_p = &Curve_p->P;
+
+    // 0 < r, s < n
+    if (!CALSWLib_BigNum_FromBytes(
+                r,
+                p_signature->r.p_num,
+                p_signature->r.byteLen,
+                Params_p->ByteLen) ||
+        !CALSWLib_BigNum_FromBytes(
+                s,
+                p_signature->s.p_num,
+                p_signature->s.byteLen,
+                Params_p->ByteLen))
+    {
+        return SFZCRYPTO_INVALID_SIGNATURE;
+    }
+
+    if (CALSWLib_BigNum_IsZero(r) ||
+        CALSWLib_BigNum_IsZero(s) ||
+        CALSWLib_BigNum_Cmp(r, Curve_p->nPlain) >= 0 ||
+        CALSWLib_BigNum_Cmp(s, Curve_p->nPlain) >= 0)
+    {
+        return SFZCRYPTO_INVALID_SIGNATURE;
+    }
+
+    // public key: coordinates below p and on the curve
+    {
+        const SfzCryptoECCPoint * const Pub_p = &p_sigctx->Key.ecPubKey.Q;
+
+        if (!CALSWLib_BigNum_FromBytes(
+                    t1,
+                    Pub_p->x_cord.p_num,
+                    Pub_p->x_cord.byteLen,
+                    Params_p->ByteLen) ||
+            !CALSWLib_BigNum_FromBytes(
+                    t2,
+                    Pub_p->y_cord.p_num,
+                    Pub_p->y_cord.byteLen,
+                    Params_p->ByteLen) ||
+            CALSWLib_BigNum_Cmp(t1, F_p->m) >= 0 ||
+            CALSWLib_BigNum_Cmp(t2, F_p->m) >= 0)
+        {
+            return SFZCRYPTO_INVALID_PARAMETER;
+        }
+
+        CALSWLib_Mod_Mul(Q.X, t1, F_p->R2, F_p);
+        CALSWLib_Mod_Mul(Q.Y, t2, F_p->R2, F_p);
+        c_memcpy(Q.Z, F_p->One, sizeof(Q.Z));
+
+        // y^2 == x^3 - 3x + b
+        CALSWLib_Mod_Mul(t1, Q.X, Q.X, F_p);
+        CALSWLib_Mod_Mul(t1, t1, Q.X, F_p);
+        CALSWLib_Mod_Sub(t1, t1, Q.X, F_p);
+        CALSWLib_Mod_Sub(t1, t1, Q.X, F_p);
+        CALSWLib_Mod_Sub(t1, t1, Q.X, F_p);
+        CALSWLib_Mod_Add(t1, t1, Curve_p->bM, F_p);
+        CALSWLib_Mod_Mul(t2, Q.Y, Q.Y, F_p);
+
+        if (CALSWLib_BigNum_Cmp(t1, t2) != 0)
+        {
+            LOG_INFO(
+                "sfzcrypto_sw_ecdsa_verify: "
+                "Public key not on curve\n");
+
+            return SFZCRYPTO_INVALID_PARAMETER;
+        }
+    }
+
+    // e = leftmost bits of the digest (the order has ByteLen * 8 bits)
+    CALSWLib_BigNum_FromBytes(
+            e,
+            p_hash_msg,
+            MIN(hash_msglen, Params_p->ByteLen),
+            Params_p->ByteLen);
+
+    if (CALSWLib_BigNum_Cmp(e, Curve_p->nPlain) >= 0)
+        CALSWLib_BigNum_Sub(e, e, Curve_p->nPlain);
+
+    // w = s^-1 mod n (Montgomery domain), u1 = e * w, u2 = r * w
+    CALSWLib_Mod_Mul(t1, s, Curve_p->N.R2, &Curve_p->N);
+    CALSWLib_Mod_Inv(t1, t1, &Curve_p->N);
+    CALSWLib_Mod_Mul(u1, e, t1, &Curve_p->N);
+    CALSWLib_Mod_Mul(u2, r, t1, &Curve_p->N);
+
+    // R = u1 * G + u2 * Q
+    CALSWLib_Point_OddMultiples(QTable, &Q, CALSW_ECC_VAR_POINTS, F_p);
+
+    Len1 = CALSWLib_Scalar_ToNaf(Naf1, u1, CALSW_ECDSA_FIXED_WINDOW);
+    Len2 = CALSWLib_Scalar_ToNaf(Naf2, u2, CALSW_ECDSA_VAR_WINDOW);
+
+    c_memset(&R, 0, sizeof(R));
+
+    for (i = (int)MAX(Len1, Len2) - 1; i >= 0; i--)
+    {
+        CALSWLib_Point_Double(&R, F_p);
+
+        if (i < (int)Len1 && Naf1[i] != 0)
+        {
+            const int d = Naf1[i];
+
+            CALSWLib_Point_AddAffine(
+                    &R,
+                    &Curve_p->GTable[(d > 0 ? d : -d) >> 1],
+                    (d < 0),
+                    F_p);
+        }
+
+        if (i < (int)Len2 && Naf2[i] != 0)
+        {
+            const int d = Naf2[i];
+
+            CALSWLib_Point_Add(
+                    &R,
+                    &QTable[(d > 0 ? d : -d) >> 1],
+                    (d < 0),
+                    F_p);
+        }
+    }
+
+    if (CALSWLib_BigNum_IsZero(R.Z))
+        return SFZCRYPTO_SIGNATURE_CHECK_FAILED;
+
+    // x(R) mod n == r  <=>  X == r * Z^2 or X == (r + n) * Z^2 (mod p)
+    CALSWLib_Mod_Mul(t2, R.Z, R.Z, F_p);
+
+    CALSWLib_Mod_Mul(t1, r, F_p->R2, F_p);
+    CALSWLib_Mod_Mul(t1, t1, t2, F_p);
+    if (CALSWLib_BigNum_Cmp(t1, R.X) == 0)
+        return SFZCRYPTO_SUCCESS;
+
+    if (CALSWLib_BigNum_Add(r, r, Curve_p->nPlain) == 0 &&
+        CALSWLib_BigNum_Cmp(r, F_p->m) < 0)
+    {
+        CALSWLib_Mod_Mul(t1, r, F_p->R2, F_p);
+        CALSWLib_Mod_Mul(t1, t1, t2, F_p);
+        if (CALSWLib_BigNum_Cmp(t1, R.X) == 0)
+            return SFZCRYPTO_SUCCESS;
+    }
+
+    return SFZCRYPTO_SIGNATURE_CHECK_FAILED;
+}
+
+#else
+extern const int _avoid_empty_translation_unit;
+#endif /* SFZCRYPTO_CF_ECDSA_VERIFY__SW */
+
+/* end of file cal_sw_ecdsa.c */
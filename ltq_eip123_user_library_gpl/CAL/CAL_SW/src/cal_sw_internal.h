@@ -0,0 +1,47 @@
+/* cal_sw_internal.h
+ *
+ * CAL_SW module internal interfaces and definitions.
+ */
+
+/*****************************************************************************
+* Copyright (c) 2007-2015 INSIDE Secure B.V. All Rights Reserved.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 2 of the License, or
+* any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef INCLUDE_GUARD_CAL_SW_INTERNAL_H
+#define INCLUDE_GUARD_CAL_SW_INTERNAL_H
+
+#include "basic_defs.h"
+
+/*
+ * Big numbers are kept as little-endian arrays of limbs. Where the
+ * compiler offers a 128-bit type 64-bit limbs are used, otherwise 32-bit
+ * limbs. CALSW_DLimb_t holds the product of two limbs.
+ */
+#ifdef __SIZEOF_INT128__
+typedef uint64_t CALSW_Limb_t;
+__extension__ typedef unsigned __int128 CALSW_DLimb_t;
+#define CALSW_LIMB_BITS  64
+#else
+typedef uint32_t CALSW_Limb_t;
+typedef uint64_t CALSW_DLimb_t;
+#define CALSW_LIMB_BITS  32
+#endif
+
+#define CALSW_LIMB_BYTES  (CALSW_LIMB_BITS / 8)
+
+#endif /* INCLUDE_GUARD_CAL_SW_INTERNAL_H */
+
+/* end of file cal_sw_internal.h */
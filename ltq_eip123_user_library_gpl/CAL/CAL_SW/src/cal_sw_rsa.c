@@ -0,0 +1,2160 @@
+/* cal_sw_rsa.c
+ *
+ * Implementation of the CAL API in software.
+ *
+ * This file implements RSA encrypt, decrypt, sign and verify with the
+ * PKCS #1 v1.5 and PSS padding schemes.
+ */
+
+/*****************************************************************************
+* Copyright (c) 2007-2015 INSIDE Secure B.V. All Rights Reserved.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 2 of the License, or
+* any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "c_cal_sw.h"
+
+#if defined(SFZCRYPTO_CF_RSA_ENCRYPT__SW) || \
+    defined(SFZCRYPTO_CF_RSA_DECRYPT__SW) || \
+    defined(SFZCRYPTO_CF_RSA_SIGN__SW) || \
+    defined(SFZCRYPTO_CF_RSA_VERIFY__SW)
+
+#include "basic_defs.h"
+#include "clib.h"
+#include "log.h"
+
+#include "cal_sw.h"                 // the API to implement
+#include "cal_sw_internal.h"
+
+#include "cal_cm.h"                 // sfzcrypto_cm_hash_data, _rand_data
+
+#include "spal_memory.h"
+
+/*
+ * Implementation notes
+ *
+ * Numbers are kept as little-endian arrays of limbs (see
+ * cal_sw_internal.h), wide enough for SFZCRYPTO_RSA_MAX_BITS. Each
+ * modulus has its own limb count, so the work per multiplication follows
+ * the key size.
+ *
+ * Modular exponentiation uses Montgomery multiplication (CIOS) and a
+ * left-to-right sliding window over the exponent. The window width grows
+ * with the exponent size (up to CALSW_RSA_WINDOW_MAX); short exponents
+ * such as e = 65537 use plain square-and-multiply without a table, so a
+ * verify costs 16 squarings and one multiplication.
+ *
+ * Private key operations use the CRT (Garner's recombination with
+ * cofQinv) when all CRT parameters are available, otherwise the private
+ * exponent. With CALSW_RSA_CRT_CHECK the CRT result is checked with the
+ * public exponent before it is returned.
+ *
+ * The hash computations of PSS and MGF1 and the random bytes for padding
+ * and salt are obtained from the CM.
+ *
+ * PKCS #1 v1.5 decryption checks the padding without data dependent
+ * branches and does not report invalid padding: a message derived from the
+ * private key and the ciphertext is returned instead (implicit rejection,
+ * as OpenSSL), so the result cannot be used as a padding oracle.
+ *
+ * The exponentiation is not constant-time.
+ */
+
+#if defined(SFZCRYPTO_CF_RSA_DECRYPT__SW) || \
+    defined(SFZCRYPTO_CF_RSA_SIGN__SW)
+#define CALSW_RSA_PRIVATE
+#endif
+
+#if defined(SFZCRYPTO_CF_RSA_ENCRYPT__SW) || \
+    defined(SFZCRYPTO_CF_RSA_VERIFY__SW) || \
+    (defined(CALSW_RSA_PRIVATE) && defined(CALSW_RSA_CRT_CHECK))
+#define CALSW_RSA_PUBLIC
+#endif
+
+#if defined(SFZCRYPTO_CF_RSA_SIGN__SW) || \
+    defined(SFZCRYPTO_CF_RSA_VERIFY__SW)
+#define CALSW_RSA_SIGNATURE
+#endif
+
+#if defined(CALSW_RSA_SIGNATURE) || \
+    defined(SFZCRYPTO_CF_RSA_DECRYPT__SW)
+#define CALSW_RSA_HASH
+#endif
+
+#define CALSW_RSA_LIMBS       (SFZCRYPTO_RSA_MAX_BITS / CALSW_LIMB_BITS)
+#define CALSW_RSA_TABLE_SIZE  (1 << (CALSW_RSA_WINDOW_MAX - 1))
+
+// largest digest used by the signature schemes (SHA-256)
+#define CALSW_RSA_DIGEST_MAX  32
+
+// PSS: M' = (0x)00 00 00 00 00 00 00 00 || mHash || salt
+#define CALSW_RSA_PSS_PADDING_LEN  8
+
+// PKCS #1 v1.5 padding overhead: 00 || 01/02 || PS (8 or more) || 00
+#define CALSW_RSA_PKCS1_OVERHEAD  11
+
+// implicit rejection: HMAC-SHA256 block size and the number of 16-bit
+// candidates for the length of the synthetic message
+#define CALSW_RSA_HMAC_BLOCK_LEN  64
+#define CALSW_RSA_IR_LENGTHS      128
+
+// modulus with its Montgomery constants
+typedef struct
+{
+    CALSW_Limb_t m[CALSW_RSA_LIMBS];
+    CALSW_Limb_t One[CALSW_RSA_LIMBS];      // R mod m
+    CALSW_Limb_t R2[CALSW_RSA_LIMBS];       // R^2 mod m
+    CALSW_Limb_t m0inv;                     // -m^-1 mod 2^CALSW_LIMB_BITS
+    unsigned int Limbs;                     // R = 2^(Limbs * CALSW_LIMB_BITS)
+} CALSW_RsaMod_t;
+
+// state of one RSA operation, allocated per call (too large for the stack)
+typedef struct
+{
+    CALSW_RsaMod_t N;
+    CALSW_RsaMod_t P;                       // CRT only
+    CALSW_RsaMod_t Q;                       // CRT only
+    uint32_t ModBits;
+    uint32_t ModBytes;                      // k
+
+    CALSW_Limb_t a[CALSW_RSA_LIMBS];        // input
+    CALSW_Limb_t r[CALSW_RSA_LIMBS];        // result
+    CALSW_Limb_t x[CALSW_RSA_LIMBS];
+    CALSW_Limb_t y[CALSW_RSA_LIMBS];
+    CALSW_Limb_t z[CALSW_RSA_LIMBS];
+    CALSW_Limb_t t[2 * CALSW_RSA_LIMBS];
+    CALSW_Limb_t Table[CALSW_RSA_TABLE_SIZE][CALSW_RSA_LIMBS];
+
+    uint8_t EM[SFZCRYPTO_RSA_BYTES];        // encoded message
+    uint8_t Buf[CALSW_RSA_PSS_PADDING_LEN + 2 * CALSW_RSA_DIGEST_MAX +
+                SFZCRYPTO_RSA_BYTES];
+
+#ifdef SFZCRYPTO_CF_RSA_DECRYPT__SW
+    // PKCS #1 v1.5 implicit rejection
+    uint8_t Kdk[CALSW_RSA_DIGEST_MAX];
+    uint8_t Synthetic[SFZCRYPTO_RSA_BYTES];
+    uint8_t Lengths[2 * CALSW_RSA_IR_LENGTHS];
+#endif
+} CALSW_RsaWork_t;
+
+#ifdef CALSW_RSA_HASH
+// hash algorithm with the DER encoded DigestInfo prefix for PKCS #1 v1.5
+typedef struct
+{
+    SfzCryptoHashAlgo HashAlgo;
+    uint32_t DigestLen;
+    const uint8_t * DigestInfo_p;
+    uint32_t DigestInfoLen;
+} CALSW_RsaHash_t;
+#endif
+
+#ifdef CALSW_RSA_SIGNATURE
+static const CALSW_RsaHash_t CALSW_RsaHash_MD5 =
+{
+    SFZCRYPTO_ALGO_HASH_MD5,
+    16,
+    (const uint8_t *)
+    "\x30\x20\x30\x0C\x06\x08\x2A\x86\x48\x86\xF7\x0D\x02\x05\x05\x00"
+    "\x04\x10",
+    18
+};
+
+static const CALSW_RsaHash_t CALSW_RsaHash_SHA1 =
+{
+    SFZCRYPTO_ALGO_HASH_SHA160,
+    20,
+    (const uint8_t *)
+    "\x30\x21\x30\x09\x06\x05\x2B\x0E\x03\x02\x1A\x05\x00\x04\x14",
+    15
+};
+
+static const CALSW_RsaHash_t CALSW_RsaHash_SHA224 =
+{
+    SFZCRYPTO_ALGO_HASH_SHA224,
+    28,
+    (const uint8_t *)
+    "\x30\x2D\x30\x0D\x06\x09\x60\x86\x48\x01\x65\x03\x04\x02\x04\x05"
+    "\x00\x04\x1C",
+    19
+};
+#endif /* CALSW_RSA_SIGNATURE */
+
+#ifdef CALSW_RSA_HASH
+static const CALSW_RsaHash_t CALSW_RsaHash_SHA256 =
+{
+    SFZCRYPTO_ALGO_HASH_SHA256,
+    32,
+    (const uint8_t *)
+    "\x30\x31\x30\x0D\x06\x09\x60\x86\x48\x01\x65\x03\x04\x02\x01\x05"
+    "\x00\x04\x20",
+    19
+};
+#endif /* CALSW_RSA_HASH */
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Num_FromBytes
+ *
+ * Converts a big-endian octet string to a number of Limbs limbs. Leading
+ * zero bytes are allowed. Returns false when the value does not fit.
+ */
+static bool
+CALSWLib_Num_FromBytes(
+        CALSW_Limb_t * r,
+        const unsigned int Limbs,
+        const uint8_t * Data_p,
+        uint32_t DataLen)
+{
+    unsigned int i;
+
+    if (Data_p == NULL)
+        return false;
+
+    while (DataLen > 0 && *Data_p == 0)
+    {
+        Data_p++;
+        DataLen--;
+    }
+
+    if (DataLen > Limbs * CALSW_LIMB_BYTES)
+        return false;
+
+    c_memset(r, 0, Limbs * sizeof(CALSW_Limb_t));
+
+    for (i = 0; i < DataLen; i++)
+    {
+        const unsigned int ByteNr = DataLen - 1 - i;
+
+        r[ByteNr / CALSW_LIMB_BYTES] |=
+            (CALSW_Limb_t)Data_p[i] << (8 * (ByteNr % CALSW_LIMB_BYTES));
+    }
+
+    return true;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Num_ToBytes
+ *
+ * Writes a number as a big-endian octet string of exactly DataLen bytes.
+ */
+static void
+CALSWLib_Num_ToBytes(
+        uint8_t * Data_p,
+        const uint32_t DataLen,
+        const CALSW_Limb_t * a,
+        const unsigned int Limbs)
+{
+    unsigned int i;
+
+    for (i = 0; i < DataLen; i++)
+    {
+        const unsigned int ByteNr = DataLen - 1 - i;
+
+        if (ByteNr / CALSW_LIMB_BYTES < Limbs)
+        {
+            Data_p[i] = (uint8_t)(a[ByteNr / CALSW_LIMB_BYTES] >>
+                                  (8 * (ByteNr % CALSW_LIMB_BYTES)));
+        }
+        else
+        {
+            Data_p[i] = 0;
+        }
+    }
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Num_Bits
+ */
+static unsigned int
+CALSWLib_Num_Bits(
+        const CALSW_Limb_t * a,
+        const unsigned int Limbs)
+{
+    int i;
+
+    for (i = (int)Limbs - 1; i >= 0; i--)
+    {
+        if (a[i] != 0)
+        {
+            CALSW_Limb_t v = a[i];
+            unsigned int Bits = i * CALSW_LIMB_BITS;
+
+            while (v != 0)
+            {
+                Bits++;
+                v >>= 1;
+            }
+
+            return Bits;
+        }
+    }
+
+    return 0;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Num_Cmp
+ */
+static int
+CALSWLib_Num_Cmp(
+        const CALSW_Limb_t * a,
+        const CALSW_Limb_t * b,
+        const unsigned int Limbs)
+{
+    int i;
+
+    for (i = (int)Limbs - 1; i >= 0; i--)
+    {
+        if (a[i] != b[i])
+            return (a[i] > b[i]) ? 1 : -1;
+    }
+
+    return 0;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Num_Add
+ *
+ * r = a + b, returns the carry.
+ */
+static CALSW_Limb_t
+CALSWLib_Num_Add(
+        CALSW_Limb_t * r,
+        const CALSW_Limb_t * a,
+        const CALSW_Limb_t * b,
+        const unsigned int Limbs)
+{
+    CALSW_DLimb_t Acc = 0;
+    unsigned int i;
+
+    for (i = 0; i < Limbs; i++)
+    {
+        Acc += (CALSW_DLimb_t)a[i] + b[i];
+        r[i] = (CALSW_Limb_t)Acc;
+        Acc >>= CALSW_LIMB_BITS;
+    }
+
+    return (CALSW_Limb_t)Acc;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Num_Sub
+ *
+ * r = a - b, returns the borrow.
+ */
+static CALSW_Limb_t
+CALSWLib_Num_Sub(
+        CALSW_Limb_t * r,
+        const CALSW_Limb_t * a,
+        const CALSW_Limb_t * b,
+        const unsigned int Limbs)
+{
+    CALSW_Limb_t Borrow = 0;
+    unsigned int i;
+
+    for (i = 0; i < Limbs; i++)
+    {
+        const CALSW_Limb_t ai = a[i];
+        const CALSW_Limb_t d = ai - b[i];
+
+        r[i] = d - Borrow;
+        Borrow = (ai < b[i]) | (d < Borrow);
+    }
+
+    return Borrow;
+}
+
+
+#ifdef CALSW_RSA_PRIVATE
+/*----------------------------------------------------------------------------
+ * CALSWLib_Num_Mul
+ *
+ * r = a * b, with r of 2 * Limbs limbs (not overlapping a or b).
+ */
+static void
+CALSWLib_Num_Mul(
+        CALSW_Limb_t * r,
+        const CALSW_Limb_t * a,
+        const CALSW_Limb_t * b,
+        const unsigned int Limbs)
+{
+    unsigned int i, j;
+
+    c_memset(r, 0, 2 * Limbs * sizeof(CALSW_Limb_t));
+
+    for (i = 0; i < Limbs; i++)
+    {
+        CALSW_DLimb_t Acc = 0;
+
+        for (j = 0; j < Limbs; j++)
+        {
+            Acc += (CALSW_DLimb_t)a[j] * b[i] + r[i + j];
+            r[i + j] = (CALSW_Limb_t)Acc;
+            Acc >>= CALSW_LIMB_BITS;
+        }
+
+        r[i + Limbs] = (CALSW_Limb_t)Acc;
+    }
+}
+#endif /* CALSW_RSA_PRIVATE */
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Mod_Add
+ *
+ * r = a + b mod m, for a, b < m.
+ */
+static void
+CALSWLib_Mod_Add(
+        CALSW_Limb_t * r,
+        const CALSW_Limb_t * a,
+        const CALSW_Limb_t * b,
+        const CALSW_RsaMod_t * const M_p)
+{
+    if (CALSWLib_Num_Add(r, a, b, M_p->Limbs) ||
+        CALSWLib_Num_Cmp(r, M_p->m, M_p->Limbs) >= 0)
+    {
+        CALSWLib_Num_Sub(r, r, M_p->m, M_p->Limbs);
+    }
+}
+
+
+#ifdef CALSW_RSA_PRIVATE
+/*----------------------------------------------------------------------------
+ * CALSWLib_Mod_Sub
+ *
+ * r = a - b mod m, for a, b < m.
+ */
+static void
+CALSWLib_Mod_Sub(
+        CALSW_Limb_t * r,
+        const CALSW_Limb_t * a,
+        const CALSW_Limb_t * b,
+        const CALSW_RsaMod_t * const M_p)
+{
+    if (CALSWLib_Num_Sub(r, a, b, M_p->Limbs))
+        CALSWLib_Num_Add(r, r, M_p->m, M_p->Limbs);
+}
+#endif /* CALSW_RSA_PRIVATE */
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Mod_Mul
+ *
+ * Montgomery multiplication: r = a * b / R mod m, for a * b < m * R.
+ * r may overlap with a or b.
+ */
+static void
+CALSWLib_Mod_Mul(
+        CALSW_Limb_t * r,
+        const CALSW_Limb_t * a,
+        const CALSW_Limb_t * b,
+        const CALSW_RsaMod_t * const M_p)
+{
+    const unsigned int n = M_p->Limbs;
+    CALSW_Limb_t t[CALSW_RSA_LIMBS + 2];
+    unsigned int i, j;
+
+    c_memset(t, 0, (n + 2) * sizeof(CALSW_Limb_t));
+
+    for (i = 0; i < n; i++)
+    {
+        CALSW_DLimb_t Acc = 0;
+        CALSW_Limb_t q;
+
+        // t += a * b[i]
+        for (j = 0; j < n; j++)
+        {
+            Acc += (CALSW_DLimb_t)a[j] * b[i] + t[j];
+            t[j] = (CALSW_Limb_t)Acc;
+            Acc >>= CALSW_LIMB_BITS;
+        }
+
+        Acc += t[n];
+        t[n] = (CALSW_Limb_t)Acc;
+        t[n + 1] = (CALSW_Limb_t)(Acc >> CALSW_LIMB_BITS);
+
+        // t = (t + q * m) / 2^CALSW_LIMB_BITS
+        q = t[0] * M_p->m0inv;
+
+        Acc = (CALSW_DLimb_t)q * M_p->m[0] + t[0];
+        Acc >>= CALSW_LIMB_BITS;
+
+        for (j = 1; j < n; j++)
+        {
+            Acc += (CALSW_DLimb_t)q * M_p->m[j] + t[j];
+            t[j - 1] = (CALSW_Limb_t)Acc;
+            Acc >>= CALSW_LIMB_BITS;
+        }
+
+        Acc += t[n];
+        t[n - 1] = (CALSW_Limb_t)Acc;
+        t[n] = t[n + 1] + (CALSW_Limb_t)(Acc >> CALSW_LIMB_BITS);
+    }
+
+    // t < 2m
+    if (t[n] != 0 || CALSWLib_Num_Cmp(t, M_p->m, n) >= 0)
+        CALSWLib_Num_Sub(r, t, M_p->m, n);
+    else
+        c_memcpy(r, t, n * sizeof(CALSW_Limb_t));
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Mod_Reduce
+ *
+ * Montgomery reduction: r = t / R mod m, for t (2 * Limbs limbs) < m * R.
+ * t is destroyed.
+ */
+static void
+CALSWLib_Mod_Reduce(
+        CALSW_Limb_t * r,
+        CALSW_Limb_t * t,
+        const CALSW_RsaMod_t * const M_p)
+{
+    const unsigned int n = M_p->Limbs;
+    CALSW_Limb_t Carry = 0;
+    unsigned int i, j;
+
+    for (i = 0; i < n; i++)
+    {
+        const CALSW_Limb_t q = t[i] * M_p->m0inv;
+        CALSW_DLimb_t Acc = 0;
+
+        // t += q * m * 2^(i * CALSW_LIMB_BITS), clears t[i]
+        for (j = 0; j < n; j++)
+        {
+            Acc += (CALSW_DLimb_t)q * M_p->m[j] + t[i + j];
+            t[i + j] = (CALSW_Limb_t)Acc;
+            Acc >>= CALSW_LIMB_BITS;
+        }
+
+        Acc += (CALSW_DLimb_t)t[i + n] + Carry;
+        t[i + n] = (CALSW_Limb_t)Acc;
+        Carry = (CALSW_Limb_t)(Acc >> CALSW_LIMB_BITS);
+    }
+
+    // t / R < 2m
+    if (Carry != 0 || CALSWLib_Num_Cmp(t + n, M_p->m, n) >= 0)
+        CALSWLib_Num_Sub(r, t + n, M_p->m, n);
+    else
+        c_memcpy(r, t + n, n * sizeof(CALSW_Limb_t));
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Mod_FromMont
+ *
+ * r = a / R mod m, converts out of the Montgomery domain.
+ */
+static void
+CALSWLib_Mod_FromMont(
+        CALSW_Limb_t * r,
+        const CALSW_Limb_t * a,
+        const CALSW_RsaMod_t * const M_p)
+{
+    CALSW_Limb_t t[2 * CALSW_RSA_LIMBS];
+
+    c_memset(t, 0, 2 * M_p->Limbs * sizeof(CALSW_Limb_t));
+    c_memcpy(t, a, M_p->Limbs * sizeof(CALSW_Limb_t));
+
+    CALSWLib_Mod_Reduce(r, t, M_p);
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Mod_Setup
+ *
+ * Prepares the Montgomery constants for the modulus in M_p->m, using
+ * Limbs limbs. Returns false when the modulus is even or below 3.
+ */
+static bool
+CALSWLib_Mod_Setup(
+        CALSW_RsaMod_t * const M_p,
+        const unsigned int Limbs)
+{
+    const unsigned int RBits = Limbs * CALSW_LIMB_BITS;
+    unsigned int Bits;
+    CALSW_Limb_t Inv;
+    unsigned int i;
+    int Bit;
+
+    M_p->Limbs = Limbs;
+
+    Bits = CALSWLib_Num_Bits(M_p->m, Limbs);
+    if (Bits < 2 || (M_p->m[0] & 1) == 0)
+        return false;
+
+    // m^-1 mod 2^CALSW_LIMB_BITS by Newton iteration
+    // each step doubles the number of correct bits (starting with 3)
+    Inv = M_p->m[0];
+    for (i = 0; i < 5; i++)
+        Inv *= 2 - M_p->m[0] * Inv;
+
+    M_p->m0inv = (CALSW_Limb_t)0 - Inv;
+
+    // R mod m: start from 2^(Bits - 1) < m and double up to 2^RBits
+    c_memset(M_p->One, 0, Limbs * sizeof(CALSW_Limb_t));
+    M_p->One[(Bits - 1) / CALSW_LIMB_BITS] =
+        (CALSW_Limb_t)1 << ((Bits - 1) % CALSW_LIMB_BITS);
+
+    for (i = Bits - 1; i < RBits; i++)
+        CALSWLib_Mod_Add(M_p->One, M_p->One, M_p->One, M_p);
+
+    // R^2 mod m = 2^RBits in the Montgomery domain, by square-and-double
+    // over the bits of RBits (a handful of multiplications)
+    c_memcpy(M_p->R2, M_p->One, Limbs * sizeof(CALSW_Limb_t));
+
+    for (Bit = 31; Bit >= 0 && ((RBits >> Bit) & 1) == 0; Bit--)
+        ;
+
+    for (; Bit >= 0; Bit--)
+    {
+        CALSWLib_Mod_Mul(M_p->R2, M_p->R2, M_p->R2, M_p);
+
+        if ((RBits >> Bit) & 1)
+            CALSWLib_Mod_Add(M_p->R2, M_p->R2, M_p->R2, M_p);
+    }
+
+    return true;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Exp_Bit
+ */
+static inline unsigned int
+CALSWLib_Exp_Bit(
+        const uint8_t * Exp_p,
+        const uint32_t ExpLen,
+        const unsigned int Bit)
+{
+    return (Exp_p[ExpLen - 1 - Bit / 8] >> (Bit % 8)) & 1;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Exp_Window
+ *
+ * Sliding window width for an exponent of Bits bits, chosen to minimize
+ * the table setup plus the multiplications in the main loop.
+ */
+static unsigned int
+CALSWLib_Exp_Window(
+        const unsigned int Bits)
+{
+    unsigned int Window;
+
+    if (Bits <= 24)
+        Window = 1;         // short public exponents such as 65537
+    else if (Bits <= 80)
+        Window = 3;
+    else if (Bits <= 240)
+        Window = 4;
+    else if (Bits <= 672)
+        Window = 5;
+    else if (Bits <= 1792)
+        Window = 6;
+    else
+        Window = 7;
+
+    return MIN(Window, CALSW_RSA_WINDOW_MAX);
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Mod_Exp
+ *
+ * r = a ^ e mod m, with a and r in the Montgomery domain and e a
+ * big-endian octet string. Table_p provides room for the odd powers.
+ */
+static void
+CALSWLib_Mod_Exp(
+        CALSW_Limb_t * r,
+        const CALSW_Limb_t * a,
+        const uint8_t * Exp_p,
+        uint32_t ExpLen,
+        const CALSW_RsaMod_t * const M_p,
+        CALSW_Limb_t (* Table_p)[CALSW_RSA_LIMBS])
+{
+    const size_t Size = M_p->Limbs * sizeof(CALSW_Limb_t);
+    unsigned int Bits, Window, i;
+    bool fFirst = true;
+    int Bit;
+
+    while (ExpLen > 0 && *Exp_p == 0)
+    {
+        Exp_p++;
+        ExpLen--;
+    }
+
+    Bits = ExpLen * 8;
+    while (Bits > 0 && CALSWLib_Exp_Bit(Exp_p, ExpLen, Bits - 1) == 0)
+        Bits--;
+
+    if (Bits == 0)
+    {
+        c_memcpy(r, M_p->One, Size);
+        return;
+    }
+
+    Window = CALSWLib_Exp_Window(Bits);
+
+    // a, a^3, a^5, ... a^(2^Window - 1)
+    c_memcpy(Table_p[0], a, Size);
+
+    if (Window > 1)
+    {
+        CALSWLib_Mod_Mul(r, a, a, M_p);
+
+        for (i = 1; i < (1U << (Window - 1)); i++)
+            CALSWLib_Mod_Mul(Table_p[i], Table_p[i - 1], r, M_p);
+    }
+
+    Bit = (int)Bits - 1;
+    while (Bit >= 0)
+    {
+        unsigned int Value = 0;
+        int Low, j;
+
+        if (CALSWLib_Exp_Bit(Exp_p, ExpLen, Bit) == 0)
+        {
+            CALSWLib_Mod_Mul(r, r, r, M_p);
+            Bit--;
+            continue;
+        }
+
+        // longest window [Bit..Low] that ends with a one bit
+        Low = MAX(Bit - (int)Window + 1, 0);
+        while (CALSWLib_Exp_Bit(Exp_p, ExpLen, Low) == 0)
+            Low++;
+
+        for (j = Bit; j >= Low; j--)
+            Value = (Value << 1) | CALSWLib_Exp_Bit(Exp_p, ExpLen, j);
+
+        if (fFirst)
+        {
+            // the top bit is always one, so this is the first window
+            c_memcpy(r, Table_p[Value >> 1], Size);
+            fFirst = false;
+        }
+        else
+        {
+            for (j = Low; j <= Bit; j++)
+                CALSWLib_Mod_Mul(r, r, r, M_p);
+
+            CALSWLib_Mod_Mul(r, r, Table_p[Value >> 1], M_p);
+        }
+
+        Bit = Low - 1;
+    }
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Rsa_SetModulus
+ *
+ * Completes W_p->N from the value in W_p->N.m (CALSW_RSA_LIMBS limbs).
+ */
+static SfzCryptoStatus
+CALSWLib_Rsa_SetModulus(
+        CALSW_RsaWork_t * const W_p)
+{
+    const unsigned int Bits = CALSWLib_Num_Bits(W_p->N.m, CALSW_RSA_LIMBS);
+
+    if (Bits < SFZCRYPTO_RSA_MIN_BITS || Bits > SFZCRYPTO_RSA_MAX_BITS)
+        return SFZCRYPTO_INVALID_KEYSIZE;
+
+    W_p->ModBits = Bits;
+    W_p->ModBytes = (Bits + 7) / 8;
+
+    if (!CALSWLib_Mod_Setup(
+                &W_p->N,
+                (Bits + CALSW_LIMB_BITS - 1) / CALSW_LIMB_BITS))
+    {
+        return SFZCRYPTO_INVALID_PARAMETER;
+    }
+
+    return SFZCRYPTO_SUCCESS;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Rsa_LoadPublic
+ */
+static SfzCryptoStatus
+CALSWLib_Rsa_LoadPublic(
+        CALSW_RsaWork_t * const W_p,
+        const SfzCryptoBigInt * const Modulus_p)
+{
+    if (!CALSWLib_Num_FromBytes(
+                W_p->N.m,
+                CALSW_RSA_LIMBS,
+                Modulus_p->p_num,
+                Modulus_p->byteLen))
+    {
+        return (Modulus_p->p_num == NULL) ?
+                    SFZCRYPTO_INVALID_PARAMETER :
+                    SFZCRYPTO_INVALID_KEYSIZE;
+    }
+
+    return CALSWLib_Rsa_SetModulus(W_p);
+}
+
+
+#ifdef CALSW_RSA_PUBLIC
+/*----------------------------------------------------------------------------
+ * CALSWLib_Rsa_Public
+ *
+ * Out = In ^ e mod n, for In < n. Out may be In.
+ */
+static SfzCryptoStatus
+CALSWLib_Rsa_Public(
+        CALSW_RsaWork_t * const W_p,
+        const SfzCryptoBigInt * const PubExp_p,
+        const CALSW_Limb_t * In,
+        CALSW_Limb_t * Out)
+{
+    const CALSW_RsaMod_t * const N_p = &W_p->N;
+
+    if (PubExp_p->p_num == NULL || PubExp_p->byteLen == 0)
+        return SFZCRYPTO_INVALID_PARAMETER;
+
+    CALSWLib_Mod_Mul(W_p->x, In, N_p->R2, N_p);
+
+    CALSWLib_Mod_Exp(
+            W_p->y,
+            W_p->x,
+            PubExp_p->p_num,
+            PubExp_p->byteLen,
+            N_p,
+            W_p->Table);
+
+    CALSWLib_Mod_FromMont(Out, W_p->y, N_p);
+
+    return SFZCRYPTO_SUCCESS;
+}
+#endif /* CALSW_RSA_PUBLIC */
+
+
+#ifdef CALSW_RSA_PRIVATE
+/*----------------------------------------------------------------------------
+ * CALSWLib_Rsa_LoadPrivate
+ *
+ * Selects the CRT when all CRT parameters are available. For the CRT the
+ * modulus is computed as p * q.
+ */
+static SfzCryptoStatus
+CALSWLib_Rsa_LoadPrivate(
+        CALSW_RsaWork_t * const W_p,
+        const SfzCryptoAsymKey * const Key_p,
+        bool * const fCrt_p)
+{
+    const SfzCryptoBigInt * const P_p = &Key_p->Key.rsaPrivKey.primeP;
+    const SfzCryptoBigInt * const Q_p = &Key_p->Key.rsaPrivKey.primeQ;
+    unsigned int Limbs;
+
+    *fCrt_p = (P_p->p_num != NULL &&
+               Q_p->p_num != NULL &&
+               Key_p->Key.rsaPrivKey.dmodP.p_num != NULL &&
+               Key_p->Key.rsaPrivKey.dmodQ.p_num != NULL &&
+               Key_p->Key.rsaPrivKey.cofQinv.p_num != NULL);
+
+    if (!*fCrt_p)
+    {
+        if (Key_p->Key.rsaPrivKey.privexp.p_num == NULL)
+            return SFZCRYPTO_INVALID_PARAMETER;
+
+        return CALSWLib_Rsa_LoadPublic(W_p, &Key_p->Key.rsaPrivKey.modulus);
+    }
+
+    // both primes use the limb count of the larger one
+    Limbs = CALSW_RSA_LIMBS / 2;
+
+    if (!CALSWLib_Num_FromBytes(W_p->P.m, Limbs, P_p->p_num, P_p->byteLen) ||
+        !CALSWLib_Num_FromBytes(W_p->Q.m, Limbs, Q_p->p_num, Q_p->byteLen))
+    {
+        return SFZCRYPTO_INVALID_KEYSIZE;
+    }
+
+    Limbs = MAX(CALSWLib_Num_Bits(W_p->P.m, Limbs),
+                CALSWLib_Num_Bits(W_p->Q.m, Limbs));
+    Limbs = (Limbs + CALSW_LIMB_BITS - 1) / CALSW_LIMB_BITS;
+
+    if (!CALSWLib_Mod_Setup(&W_p->P, Limbs) ||
+        !CALSWLib_Mod_Setup(&W_p->Q, Limbs))
+    {
+        return SFZCRYPTO_INVALID_PARAMETER;
+    }
+
+    CALSWLib_Num_Mul(W_p->t, W_p->P.m, W_p->Q.m, Limbs);
+
+    c_memset(W_p->N.m, 0, sizeof(W_p->N.m));
+    c_memcpy(W_p->N.m, W_p->t, 2 * Limbs * sizeof(CALSW_Limb_t));
+
+    return CALSWLib_Rsa_SetModulus(W_p);
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Rsa_Private
+ *
+ * W_p->r = W_p->a ^ d mod n, for a < n.
+ */
+static SfzCryptoStatus
+CALSWLib_Rsa_Private(
+        CALSW_RsaWork_t * const W_p,
+        const SfzCryptoAsymKey * const Key_p,
+        const bool fCrt)
+{
+    const CALSW_RsaMod_t * const N_p = &W_p->N;
+    const CALSW_RsaMod_t * const P_p = &W_p->P;
+    const CALSW_RsaMod_t * const Q_p = &W_p->Q;
+    const size_t Size = P_p->Limbs * sizeof(CALSW_Limb_t);
+    const SfzCryptoBigInt * Exp_p;
+    CALSW_Limb_t Carry;
+    unsigned int i;
+
+    if (!fCrt)
+    {
+        Exp_p = &Key_p->Key.rsaPrivKey.privexp;
+
+        CALSWLib_Mod_Mul(W_p->x, W_p->a, N_p->R2, N_p);
+        CALSWLib_Mod_Exp(
+                W_p->y,
+                W_p->x,
+                Exp_p->p_num,
+                Exp_p->byteLen,
+                N_p,
+                W_p->Table);
+        CALSWLib_Mod_FromMont(W_p->r, W_p->y, N_p);
+
+        return SFZCRYPTO_SUCCESS;
+    }
+
+    // m1 = (a mod p) ^ dP mod p, in x (Montgomery domain)
+    // a < p * q < p * R, so one reduction brings it below p
+    c_memset(W_p->t, 0, 2 * Size);
+    c_memcpy(W_p->t, W_p->a, N_p->Limbs * sizeof(CALSW_Limb_t));
+    CALSWLib_Mod_Reduce(W_p->y, W_p->t, P_p);
+    CALSWLib_Mod_Mul(W_p->y, W_p->y, P_p->R2, P_p);
+    CALSWLib_Mod_Mul(W_p->y, W_p->y, P_p->R2, P_p);
+
+    Exp_p = &Key_p->Key.rsaPrivKey.dmodP;
+    CALSWLib_Mod_Exp(
+            W_p->x,
+            W_p->y,
+            Exp_p->p_num,
+            Exp_p->byteLen,
+            P_p,
+            W_p->Table);
+
+    // m2 = (a mod q) ^ dQ mod q, in z
+    c_memset(W_p->t, 0, 2 * Size);
+    c_memcpy(W_p->t, W_p->a, N_p->Limbs * sizeof(CALSW_Limb_t));
+    CALSWLib_Mod_Reduce(W_p->y, W_p->t, Q_p);
+    CALSWLib_Mod_Mul(W_p->y, W_p->y, Q_p->R2, Q_p);
+    CALSWLib_Mod_Mul(W_p->y, W_p->y, Q_p->R2, Q_p);
+
+    Exp_p = &Key_p->Key.rsaPrivKey.dmodQ;
+    CALSWLib_Mod_Exp(
+            W_p->z,
+            W_p->y,
+            Exp_p->p_num,
+            Exp_p->byteLen,
+            Q_p,
+            W_p->Table);
+
+    CALSWLib_Mod_FromMont(W_p->z, W_p->z, Q_p);
+
+    // h = (m1 - m2) * qInv mod p, in x
+    // m2 < R, so the multiplication with R^2 reduces it mod p
+    CALSWLib_Mod_Mul(W_p->y, W_p->z, P_p->R2, P_p);
+    CALSWLib_Mod_Sub(W_p->x, W_p->x, W_p->y, P_p);
+
+    Exp_p = &Key_p->Key.rsaPrivKey.cofQinv;
+    if (!CALSWLib_Num_FromBytes(
+                W_p->y,
+                P_p->Limbs,
+                Exp_p->p_num,
+                Exp_p->byteLen) ||
+        CALSWLib_Num_Cmp(W_p->y, P_p->m, P_p->Limbs) >= 0)
+    {
+        return SFZCRYPTO_INVALID_PARAMETER;
+    }
+
+    CALSWLib_Mod_Mul(W_p->x, W_p->x, W_p->y, P_p);
+
+    // r = m2 + h * q
+    CALSWLib_Num_Mul(W_p->t, W_p->x, Q_p->m, Q_p->Limbs);
+
+    Carry = CALSWLib_Num_Add(W_p->t, W_p->t, W_p->z, Q_p->Limbs);
+    for (i = Q_p->Limbs; i < 2 * Q_p->Limbs && Carry != 0; i++)
+    {
+        W_p->t[i] += Carry;
+        Carry = (W_p->t[i] == 0);
+    }
+
+    c_memcpy(W_p->r, W_p->t, N_p->Limbs * sizeof(CALSW_Limb_t));
+
+#ifdef CALSW_RSA_CRT_CHECK
+    // a fault in one of the halves would expose a factor of n
+    if (Key_p->Key.rsaPrivKey.pubexp.p_num != NULL &&
+        Key_p->Key.rsaPrivKey.pubexp.byteLen > 0)
+    {
+        CALSWLib_Rsa_Public(
+                W_p,
+                &Key_p->Key.rsaPrivKey.pubexp,
+                W_p->r,
+                W_p->z);
+
+        if (CALSWLib_Num_Cmp(W_p->z, W_p->a, N_p->Limbs) != 0)
+        {
+            LOG_WARN(
+                "CALSWLib_Rsa_Private: "
+                "CRT result check failed\n");
+
+            c_memset(W_p->r, 0, sizeof(W_p->r));
+            return SFZCRYPTO_OPERATION_FAILED;
+        }
+    }
+#endif
+
+    return SFZCRYPTO_SUCCESS;
+}
+#endif /* CALSW_RSA_PRIVATE */
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Rsa_LoadInput
+ *
+ * W_p->a = the octet string Data_p, which must be below n.
+ */
+static bool
+CALSWLib_Rsa_LoadInput(
+        CALSW_RsaWork_t * const W_p,
+        const uint8_t * Data_p,
+        const uint32_t DataLen)
+{
+    return CALSWLib_Num_FromBytes(W_p->a, W_p->N.Limbs, Data_p, DataLen) &&
+           CALSWLib_Num_Cmp(W_p->a, W_p->N.m, W_p->N.Limbs) < 0;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Rsa_WorkAlloc
+ */
+static CALSW_RsaWork_t *
+CALSWLib_Rsa_WorkAlloc(void)
+{
+    return SPAL_Memory_Alloc(sizeof(CALSW_RsaWork_t));
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Rsa_WorkFree
+ *
+ * The work area may hold private key material and is cleared first.
+ */
+static void
+CALSWLib_Rsa_WorkFree(
+        CALSW_RsaWork_t * const W_p)
+{
+    c_memset(W_p, 0, sizeof(CALSW_RsaWork_t));
+    SPAL_Memory_Free(W_p);
+}
+
+
+#if defined(SFZCRYPTO_CF_RSA_ENCRYPT__SW) || \
+    defined(SFZCRYPTO_CF_RSA_SIGN__SW)
+/*----------------------------------------------------------------------------
+ * CALSWLib_Random
+ */
+static SfzCryptoStatus
+CALSWLib_Random(
+        uint8_t * Data_p,
+        const uint32_t DataLen)
+{
+#ifdef SFZCRYPTO_CF_RAND_DATA__CM
+    return sfzcrypto_cm_rand_data(DataLen, Data_p);
+#else
+    IDENTIFIER_NOT_USED(Data_p);
+    IDENTIFIER_NOT_USED(DataLen);
+    return SFZCRYPTO_UNSUPPORTED;
+#endif
+}
+#endif
+
+
+#ifdef CALSW_RSA_HASH
+/*----------------------------------------------------------------------------
+ * CALSWLib_Hash
+ *
+ * Digest_p = Hash(Data_p), computed by the CM.
+ */
+static SfzCryptoStatus
+CALSWLib_Hash(
+        const CALSW_RsaHash_t * const Hash_p,
+        const uint8_t * Data_p,
+        const uint32_t DataLen,
+        uint8_t * Digest_p)
+{
+#ifdef SFZCRYPTO_CF_HASH_DATA__CM
+    SfzCryptoHashContext Ctx;
+    SfzCryptoStatus status;
+
+    c_memset(&Ctx, 0, sizeof(Ctx));
+    Ctx.algo = Hash_p->HashAlgo;
+
+    status = sfzcrypto_cm_hash_data(
+                    &Ctx,
+                    (uint8_t *)Data_p,
+                    DataLen,
+                    true,
+                    true);
+
+    if (status != SFZCRYPTO_SUCCESS)
+        return status;
+
+    c_memcpy(Digest_p, Ctx.digest, Hash_p->DigestLen);
+
+    return SFZCRYPTO_SUCCESS;
+#else
+    IDENTIFIER_NOT_USED(Hash_p);
+    IDENTIFIER_NOT_USED(Data_p);
+    IDENTIFIER_NOT_USED(DataLen);
+    IDENTIFIER_NOT_USED(Digest_p);
+    return SFZCRYPTO_UNSUPPORTED;
+#endif
+}
+#endif /* CALSW_RSA_HASH */
+
+
+#ifdef CALSW_RSA_SIGNATURE
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Mgf1_Xor
+ *
+ * XORs MGF1(Seed_p) into Data_p (Seed_p is DigestLen bytes).
+ */
+static SfzCryptoStatus
+CALSWLib_Mgf1_Xor(
+        const CALSW_RsaHash_t * const Hash_p,
+        uint8_t * Data_p,
+        uint32_t DataLen,
+        const uint8_t * Seed_p)
+{
+    const uint32_t hLen = Hash_p->DigestLen;
+    uint8_t Block[CALSW_RSA_DIGEST_MAX + 4];
+    uint8_t Mask[CALSW_RSA_DIGEST_MAX];
+    uint32_t Counter = 0;
+
+    c_memcpy(Block, Seed_p, hLen);
+
+    while (DataLen > 0)
+    {
+        const uint32_t Len = MIN(hLen, DataLen);
+        SfzCryptoStatus status;
+        uint32_t i;
+
+        Block[hLen + 0] = (uint8_t)(Counter >> 24);
+        Block[hLen + 1] = (uint8_t)(Counter >> 16);
+        Block[hLen + 2] = (uint8_t)(Counter >> 8);
+        Block[hLen + 3] = (uint8_t)Counter;
+
+        status = CALSWLib_Hash(Hash_p, Block, hLen + 4, Mask);
+        if (status != SFZCRYPTO_SUCCESS)
+            return status;
+
+        for (i = 0; i < Len; i++)
+            Data_p[i] ^= Mask[i];
+
+        Data_p += Len;
+        DataLen -= Len;
+        Counter++;
+    }
+
+    return SFZCRYPTO_SUCCESS;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Rsa_SigScheme
+ *
+ * Maps the algorithm to the signature scheme and hash. For the PSS scheme
+ * without a hash the digest length selects the hash.
+ */
+static SfzCryptoStatus
+CALSWLib_Rsa_SigScheme(
+        const SfzCryptoAlgoAsym Algo,
+        const uint32_t DigestLen,
+        const CALSW_RsaHash_t ** const Hash_pp,
+        bool * const fPss_p)
+{
+    const CALSW_RsaHash_t * Hash_p = NULL;
+
+    *fPss_p = false;
+
+    switch (Algo)
+    {
+        case SFZCRYPTO_ALGO_ASYMM_RSA_PSS_MD5:
+            *fPss_p = true;
+            // fall-through
+        case SFZCRYPTO_ALGO_ASYMM_RSA_PKCS1_MD5:
+            Hash_p = &CALSW_RsaHash_MD5;
+            break;
+
+        case SFZCRYPTO_ALGO_ASYMM_RSA_PSS_SHA1:
+            *fPss_p = true;
+            // fall-through
+        case SFZCRYPTO_ALGO_ASYMM_RSA_PKCS1_SHA1:
+            Hash_p = &CALSW_RsaHash_SHA1;
+            break;
+
+        case SFZCRYPTO_ALGO_ASYMM_RSA_PSS_SHA224:
+            *fPss_p = true;
+            // fall-through
+        case SFZCRYPTO_ALGO_ASYMM_RSA_PKCS1_SHA224:
+            Hash_p = &CALSW_RsaHash_SHA224;
+            break;
+
+        case SFZCRYPTO_ALGO_ASYMM_RSA_PSS_SHA256:
+            *fPss_p = true;
+            // fall-through
+        case SFZCRYPTO_ALGO_ASYMM_RSA_PKCS1_SHA256:
+            Hash_p = &CALSW_RsaHash_SHA256;
+            break;
+
+        case SFZCRYPTO_ALGO_ASYMM_RSA_PSS:
+            *fPss_p = true;
+            if (DigestLen == CALSW_RsaHash_MD5.DigestLen)
+                Hash_p = &CALSW_RsaHash_MD5;
+            else if (DigestLen == CALSW_RsaHash_SHA1.DigestLen)
+                Hash_p = &CALSW_RsaHash_SHA1;
+            else if (DigestLen == CALSW_RsaHash_SHA224.DigestLen)
+                Hash_p = &CALSW_RsaHash_SHA224;
+            else if (DigestLen == CALSW_RsaHash_SHA256.DigestLen)
+                Hash_p = &CALSW_RsaHash_SHA256;
+            else
+                return SFZCRYPTO_INVALID_LENGTH;
+            break;
+
+        default:
+            return SFZCRYPTO_INVALID_ALGORITHM;
+    }
+
+    if (DigestLen != Hash_p->DigestLen)
+        return SFZCRYPTO_INVALID_LENGTH;
+
+    *Hash_pp = Hash_p;
+
+    return SFZCRYPTO_SUCCESS;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Pkcs1_EncodeSignature
+ *
+ * EMSA-PKCS1-v1_5: EM = 00 || 01 || FF .. FF || 00 || DigestInfo || H
+ */
+static SfzCryptoStatus
+CALSWLib_Pkcs1_EncodeSignature(
+        uint8_t * EM_p,
+        const uint32_t EmLen,
+        const CALSW_RsaHash_t * const Hash_p,
+        const uint8_t * Digest_p)
+{
+    const uint32_t TLen = Hash_p->DigestInfoLen + Hash_p->DigestLen;
+
+    if (EmLen < TLen + CALSW_RSA_PKCS1_OVERHEAD)
+        return SFZCRYPTO_INVALID_KEYSIZE;
+
+    EM_p[0] = 0x00;
+    EM_p[1] = 0x01;
+    c_memset(EM_p + 2, 0xFF, EmLen - TLen - 3);
+    EM_p[EmLen - TLen - 1] = 0x00;
+
+    c_memcpy(
+        EM_p + EmLen - TLen,
+        Hash_p->DigestInfo_p,
+        Hash_p->DigestInfoLen);
+
+    c_memcpy(
+        EM_p + EmLen - Hash_p->DigestLen,
+        Digest_p,
+        Hash_p->DigestLen);
+
+    return SFZCRYPTO_SUCCESS;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Pss_HashMPrime
+ *
+ * Digest_p = Hash(00 x 8 || mHash || salt), using W_p->Buf.
+ */
+static SfzCryptoStatus
+CALSWLib_Pss_HashMPrime(
+        CALSW_RsaWork_t * const W_p,
+        const CALSW_RsaHash_t * const Hash_p,
+        const uint8_t * MHash_p,
+        const uint8_t * Salt_p,
+        const uint32_t SaltLen,
+        uint8_t * Digest_p)
+{
+    uint8_t * p = W_p->Buf;
+
+    c_memset(p, 0, CALSW_RSA_PSS_PADDING_LEN);
+    p += CALSW_RSA_PSS_PADDING_LEN;
+
+    c_memcpy(p, MHash_p, Hash_p->DigestLen);
+    p += Hash_p->DigestLen;
+
+    c_memcpy(p, Salt_p, SaltLen);
+    p += SaltLen;
+
+    return CALSWLib_Hash(Hash_p, W_p->Buf, (uint32_t)(p - W_p->Buf), Digest_p);
+}
+#endif /* CALSW_RSA_SIGNATURE */
+
+
+#ifdef SFZCRYPTO_CF_RSA_SIGN__SW
+/*----------------------------------------------------------------------------
+ * CALSWLib_Pss_Encode
+ *
+ * EMSA-PSS encoding of mHash into W_p->EM (ModBytes bytes), with a random
+ * salt of the digest length.
+ */
+static SfzCryptoStatus
+CALSWLib_Pss_Encode(
+        CALSW_RsaWork_t * const W_p,
+        const CALSW_RsaHash_t * const Hash_p,
+        const uint8_t * MHash_p)
+{
+    const uint32_t hLen = Hash_p->DigestLen;
+    const uint32_t EmBits = W_p->ModBits - 1;
+    const uint32_t EmLen = (EmBits + 7) / 8;
+    uint8_t * const EM_p = W_p->EM + (W_p->ModBytes - EmLen);
+    uint8_t Salt[CALSW_RSA_DIGEST_MAX];
+    uint32_t DbLen;
+    SfzCryptoStatus status;
+
+    if (EmLen < 2 * hLen + 2)
+        return SFZCRYPTO_INVALID_KEYSIZE;
+
+    DbLen = EmLen - hLen - 1;
+
+    status = CALSWLib_Random(Salt, hLen);
+    if (status != SFZCRYPTO_SUCCESS)
+        return status;
+
+    c_memset(W_p->EM, 0, W_p->ModBytes);
+
+    // H, directly after DB
+    status = CALSWLib_Pss_HashMPrime(W_p, Hash_p, MHash_p, Salt, hLen,
+                                     EM_p + DbLen);
+    if (status != SFZCRYPTO_SUCCESS)
+        return status;
+
+    // DB = 00 .. 00 || 01 || salt, masked with MGF1(H)
+    EM_p[DbLen - hLen - 1] = 0x01;
+    c_memcpy(EM_p + DbLen - hLen, Salt, hLen);
+
+    status = CALSWLib_Mgf1_Xor(Hash_p, EM_p, DbLen, EM_p + DbLen);
+    if (status != SFZCRYPTO_SUCCESS)
+        return status;
+
+    EM_p[0] &= 0xFF >> (8 * EmLen - EmBits);
+    EM_p[EmLen - 1] = 0xBC;
+
+    return SFZCRYPTO_SUCCESS;
+}
+#endif /* SFZCRYPTO_CF_RSA_SIGN__SW */
+
+
+#ifdef SFZCRYPTO_CF_RSA_VERIFY__SW
+/*----------------------------------------------------------------------------
+ * CALSWLib_Pss_Verify
+ *
+ * EMSA-PSS verification of W_p->EM (ModBytes bytes) against mHash. The
+ * salt length is taken from the encoded message.
+ */
+static SfzCryptoStatus
+CALSWLib_Pss_Verify(
+        CALSW_RsaWork_t * const W_p,
+        const CALSW_RsaHash_t * const Hash_p,
+        const uint8_t * MHash_p)
+{
+    const uint32_t hLen = Hash_p->DigestLen;
+    const uint32_t EmBits = W_p->ModBits - 1;
+    const uint32_t EmLen = (EmBits + 7) / 8;
+    const uint8_t TopMask = 0xFF >> (8 * EmLen - EmBits);
+    uint8_t * const EM_p = W_p->EM + (W_p->ModBytes - EmLen);
+    uint8_t Digest[CALSW_RSA_DIGEST_MAX];
+    uint32_t DbLen, i;
+    SfzCryptoStatus status;
+
+    if (EmLen < hLen + 2)
+        return SFZCRYPTO_INVALID_KEYSIZE;
+
+    if ((EmLen < W_p->ModBytes && W_p->EM[0] != 0) ||
+        EM_p[EmLen - 1] != 0xBC ||
+        (EM_p[0] & ~TopMask) != 0)
+    {
+        return SFZCRYPTO_SIGNATURE_CHECK_FAILED;
+    }
+
+    DbLen = EmLen - hLen - 1;
+
+    status = CALSWLib_Mgf1_Xor(Hash_p, EM_p, DbLen, EM_p + DbLen);
+    if (status != SFZCRYPTO_SUCCESS)
+        return status;
+
+    EM_p[0] &= TopMask;
+
+    // DB = 00 .. 00 || 01 || salt
+    for (i = 0; i < DbLen && EM_p[i] == 0; i++)
+        ;
+
+    if (i == DbLen || EM_p[i] != 0x01)
+        return SFZCRYPTO_SIGNATURE_CHECK_FAILED;
+
+    i++;
+
+    status = CALSWLib_Pss_HashMPrime(W_p, Hash_p, MHash_p, EM_p + i,
+                                     DbLen - i, Digest);
+    if (status != SFZCRYPTO_SUCCESS)
+        return status;
+
+    if (c_memcmp(Digest, EM_p + DbLen, hLen) != 0)
+        return SFZCRYPTO_SIGNATURE_CHECK_FAILED;
+
+    return SFZCRYPTO_SUCCESS;
+}
+#endif /* SFZCRYPTO_CF_RSA_VERIFY__SW */
+
+
+#ifdef SFZCRYPTO_CF_RSA_ENCRYPT__SW
+/*----------------------------------------------------------------------------
+ * sfzcrypto_sw_rsa_encrypt
+ */
+SfzCryptoStatus
+sfzcrypto_sw_rsa_encrypt(
+        SfzCryptoAsymKey * const p_enctx,
+        SfzCryptoBigInt * const p_plaintext,
+        SfzCryptoBigInt * const p_ciphertext)
+{
+    CALSW_RsaWork_t * W_p;
+    SfzCryptoStatus status;
+    uint32_t k;
+
+    if (p_enctx == NULL ||
+        p_plaintext == NULL ||
+        p_ciphertext == NULL ||
+        p_plaintext->p_num == NULL ||
+        p_ciphertext->p_num == NULL)
+    {
+        return SFZCRYPTO_INVALID_PARAMETER;
+    }
+
+    switch (p_enctx->algo_type)
+    {
+        case SFZCRYPTO_ALGO_ASYMM_RSA_PKCS1:
+        case SFZCRYPTO_ALGO_ASYMM_RSA_RAW:
+            break;
+
+        case SFZCRYPTO_ALGO_ASYMM_RSA_OAEP_WITH_MGF1_SHA1:
+        case SFZCRYPTO_ALGO_ASYMM_RSA_OAEP_WITH_MGF1_SHA256:
+            return SFZCRYPTO_UNSUPPORTED;
+
+        default:
+            return SFZCRYPTO_INVALID_ALGORITHM;
+    }
+
+    W_p = CALSWLib_Rsa_WorkAlloc();
+    if (W_p == NULL)
+        return SFZCRYPTO_NO_MEMORY;
+
+    status = CALSWLib_Rsa_LoadPublic(W_p, &p_enctx->Key.rsaPubKey.modulus);
+    if (status != SFZCRYPTO_SUCCESS)
+        goto LEAVE;
+
+    k = W_p->ModBytes;
+
+    if (p_ciphertext->byteLen < k)
+    {
+        p_ciphertext->byteLen = k;
+        status = SFZCRYPTO_BUFFER_TOO_SMALL;
+        goto LEAVE;
+    }
+
+    if (p_enctx->algo_type == SFZCRYPTO_ALGO_ASYMM_RSA_PKCS1)
+    {
+        // EM = 00 || 02 || PS (non-zero random) || 00 || M
+        const uint32_t MLen = p_plaintext->byteLen;
+        uint8_t * const PS_p = W_p->EM + 2;
+        uint32_t PsLen, i;
+
+        if (MLen + CALSW_RSA_PKCS1_OVERHEAD > k)
+        {
+            status = SFZCRYPTO_INVALID_LENGTH;
+            goto LEAVE;
+        }
+
+        PsLen = k - MLen - 3;
+
+        status = CALSWLib_Random(PS_p, PsLen);
+        if (status != SFZCRYPTO_SUCCESS)
+            goto LEAVE;
+
+        for (i = 0; i < PsLen; i++)
+        {
+            while (PS_p[i] == 0)
+            {
+                status = CALSWLib_Random(PS_p + i, 1);
+                if (status != SFZCRYPTO_SUCCESS)
+                    goto LEAVE;
+            }
+        }
+
+        W_p->EM[0] = 0x00;
+        W_p->EM[1] = 0x02;
+        W_p->EM[k - MLen - 1] = 0x00;
+        c_memcpy(W_p->EM + k - MLen, p_plaintext->p_num, MLen);
+
+        CALSWLib_Rsa_LoadInput(W_p, W_p->EM, k);
+    }
+    else
+    {
+        if (!CALSWLib_Rsa_LoadInput(
+                    W_p,
+                    p_plaintext->p_num,
+                    p_plaintext->byteLen))
+        {
+            status = SFZCRYPTO_INVALID_PARAMETER;
+            goto LEAVE;
+        }
+    }
+
+    status = CALSWLib_Rsa_Public(
+                    W_p,
+                    &p_enctx->Key.rsaPubKey.pubexp,
+                    W_p->a,
+                    W_p->r);
+    if (status != SFZCRYPTO_SUCCESS)
+        goto LEAVE;
+
+    CALSWLib_Num_ToBytes(p_ciphertext->p_num, k, W_p->r, W_p->N.Limbs);
+    p_ciphertext->byteLen = k;
+
+LEAVE:
+    CALSWLib_Rsa_WorkFree(W_p);
+
+    return status;
+}
+#endif /* SFZCRYPTO_CF_RSA_ENCRYPT__SW */
+
+
+#ifdef SFZCRYPTO_CF_RSA_DECRYPT__SW
+/*----------------------------------------------------------------------------
+ * CALSWLib_CT_IsZero
+ *
+ * Returns all ones when a is zero, else zero, without branches.
+ */
+static inline uint32_t
+CALSWLib_CT_IsZero(
+        const uint32_t a)
+{
+    return ((a | (0 - a)) >> 31) - 1;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_CT_IsLess
+ *
+ * Returns all ones when a < b, else zero, for a and b below 2^31.
+ */
+static inline uint32_t
+CALSWLib_CT_IsLess(
+        const uint32_t a,
+        const uint32_t b)
+{
+    return 0 - ((a - b) >> 31);
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_CT_Select
+ *
+ * Returns a when Mask is all ones, b when Mask is zero.
+ */
+static inline uint32_t
+CALSWLib_CT_Select(
+        const uint32_t Mask,
+        const uint32_t a,
+        const uint32_t b)
+{
+    return (a & Mask) | (b & ~Mask);
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Rsa_HmacSha256
+ *
+ * Mac_p = HMAC-SHA256(Key_p, Data_p), for a key of CALSW_RSA_DIGEST_MAX
+ * bytes. W_p->Buf holds the inner hash input, so DataLen may be up to the
+ * modulus length.
+ */
+static SfzCryptoStatus
+CALSWLib_Rsa_HmacSha256(
+        CALSW_RsaWork_t * const W_p,
+        const uint8_t * Key_p,
+        const uint8_t * Data_p,
+        const uint32_t DataLen,
+        uint8_t * Mac_p)
+{
+    uint8_t Outer[CALSW_RSA_HMAC_BLOCK_LEN + CALSW_RSA_DIGEST_MAX];
+    SfzCryptoStatus status;
+    uint32_t i;
+
+    for (i = 0; i < CALSW_RSA_HMAC_BLOCK_LEN; i++)
+    {
+        const uint8_t k = (i < CALSW_RSA_DIGEST_MAX) ? Key_p[i] : 0;
+
+        W_p->Buf[i] = k ^ 0x36;
+        Outer[i] = k ^ 0x5C;
+    }
+
+    c_memcpy(W_p->Buf + CALSW_RSA_HMAC_BLOCK_LEN, Data_p, DataLen);
+
+    status = CALSWLib_Hash(
+                    &CALSW_RsaHash_SHA256,
+                    W_p->Buf,
+                    CALSW_RSA_HMAC_BLOCK_LEN + DataLen,
+                    Outer + CALSW_RSA_HMAC_BLOCK_LEN);
+
+    if (status == SFZCRYPTO_SUCCESS)
+    {
+        status = CALSWLib_Hash(
+                        &CALSW_RsaHash_SHA256,
+                        Outer,
+                        sizeof(Outer),
+                        Mac_p);
+    }
+
+    c_memset(Outer, 0, sizeof(Outer));
+    c_memset(W_p->Buf, 0, CALSW_RSA_HMAC_BLOCK_LEN);
+
+    return status;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Rsa_DeriveKdk
+ *
+ * W_p->Kdk = HMAC-SHA256(SHA256(d), C), with the ciphertext C (in W_p->a)
+ * as a k-byte octet string. For keys without the private exponent d the
+ * hash of the CRT exponents is used instead of SHA256(d).
+ */
+static SfzCryptoStatus
+CALSWLib_Rsa_DeriveKdk(
+        CALSW_RsaWork_t * const W_p,
+        const SfzCryptoAsymKey * const Key_p)
+{
+    const SfzCryptoBigInt * const D_p = &Key_p->Key.rsaPrivKey.privexp;
+    const SfzCryptoBigInt * const DP_p = &Key_p->Key.rsaPrivKey.dmodP;
+    const SfzCryptoBigInt * const DQ_p = &Key_p->Key.rsaPrivKey.dmodQ;
+    uint8_t KeyHash[2 * CALSW_RSA_DIGEST_MAX];
+    SfzCryptoStatus status;
+
+    if (D_p->p_num != NULL)
+    {
+        status = CALSWLib_Hash(
+                        &CALSW_RsaHash_SHA256,
+                        D_p->p_num,
+                        D_p->byteLen,
+                        KeyHash);
+    }
+    else
+    {
+        // CRT key (see CALSWLib_Rsa_LoadPrivate)
+        status = CALSWLib_Hash(
+                        &CALSW_RsaHash_SHA256,
+                        DP_p->p_num,
+                        DP_p->byteLen,
+                        KeyHash);
+
+        if (status == SFZCRYPTO_SUCCESS)
+        {
+            status = CALSWLib_Hash(
+                            &CALSW_RsaHash_SHA256,
+                            DQ_p->p_num,
+                            DQ_p->byteLen,
+                            KeyHash + CALSW_RSA_DIGEST_MAX);
+        }
+
+        if (status == SFZCRYPTO_SUCCESS)
+        {
+            status = CALSWLib_Hash(
+                            &CALSW_RsaHash_SHA256,
+                            KeyHash,
+                            sizeof(KeyHash),
+                            KeyHash);
+        }
+    }
+
+    if (status == SFZCRYPTO_SUCCESS)
+    {
+        CALSWLib_Num_ToBytes(W_p->EM, W_p->ModBytes, W_p->a, W_p->N.Limbs);
+
+        status = CALSWLib_Rsa_HmacSha256(
+                        W_p,
+                        KeyHash,
+                        W_p->EM,
+                        W_p->ModBytes,
+                        W_p->Kdk);
+    }
+
+    c_memset(KeyHash, 0, sizeof(KeyHash));
+
+    return status;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Rsa_Prf
+ *
+ * Out_p = the first OutLen bytes of HMAC-SHA256(Kdk, I || Label || L) for
+ * I = 0, 1, ..., where I and L (OutLen in bits) are 16-bit big-endian.
+ */
+static SfzCryptoStatus
+CALSWLib_Rsa_Prf(
+        CALSW_RsaWork_t * const W_p,
+        const char * const Label_p,
+        const uint32_t LabelLen,
+        uint8_t * Out_p,
+        const uint32_t OutLen)
+{
+    uint8_t Data[2 + 8 + 2];
+    uint8_t Mac[CALSW_RSA_DIGEST_MAX];
+    SfzCryptoStatus status = SFZCRYPTO_SUCCESS;
+    uint32_t Iter = 0;
+    uint32_t Pos;
+
+    if (LabelLen > sizeof(Data) - 4)
+        return SFZCRYPTO_INTERNAL_ERROR;
+
+    c_memcpy(Data + 2, Label_p, LabelLen);
+    Data[2 + LabelLen] = (uint8_t)((8 * OutLen) >> 8);
+    Data[3 + LabelLen] = (uint8_t)(8 * OutLen);
+
+    for (Pos = 0; Pos < OutLen; Pos += CALSW_RSA_DIGEST_MAX, Iter++)
+    {
+        Data[0] = (uint8_t)(Iter >> 8);
+        Data[1] = (uint8_t)Iter;
+
+        status = CALSWLib_Rsa_HmacSha256(
+                        W_p,
+                        W_p->Kdk,
+                        Data,
+                        4 + LabelLen,
+                        Mac);
+
+        if (status != SFZCRYPTO_SUCCESS)
+            break;
+
+        c_memcpy(Out_p + Pos, Mac, MIN(CALSW_RSA_DIGEST_MAX, OutLen - Pos));
+    }
+
+    c_memset(Mac, 0, sizeof(Mac));
+
+    return status;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CALSWLib_Rsa_Pkcs1Decode
+ *
+ * Decodes EM = 00 || 02 || PS (8 or more non-zero bytes) || 00 || M in
+ * W_p->EM. When the encoding is invalid, the synthetic message in
+ * W_p->Synthetic is returned instead; its length was chosen with the
+ * candidates in W_p->Lengths. The message ends up at the end of W_p->EM;
+ * returns its length. No branches or memory accesses depend on EM.
+ */
+static uint32_t
+CALSWLib_Rsa_Pkcs1Decode(
+        CALSW_RsaWork_t * const W_p)
+{
+    const uint32_t k = W_p->ModBytes;
+    const uint32_t MaxLen = k - CALSW_RSA_PKCS1_OVERHEAD + 1;
+    uint32_t LenMask = MaxLen;
+    uint32_t SynLen = 0;
+    uint32_t Good;
+    uint32_t Found = 0;
+    uint32_t ZeroIndex = 0;
+    uint32_t MLen;
+    uint32_t i;
+
+    // length of the synthetic message: the last candidate below MaxLen
+    LenMask |= LenMask >> 1;
+    LenMask |= LenMask >> 2;
+    LenMask |= LenMask >> 4;
+    LenMask |= LenMask >> 8;
+
+    for (i = 0; i < CALSW_RSA_IR_LENGTHS; i++)
+    {
+        const uint32_t Len =
+            (((uint32_t)W_p->Lengths[2 * i] << 8) |
+             W_p->Lengths[2 * i + 1]) & LenMask;
+
+        SynLen = CALSWLib_CT_Select(
+                        CALSWLib_CT_IsLess(Len, MaxLen),
+                        Len,
+                        SynLen);
+    }
+
+    Good = CALSWLib_CT_IsZero(W_p->EM[0]) &
+           CALSWLib_CT_IsZero(W_p->EM[1] ^ 0x02);
+
+    // the first zero byte after the header, no early exit
+    for (i = 2; i < k; i++)
+    {
+        const uint32_t IsZero = CALSWLib_CT_IsZero(W_p->EM[i]);
+
+        ZeroIndex = CALSWLib_CT_Select(~Found & IsZero, i, ZeroIndex);
+        Found |= IsZero;
+    }
+
+    Good &= Found;
+    Good &= ~CALSWLib_CT_IsLess(ZeroIndex, CALSW_RSA_PKCS1_OVERHEAD - 1);
+
+    MLen = CALSWLib_CT_Select(Good, k - ZeroIndex - 1, SynLen);
+
+    // both messages are at the end of their buffer
+    for (i = 0; i < k; i++)
+    {
+        W_p->EM[i] = (uint8_t)CALSWLib_CT_Select(
+                                        Good,
+                                        W_p->EM[i],
+                                        W_p->Synthetic[i]);
+    }
+
+    return MLen;
+}
+
+
+/*----------------------------------------------------------------------------
+ * sfzcrypto_sw_rsa_decrypt
+ */
+SfzCryptoStatus
+sfzcrypto_sw_rsa_decrypt(
+        SfzCryptoAsymKey * const p_dectx,
+        SfzCryptoBigInt * const p_ciphertext,
+        SfzCryptoBigInt * const p_plaintext)
+{
+    CALSW_RsaWork_t * W_p;
+    SfzCryptoStatus status;
+    const uint8_t * M_p;
+    uint32_t MLen;
+    bool fCrt;
+    uint32_t k;
+
+    if (p_dectx == NULL ||
+        p_ciphertext == NULL ||
+        p_plaintext == NULL ||
+        p_ciphertext->p_num == NULL ||
+        p_plaintext->p_num == NULL)
+    {
+        return SFZCRYPTO_INVALID_PARAMETER;
+    }
+
+    switch (p_dectx->algo_type)
+    {
+        case SFZCRYPTO_ALGO_ASYMM_RSA_PKCS1:
+        case SFZCRYPTO_ALGO_ASYMM_RSA_RAW:
+            break;
+
+        case SFZCRYPTO_ALGO_ASYMM_RSA_OAEP_WITH_MGF1_SHA1:
+        case SFZCRYPTO_ALGO_ASYMM_RSA_OAEP_WITH_MGF1_SHA256:
+            return SFZCRYPTO_UNSUPPORTED;
+
+        default:
+            return SFZCRYPTO_INVALID_ALGORITHM;
+    }
+
+    W_p = CALSWLib_Rsa_WorkAlloc();
+    if (W_p == NULL)
+        return SFZCRYPTO_NO_MEMORY;
+
+    status = CALSWLib_Rsa_LoadPrivate(W_p, p_dectx, &fCrt);
+    if (status != SFZCRYPTO_SUCCESS)
+        goto LEAVE;
+
+    k = W_p->ModBytes;
+
+    if (!CALSWLib_Rsa_LoadInput(
+                W_p,
+                p_ciphertext->p_num,
+                p_ciphertext->byteLen))
+    {
+        status = SFZCRYPTO_INVALID_PARAMETER;
+        goto LEAVE;
+    }
+
+    if (p_dectx->algo_type == SFZCRYPTO_ALGO_ASYMM_RSA_PKCS1)
+    {
+        if (k < CALSW_RSA_PKCS1_OVERHEAD)
+        {
+            status = SFZCRYPTO_INVALID_KEYSIZE;
+            goto LEAVE;
+        }
+
+        // the synthetic message for invalid padding (implicit rejection)
+        // only depends on the key and the ciphertext
+        status = CALSWLib_Rsa_DeriveKdk(W_p, p_dectx);
+
+        if (status == SFZCRYPTO_SUCCESS)
+        {
+            status = CALSWLib_Rsa_Prf(
+                            W_p,
+                            "length",
+                            6,
+                            W_p->Lengths,
+                            sizeof(W_p->Lengths));
+        }
+
+        if (status == SFZCRYPTO_SUCCESS)
+        {
+            status = CALSWLib_Rsa_Prf(
+                            W_p,
+                            "message",
+                            7,
+                            W_p->Synthetic,
+                            k);
+        }
+
+        if (status != SFZCRYPTO_SUCCESS)
+            goto LEAVE;
+    }
+
+    status = CALSWLib_Rsa_Private(W_p, p_dectx, fCrt);
+    if (status != SFZCRYPTO_SUCCESS)
+        goto LEAVE;
+
+    CALSWLib_Num_ToBytes(W_p->EM, k, W_p->r, W_p->N.Limbs);
+
+    M_p = W_p->EM;
+    MLen = k;
+
+    if (p_dectx->algo_type == SFZCRYPTO_ALGO_ASYMM_RSA_PKCS1)
+    {
+        MLen = CALSWLib_Rsa_Pkcs1Decode(W_p);
+        M_p = W_p->EM + k - MLen;
+    }
+
+    if (p_plaintext->byteLen < MLen)
+    {
+        p_plaintext->byteLen = MLen;
+        status = SFZCRYPTO_BUFFER_TOO_SMALL;
+        goto LEAVE;
+    }
+
+    c_memcpy(p_plaintext->p_num, M_p, MLen);
+    p_plaintext->byteLen = MLen;
+
+LEAVE:
+    CALSWLib_Rsa_WorkFree(W_p);
+
+    return status;
+}
+#endif /* SFZCRYPTO_CF_RSA_DECRYPT__SW */
+
+
+#ifdef SFZCRYPTO_CF_RSA_SIGN__SW
+/*----------------------------------------------------------------------------
+ * sfzcrypto_sw_rsa_sign
+ */
+SfzCryptoStatus
+sfzcrypto_sw_rsa_sign(
+        SfzCryptoAsymKey * const p_sigctx,
+        SfzCryptoBigInt * const p_signature,
+        uint8_t * p_hash_msg,
+        uint32_t hash_msglen)
+{
+    const CALSW_RsaHash_t * Hash_p;
+    CALSW_RsaWork_t * W_p;
+    SfzCryptoStatus status;
+    bool fCrt, fPss;
+    uint32_t k;
+
+    if (p_sigctx == NULL ||
+        p_signature == NULL ||
+        p_signature->p_num == NULL ||
+        p_hash_msg == NULL)
+    {
+        return SFZCRYPTO_INVALID_PARAMETER;
+    }
+
+    status = CALSWLib_Rsa_SigScheme(
+                    p_sigctx->algo_type,
+                    hash_msglen,
+                    &Hash_p,
+                    &fPss);
+    if (status != SFZCRYPTO_SUCCESS)
+        return status;
+
+    W_p = CALSWLib_Rsa_WorkAlloc();
+    if (W_p == NULL)
+        return SFZCRYPTO_NO_MEMORY;
+
+    status = CALSWLib_Rsa_LoadPrivate(W_p, p_sigctx, &fCrt);
+    if (status != SFZCRYPTO_SUCCESS)
+        goto LEAVE;
+
+    k = W_p->ModBytes;
+
+    if (p_signature->byteLen < k)
+    {
+        p_signature->byteLen = k;
+        status = SFZCRYPTO_BUFFER_TOO_SMALL;
+        goto LEAVE;
+    }
+
+    if (fPss)
+        status = CALSWLib_Pss_Encode(W_p, Hash_p, p_hash_msg);
+    else
+        status = CALSWLib_Pkcs1_EncodeSignature(W_p->EM, k, Hash_p, p_hash_msg);
+
+    if (status != SFZCRYPTO_SUCCESS)
+        goto LEAVE;
+
+    // the encoded message starts with a zero byte, so it is below n
+    CALSWLib_Rsa_LoadInput(W_p, W_p->EM, k);
+
+    status = CALSWLib_Rsa_Private(W_p, p_sigctx, fCrt);
+    if (status != SFZCRYPTO_SUCCESS)
+        goto LEAVE;
+
+    CALSWLib_Num_ToBytes(p_signature->p_num, k, W_p->r, W_p->N.Limbs);
+    p_signature->byteLen = k;
+
+LEAVE:
+    CALSWLib_Rsa_WorkFree(W_p);
+
+    return status;
+}
+#endif /* SFZCRYPTO_CF_RSA_SIGN__SW */
+
+
+#ifdef SFZCRYPTO_CF_RSA_VERIFY__SW
+/*----------------------------------------------------------------------------
+ * sfzcrypto_sw_rsa_verify
+ */
+SfzCryptoStatus
+sfzcrypto_sw_rsa_verify(
+        SfzCryptoAsymKey * const p_sigctx,
+        SfzCryptoBigInt * const p_signature,
+        uint8_t * p_hash_msg,
+        uint32_t hash_msglen)
+{
+    const CALSW_RsaHash_t * Hash_p;
+    CALSW_RsaWork_t * W_p;
+    SfzCryptoStatus status;
+    bool fPss;
+    uint32_t k;
+
+    if (p_sigctx == NULL ||
+        p_signature == NULL ||
+        p_signature->p_num == NULL ||
+        p_hash_msg == NULL)
+    {
+        return SFZCRYPTO_INVALID_PARAMETER;
+    }
+
+    status = CALSWLib_Rsa_SigScheme(
+                    p_sigctx->algo_type,
+                    hash_msglen,
+                    &Hash_p,
+                    &fPss);
+    if (status != SFZCRYPTO_SUCCESS)
+        return status;
+
+    W_p = CALSWLib_Rsa_WorkAlloc();
+    if (W_p == NULL)
+        return SFZCRYPTO_NO_MEMORY;
+
+    status = CALSWLib_Rsa_LoadPublic(W_p, &p_sigctx->Key.rsaPubKey.modulus);
+    if (status != SFZCRYPTO_SUCCESS)
+        goto LEAVE;
+
+    k = W_p->ModBytes;
+
+    if (!CALSWLib_Rsa_LoadInput(
+                W_p,
+                p_signature->p_num,
+                p_signature->byteLen))
+    {
+        status = SFZCRYPTO_INVALID_SIGNATURE;
+        goto LEAVE;
+    }
+
+    status = CALSWLib_Rsa_Public(
+                    W_p,
+                    &p_sigctx->Key.rsaPubKey.pubexp,
+                    W_p->a,
+                    W_p->r);
+    if (status != SFZCRYPTO_SUCCESS)
+        goto LEAVE;
+
+    CALSWLib_Num_ToBytes(W_p->EM, k, W_p->r, W_p->N.Limbs);
+
+    if (fPss)
+    {
+        status = CALSWLib_Pss_Verify(W_p, Hash_p, p_hash_msg);
+    }
+    else
+    {
+        // compare with the expected encoding
+        uint8_t * const Expected_p = W_p->Buf;
+
+        status = CALSWLib_Pkcs1_EncodeSignature(
+                        Expected_p,
+                        k,
+                        Hash_p,
+                        p_hash_msg);
+
+        if (status == SFZCRYPTO_SUCCESS &&
+            c_memcmp(Expected_p, W_p->EM, k) != 0)
+        {
+            status = SFZCRYPTO_SIGNATURE_CHECK_FAILED;
+        }
+    }
+
+LEAVE:
+    CALSWLib_Rsa_WorkFree(W_p);
+
+    return status;
+}
+#endif /* SFZCRYPTO_CF_RSA_VERIFY__SW */
+
+#else
+extern const int _avoid_empty_translation_unit;
+#endif /* SFZCRYPTO_CF_RSA_*__SW */
+
+/* end of file cal_sw_rsa.c */
@@ -56,6 +56,17 @@
 #undef  SFZCRYPTO_CF_CIPHER_MAC_DATA__SW
 #define SFZCRYPTO_CF_CIPHER_MAC_DATA__CM
 
+// AES-CCM is built from the CM AES-CBC-MAC and AES-CTR operations
+#undef  SFZCRYPTO_CF_AUTH_CRYPT__REMOVE
+#undef  SFZCRYPTO_CF_AUTH_CRYPT__STUB
+#undef  SFZCRYPTO_CF_AUTH_CRYPT__SW
+#define SFZCRYPTO_CF_AUTH_CRYPT__CM
+
+#undef  SFZCRYPTO_CF_AES_WRAP_UNWRAP__REMOVE
+#undef  SFZCRYPTO_CF_AES_WRAP_UNWRAP__STUB
+#undef  SFZCRYPTO_CF_AES_WRAP_UNWRAP__SW
+#define SFZCRYPTO_CF_AES_WRAP_UNWRAP__CM
+
 #undef  SFZCRYPTO_CF_CPRM_C2_DERIVE__REMOVE
 #undef  SFZCRYPTO_CF_CPRM_C2_DERIVE__STUB
 #undef  SFZCRYPTO_CF_CPRM_C2_DERIVE__SW
@@ -162,4 +173,28 @@
 #undef  SFZCRYPTO_CF_AUNLOCK__STUB
 #define SFZCRYPTO_CF_AUNLOCK__CM
 
+// ECDSA verify is not offered by the CM; use the CAL_SW implementation
+#undef  SFZCRYPTO_CF_ECDSA_VERIFY__REMOVE
+#undef  SFZCRYPTO_CF_ECDSA_VERIFY__STUB
+#undef  SFZCRYPTO_CF_ECDSA_VERIFY__PK
+#define SFZCRYPTO_CF_ECDSA_VERIFY__SW
+
+// RSA is not offered by the CM; use the CAL_SW implementation
+#undef  SFZCRYPTO_CF_RSA_ENCRYPT__REMOVE
+#undef  SFZCRYPTO_CF_RSA_ENCRYPT__STUB
+#undef  SFZCRYPTO_CF_RSA_ENCRYPT__PK
+#define SFZCRYPTO_CF_RSA_ENCRYPT__SW
+#undef  SFZCRYPTO_CF_RSA_DECRYPT__REMOVE
+#undef  SFZCRYPTO_CF_RSA_DECRYPT__STUB
+#undef  SFZCRYPTO_CF_RSA_DECRYPT__PK
+#define SFZCRYPTO_CF_RSA_DECRYPT__SW
+#undef  SFZCRYPTO_CF_RSA_SIGN__REMOVE
+#undef  SFZCRYPTO_CF_RSA_SIGN__STUB
+#undef  SFZCRYPTO_CF_RSA_SIGN__PK
+#define SFZCRYPTO_CF_RSA_SIGN__SW
+#undef  SFZCRYPTO_CF_RSA_VERIFY__REMOVE
+#undef  SFZCRYPTO_CF_RSA_VERIFY__STUB
+#undef  SFZCRYPTO_CF_RSA_VERIFY__PK
+#define SFZCRYPTO_CF_RSA_VERIFY__SW
+
 /* end of file cf_cal_cm-v2.h */
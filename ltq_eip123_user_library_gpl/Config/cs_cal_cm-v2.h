@@ -47,6 +47,46 @@
 // bounced after all.
 //#define CALCM_DMA_BOUNCE_ALWAYS
 
+// AES/DES operations on at least CALCM_DMA_PIPELINE_MIN_SIZE bytes that must
+// be bounced are processed in segments of CALCM_DMA_PIPELINE_SEGMENT_SIZE
+// bytes (multiple of 16), so the copies to and from the bounce buffers
+// overlap with the processing in the CM. Set the segment size to 0 to
+// disable.
+#define CALCM_DMA_PIPELINE_SEGMENT_SIZE  (16 * 1024)
+#define CALCM_DMA_PIPELINE_MIN_SIZE      (64 * 1024)
+
+// bounce copies of at least this many bytes use streaming (non-temporal)
+// stores on CPUs that have them (SSE2); 0 = always use memcpy
+#define CALCM_DMA_STREAMING_COPY_MIN     4096
+
+// Number of released DMA tasks (with their DMA-safe buffer for the
+// descriptor chains and the TokenID) kept for the next operations, instead
+// of being freed. Set to 0 to disable.
+#define CALCM_DMA_TASK_POOL_SIZE         4
+
+// Number of input and output descriptor chains kept per DMA task. An
+// operation on the same DMA address, length and block size as a kept chain
+// reuses that chain, without fragmenting the buffer or writing the chain
+// buffer again. This pays off for applications that reuse fixed buffers
+// (with the task pool) and for segmented AES/DES. Set to 0 to disable.
+#define CALCM_DMA_DC_CACHE_ENTRIES       2
+
+// Each thread keeps the DMA task (and the bulk buffer of at most
+// CALCM_DMA_THREAD_BULK_MAX bytes) that it released last, for its next
+// operation. This takes no lock and no allocation in the common case. The
+// resources are released when the thread exits. Uses POSIX thread keys.
+#define CALCM_DMA_THREAD_CONTEXT
+#define CALCM_DMA_THREAD_BULK_MAX        (64 * 1024)
+
+// With the CAL_HW warm start (see CALHW_WARMSTART_SHM_NAME), the basic DMA
+// test of sfzcrypto_cm_init is skipped when it passed less than this many
+// seconds ago, in any process. 0 = always run the test.
+#define CALCM_WARMSTART_DMATEST_INTERVAL_S  3600
+
+// report the time spent in each phase of sfzcrypto_cm_init (LOG_INFO);
+// requires clock_gettime
+//#define CALCM_INIT_TIMING
+
 // CAL API call trace options
 //#define CALCM_TRACE_sfzcrypto_cm_hash_data
 //#define CALCM_TRACE_sfzcrypto_cm_hmac_data
@@ -71,6 +111,66 @@
 // Static number used to identify the root key (typically in NVM)
 #define CALCM_ROOT_KEY_INDEX    1
 
+// Random pool: a background thread keeps up to CALCM_RANDOM_POOL_SIZE random
+// bytes available for the requests up to CALCM_RANDOM_POOL_MAX_REQUEST bytes.
+// A refill is started when the pool drops below the low watermark and it
+// stops at the high watermark. Set the size to 0 to disable the pool.
+#define CALCM_RANDOM_POOL_SIZE            4096
+#define CALCM_RANDOM_POOL_LOW_WATERMARK   1024
+#define CALCM_RANDOM_POOL_HIGH_WATERMARK  4096
+#define CALCM_RANDOM_POOL_MAX_REQUEST     64
+#define CALCM_RANDOM_POOL_REFILL_CHUNK    1024
+// enables fork() handling (pthread_atfork) and refill latency statistics
+// (clock_gettime) in the random pool; requires a POSIX system
+#define CALCM_RANDOM_POOL_USE_POSIX
+
+// Continuous health tests on all random bytes retrieved from the CM: the
+// Repetition Count and Adaptive Proportion tests of SP 800-90B (byte
+// samples, full entropy assumed, false alarm rate 2^-40) and the FIPS 140-2
+// Monobit, Poker, Runs and Long Run tests per 20000 bits.
+// With CALCM_RANDOM_HEALTH_REJECT, the random bytes that fail the
+// Repetition Count or Adaptive Proportion test are not returned; the FIPS
+// 140-2 test failures are only counted and reported.
+#define CALCM_RANDOM_HEALTH_TESTS
+#define CALCM_RANDOM_HEALTH_RCT_CUTOFF    6
+#define CALCM_RANDOM_HEALTH_APT_WINDOW    512
+#define CALCM_RANDOM_HEALTH_APT_CUTOFF    19
+#define CALCM_RANDOM_HEALTH_REJECT
+
+// Static asset numbers to search during sfzcrypto_cm_init, so that later
+// searches (and sfzcrypto_cm_asset_get_root_key) are served from the cache.
+// When undefined, the cache is only filled on demand.
+#define CALCM_ASSETSEARCH_PRELOAD_LIST  CALCM_ROOT_KEY_INDEX
+
+// Number of plaintext HMAC keys for which the key and the inner (ipad) state
+// are kept in the Asset Store, to avoid the key processing per message.
+// Each entry occupies two assets; only a fingerprint of the key is kept in
+// memory. Set to 0 to disable.
+#define CALCM_HMAC_KEYCACHE_ENTRIES  4
+
+// Number of token templates kept for AES/DES cipher contexts. A template
+// holds the part of the command token that only depends on the algorithm,
+// mode and key, so that repeated operations on a context only fill in the
+// data length, IV, descriptors and TokenID. Only keys in the Asset Store get
+// a template; the key is never copied into one. The table takes no lock.
+// Set to 0 to disable.
+#define CALCM_TOKEN_TEMPLATE_ENTRIES  16
+
+// Token scheduler: callers waiting for the CM are served by priority class
+// (interactive, normal, bulk) and FIFO within a class. A waiting class is
+// served anyway after being passed over CALCM_SCHED_AGING_LIMIT times.
+// Without a class selected by the thread, crypto, hash and MAC tokens of at
+// least CALCM_SCHED_BULK_MIN_SIZE bytes are bulk, TRNG and asset tokens are
+// interactive. AES/DES operations larger than CALCM_SCHED_BULK_SLICE_SIZE
+// bytes (multiple of 16, 0 = no limit) are split in slices, so that other
+// callers can use the CM in between.
+#define CALCM_SCHED_AGING_LIMIT        8
+#define CALCM_SCHED_BULK_MIN_SIZE      (64 * 1024)
+#define CALCM_SCHED_BULK_SLICE_SIZE    (1024 * 1024)
+// enables per-thread classes (pthread_setspecific) and wait time statistics
+// (clock_gettime) in the token scheduler; requires a POSIX system
+#define CALCM_SCHED_USE_POSIX
+
 /*
 ** LANTIQ Specific
 ** !<WW: <w.widjaja.ee@lantiq.com> (30/Sept/14)
@@ -46,6 +46,20 @@
 #define CALHW_REMOVE_PKA_SUPPORT
 #endif
 
+// Warm start: the state of the CM after initialization is recorded in this
+// POSIX shared memory object. Later processes that find a valid record, for
+// the same configuration, skip the clock and reset, the device communication
+// test and the configuration tokens (DMA, TRNG). The record is only used
+// while the CM mailbox is still linked, i.e. the CM was not reset since. The
+// record is invalidated while a process initializes the CM and does not
+// survive a reboot.
+// Comment-out to always initialize the CM fully.
+#define CALHW_WARMSTART_SHM_NAME  "/sfzcrypto_cm_state"
+
+// report the time spent in each initialization phase (LOG_INFO);
+// requires clock_gettime
+//#define CALHW_INIT_TIMING
+
 // delay for polling mode; used while waiting for OUT token
 #define CALHW_POLLING_DELAY_MS  1
 
@@ -0,0 +1,47 @@
+/* cs_cal_sw.h
+ *
+ * Configuration Settings for the CAL SW module.
+ */
+
+/*****************************************************************************
+* Copyright (c) 2007-2015 INSIDE Secure B.V. All Rights Reserved.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 2 of the License, or
+* any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+// enable debug logging
+//#define LOG_SEVERITY_MAX  LOG_SEVERITY_INFO
+
+// curves supported by the software ECDSA verify
+// (the secure boot images use P-224 or P-256, see SBIF_ECDSA_WORDS)
+#define CALSW_ECDSA_CURVE_P224
+#define CALSW_ECDSA_CURVE_P256
+
+// wNAF window width for the precomputed multiples of the base point G
+// (2^(w-2) points per curve, built on first use)
+#define CALSW_ECDSA_FIXED_WINDOW  7
+
+// wNAF window width for the multiples of the public key Q
+// (2^(w-2) points, built for each verify)
+#define CALSW_ECDSA_VAR_WINDOW  5
+
+// maximum sliding window width for the RSA exponentiation
+// (2^(w-1) precomputed powers; the width used follows the exponent size)
+#define CALSW_RSA_WINDOW_MAX  6
+
+// check each RSA-CRT result with the public exponent, when the key holds it
+// (a faulty half of the CRT computation would otherwise expose the key)
+#define CALSW_RSA_CRT_CHECK
+
+/* end of file cs_cal_sw.h */
@@ -66,6 +66,18 @@
       HWPAL_REMAP_ONE(_old, _new)
 */
 
+// direct register access: Device_Read32/Write32 and the array functions
+// access the registers via the base address resolved by Device_Find, without
+// the checks and the configuration handling per access.
+// Requires that tracing and PCI config space devices are disabled and that
+// the device addresses are not remapped. Define HWPAL_DEVICE_DIRECT_SWAP when
+// the words must be swapped (for all devices). Device_Find fails for devices
+// that do not match this configuration.
+#if defined(CFG_ENABLE_TARGET_VERSATILE) && defined(CFG_IMPLDEFS_NO_DEBUG)
+#define HWPAL_DEVICE_DIRECT_ACCESS
+#endif
+//#define HWPAL_DEVICE_DIRECT_SWAP
+
 // #of supported DMA resources
 #define HWPAL_DMA_NRESOURCES 128
 
@@ -0,0 +1,32 @@
+/* cs_metrics.h
+ *
+ * Configuration Settings for the Metrics module (shared memory counters).
+ * The module is enabled with configure option --enable-metrics.
+ */
+
+/*****************************************************************************
+* Copyright (c) 2008-2013 INSIDE Secure B.V. All Rights Reserved.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 2 of the License, or
+* any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+// name of the shared memory segment (shm_open) of a process is this
+// prefix followed by the process ID
+#define METRICS_SHM_NAME_PREFIX  "/sfzcrypto_metrics."
+
+// access mode of the shared memory segment
+// (the readers need read access only)
+#define METRICS_SHM_MODE  0644
+
+/* end of file cs_metrics.h */
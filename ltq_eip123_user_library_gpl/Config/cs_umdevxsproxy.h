@@ -24,6 +24,11 @@
 
 #define UMDEVXSPROXY_NODE_NAME "//dev//umdevxs_c"
 
+// shared memory buffers of this size or more are mapped at an address that
+// is aligned to it, so that the kernel driver can map them with huge pages
+// (see UMDEVXS_SMBUF_HUGE_PAGES); set to 0 to disable
+#define UMDEVXSPROXY_SMBUF_HUGE_PAGE_SIZE  (2 * 1024 * 1024)
+
 // uncomment to remove selected functionality
 //#define UMDEVXSPROXY_REMOVE_DEVICE
 //#define UMDEVXSPROXY_REMOVE_SMBUF
@@ -49,4 +49,13 @@
 #error "Expected HWPAL_REMAP_ADDRESSES defined by cs_hwpal_umdevxs.h"
 #endif
 
+#ifdef HWPAL_DEVICE_DIRECT_ACCESS
+#if defined(HWPAL_TRACE_DEVICE_READ) || defined(HWPAL_TRACE_DEVICE_WRITE)
+#error "HWPAL_DEVICE_DIRECT_ACCESS does not support device tracing"
+#endif
+#ifndef HWPAL_REMOVE_DEVICE_PCICONFIGSPACE
+#error "HWPAL_DEVICE_DIRECT_ACCESS requires HWPAL_REMOVE_DEVICE_PCICONFIGSPACE"
+#endif
+#endif
+
 /* end of file c_hwpal_device_umdevxs.h */
@@ -53,6 +53,10 @@
 
 typedef struct
 {
+#ifdef HWPAL_DEVICE_DIRECT_ACCESS
+    volatile uint32_t * Base_p;     // set by Device_Find
+#endif
+
     const char * DevName;
     unsigned int DeviceNr;
     unsigned int FirstOfs;
@@ -66,13 +70,21 @@ typedef struct
 } HWPALLib_DeviceAdmin_t;
 
 
+#ifdef HWPAL_DEVICE_DIRECT_ACCESS
+#define HWPAL_DEVICE_DIRECT_INIT  NULL,
+#else
+#define HWPAL_DEVICE_DIRECT_INIT
+#endif
+
 #ifdef HWPAL_DEVICE_MAGIC
 #define HWPAL_DEVICE_ADD(_name, _devnr, _firstofs, _lastofs, _flags) \
-                       { _name, _devnr, _firstofs, _lastofs, _flags, \
+                       { HWPAL_DEVICE_DIRECT_INIT \
+                         _name, _devnr, _firstofs, _lastofs, _flags, \
                                                         HWPAL_DEVICE_MAGIC }
 #else
 #define HWPAL_DEVICE_ADD(_name, _devnr, _firstofs, _lastofs, _flags) \
-                       { _name, _devnr, _firstofs, _lastofs, _flags }
+                       { HWPAL_DEVICE_DIRECT_INIT \
+                         _name, _devnr, _firstofs, _lastofs, _flags }
 #endif
 
 static HWPALLib_DeviceAdmin_t HWPALLib_Devices[] =
@@ -189,6 +201,80 @@ HWPALLib_IsValid(
     return true;
 }
 
+
+/*----------------------------------------------------------------------------
+ * HWPALLib_SetDirect
+ *
+ * This function checks that the device can be accessed directly by
+ * Device_Read32/Write32 (see HWPAL_DEVICE_DIRECT_ACCESS) and sets its base
+ * address. This replaces the checks per access.
+ *
+ * Return Value
+ *     false   Device does not match the direct access configuration
+ *     true    Success
+ */
+#ifdef HWPAL_DEVICE_DIRECT_ACCESS
+static bool
+HWPALLib_SetDirect(
+        HWPALLib_DeviceAdmin_t * const Device_p)
+{
+    const unsigned int DeviceNr = Device_p->DeviceNr;
+    bool fSwap = false;
+    unsigned int Ofs;
+
+    if ((Device_p->FirstOfs & 3) != 0 ||
+        Device_p->LastOfs < Device_p->FirstOfs ||
+        Device_p->LastOfs >= HWPALLib_UMDevXS_Devices[DeviceNr].Size)
+    {
+        LOG_WARN(
+            "Device_Find: "
+            "Device '%s' does not fit in the mapped memory\n",
+            Device_p->DevName);
+
+        return false;
+    }
+
+#ifdef HWPAL_DEVICE_ENABLE_SWAP
+    if (Device_p->Flags & HWPAL_FLAGS_SWAP)
+        fSwap = true;
+#endif
+
+#ifdef HWPAL_DEVICE_DIRECT_SWAP
+    fSwap = !fSwap;
+#endif
+
+    if (fSwap)
+    {
+        LOG_WARN(
+            "Device_Find: "
+            "Swapping of device '%s' does not match "
+            "HWPAL_DEVICE_DIRECT_SWAP\n",
+            Device_p->DevName);
+
+        return false;
+    }
+
+    for (Ofs = Device_p->FirstOfs; Ofs <= Device_p->LastOfs; Ofs += 4)
+    {
+        if (Device_RemapDeviceAddress(Ofs) != Ofs)
+        {
+            LOG_WARN(
+                "Device_Find: "
+                "Device '%s' has remapped addresses\n",
+                Device_p->DevName);
+
+            return false;
+        }
+    }
+
+    Device_p->Base_p =
+        HWPALLib_UMDevXS_Devices[DeviceNr].Mem32_p + (Device_p->FirstOfs >> 2);
+
+    return true;
+}
+#endif /* HWPAL_DEVICE_DIRECT_ACCESS */
+
+
 /*------------------------------------------------------------------------------
  * device_mgmt API
  *
@@ -301,6 +387,13 @@ Device_Initialize(
 void
 Device_UnInitialize(void)
 {
+#ifdef HWPAL_DEVICE_DIRECT_ACCESS
+    unsigned int i;
+
+    for (i = 0; i < HWPALLIB_DEVICES_COUNT; i++)
+        HWPALLib_Devices[i].Base_p = NULL;
+#endif
+
     UMDevXSProxy_Shutdown();
 
     HWPALLib_UMDevXS_Devices[0].Mem32_p = NULL;
@@ -364,6 +457,11 @@ Device_Find(
             if (HWPALLib_UMDevXS_Devices[DeviceNr].Mem32_p == NULL)
                 return NULL;
 
+#ifdef HWPAL_DEVICE_DIRECT_ACCESS
+            if (!HWPALLib_SetDirect(HWPALLib_Devices + i))
+                return NULL;
+#endif
+
             // Return the device handle
             return (Device_Handle_t)(HWPALLib_Devices + i);
         }
@@ -386,8 +484,95 @@ Device_Find(
  * Endianess swapping is performed on the fly based on the configuration for
  * this device.
  *
+ * With HWPAL_DEVICE_DIRECT_ACCESS, the device memory is accessed via the
+ * base address that Device_Find has resolved and checked once, without
+ * checking the handle and the offset per access. The handle must have been
+ * returned by Device_Find and the offsets must be inside the device, as the
+ * EIP drivers do with their fixed register maps.
  */
 
+#ifdef HWPAL_DEVICE_DIRECT_ACCESS
+
+#ifdef HWPAL_DEVICE_DIRECT_SWAP
+#define HWPAL_DEVICE_DIRECT_VALUE(_v)  Device_SwapEndian32(_v)
+#else
+#define HWPAL_DEVICE_DIRECT_VALUE(_v)  (_v)
+#endif
+
+/*------------------------------------------------------------------------------
+ * Device_Read32
+ */
+uint32_t
+Device_Read32(
+        const Device_Handle_t Device,
+        const unsigned int ByteOffset)
+{
+    const HWPALLib_DeviceAdmin_t * const Device_p = Device;
+
+    return HWPAL_DEVICE_DIRECT_VALUE(Device_p->Base_p[ByteOffset >> 2]);
+}
+
+
+/*------------------------------------------------------------------------------
+ * Device_Write32
+ */
+void
+Device_Write32(
+        const Device_Handle_t Device,
+        const unsigned int ByteOffset,
+        const uint32_t Value)
+{
+    const HWPALLib_DeviceAdmin_t * const Device_p = Device;
+
+    Device_p->Base_p[ByteOffset >> 2] = HWPAL_DEVICE_DIRECT_VALUE(Value);
+}
+
+
+/*------------------------------------------------------------------------------
+ * Device_Read32Array
+ */
+void
+Device_Read32Array(
+        const Device_Handle_t Device,
+        const unsigned int StartByteOffset,
+        uint32_t * MemoryDst_p,
+        const int Count)
+{
+    const HWPALLib_DeviceAdmin_t * const Device_p = Device;
+    volatile uint32_t * Src_p = Device_p->Base_p + (StartByteOffset >> 2);
+    int i;
+
+    for (i = 0; i < Count; i++)
+        MemoryDst_p[i] = Src_p[i];
+
+#ifdef HWPAL_DEVICE_DIRECT_SWAP
+    // swap the words read in one pass
+    if (Count > 0)
+        Device_SwapEndian32Array(MemoryDst_p, MemoryDst_p, Count);
+#endif
+}
+
+
+/*------------------------------------------------------------------------------
+ * Device_Write32Array
+ */
+void
+Device_Write32Array(
+        const Device_Handle_t Device,
+        const unsigned int StartByteOffset,
+        const uint32_t * MemorySrc_p,
+        const int Count)
+{
+    const HWPALLib_DeviceAdmin_t * const Device_p = Device;
+    volatile uint32_t * Dst_p = Device_p->Base_p + (StartByteOffset >> 2);
+    int i;
+
+    for (i = 0; i < Count; i++)
+        Dst_p[i] = HWPAL_DEVICE_DIRECT_VALUE(MemorySrc_p[i]);
+}
+
+#else /* HWPAL_DEVICE_DIRECT_ACCESS */
+
 /*------------------------------------------------------------------------------
  * Device_Read32
  */
@@ -563,7 +748,6 @@ Device_Read32Array(
         const int Count)
 {
     HWPALLib_DeviceAdmin_t * Device_p;
-    uint32_t WordRead;
     unsigned int Idx;
     int Nwords;
 
@@ -592,26 +776,29 @@ Device_Read32Array(
     Idx = (Device_p->FirstOfs + StartByteOffset) >> 2;
     for (Nwords = 0; Nwords < Count; ++Nwords, ++Idx)
     {
-        WordRead = HWPALLib_UMDevXS_Devices[Device_p->DeviceNr].Mem32_p[Idx];
+        MemoryDst_p[Nwords] =
+                HWPALLib_UMDevXS_Devices[Device_p->DeviceNr].Mem32_p[Idx];
+    }
 
+    // swap the words read in one pass (device memory is read word by word)
 #ifdef HWPAL_DEVICE_ENABLE_SWAP
-        if (Device_p->Flags & HWPAL_FLAGS_SWAP)
-            WordRead = Device_SwapEndian32(WordRead);
+    if (Device_p->Flags & HWPAL_FLAGS_SWAP)
+        Device_SwapEndian32Array(MemoryDst_p, MemoryDst_p, Count);
 #endif
 
-        MemoryDst_p[Nwords] = WordRead;
-
 #ifdef HWPAL_TRACE_DEVICE_READ
-        if (Device_p->Flags & HWPAL_FLAGS_READ)
+    if (Device_p->Flags & HWPAL_FLAGS_READ)
+    {
+        for (Nwords = 0; Nwords < Count; ++Nwords)
         {
             Log_FormattedMessage(
                 "Device_Read32Array: rd %s@0x%08x => 0x%08x\n",
                 Device_p->DevName,
                 (Nwords << 2) + Device_p->FirstOfs,
-                WordRead);
+                MemoryDst_p[Nwords]);
         }
-#endif
     }
+#endif
 }
 
 void
@@ -622,7 +809,7 @@ Device_Write32Array(
         const int Count)
 {
     HWPALLib_DeviceAdmin_t * Device_p;
-    uint32_t WordWrite;
+    uint32_t * Dst_p;
     unsigned int Idx;
     int Nwords;
 
@@ -649,29 +836,47 @@ Device_Write32Array(
     }
 
     Idx = (Device_p->FirstOfs + StartByteOffset) >> 2;
-    for (Nwords = 0; Nwords < Count; ++Nwords, ++Idx)
-    {
-        WordWrite = MemorySrc_p[Nwords];
+    Dst_p = HWPALLib_UMDevXS_Devices[Device_p->DeviceNr].Mem32_p + Idx;
 
+    // device memory is written word by word, so only the swap decision is
+    // taken out of the loop
 #ifdef HWPAL_DEVICE_ENABLE_SWAP
-        if (Device_p->Flags & HWPAL_FLAGS_SWAP)
-            WordWrite = Device_SwapEndian32(WordWrite);
+    if (Device_p->Flags & HWPAL_FLAGS_SWAP)
+    {
+        for (Nwords = 0; Nwords < Count; ++Nwords)
+            Dst_p[Nwords] = Device_SwapEndian32(MemorySrc_p[Nwords]);
+    }
+    else
 #endif
-
-        HWPALLib_UMDevXS_Devices[Device_p->DeviceNr].Mem32_p[Idx] = WordWrite;
+    {
+        for (Nwords = 0; Nwords < Count; ++Nwords)
+            Dst_p[Nwords] = MemorySrc_p[Nwords];
+    }
 
 #ifdef HWPAL_TRACE_DEVICE_WRITE
-        if (Device_p->Flags & HWPAL_FLAGS_WRITE)
+    if (Device_p->Flags & HWPAL_FLAGS_WRITE)
+    {
+        for (Nwords = 0; Nwords < Count; ++Nwords)
         {
+            uint32_t WordWrite = MemorySrc_p[Nwords];
+
+#ifdef HWPAL_DEVICE_ENABLE_SWAP
+            if (Device_p->Flags & HWPAL_FLAGS_SWAP)
+                WordWrite = Device_SwapEndian32(WordWrite);
+#endif
+
+            // not read back: the device memory can be write-only
             Log_FormattedMessage(
                 "Device_Write32Array: wr %s@0x%08x = 0x%08x\n",
                 Device_p->DevName,
                 (Nwords << 2) + Device_p->FirstOfs,
                 WordWrite);
         }
-#endif
     }
+#endif
 }
 
+#endif /* HWPAL_DEVICE_DIRECT_ACCESS */
+
 
 /* end of file hwpal_device_umdevxs.c */
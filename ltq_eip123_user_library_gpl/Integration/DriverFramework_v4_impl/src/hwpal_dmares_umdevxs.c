@@ -50,13 +50,13 @@
 #include "c_hwpal_dmares_umdevxs.h" // get the configuration options
 
 #include "basic_defs.h"
-#include "clib.h"           // memset
+#include "clib.h"           // memset, memcpy
 
 #include "dmares_mgmt.h"    // the API to implement
 #include "dmares_buf.h"
 #include "dmares_addr.h"
 #include "dmares_rw.h"
-#include "device_swap.h"    // Device_SwapEndian32
+#include "device_swap.h"    // Device_SwapEndian32, Device_SwapEndian32Array
 
 #undef LOG_SEVERITY_MAX
 #define LOG_SEVERITY_MAX  HWPAL_LOG_SEVERITY
@@ -65,6 +65,8 @@
 #include "umdevxsproxy.h"           // UMDevXSProxy_Init
 #include "umdevxsproxy_shmem.h"
 
+#include "metrics.h"        // METRICS_*
+
 #include <pthread.h>        // pthread_mutex_*
 #include <stdlib.h>         // malloc, free
 #include <unistd.h>         // getpagesize
@@ -1059,18 +1061,23 @@ DMAResource_Read32Array(
 
     {
         uint32_t * Address_p = Pair_p->Address_p;
-        unsigned int i;
 
-        for (i = 0; i < WordCount; i++)
+        // swap endianness, if required
+        // (Values_p can be the DMA buffer itself: in-place)
+        if (Rec_p->fSwapEndianess)
         {
-            uint32_t Value = Address_p[StartWordOffset + i];
-
-            // swap endianness, if required
-            if (Rec_p->fSwapEndianess)
-                Value = Device_SwapEndian32(Value);
-
-            Values_p[i] = Value;
-        } // for
+            Device_SwapEndian32Array(
+                        Values_p,
+                        Address_p + StartWordOffset,
+                        WordCount);
+        }
+        else if (Values_p != Address_p + StartWordOffset)
+        {
+            memcpy(
+                Values_p,
+                Address_p + StartWordOffset,
+                WordCount * sizeof(uint32_t));
+        }
     }
 
 #ifdef HWPAL_TRACE_DMARESOURCE_READ
@@ -1154,18 +1161,23 @@ DMAResource_Write32Array(
 
     {
         uint32_t * Address_p = Pair_p->Address_p;
-        unsigned int i;
 
-        for (i = 0; i < WordCount; i++)
+        // swap endianness, if required
+        // (Values_p can be the DMA buffer itself: in-place)
+        if (Rec_p->fSwapEndianess)
         {
-            uint32_t Value = Values_p[i];
-
-            // swap endianness, if required
-            if (Rec_p->fSwapEndianess)
-                Value = Device_SwapEndian32(Value);
-
-            Address_p[StartWordOffset + i] = Value;
-        } // for
+            Device_SwapEndian32Array(
+                        Address_p + StartWordOffset,
+                        Values_p,
+                        WordCount);
+        }
+        else if (Values_p != Address_p + StartWordOffset)
+        {
+            memcpy(
+                Address_p + StartWordOffset,
+                Values_p,
+                WordCount * sizeof(uint32_t));
+        }
     }
 
 #ifdef HWPAL_TRACE_DMARESOURCE_WRITE
@@ -1240,8 +1252,12 @@ DMAResource_PreDMA(
         return;
     }
 
+    METRICS_INC(PreDMA);
+
     if (Rec_p->Props.fCached)
     {
+        METRICS_ADD(CacheBytes, NBytes);
+
         // Send "cache clean" request to driver via driver proxy
         UMDevXSProxy_SHMem_Commit(
                 Rec_p->DriverHandle,
@@ -1291,8 +1307,12 @@ DMAResource_PostDMA(
         return;
     }
 
+    METRICS_INC(PostDMA);
+
     if (Rec_p->Props.fCached)
     {
+        METRICS_ADD(CacheBytes, NBytes);
+
         // Send "cache invalidate" request to driver via driver proxy
         UMDevXSProxy_SHMem_Refresh(
                 Rec_p->DriverHandle,
@@ -1364,9 +1384,12 @@ DMAResource_Alloc(
             RequestedProperties.Bank,
             RequestedProperties.Alignment);
         DMAResource_DestroyRecord(Handle);
+        METRICS_INC(DMAAllocFailures);
         return -1;
     }
 
+    METRICS_INC(DMAAlloc);
+
     ActualProperties.Alignment = RequestedProperties.Alignment;
     ActualProperties.Bank = RequestedProperties.Bank;
 #ifndef HWPAL_ARCH_COHERENT
@@ -1505,6 +1528,8 @@ DMAResource_CheckAndRegister(
     Pair_p->Address_p = AddrPair.Address_p;
     Pair_p->Domain = DMARES_DOMAIN_HOST;
 
+    METRICS_INC(DMARegister);
+
     *Handle_p = Handle;
     return 0;
 }
@@ -1654,6 +1679,8 @@ DMAResource_Release(
     // free administration resources
     DMAResource_DestroyRecord(Handle);
 
+    METRICS_INC(DMARelease);
+
     return rv;
 }
 
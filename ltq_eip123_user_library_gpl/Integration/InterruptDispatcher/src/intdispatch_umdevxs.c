@@ -45,6 +45,7 @@
 #include "clib.h"                    // strcmp
 #include "device_mgmt.h"             // Device_Initialize, Device_Find
 #include "eip201.h"                  // Advanced Interrupt Controller
+#include "metrics.h"                 // METRICS_*
 
 #define ELEMENTS_COUNT(_x) (sizeof(_x) / sizeof(_x[0]))
 
@@ -295,9 +296,14 @@ IntDispatchLib_CheckAndDispatchNow(
     Sources = EIP201_SourceStatus_ReadAllEnabled(
                            IntDispatchLib_Devices[AIC_Nr]);
 
+    METRICS_INC(IntChecks);
+
     // allow early finish
     if (Sources == 0)
+    {
+        METRICS_INC(IntSpurious);
         return;         // ## RETURN ##
+    }
 
     // acknowledge these interrupts
     (void)EIP201_Acknowledge(
@@ -339,6 +345,7 @@ IntDispatchLib_CheckAndDispatchNow(
 
                 if (p->fIsHooked)
                 {
+                    METRICS_INC(IntDispatched);
                     p->CBFunc_p(p->Arg_p);
                 }
                 else
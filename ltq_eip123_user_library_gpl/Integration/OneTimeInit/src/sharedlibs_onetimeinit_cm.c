@@ -28,14 +28,45 @@
 #define LOG_SEVERITY_MAX  LOG_SEVERITY_WARN
 #include "log.h"
 
+// initialize the DMA resource layer in a separate thread, in parallel with
+// the device layer; comment-out to initialize one after the other
+#define ONETIMEINIT_PARALLEL
+
+#ifdef ONETIMEINIT_PARALLEL
+#include <pthread.h>                 // pthread_create, pthread_join
+#endif
+
 static int OneTimeInitLib_InitState = 0;
 
+
+#ifdef ONETIMEINIT_PARALLEL
+static bool OneTimeInitLib_fDMAResourceOK = false;
+
+/*----------------------------------------------------------------------------
+ * OneTimeInitLib_DMAResource_Init
+ *
+ * Thread function for DMAResource_Init.
+ */
+static void *
+OneTimeInitLib_DMAResource_Init(
+        void * Arg_p)
+{
+    IDENTIFIER_NOT_USED(Arg_p);
+
+    OneTimeInitLib_fDMAResourceOK = DMAResource_Init();
+
+    return NULL;
+}
+#endif /* ONETIMEINIT_PARALLEL */
+
 /*----------------------------------------------------------------------------
  * SharedLibs_OneTimeInit
  *
  * Initialize all shared libraries, unless this has already been done.
  * This function is not fully re-entrant nor thread-safe and should be
  * invoked by the application while it is still single-threaded.
+ * With ONETIMEINIT_PARALLEL, the DMA resource layer is initialized in a
+ * separate thread while the device layer is being initialized.
  */
 int
 SharedLibs_OneTimeInit(void)
@@ -43,11 +74,34 @@ SharedLibs_OneTimeInit(void)
     // run initialization only once
     if (OneTimeInitLib_InitState == 0)
     {
+#ifdef ONETIMEINIT_PARALLEL
+        pthread_t Thread;
+        bool fThread;
+
+        // the layers do not depend on each other
+        fThread = (pthread_create(
+                        &Thread,
+                        NULL,
+                        OneTimeInitLib_DMAResource_Init,
+                        NULL) == 0);
+
+        if (0 != Device_Initialize(NULL))
+            OneTimeInitLib_InitState |= BIT_0;
+
+        if (fThread)
+            pthread_join(Thread, NULL);
+        else
+            OneTimeInitLib_fDMAResourceOK = DMAResource_Init();
+
+        if (!OneTimeInitLib_fDMAResourceOK)
+            OneTimeInitLib_InitState |= BIT_1;
+#else
         if (0 != Device_Initialize(NULL))
             OneTimeInitLib_InitState |= BIT_0;
 
         if (!DMAResource_Init())
             OneTimeInitLib_InitState |= BIT_1;
+#endif /* ONETIMEINIT_PARALLEL */
 
         if (OneTimeInitLib_InitState == 0)
         {
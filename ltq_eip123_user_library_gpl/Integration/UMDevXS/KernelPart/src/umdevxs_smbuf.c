@@ -33,10 +33,34 @@
 #include <linux/mm.h>           // remap_pfn_range & find_vma
 #include <linux/sched.h>        // task_struct
 #include <linux/types.h>        // uintptr_t
+#include <linux/version.h>      // LINUX_VERSION_CODE, KERNEL_VERSION
 #include <asm/io.h>             // virt_to_phys
 #include <asm/current.h>        // current
 #include <asm/cacheflush.h>     // flush_cache_range
 
+// Huge page mappings use the huge_fault handler with the page_entry_size
+// argument and vmf_insert_pfn_pmd taking a vm_fault (Linux 5.8 .. 5.19).
+// Before 5.8 (vma_is_special_huge), munmap handles a huge PFN mapping like
+// a mapping of normal pages and breaks the page map counts. From 6.0,
+// hugepage_vma_check rejects VM_PFNMAP / VM_IO mappings before huge_fault
+// is called, so these would only get 4kB pages.
+#if defined(UMDEVXS_SMBUF_HUGE_PAGES) && \
+    defined(CONFIG_TRANSPARENT_HUGEPAGE) && \
+    (LINUX_VERSION_CODE >= KERNEL_VERSION(5, 8, 0)) && \
+    (LINUX_VERSION_CODE < KERNEL_VERSION(6, 0, 0))
+#define UMDEVXS_SMBUF_HUGE_MAP
+#include <linux/huge_mm.h>      // vmf_insert_pfn_pmd
+#include <linux/pfn_t.h>        // pfn_to_pfn_t
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 3, 0)
+#define UMDEVXS_SMBUF_VM_FLAGS_SET(_vma_p, _flags) \
+    vm_flags_set(_vma_p, _flags)
+#else
+#define UMDEVXS_SMBUF_VM_FLAGS_SET(_vma_p, _flags) \
+    (_vma_p)->vm_flags |= (_flags)
+#endif
+#endif
+
 
 /*----------------------------------------------------------------------------
  * DMABuf_Alloc
@@ -526,8 +550,81 @@ HWPAL_DMAResource_PostDMA(
 }
 
 
+#ifdef UMDEVXS_SMBUF_HUGE_MAP
+/*----------------------------------------------------------------------------
+ * UMDevXSLib_SMBuf_Fault
+ *
+ * Maps one page of a buffer, see UMDevXS_SMBuf_Map. vm_private_data holds
+ * the page frame number of the start of the buffer.
+ */
+static vm_fault_t
+UMDevXSLib_SMBuf_Fault(
+        struct vm_fault * vmf)
+{
+    struct vm_area_struct * vma_p = vmf->vma;
+    unsigned long Addr = vmf->address & PAGE_MASK;
+    unsigned long pfn;
+
+    pfn = (unsigned long)vma_p->vm_private_data +
+          ((Addr - vma_p->vm_start) >> PAGE_SHIFT);
+
+    return vmf_insert_pfn(vma_p, Addr, pfn);
+}
+
+
+/*----------------------------------------------------------------------------
+ * UMDevXSLib_SMBuf_HugeFault
+ *
+ * Maps PMD_SIZE bytes of a buffer with one huge page entry, when the
+ * virtual and the physical address are both aligned to PMD_SIZE and the
+ * huge page fits in the mapping. Otherwise the kernel falls back to
+ * UMDevXSLib_SMBuf_Fault.
+ */
+static vm_fault_t
+UMDevXSLib_SMBuf_HugeFault(
+        struct vm_fault * vmf,
+        enum page_entry_size pe_size)
+{
+    struct vm_area_struct * vma_p = vmf->vma;
+    unsigned long Addr = vmf->address & PMD_MASK;
+    unsigned long pfn;
+
+    if (pe_size != PE_SIZE_PMD)
+        return VM_FAULT_FALLBACK;
+
+    if (Addr < vma_p->vm_start || Addr + PMD_SIZE > vma_p->vm_end)
+        return VM_FAULT_FALLBACK;
+
+    pfn = (unsigned long)vma_p->vm_private_data +
+          ((Addr - vma_p->vm_start) >> PAGE_SHIFT);
+
+    if ((pfn & ((PMD_SIZE >> PAGE_SHIFT) - 1)) != 0)
+        return VM_FAULT_FALLBACK;
+
+    return vmf_insert_pfn_pmd(
+                vmf,
+                pfn_to_pfn_t(pfn),
+                (vmf->flags & FAULT_FLAG_WRITE) != 0);
+}
+
+
+static const struct vm_operations_struct UMDevXS_SMBuf_VmOps =
+{
+    .fault = UMDevXSLib_SMBuf_Fault,
+    .huge_fault = UMDevXSLib_SMBuf_HugeFault,
+};
+#endif /* UMDEVXS_SMBUF_HUGE_MAP */
+
+
 /*----------------------------------------------------------------------------
  * UMDevXS_SMBuf_Map
+ *
+ * With UMDEVXS_SMBUF_HUGE_PAGES, shared mappings of at least PMD_SIZE bytes
+ * are populated on demand, with huge page entries where possible. Buffers
+ * of PMD_SIZE bytes or more are aligned to PMD_SIZE by __get_dma_pages (the
+ * allocation order is at least the PMD order); the caller must align the
+ * virtual address (see UMDevXSProxyLib_Map). Transparent huge pages must be
+ * enabled ("always" or "madvise"), else the kernel uses 4kB pages.
  */
 int
 UMDevXS_SMBuf_Map(
@@ -575,6 +672,21 @@ UMDevXS_SMBuf_Map(
         if ((StartOfs & (PAGE_SIZE - 1)) != 0)
             return -4;
 
+#ifdef UMDEVXS_SMBUF_HUGE_MAP
+        if ((vma_p->vm_flags & VM_SHARED) != 0 && Length >= PMD_SIZE)
+        {
+            UMDEVXS_SMBUF_VM_FLAGS_SET(
+                    vma_p,
+                    VM_PFNMAP | VM_IO | VM_DONTEXPAND | VM_DONTDUMP |
+                    VM_HUGEPAGE);
+
+            vma_p->vm_private_data = (void *)(StartOfs >> PAGE_SHIFT);
+            vma_p->vm_ops = &UMDevXS_SMBuf_VmOps;
+
+            return 0;       // 0 = success
+        }
+#endif
+
         // map the whole physically contiguous area in one piece
         ret = remap_pfn_range(
                     vma_p,
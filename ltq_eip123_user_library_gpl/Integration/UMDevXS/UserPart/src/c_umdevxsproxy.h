@@ -37,6 +37,16 @@
 #define UMDEVXSPROXY_NODENAME "//dev//umpci_c"
 #endif
 
+// shared memory buffers are not aligned for huge pages unless configured
+#ifndef UMDEVXSPROXY_SMBUF_HUGE_PAGE_SIZE
+#define UMDEVXSPROXY_SMBUF_HUGE_PAGE_SIZE 0
+#endif
+
+#if (UMDEVXSPROXY_SMBUF_HUGE_PAGE_SIZE & \
+     (UMDEVXSPROXY_SMBUF_HUGE_PAGE_SIZE - 1)) != 0
+#error "UMDEVXSPROXY_SMBUF_HUGE_PAGE_SIZE must be 0 or a power of 2"
+#endif
+
 #endif /* INCLUDE_GUARD_C_UMDEVXSPROXY_H */
 
 /* end of file c_umdevxsproxy.h */
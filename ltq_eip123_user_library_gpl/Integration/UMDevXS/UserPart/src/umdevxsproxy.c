@@ -41,6 +41,7 @@
 #endif
 
 #include "umdevxs_cmd.h"        // the cmd/rsp structure to the kernel
+#include "metrics.h"            // METRICS_*
 
 #include <fcntl.h>              // open, O_RDWR
 #include <unistd.h>             // close, write, getpagesize
@@ -48,6 +49,8 @@
 #include <stdio.h>              // NULL
 #include <string.h>             // memset
 #include <stdint.h>             // uintptr_t
+#include <stdbool.h>            // bool
+#include <pthread.h>            // pthread_mutex_*
 
 #define ZEROINIT(_x)  memset(&_x, 0, sizeof(_x))
 #define IDENTIFIER_NOT_USED(_v) if(_v){}
@@ -56,6 +59,9 @@
 // character device file descriptor
 static int UMDevXSProxy_fd = -1;
 
+// the device and DMA resource layers can be initialized in parallel
+static pthread_mutex_t UMDevXSProxy_InitLock = PTHREAD_MUTEX_INITIALIZER;
+
 static const char UMDevXSProxy_NodeName[] = UMDEVXSPROXY_NODE_NAME;
 
 
@@ -71,6 +77,9 @@ UMDevXSProxyLib_DoCmdRsp(
         UMDevXS_CmdRsp_t * const CmdRsp_p)
 {
     int res;
+#ifdef CFG_ENABLE_METRICS
+    uint32_t StartUS;
+#endif
 
     if (CmdRsp_p == NULL)
         return -1;
@@ -80,6 +89,8 @@ UMDevXSProxyLib_DoCmdRsp(
 
     CmdRsp_p->Magic = UMDEVXS_CMDRSP_MAGIC;
 
+    METRICS_TIMESTAMP(StartUS);
+
     // write() is a blocking call
     // it takes the pointer to the CmdRsp structure
     // process it and fills it with the results
@@ -88,20 +99,72 @@ UMDevXSProxyLib_DoCmdRsp(
               CmdRsp_p,
               sizeof(UMDevXS_CmdRsp_t));
 
+    METRICS_LATENCY(KernelRequests, StartUS);
+
     if (res != sizeof(UMDevXS_CmdRsp_t))
+    {
+        METRICS_INC(KernelErrors);
         return -1;
+    }
 
     return 0;       // 0 = success
 }
 
 
+#if UMDEVXSPROXY_SMBUF_HUGE_PAGE_SIZE > 0
+/*----------------------------------------------------------------------------
+ * UMDevXSProxyLib_ReserveAligned
+ *
+ * Reserves MemorySize bytes of address space, aligned to the huge page
+ * size, so that the kernel driver can map the buffer with huge pages.
+ * Returns NULL when no address space is available.
+ */
+static void *
+UMDevXSProxyLib_ReserveAligned(
+        const unsigned int MemorySize)
+{
+    const size_t Align = UMDEVXSPROXY_SMBUF_HUGE_PAGE_SIZE;
+    uintptr_t Start, Aligned, End;
+    void * p;
+
+    p = mmap(
+            NULL,
+            (size_t)MemorySize + Align,
+            PROT_NONE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+            -1,
+            0);
+
+    if (p == MAP_FAILED)
+        return NULL;
+
+    Start = (uintptr_t)p;
+    Aligned = (Start + Align - 1) & ~(uintptr_t)(Align - 1);
+    End = Start + MemorySize + Align;
+
+    // release the unaligned head and the tail
+    if (Aligned > Start)
+        munmap(p, Aligned - Start);
+
+    if (End > Aligned + MemorySize)
+        munmap((void *)(Aligned + MemorySize), End - Aligned - MemorySize);
+
+    return (void *)Aligned;
+}
+#endif /* UMDEVXSPROXY_SMBUF_HUGE_PAGE_SIZE */
+
+
 /*----------------------------------------------------------------------------
  * UMDevXSProxyLib_Map
+ *
+ * fHugeAlign requests a virtual address aligned to the huge page size for
+ * buffers of at least that size (see UMDEVXSPROXY_SMBUF_HUGE_PAGE_SIZE).
  */
 static void *
 UMDevXSProxyLib_Map(
         const int Handle,
-        const unsigned int MemorySize)
+        const unsigned int MemorySize,
+        const bool fHugeAlign)
 {
     void * p = NULL;
 
@@ -112,25 +175,46 @@ UMDevXSProxyLib_Map(
     // fail if not talking to character device
     if (UMDevXSProxy_fd >= 0)
     {
+        void * Addr_p = NULL;
+        int Flags = MAP_SHARED;
         off_t MapOffset;
 
         // encode the Handle into the MapOffset
         MapOffset = (off_t)Handle;
         MapOffset *= getpagesize();     // mandatory
 
+#if UMDEVXSPROXY_SMBUF_HUGE_PAGE_SIZE > 0
+        if (fHugeAlign && MemorySize >= UMDEVXSPROXY_SMBUF_HUGE_PAGE_SIZE)
+        {
+            // replace the reserved address range; when nothing could be
+            // reserved, any address is used
+            Addr_p = UMDevXSProxyLib_ReserveAligned(MemorySize);
+            if (Addr_p != NULL)
+                Flags |= MAP_FIXED;
+        }
+#else
+        IDENTIFIER_NOT_USED(fHugeAlign);
+#endif
+
         // try to map the memory region
         // MAP_SHARED disable private buffering with manual sync
         p = mmap(
-                NULL,
+                Addr_p,
                 (size_t)MemorySize,
                 PROT_READ | PROT_WRITE,
-                MAP_SHARED,
+                Flags,
                 UMDevXSProxy_fd,
                 MapOffset);         // encodes the Handle
 
         // check for special error pointer
         if (p == MAP_FAILED)
+        {
+            // release the reserved address range
+            if (Addr_p != NULL)
+                munmap(Addr_p, (size_t)MemorySize);
+
             p = NULL;
+        }
     }
 
     return p;
@@ -152,7 +236,8 @@ UMDevXSProxyLib_Unmap(
 /*----------------------------------------------------------------------------
  * UMDevXSProxy_Init
  *
- * Must be called once before any of the other functions.
+ * Must be called once before any of the other functions. Can be called
+ * from several threads at the same time.
  *
  * Return Value
  *     0  Success
@@ -161,24 +246,27 @@ UMDevXSProxyLib_Unmap(
 int
 UMDevXSProxy_Init(void)
 {
-    // silently ignore bad use order
-    if (UMDevXSProxy_fd >= 0)
-        return 0;
+    int res = 0;
 
-    // try to open the character device
+    pthread_mutex_lock(&UMDevXSProxy_InitLock);
+
+    // silently ignore bad use order
+    if (UMDevXSProxy_fd < 0)
     {
         int fd;
 
+        // try to open the character device
         fd = open(UMDevXSProxy_NodeName, O_RDWR);
 
         if (fd < 0)
-            return -1;
-
-        // connected successfully
-        UMDevXSProxy_fd = fd;
+            res = -1;
+        else
+            UMDevXSProxy_fd = fd;   // connected successfully
     }
 
-    return 0;       // 0 = success
+    pthread_mutex_unlock(&UMDevXSProxy_InitLock);
+
+    return res;     // 0 = success
 }
 
 
@@ -323,7 +411,7 @@ UMDevXSProxy_Device_Map(
         const int DeviceID,
         const unsigned int DeviceMemorySize)
 {
-    return UMDevXSProxyLib_Map(DeviceID, DeviceMemorySize);
+    return UMDevXSProxyLib_Map(DeviceID, DeviceMemorySize, false);
 }
 #endif /* UMDEVXSPROXY_REMOVE_DEVICE */
 
@@ -405,7 +493,7 @@ UMDevXSProxy_SHMem_Alloc(
 
     // next, map the buffer into the memory map of the caller,
     // using PagedSize, i.e. not the actual size in CmdRsp.uint.
-    p = UMDevXSProxyLib_Map(CmdRsp.Handle, PagedSize);
+    p = UMDevXSProxyLib_Map(CmdRsp.Handle, PagedSize, true);
 
     // managed to add to address map?
     if (p == NULL)
@@ -595,7 +683,7 @@ UMDevXSProxy_SHMem_Attach(
         return -1;      // ## RETURN ##
 
     // next, map the buffer into the memory map of the caller
-    p = UMDevXSProxyLib_Map(CmdRsp.Handle, CmdRsp.uint1);
+    p = UMDevXSProxyLib_Map(CmdRsp.Handle, CmdRsp.uint1, true);
 
     // managed to add to address map?
     if (p == NULL)
@@ -29,6 +29,23 @@
 
 #include "basic_defs.h"     // uint32_t, inline
 
+// vector implementation of Device_SwapEndian32Array, unless disabled
+#ifndef DEVICE_SWAP_NO_SIMD
+#if defined(__SSSE3__)
+#include <tmmintrin.h>      // _mm_shuffle_epi8
+#define DEVICE_SWAP_SSSE3
+#elif defined(__SSE2__)
+#include <emmintrin.h>      // _mm_shufflehi_epi16, _mm_slli_epi16, etc.
+#define DEVICE_SWAP_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>       // vrev32q_u8
+#define DEVICE_SWAP_NEON
+#elif defined(__mips_msa)
+#include <msa.h>            // __msa_shf_b
+#define DEVICE_SWAP_MSA
+#endif
+#endif /* !DEVICE_SWAP_NO_SIMD */
+
 /*----------------------------------------------------------------------------
  * Device_SwapEndian32
  *
@@ -53,6 +70,65 @@ Device_SwapEndian32(
 #endif
 }
 
+
+/*----------------------------------------------------------------------------
+ * Device_SwapEndian32Array
+ *
+ * This function swaps the byte order of WordCount 32bit integers from Src_p
+ * into Dst_p, 16 bytes at a time where the CPU has vector byte shuffles.
+ * Dst_p may be equal to Src_p (swap in place), but the buffers may not
+ * overlap otherwise. No alignment is required beyond that of uint32_t.
+ */
+static inline void
+Device_SwapEndian32Array(
+        uint32_t * Dst_p,
+        const uint32_t * Src_p,
+        unsigned int WordCount)
+{
+#if defined(DEVICE_SWAP_SSSE3)
+    const __m128i Shuffle = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11,
+                                         4, 5, 6, 7, 0, 1, 2, 3);
+
+    for (; WordCount >= 4; WordCount -= 4, Src_p += 4, Dst_p += 4)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)Src_p);
+
+        _mm_storeu_si128((__m128i *)Dst_p, _mm_shuffle_epi8(v, Shuffle));
+    }
+#elif defined(DEVICE_SWAP_SSE2)
+    for (; WordCount >= 4; WordCount -= 4, Src_p += 4, Dst_p += 4)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)Src_p);
+
+        // swap the 16bit halves, then the bytes in each half
+        v = _mm_shufflelo_epi16(v, 0xB1);
+        v = _mm_shufflehi_epi16(v, 0xB1);
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+
+        _mm_storeu_si128((__m128i *)Dst_p, v);
+    }
+#elif defined(DEVICE_SWAP_NEON)
+    for (; WordCount >= 4; WordCount -= 4, Src_p += 4, Dst_p += 4)
+    {
+        uint8x16_t v = vld1q_u8((const uint8_t *)Src_p);
+
+        vst1q_u8((uint8_t *)Dst_p, vrev32q_u8(v));
+    }
+#elif defined(DEVICE_SWAP_MSA)
+    for (; WordCount >= 4; WordCount -= 4, Src_p += 4, Dst_p += 4)
+    {
+        v16i8 v = (v16i8)__msa_ld_b((const void *)Src_p, 0);
+
+        // 0x1B selects bytes 3, 2, 1, 0 of each word
+        __msa_st_b(__msa_shf_b(v, 0x1B), (void *)Dst_p, 0);
+    }
+#endif
+
+    for (; WordCount > 0; WordCount--)
+        *Dst_p++ = Device_SwapEndian32(*Src_p++);
+}
+
+
 #endif /* Include Guard */
 
 /* end of file device_swap.h */
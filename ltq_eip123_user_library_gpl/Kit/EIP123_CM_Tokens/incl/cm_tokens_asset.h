@@ -119,6 +119,8 @@ CMTokens_MakeCommand_AssetCreate(
     CommandToken_p->W[2] = Policy;
 
     CommandToken_p->W[3] = (LengthInBytes & MASK_10_BITS);
+
+    CMTokens_MakeCommand_SetLength(CommandToken_p, 4, 2);
 }
 
 
@@ -150,6 +152,8 @@ CMTokens_MakeCommand_AssetSearch(
     CommandToken_p->W[3] = (MASK_6_BITS & Index) << 16;
 
     CommandToken_p->W[3] |= BIT_15;  // search
+
+    CMTokens_MakeCommand_SetLength(CommandToken_p, 4, 3);
 }
 
 
@@ -183,6 +187,8 @@ CMTokens_MakeCommand_AssetDelete(
                            (3 << 28);   // Subcode = 3 = Asset Delete
 
     CommandToken_p->W[2] = AssetRef;
+
+    CMTokens_MakeCommand_SetLength(CommandToken_p, 3, 1);
 }
 
 
@@ -209,6 +215,8 @@ CMTokens_MakeCommand_AssetLoad_Derive(
     CommandToken_p->W[3] = BIT_24;      // Derive
 
     CommandToken_p->W[7] = KdkAssetRef;
+
+    CMTokens_MakeCommand_SetLength(CommandToken_p, 8, 1);
 }
 
 
@@ -231,6 +239,8 @@ CMTokens_MakeCommand_AssetLoad_Random(
     CommandToken_p->W[2] = TargetAssetRef;
 
     CommandToken_p->W[3] = BIT_25;      // Random
+
+    CMTokens_MakeCommand_SetLength(CommandToken_p, 4, 1);
 }
 
 
@@ -257,6 +267,8 @@ CMTokens_MakeCommand_AssetLoad_Import(
     CommandToken_p->W[3] |= BIT_26;     // Unwrap
 
     CommandToken_p->W[7] = KekAssetRef;
+
+    CMTokens_MakeCommand_SetLength(CommandToken_p, 8, 1);
 }
 
 
@@ -280,6 +292,8 @@ CMTokens_MakeCommand_AssetLoad_Plaintext(
 
     CommandToken_p->W[3] = (PlaintextLengthInBytes & MASK_10_BITS);
     CommandToken_p->W[3] |= BIT_27;     // Plaintext
+
+    CMTokens_MakeCommand_SetLength(CommandToken_p, 4, 1);
 }
 
 
@@ -304,6 +318,8 @@ CMTokens_MakeCommand_AssetLoad_AesUnwrap(
     CommandToken_p->W[3] |= BIT_28;     // Unwrap
 
     CommandToken_p->W[7] = KekAssetRef;
+
+    CMTokens_MakeCommand_SetLength(CommandToken_p, 8, 1);
 }
 
 
@@ -369,6 +385,8 @@ CMTokens_MakeCommand_AssetLoad_Export(
     CommandToken_p->W[3] |= BIT_31;      // KeyBlob
 
     CommandToken_p->W[7] = KekAssetRef;
+
+    CMTokens_MakeCommand_ExtendLength(CommandToken_p, 8, 2);
 }
 
 
@@ -455,6 +473,8 @@ CMTokens_MakeCommand_InsertAppID(
     AADLen += AdditionalDataSizeInBytes;
     CommandToken_p->W[3] &= ~(MASK_8_BITS << 16);
     CommandToken_p->W[3] |= (AADLen << 16);
+
+    CMTokens_MakeCommand_ExtendLength(CommandToken_p, 8 + (AADLen + 3) / 4, 1);
 }
 
 
@@ -52,6 +52,8 @@ CMTokens_Command_AUnlock_Start(
     CommandToken_p->W[0] = (8 << 24) | (0 << 28);
     CommandToken_p->W[2] = StateAssetID;
     CommandToken_p->W[3] = KeyAssetID;
+
+    CMTokens_MakeCommand_SetLength(CommandToken_p, 4, 6);
 }
 
 
@@ -106,6 +108,8 @@ CMTokens_Command_AUnlock_Verify(
     CommandToken_p->W[3] = (DataLengthInBytes & MASK_10_BITS);
 
     CMTokens_MakeCommand_ReadByteArray(NonceData_p, 16, CommandToken_p, 6);
+
+    CMTokens_MakeCommand_SetLength(CommandToken_p, 10, 1);
 }
 
 
@@ -142,6 +146,8 @@ CMTokens_Command_SetSecureDebug(
     CommandToken_p->W[0] = (8 << 24) | (2 << 28);
     CommandToken_p->W[2] = StateAssetID;
     CommandToken_p->W[3] = Set ? BIT_31 : 0;
+
+    CMTokens_MakeCommand_SetLength(CommandToken_p, 4, 1);
 }
 
 
@@ -38,6 +38,13 @@
 typedef struct
 {
     uint32_t W[CMTOKENS_COMMAND_WORDS];
+
+    // Effective length: number of words (from W[0]) used by the CM and number
+    // of result token words used by the CMTokens_ParseResponse_* functions
+    // for this command. Maintained by the CMTokens_MakeCommand_* functions;
+    // only these words are moved through the mailbox.
+    unsigned int WordCount;
+    unsigned int ResponseWordCount;
 } CMTokens_Command_t;
 
 typedef struct
@@ -60,6 +67,53 @@ CMTokens_MakeToken_Clear(
 
     for (i = 0; i < CMTOKENS_COMMAND_WORDS; i++)
         CommandToken_p->W[i] = 0xAAAAAAAA;
+
+    CommandToken_p->WordCount = CMTOKENS_COMMAND_WORDS;
+    CommandToken_p->ResponseWordCount = CMTOKENS_RESPONSE_WORDS;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CMTokens_MakeCommand_SetLength
+ *
+ * This function sets the effective length of the command token and of the
+ * expected response token. It is used by the functions that set the opcode;
+ * the optional parts of a token use CMTokens_MakeCommand_ExtendLength.
+ *
+ * Internal helper function - not to be used directly due to knowledge of
+ * token word offsets.
+ */
+static inline void
+CMTokens_MakeCommand_SetLength(
+        CMTokens_Command_t * const CommandToken_p,
+        const unsigned int WordCount,
+        const unsigned int ResponseWordCount)
+{
+    CommandToken_p->WordCount = WordCount;
+    CommandToken_p->ResponseWordCount = ResponseWordCount;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CMTokens_MakeCommand_ExtendLength
+ *
+ * This function extends the effective length of the command token and of the
+ * expected response token to at least the given number of words.
+ *
+ * Internal helper function - not to be used directly due to knowledge of
+ * token word offsets.
+ */
+static inline void
+CMTokens_MakeCommand_ExtendLength(
+        CMTokens_Command_t * const CommandToken_p,
+        const unsigned int WordCount,
+        const unsigned int ResponseWordCount)
+{
+    if (CommandToken_p->WordCount < WordCount)
+        CommandToken_p->WordCount = WordCount;
+
+    if (CommandToken_p->ResponseWordCount < ResponseWordCount)
+        CommandToken_p->ResponseWordCount = ResponseWordCount;
 }
 
 
@@ -74,6 +128,8 @@ CMTokens_MakeToken_Identity(
         uint32_t Identity)
 {
     CommandToken_p->W[1] = Identity;
+
+    CMTokens_MakeCommand_ExtendLength(CommandToken_p, 2, 1);
 }
 
 
@@ -64,6 +64,8 @@ CMTokens_MakeCommand_C2KeyDeriveCommon(
                             InputLenInBytes,
                             CommandToken_p,
                             /*StartWord:*/6);
+
+    CMTokens_MakeCommand_SetLength(CommandToken_p, 6 + (InputLenInBytes + 3) / 4, CMTOKENS_RESPONSE_WORDS);
 }
 
 
@@ -128,6 +130,8 @@ CMTokens_MakeCommand_C2KeyInfo(
                            (1 << 28);    // Subcode = 1 = C2 Key Asset Information
 
     CommandToken_p->W[2] = DeviceKeyAssetRef;
+
+    CMTokens_MakeCommand_SetLength(CommandToken_p, 3, 2);
 }
 
 
@@ -76,6 +76,8 @@ CMTokens_MakeCommand_Crypto_AES(
         CommandToken_p->W[10] |= BIT_15;
 
     CommandToken_p->W[10] |= (MASK_4_BITS & Mode) << 4;
+
+    CMTokens_MakeCommand_SetLength(CommandToken_p, 11, 6);
 }
 
 
@@ -119,6 +121,8 @@ CMTokens_MakeCommand_Crypto_3DES(
 
     CommandToken_p->W[10] |= (MASK_1_BIT & Mode) << 4;
 
+
+    CMTokens_MakeCommand_SetLength(CommandToken_p, 11, 6);
 }
 #endif /* !CMTOKENS_REMOVE_CRYPTO_3DES */
 
@@ -150,6 +154,8 @@ CMTokens_MakeCommand_Crypto_ARC4(
     // no mode: we always use stateful-to-stateful
 
     CommandToken_p->W[12] = (j << 8) | i;
+
+    CMTokens_MakeCommand_SetLength(CommandToken_p, 13, 2);
 }
 #endif /* !CMTOKENS_REMOVE_CRYPTO_ARC4 */
 
@@ -217,6 +223,8 @@ CMTokens_MakeCommand_Crypto_CAMELLIA(
         CommandToken_p->W[10] |= BIT_15;
 
     CommandToken_p->W[10] |= (MASK_4_BITS & Mode) << 4;
+
+    CMTokens_MakeCommand_SetLength(CommandToken_p, 11, 6);
 }
 #endif /* !CMTOKENS_REMOVE_CRYPTO_CAMELLIA */
 
@@ -253,6 +261,8 @@ CMTokens_MakeCommand_Crypto_C2(
 
     CommandToken_p->W[10] |= (MASK_2_BITS & Mode) << 4;
     // W[10][19:16] (encoded KeyLength) is ignored for C2
+
+    CMTokens_MakeCommand_SetLength(CommandToken_p, 11, 6);
 }
 #endif /* !CMTOKENS_REMOVE_CRYPTO_C2 */
 
@@ -290,10 +300,27 @@ CMTokens_MakeCommand_Crypto_MULTI2(
 
     CommandToken_p->W[10] |= (MASK_4_BITS & Mode) << 4;
     // W[10][19:16] (encoded KeyLength) is ignored for MULTI2
+
+    CMTokens_MakeCommand_SetLength(CommandToken_p, 11, 6);
 }
 #endif /* !CMTOKENS_REMOVE_CRYPTO_MULTI2 */
 
 
+/*----------------------------------------------------------------------------
+ * CMTokens_MakeCommand_Crypto_SetDataLength
+ *
+ * This function replaces the number of bytes to process, for example in a
+ * token started from a template (see cm_tokens_template.h).
+ */
+static inline void
+CMTokens_MakeCommand_Crypto_SetDataLength(
+        CMTokens_Command_t * const CommandToken_p,
+        const uint32_t DataLengthInBytes)
+{
+    CommandToken_p->W[2] = DataLengthInBytes;
+}
+
+
 /*----------------------------------------------------------------------------
  * CMTokens_MakeCommand_Crypto_SetASLoadKey
  *
@@ -307,6 +334,8 @@ CMTokens_MakeCommand_Crypto_SetASLoadKey(
 {
     CommandToken_p->W[10] |= BIT_8;
     CommandToken_p->W[16] = AssetRef;
+
+    CMTokens_MakeCommand_ExtendLength(CommandToken_p, 17, 1);
 }
 
 
@@ -323,6 +352,8 @@ CMTokens_MakeCommand_Crypto_SetASLoadIV(
 {
     CommandToken_p->W[10] |= BIT_9;
     CommandToken_p->W[12] = AssetRef;
+
+    CMTokens_MakeCommand_ExtendLength(CommandToken_p, 13, 1);
 }
 
 
@@ -339,6 +370,8 @@ CMTokens_MakeCommand_Crypto_SetASSaveIV(
 {
     CommandToken_p->W[10] |= BIT_12;
     CommandToken_p->W[11] = AssetRef;
+
+    CMTokens_MakeCommand_ExtendLength(CommandToken_p, 12, 1);
 }
 
 
@@ -382,6 +415,8 @@ CMTokens_MakeCommand_Crypto_Copyf8SaltKey(
                             KeyLengthInBytes,
                             CommandToken_p,
                             /*StartWord:*/28);
+
+    CMTokens_MakeCommand_ExtendLength(CommandToken_p, 0, 10);
 }
 #endif /* !CMTOKENS_REMOVE_CRYPTO_AES_F8 */
 
@@ -422,6 +457,8 @@ CMTokens_MakeCommand_Crypto_Copyf8IV(
                             16,
                             CommandToken_p,
                             /*StartWord:*/24);
+
+    CMTokens_MakeCommand_ExtendLength(CommandToken_p, 0, 10);
 }
 #endif /* !CMTOKENS_REMOVE_CRYPTO_AES_F8 */
 
@@ -443,6 +480,8 @@ CMTokens_MakeCommand_Crypto_Copyf8Keystream(
                             16,
                             CommandToken_p,
                             /*StartWord:*/32);
+
+    CMTokens_MakeCommand_ExtendLength(CommandToken_p, 0, 10);
 }
 #endif /* !CMTOKENS_REMOVE_CRYPTO_AES_F8 */
 
@@ -533,6 +572,8 @@ CMTokens_MakeCommand_Crypto_WriteStateDescriptor(
         const uint32_t ARC4State_Addr)
 {
     CommandToken_p->W[9] = ARC4State_Addr;
+
+    CMTokens_MakeCommand_ExtendLength(CommandToken_p, 10, 1);
 }
 #endif /* !CMTOKENS_REMOVE_CRYPTO_ARC4 */
 
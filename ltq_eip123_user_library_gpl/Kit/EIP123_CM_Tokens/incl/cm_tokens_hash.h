@@ -78,6 +78,8 @@ CMTokens_MakeCommand_Hash_SetLengthAlgoMode(
 
     if (!fFinalize)
         CommandToken_p->W[6] |= BIT_5;
+
+    CMTokens_MakeCommand_SetLength(CommandToken_p, 7, 10);
 }
 
 
@@ -96,6 +98,8 @@ CMTokens_MakeCommand_Hash_SetTotalMessageLength(
 {
     CommandToken_p->W[16] = TotalMessageLength_LSW;
     CommandToken_p->W[17] = TotalMessageLength_MSW;
+
+    CMTokens_MakeCommand_ExtendLength(CommandToken_p, 18, 1);
 }
 
 
@@ -82,6 +82,8 @@ CMTokens_MakeCommand_Mac_SetLengthAlgoMode(
 
     if (!fFinalize)
         CommandToken_p->W[6] |= BIT_5;
+
+    CMTokens_MakeCommand_SetLength(CommandToken_p, 7, 10);
 }
 
 
@@ -100,6 +102,8 @@ CMTokens_MakeCommand_Mac_SetTotalMessageLength(
 {
     CommandToken_p->W[16] = TotalMessageLength_LSW;
     CommandToken_p->W[17] = TotalMessageLength_MSW;
+
+    CMTokens_MakeCommand_ExtendLength(CommandToken_p, 18, 1);
 }
 
 
@@ -118,6 +122,8 @@ CMTokens_MakeCommand_Mac_SetASLoadKey(
     CommandToken_p->W[6] |= ((MASK_7_BITS & KeyLengthInBytes) << 16);
     CommandToken_p->W[6] |= BIT_8;
     CommandToken_p->W[18] = AssetRef;
+
+    CMTokens_MakeCommand_ExtendLength(CommandToken_p, 19, 1);
 }
 
 
@@ -134,6 +140,8 @@ CMTokens_MakeCommand_Mac_SetASLoadDigest(
 {
     CommandToken_p->W[8] = AssetRef;
     CommandToken_p->W[6] |= BIT_9;
+
+    CMTokens_MakeCommand_ExtendLength(CommandToken_p, 9, 1);
 }
 
 
@@ -150,6 +158,8 @@ CMTokens_MakeCommand_Mac_SetASSaveDigest(
 {
     CommandToken_p->W[7] = AssetRef;
     CommandToken_p->W[6] |= BIT_12;
+
+    CMTokens_MakeCommand_ExtendLength(CommandToken_p, 8, 1);
 }
 
 
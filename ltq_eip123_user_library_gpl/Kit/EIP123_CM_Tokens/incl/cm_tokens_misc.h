@@ -58,6 +58,8 @@ CMTokens_MakeCommand_RegisterWrite(
 
     // Word 5: Data to write
     CommandToken_p->W[5] = Value;
+
+    CMTokens_MakeCommand_SetLength(CommandToken_p, 6, 1);
 }
 
 
@@ -80,6 +82,8 @@ CMTokens_MakeCommand_NVM_Read(
 
     CommandToken_p->W[2] = AssetID;
     CommandToken_p->W[3] = DataLength;
+
+    CMTokens_MakeCommand_SetLength(CommandToken_p, 4, 2);
 }
 
 
@@ -133,6 +137,8 @@ CMTokens_MakeCommand_Multi2Config(
                                 CommandToken_p,
                                 /*StartWord:*/4);
     }
+
+    CMTokens_MakeCommand_SetLength(CommandToken_p, (SystemKey_p != NULL) ? 12 : 4, 1);
 }
 
 #endif /* Include Guard */
@@ -45,6 +45,8 @@ CMTokens_MakeCommand_Nop(
 {
     CommandToken_p->W[0] = 0;   // Opcode = 0 = Nop
     CommandToken_p->W[2] = DataLength;
+
+    CMTokens_MakeCommand_SetLength(CommandToken_p, 3, 1);
 }
 
 
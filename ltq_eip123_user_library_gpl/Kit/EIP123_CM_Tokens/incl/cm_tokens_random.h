@@ -67,6 +67,8 @@ CMTokens_MakeCommand_TRNG_Configure(
             (TrngConfig.MaxRefillTime << 16) |
             (TrngConfig.SampleDiv << 8) |
             TrngConfig.MinRefillTime;
+
+    CMTokens_MakeCommand_SetLength(CommandToken_p, 4, 1);
 }
 
 
@@ -96,6 +98,8 @@ CMTokens_MakeCommand_RandomNumber_Generate(
             (0 << 28);              // Subcode = 0
 
     CommandToken_p->W[2] = NumberLengthInBytes;
+
+    CMTokens_MakeCommand_SetLength(CommandToken_p, 3, 1);
 }
 
 
@@ -163,6 +167,8 @@ CMTokens_MakeCommand_PRNG_ReseedNow(
             (1 << 28);              // Subcode = 1
 
     CommandToken_p->W[2] = BIT_1;   // RRD = Reseed post-processor
+
+    CMTokens_MakeCommand_SetLength(CommandToken_p, 3, 1);
 }
 
 
@@ -203,6 +209,8 @@ CMTokens_MakeCommand_PRNG_PP_Test(
 
     CMTokens_MakeCommand_ReadByteArray(
             TestDataBytes_p, 16, CommandToken_p, 14);
+
+    CMTokens_MakeCommand_SetLength(CommandToken_p, 18, 6);
 }
 
 
@@ -266,6 +274,8 @@ CMTokens_MakeCommand_TRNG_HW_SelfTest(
             (3 << 28);              // Subcode = 3
 
     CommandToken_p->W[2] = TestDataLengthInBytes;
+
+    CMTokens_MakeCommand_SetLength(CommandToken_p, 3, 1);
 }
 
 
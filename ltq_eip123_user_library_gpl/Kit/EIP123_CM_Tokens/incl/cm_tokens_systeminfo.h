@@ -86,6 +86,8 @@ CMTokens_MakeCommand_ReadSystemInfo(
     CommandToken_p->W[0] =
             (15 << 24) |        // Opcode
             (0 << 28);          // Subcode
+
+    CMTokens_MakeCommand_SetLength(CommandToken_p, 2, 6);
 }
 
 
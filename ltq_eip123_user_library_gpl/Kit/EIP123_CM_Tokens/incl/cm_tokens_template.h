@@ -0,0 +1,98 @@
+/* cm_tokens_template.h
+ *
+ * Crypto Module Tokens Parser/Generator - Token Templates
+ *
+ * A template is a command token that was filled once with the fields that
+ * do not change between operations with the same algorithm, key and mode.
+ * Each operation starts from a copy of the template and only sets the
+ * fields that change per operation (data length, IV, descriptors, TokenID)
+ * with the regular CMTokens_MakeCommand_* functions.
+ */
+
+/*****************************************************************************
+* Copyright (c) 2010-2013 INSIDE Secure B.V. All Rights Reserved.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 2 of the License, or
+* any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef INCLUDE_GUARD_CM_TOKENS_TEMPLATE_H
+#define INCLUDE_GUARD_CM_TOKENS_TEMPLATE_H
+
+#include "basic_defs.h"         // uint32_t, bool, inline, etc.
+#include "cm_tokens_common.h"   // CMTokens_Command_t
+
+typedef struct
+{
+    CMTokens_Command_t Token;
+} CMTokens_Template_t;
+
+
+/*----------------------------------------------------------------------------
+ * CMTokens_Template_Compile
+ *
+ * This function stores a command token as template. Only the effective
+ * length of the token (WordCount) is kept. The TokenID field is cleared;
+ * it must be set for each operation.
+ *
+ * The token must not contain any per-operation fields yet, because these
+ * are not necessarily overwritten for the next operation. For example: the
+ * Asset Store IV flags of a Crypto token are only set when used.
+ */
+static inline void
+CMTokens_Template_Compile(
+        CMTokens_Template_t * const Template_p,
+        const CMTokens_Command_t * const CommandToken_p)
+{
+    unsigned int WordCount = CommandToken_p->WordCount;
+    unsigned int i;
+
+    if (WordCount == 0 || WordCount > CMTOKENS_COMMAND_WORDS)
+        WordCount = CMTOKENS_COMMAND_WORDS;
+
+    for (i = 0; i < WordCount; i++)
+        Template_p->Token.W[i] = CommandToken_p->W[i];
+
+    // TokenID and Write Token ID (see CMTokens_MakeCommand_SetTokenID)
+    Template_p->Token.W[0] &= ((MASK_16_BITS << 16) - BIT_18);
+
+    Template_p->Token.WordCount = WordCount;
+    Template_p->Token.ResponseWordCount = CommandToken_p->ResponseWordCount;
+}
+
+
+/*----------------------------------------------------------------------------
+ * CMTokens_Template_Instantiate
+ *
+ * This function starts a command token from a template. Words beyond the
+ * effective length of the template are not touched.
+ */
+static inline void
+CMTokens_Template_Instantiate(
+        CMTokens_Command_t * const CommandToken_p,
+        const CMTokens_Template_t * const Template_p)
+{
+    const unsigned int WordCount = Template_p->Token.WordCount;
+    unsigned int i;
+
+    for (i = 0; i < WordCount; i++)
+        CommandToken_p->W[i] = Template_p->Token.W[i];
+
+    CommandToken_p->WordCount = WordCount;
+    CommandToken_p->ResponseWordCount = Template_p->Token.ResponseWordCount;
+}
+
+
+#endif /* Include Guard */
+
+/* end of file cm_tokens_template.h */
@@ -55,6 +55,8 @@ CMTokens_MakeCommand_WrapUnwrap(
         CommandToken_p->W[5] = BIT_15;
     else
         CommandToken_p->W[5] = 0;
+
+    CMTokens_MakeCommand_SetLength(CommandToken_p, 6, 2);
 }
 
 
@@ -103,6 +105,8 @@ CMTokens_MakeCommand_WrapUnwrap_SetASLoadKey(
 {
     CommandToken_p->W[5] |= BIT_8;
     CommandToken_p->W[6] = AssetRef;
+
+    CMTokens_MakeCommand_ExtendLength(CommandToken_p, 7, 2);
 }
 
 
@@ -58,11 +58,13 @@ CMTokens_MakeCommand_ReadByteArray(
         W |= (*Source_p++) << 24;
 
         if (StartWord >= CMTOKENS_COMMAND_WORDS)
-            return;
+            break;
 
         CommandToken_p->W[StartWord++] = W;
 
     } // while
+
+    CMTokens_MakeCommand_ExtendLength(CommandToken_p, StartWord, 1);
 }
 
 
@@ -149,6 +151,11 @@ CMTokens_MakeCommand_WriteInDescriptor(
     // Write InputGatherAddress
     if (WordWriteCount > 2)
         CommandToken_p->W[StartWord + 2] = lli;
+
+    CMTokens_MakeCommand_ExtendLength(
+                CommandToken_p,
+                StartWord + WordWriteCount,
+                1);
 }
 
 
@@ -181,6 +188,11 @@ CMTokens_MakeCommand_WriteOutDescriptor(
     // Write OutputScatterAddress
     if (WordWriteCount > 2)
         CommandToken_p->W[StartWord + 2] = lli;
+
+    CMTokens_MakeCommand_ExtendLength(
+                CommandToken_p,
+                StartWord + WordWriteCount,
+                1);
 }
 
 
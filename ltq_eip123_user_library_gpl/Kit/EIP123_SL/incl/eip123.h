@@ -137,6 +137,18 @@ EIP123_Unlink(
         const uint8_t MailboxNr);
 
 
+/*----------------------------------------------------------------------------
+ * EIP123_IsLinked
+ *
+ * This function returns 'true' when the mailbox is linked. A mailbox stays
+ * linked until it is unlinked or the EIP-123 is reset.
+ */
+bool
+EIP123_IsLinked(
+        Device_Handle_t Device,
+        const uint8_t MailboxNr);
+
+
 /*----------------------------------------------------------------------------
  * CanReadToken/CanWriteToken
  *
@@ -162,7 +174,8 @@ EIP123_CanReadToken(
  *
  * This function writes the token to the IN mailbox and then hands off the
  * mailbox to the CM to start processing the token. The request fails when the
- * mailbox is full or not linked to thist host.
+ * mailbox is full or not linked to thist host. Only the effective length of
+ * the token (CommandToken_p->WordCount) is written.
  *
  * Device
  *     The Driver Framework Device Handle for the EIP-123.
@@ -201,8 +214,13 @@ EIP123_WriteAndSubmitToken(
  *     The mailbox number to write this token to (1..4).
  *     The mailbox must be linked to this host.
  *
- * CommandToken_p
- *     Pointer to the command token buffer this function will write to.
+ * ResponseToken_p
+ *     Pointer to the response token buffer this function will write to.
+ *
+ * WordCount
+ *     Number of words to read (0 = all), typically the ResponseWordCount of
+ *     the command token. Only word 0 is read when it reports an error.
+ *     The other words of ResponseToken_p are not written.
  *
  * Return Value
  *     0    Success
@@ -213,7 +231,8 @@ int
 EIP123_ReadToken(
         Device_Handle_t Device,
         const uint8_t MailboxNr,
-        CMTokens_Response_t * const ResponseToken_p);
+        CMTokens_Response_t * const ResponseToken_p,
+        const unsigned int WordCount);
 
 #endif /* Include Guard */
 
@@ -26,7 +26,10 @@
  * Defines that can be used in the cs_xxx.h file
  */
 
-/* currently none */
+// EIP123_MAILBOX_FULL_TOKENS
+// When defined, all CMTOKENS_COMMAND_WORDS / CMTOKENS_RESPONSE_WORDS words
+// of a token are copied through the mailbox, instead of only the effective
+// length set by the CMTokens_MakeCommand_* functions.
 
 
 /*----------------------------------------------------------------
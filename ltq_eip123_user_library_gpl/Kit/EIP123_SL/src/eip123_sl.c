@@ -215,6 +215,26 @@ EIP123_Unlink(
 #endif /* !EIP123_REMOVE_UNLINK */
 
 
+/*----------------------------------------------------------------------------
+ * EIP123_IsLinked
+ */
+bool
+EIP123_IsLinked(
+        Device_Handle_t Device,
+        const uint8_t MailboxNr)
+{
+    uint32_t MailboxBit = BIT_2 << ((MailboxNr - 1) * 4);
+    uint32_t Status;
+
+    Status = EIP123Lib_ReadReg_MailboxStat(Device);
+
+    if ((Status & MailboxBit) != 0)
+        return true;
+
+    return false;
+}
+
+
 /*----------------------------------------------------------------------------
  * EIP123_CanWriteToken
  *
@@ -278,16 +298,23 @@ EIP123_WriteAndSubmitToken(
         return -2;
 
     // copy the token to the IN mailbox
+    // only the words used by the CM
     {
         unsigned int MailboxAddr = EIP123_MAILBOX_IN_BASE;
+        unsigned int WordCount = CommandToken_p->WordCount;
 
         MailboxAddr += EIP123_MAILBOX_SPACING_BYTES * (MailboxNr - 1);
 
+#ifndef EIP123_MAILBOX_FULL_TOKENS
+        if (WordCount == 0 || WordCount > CMTOKENS_COMMAND_WORDS)
+#endif
+            WordCount = CMTOKENS_COMMAND_WORDS;
+
         Device_Write32Array(
                     Device,
                     MailboxAddr,
                     CommandToken_p->W,
-                    CMTOKENS_COMMAND_WORDS);
+                    WordCount);
     }
 
     // hand over the IN mailbox (containing the token) to the CM
@@ -308,7 +335,8 @@ int
 EIP123_ReadToken(
         Device_Handle_t Device,
         const uint8_t MailboxNr,
-        CMTokens_Response_t * const ResponseToken_p)
+        CMTokens_Response_t * const ResponseToken_p,
+        const unsigned int WordCount)
 {
 #ifdef EIP123_STRICT_ARGS
     if (ResponseToken_p == NULL)
@@ -319,16 +347,33 @@ EIP123_ReadToken(
         return -2;
 
     // copy the token from the OUT mailbox
+    // first word 0, then the other words only when the token has no error
     {
         unsigned int MailboxAddr = EIP123_MAILBOX_IN_BASE;
+        unsigned int ReadCount = WordCount;
 
         MailboxAddr += EIP123_MAILBOX_SPACING_BYTES * (MailboxNr - 1);
 
-        Device_Read32Array(
-                    Device,
-                    MailboxAddr,
-                    ResponseToken_p->W,
-                    CMTOKENS_RESPONSE_WORDS);
+#ifndef EIP123_MAILBOX_FULL_TOKENS
+        if (ReadCount == 0 || ReadCount > CMTOKENS_RESPONSE_WORDS)
+#endif
+            ReadCount = CMTOKENS_RESPONSE_WORDS;
+
+        ResponseToken_p->W[0] = Device_Read32(Device, MailboxAddr);
+
+#ifndef EIP123_MAILBOX_FULL_TOKENS
+        if (ResponseToken_p->W[0] & BIT_31)
+            ReadCount = 1;
+#endif
+
+        if (ReadCount > 1)
+        {
+            Device_Read32Array(
+                        Device,
+                        MailboxAddr + 4,
+                        ResponseToken_p->W + 1,
+                        ReadCount - 1);
+        }
     }
 
     // hand back the OUT mailbox to the CM
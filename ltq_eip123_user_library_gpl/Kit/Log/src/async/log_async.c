@@ -0,0 +1,603 @@
+/* log_async.c
+ *
+ * Log implementation with per-thread rings drained by a background thread.
+ *
+ * Each logging thread owns a single-producer single-consumer ring of
+ * formatted records; the drain thread is the only consumer of all rings.
+ * The producer never takes a lock, except once per thread to obtain its
+ * ring. Rings of exited threads are reused by new threads.
+ */
+
+/*****************************************************************************
+* Copyright (c) 2008-2013 INSIDE Secure B.V. All Rights Reserved.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 2 of the License, or
+* any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#define LOG_SEVERITY_MAX  LOG_SEVERITY_NO_OUTPUT
+
+#include "log.h"            // the API to implement
+
+#include <stdarg.h>
+#include <stdlib.h>         // calloc, atexit
+#include <string.h>         // memset, strrchr
+#include <pthread.h>        // pthread_*, pthread_atfork
+#include <time.h>           // clock_gettime, nanosleep
+
+#if (LOG_ASYNC_RING_RECORDS & (LOG_ASYNC_RING_RECORDS - 1)) != 0
+#error "LOG_ASYNC_RING_RECORDS must be a power of 2"
+#endif
+
+#if (LOG_ASYNC_SITES & (LOG_ASYNC_SITES - 1)) != 0
+#error "LOG_ASYNC_SITES must be a power of 2"
+#endif
+
+// keeps the indices of the producer and the consumer in different lines
+#define LOG_ASYNC_CACHE_LINE  64
+
+typedef struct
+{
+    const char * File_p;        // NULL = unused
+    int Line;
+    int Severity;
+    uint32_t WindowStart;       // ms
+    uint32_t Count;             // messages accepted in this window
+    uint32_t Suppressed;        // messages discarded in this window
+}
+LogAsync_Site_t;
+
+typedef struct LogAsync_Ring
+{
+    // written by the owning thread only
+    uint32_t Head;
+    uint8_t Pad1[LOG_ASYNC_CACHE_LINE - sizeof(uint32_t)];
+
+    // written by the drain only
+    uint32_t Tail;
+    uint8_t Pad2[LOG_ASYNC_CACHE_LINE - sizeof(uint32_t)];
+
+    int Orphaned;                       // owning thread has exited
+    struct LogAsync_Ring * Next_p;      // set once, before publication
+
+    LogAsync_Site_t Sites[LOG_ASYNC_SITES];
+    char Records[LOG_ASYNC_RING_RECORDS][LOG_ASYNC_RECORD_SIZE];
+}
+LogAsync_Ring_t;
+
+static const char * const LogAsync_SeverityNames[] =
+{
+    "LF_LOG", "LF_LOG_INFO", "LF_LOG_WARN", "LF_LOG_CRIT"
+};
+
+static pthread_once_t LogAsync_Once = PTHREAD_ONCE_INIT;
+static pthread_key_t LogAsync_Key;
+static int LogAsync_KeyValid;
+static int LogAsync_DrainStarted;
+static int LogAsync_DrainRestart;       // set in a child process after fork
+
+// list of all rings; only grows
+static LogAsync_Ring_t * LogAsync_Rings_p;
+static pthread_mutex_t LogAsync_RegisterLock = PTHREAD_MUTEX_INITIALIZER;
+
+// serializes the consumers (drain thread, Log_Async_Flush)
+static pthread_mutex_t LogAsync_DrainLock = PTHREAD_MUTEX_INITIALIZER;
+static FILE * LogAsync_Output_p;
+
+static uint32_t LogAsync_Written;
+static uint32_t LogAsync_Dropped;
+static uint32_t LogAsync_Suppressed;
+
+
+/*----------------------------------------------------------------------------
+ * LogAsyncLib_NowMS
+ */
+static uint32_t
+LogAsyncLib_NowMS(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint32_t)ts.tv_sec * 1000 + (uint32_t)(ts.tv_nsec / 1000000);
+}
+
+
+/*----------------------------------------------------------------------------
+ * LogAsyncLib_DrainAll
+ *
+ * Writes out all records in all rings. Caller must hold LogAsync_DrainLock.
+ */
+static void
+LogAsyncLib_DrainAll(void)
+{
+    FILE * Output_p = LogAsync_Output_p ? LogAsync_Output_p : stdout;
+    LogAsync_Ring_t * Ring_p;
+    uint32_t Written = 0;
+
+    for (Ring_p = __atomic_load_n(&LogAsync_Rings_p, __ATOMIC_ACQUIRE);
+         Ring_p != NULL;
+         Ring_p = Ring_p->Next_p)
+    {
+        uint32_t Head = __atomic_load_n(&Ring_p->Head, __ATOMIC_ACQUIRE);
+        uint32_t Tail = Ring_p->Tail;
+
+        if (Tail == Head)
+            continue;
+
+        while (Tail != Head)
+        {
+            fputs(Ring_p->Records[Tail & (LOG_ASYNC_RING_RECORDS - 1)],
+                  Output_p);
+            Tail++;
+            Written++;
+        }
+
+        // release the records to the producer
+        __atomic_store_n(&Ring_p->Tail, Tail, __ATOMIC_RELEASE);
+    }
+
+    if (Written)
+    {
+        fflush(Output_p);
+        __atomic_add_fetch(&LogAsync_Written, Written, __ATOMIC_RELAXED);
+    }
+}
+
+
+/*----------------------------------------------------------------------------
+ * LogAsyncLib_DrainThread
+ */
+static void *
+LogAsyncLib_DrainThread(
+        void * Arg_p)
+{
+    const struct timespec Interval =
+    {
+        LOG_ASYNC_DRAIN_INTERVAL_MS / 1000,
+        (LOG_ASYNC_DRAIN_INTERVAL_MS % 1000) * 1000000
+    };
+
+    (void)Arg_p;
+
+    for (;;)
+    {
+        pthread_mutex_lock(&LogAsync_DrainLock);
+        LogAsyncLib_DrainAll();
+        pthread_mutex_unlock(&LogAsync_DrainLock);
+
+        nanosleep(&Interval, NULL);
+    }
+
+    return NULL;
+}
+
+
+/*----------------------------------------------------------------------------
+ * LogAsyncLib_Reserve
+ *
+ * Returns the next free record of the ring, or NULL when the ring is full.
+ */
+static char *
+LogAsyncLib_Reserve(
+        LogAsync_Ring_t * const Ring_p)
+{
+    uint32_t Tail = __atomic_load_n(&Ring_p->Tail, __ATOMIC_ACQUIRE);
+
+    if (Ring_p->Head - Tail >= LOG_ASYNC_RING_RECORDS)
+    {
+        __atomic_add_fetch(&LogAsync_Dropped, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    return Ring_p->Records[Ring_p->Head & (LOG_ASYNC_RING_RECORDS - 1)];
+}
+
+
+/*----------------------------------------------------------------------------
+ * LogAsyncLib_StartDrain
+ */
+static void
+LogAsyncLib_StartDrain(void)
+{
+    pthread_attr_t Attr;
+    pthread_t Thread;
+
+    pthread_attr_init(&Attr);
+    pthread_attr_setdetachstate(&Attr, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&Thread, &Attr, LogAsyncLib_DrainThread, NULL) == 0)
+        LogAsync_DrainStarted = 1;
+    pthread_attr_destroy(&Attr);
+}
+
+
+/*----------------------------------------------------------------------------
+ * LogAsyncLib_Commit
+ */
+static void
+LogAsyncLib_Commit(
+        LogAsync_Ring_t * const Ring_p)
+{
+    __atomic_store_n(&Ring_p->Head, Ring_p->Head + 1, __ATOMIC_RELEASE);
+
+    // first message in a child process: start its own drain thread
+    if (__atomic_load_n(&LogAsync_DrainRestart, __ATOMIC_ACQUIRE) &&
+        pthread_mutex_trylock(&LogAsync_DrainLock) == 0)
+    {
+        if (LogAsync_DrainRestart)
+        {
+            LogAsync_DrainRestart = 0;
+            LogAsyncLib_StartDrain();
+        }
+        pthread_mutex_unlock(&LogAsync_DrainLock);
+    }
+
+    // no drain thread: write out from the caller
+    if (!LogAsync_DrainStarted &&
+        pthread_mutex_trylock(&LogAsync_DrainLock) == 0)
+    {
+        LogAsyncLib_DrainAll();
+        pthread_mutex_unlock(&LogAsync_DrainLock);
+    }
+}
+
+
+/*----------------------------------------------------------------------------
+ * LogAsyncLib_BaseName
+ */
+static const char *
+LogAsyncLib_BaseName(
+        const char * szFile_p)
+{
+    const char * p = strrchr(szFile_p, '/');
+
+    return p ? p + 1 : szFile_p;
+}
+
+
+/*----------------------------------------------------------------------------
+ * LogAsyncLib_Report
+ *
+ * Logs the number of messages of a call site discarded by the rate limit.
+ */
+static void
+LogAsyncLib_Report(
+        LogAsync_Ring_t * const Ring_p,
+        LogAsync_Site_t * const Site_p)
+{
+    char * Record_p;
+
+    if (Site_p->File_p == NULL || Site_p->Suppressed == 0)
+        return;
+
+    Record_p = LogAsyncLib_Reserve(Ring_p);
+    if (Record_p)
+    {
+        snprintf(Record_p, LOG_ASYNC_RECORD_SIZE,
+                 "%s, %s:%d: %u similar messages suppressed\n",
+                 LogAsync_SeverityNames[Site_p->Severity],
+                 LogAsyncLib_BaseName(Site_p->File_p),
+                 Site_p->Line,
+                 (unsigned int)Site_p->Suppressed);
+
+        LogAsyncLib_Commit(Ring_p);
+    }
+
+    Site_p->Suppressed = 0;
+}
+
+
+/*----------------------------------------------------------------------------
+ * LogAsyncLib_ThreadExit
+ *
+ * Reports the pending suppressed messages and hands the ring over for reuse.
+ * The drain keeps writing out the records still in it.
+ */
+static void
+LogAsyncLib_ThreadExit(
+        void * Arg_p)
+{
+    LogAsync_Ring_t * Ring_p = Arg_p;
+    unsigned int i;
+
+    for (i = 0; i < LOG_ASYNC_SITES; i++)
+        LogAsyncLib_Report(Ring_p, &Ring_p->Sites[i]);
+
+    __atomic_store_n(&Ring_p->Orphaned, 1, __ATOMIC_RELEASE);
+}
+
+
+/*----------------------------------------------------------------------------
+ * LogAsyncLib_AtExit
+ */
+static void
+LogAsyncLib_AtExit(void)
+{
+    Log_Async_Flush();
+}
+
+
+/*----------------------------------------------------------------------------
+ * LogAsyncLib_AtFork_Prepare
+ *
+ * Keeps the rings and the output consistent over fork().
+ */
+static void
+LogAsyncLib_AtFork_Prepare(void)
+{
+    pthread_mutex_lock(&LogAsync_RegisterLock);
+    pthread_mutex_lock(&LogAsync_DrainLock);
+}
+
+
+/*----------------------------------------------------------------------------
+ * LogAsyncLib_AtFork_Parent
+ */
+static void
+LogAsyncLib_AtFork_Parent(void)
+{
+    pthread_mutex_unlock(&LogAsync_DrainLock);
+    pthread_mutex_unlock(&LogAsync_RegisterLock);
+}
+
+
+/*----------------------------------------------------------------------------
+ * LogAsyncLib_AtFork_Child
+ *
+ * Only the forking thread exists in the child. The records already in the
+ * rings are written out by the parent, so they are discarded here, and the
+ * rings of the other threads are handed over for reuse. The drain thread
+ * is started again by the first message of the child; until then the
+ * messages are written out by the caller.
+ */
+static void
+LogAsyncLib_AtFork_Child(void)
+{
+    LogAsync_Ring_t * const Own_p =
+        LogAsync_KeyValid ? pthread_getspecific(LogAsync_Key) : NULL;
+    LogAsync_Ring_t * Ring_p;
+
+    for (Ring_p = LogAsync_Rings_p; Ring_p != NULL; Ring_p = Ring_p->Next_p)
+    {
+        Ring_p->Tail = Ring_p->Head;
+        if (Ring_p != Own_p)
+            Ring_p->Orphaned = 1;
+    }
+
+    LogAsync_DrainRestart = LogAsync_DrainStarted;
+    LogAsync_DrainStarted = 0;
+
+    pthread_mutex_unlock(&LogAsync_DrainLock);
+    pthread_mutex_unlock(&LogAsync_RegisterLock);
+}
+
+
+/*----------------------------------------------------------------------------
+ * LogAsyncLib_Init
+ */
+static void
+LogAsyncLib_Init(void)
+{
+    if (pthread_key_create(&LogAsync_Key, LogAsyncLib_ThreadExit) == 0)
+        LogAsync_KeyValid = 1;
+
+    LogAsyncLib_StartDrain();
+
+    pthread_atfork(
+            LogAsyncLib_AtFork_Prepare,
+            LogAsyncLib_AtFork_Parent,
+            LogAsyncLib_AtFork_Child);
+
+    atexit(LogAsyncLib_AtExit);
+}
+
+
+/*----------------------------------------------------------------------------
+ * LogAsyncLib_GetRing
+ *
+ * Returns the ring of the calling thread, NULL on allocation failure.
+ */
+static LogAsync_Ring_t *
+LogAsyncLib_GetRing(void)
+{
+    LogAsync_Ring_t * Ring_p;
+
+    pthread_once(&LogAsync_Once, LogAsyncLib_Init);
+    if (!LogAsync_KeyValid)
+        return NULL;
+
+    Ring_p = pthread_getspecific(LogAsync_Key);
+    if (Ring_p)
+        return Ring_p;
+
+    pthread_mutex_lock(&LogAsync_RegisterLock);
+
+    for (Ring_p = LogAsync_Rings_p; Ring_p != NULL; Ring_p = Ring_p->Next_p)
+    {
+        if (__atomic_load_n(&Ring_p->Orphaned, __ATOMIC_ACQUIRE))
+        {
+            Ring_p->Orphaned = 0;
+            memset(Ring_p->Sites, 0, sizeof(Ring_p->Sites));
+            break;
+        }
+    }
+
+    if (Ring_p == NULL)
+    {
+        Ring_p = calloc(1, sizeof(LogAsync_Ring_t));
+        if (Ring_p)
+        {
+            Ring_p->Next_p = LogAsync_Rings_p;
+            __atomic_store_n(&LogAsync_Rings_p, Ring_p, __ATOMIC_RELEASE);
+        }
+    }
+
+    pthread_mutex_unlock(&LogAsync_RegisterLock);
+
+    if (Ring_p)
+        pthread_setspecific(LogAsync_Key, Ring_p);
+
+    return Ring_p;
+}
+
+
+/*----------------------------------------------------------------------------
+ * Log_Async_Message
+ */
+void
+Log_Async_Message(
+        const int Severity,
+        const char * szFile_p,
+        const int Line,
+        const char * szFormat_p,
+        ...)
+{
+    LogAsync_Ring_t * Ring_p = LogAsyncLib_GetRing();
+    LogAsync_Site_t * Site_p;
+    uint32_t Now;
+    char * Record_p;
+    va_list ap;
+    int Len;
+    int Res;
+
+    if (Ring_p == NULL)
+    {
+        __atomic_add_fetch(&LogAsync_Dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    // rate limit per call site
+    Now = LogAsyncLib_NowMS();
+    Site_p = &Ring_p->Sites[
+                    (((uintptr_t)szFile_p >> 3) ^ ((unsigned int)Line * 31)) &
+                    (LOG_ASYNC_SITES - 1)];
+
+    if (Site_p->File_p != szFile_p || Site_p->Line != Line)
+    {
+        LogAsyncLib_Report(Ring_p, Site_p);
+
+        Site_p->File_p = szFile_p;
+        Site_p->Line = Line;
+        Site_p->WindowStart = Now;
+        Site_p->Count = 0;
+    }
+    else if (Now - Site_p->WindowStart >= LOG_ASYNC_WINDOW_MS)
+    {
+        LogAsyncLib_Report(Ring_p, Site_p);
+
+        Site_p->WindowStart = Now;
+        Site_p->Count = 0;
+    }
+    Site_p->Severity = Severity & 3;
+
+    if (Site_p->Count >= LOG_ASYNC_BURST)
+    {
+        // not formatted at all
+        Site_p->Suppressed++;
+        __atomic_add_fetch(&LogAsync_Suppressed, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    Site_p->Count++;
+
+    Record_p = LogAsyncLib_Reserve(Ring_p);
+    if (Record_p == NULL)
+        return;
+
+    Len = snprintf(Record_p, LOG_ASYNC_RECORD_SIZE,
+                   "%s, %s:%d: ",
+                   LogAsync_SeverityNames[Site_p->Severity],
+                   LogAsyncLib_BaseName(szFile_p),
+                   Line);
+    if (Len < 0)
+        Len = 0;
+    if (Len > LOG_ASYNC_RECORD_SIZE - 2)
+        Len = LOG_ASYNC_RECORD_SIZE - 2;
+
+    va_start(ap, szFormat_p);
+    Res = vsnprintf(Record_p + Len, LOG_ASYNC_RECORD_SIZE - Len,
+                    szFormat_p, ap);
+    va_end(ap);
+
+    if (Res < 0)
+        Res = 0;
+
+    // keep truncated messages on a line of their own
+    if (Len + Res >= LOG_ASYNC_RECORD_SIZE - 1)
+    {
+        Record_p[LOG_ASYNC_RECORD_SIZE - 2] = '\n';
+        Record_p[LOG_ASYNC_RECORD_SIZE - 1] = 0;
+    }
+
+    LogAsyncLib_Commit(Ring_p);
+}
+
+
+/*----------------------------------------------------------------------------
+ * Log_Async_SetOutput
+ */
+void
+Log_Async_SetOutput(
+        FILE * Output_p)
+{
+    pthread_mutex_lock(&LogAsync_DrainLock);
+
+    // records logged so far go to the previous output
+    LogAsyncLib_DrainAll();
+    LogAsync_Output_p = Output_p;
+
+    pthread_mutex_unlock(&LogAsync_DrainLock);
+}
+
+
+/*----------------------------------------------------------------------------
+ * Log_Async_Flush
+ */
+void
+Log_Async_Flush(void)
+{
+    LogAsync_Ring_t * Ring_p = NULL;
+
+    pthread_once(&LogAsync_Once, LogAsyncLib_Init);
+
+    if (LogAsync_KeyValid)
+        Ring_p = pthread_getspecific(LogAsync_Key);
+
+    if (Ring_p)
+    {
+        unsigned int i;
+
+        for (i = 0; i < LOG_ASYNC_SITES; i++)
+            LogAsyncLib_Report(Ring_p, &Ring_p->Sites[i]);
+    }
+
+    pthread_mutex_lock(&LogAsync_DrainLock);
+    LogAsyncLib_DrainAll();
+    pthread_mutex_unlock(&LogAsync_DrainLock);
+}
+
+
+/*----------------------------------------------------------------------------
+ * Log_Async_GetStats
+ */
+void
+Log_Async_GetStats(
+        Log_Async_Stats_t * const Stats_p)
+{
+    Stats_p->Written = __atomic_load_n(&LogAsync_Written, __ATOMIC_RELAXED);
+    Stats_p->Dropped = __atomic_load_n(&LogAsync_Dropped, __ATOMIC_RELAXED);
+    Stats_p->Suppressed =
+            __atomic_load_n(&LogAsync_Suppressed, __ATOMIC_RELAXED);
+}
+
+
+/* end of file log_async.c */
@@ -0,0 +1,119 @@
+/* log_impl.h
+ *
+ * Log Module, implementation for asynchronous, rate-limited output.
+ *
+ * Messages are formatted by the caller into a ring of its own thread and
+ * written to the output by a background thread, so the caller never blocks
+ * on I/O or on other logging threads. Per call site at most LOG_ASYNC_BURST
+ * messages are accepted per LOG_ASYNC_WINDOW_MS; the rest is counted (not
+ * formatted) and reported as a single line. Messages that do not fit in the
+ * ring are dropped and counted.
+ */
+
+/*****************************************************************************
+* Copyright (c) 2008-2013 INSIDE Secure B.V. All Rights Reserved.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 2 of the License, or
+* any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef INCLUDE_GUARD_LOG_IMPL_H
+#define INCLUDE_GUARD_LOG_IMPL_H
+
+#include <stdio.h>      // FILE
+#include <stdint.h>
+
+// Number of records in the ring of each logging thread (power of 2).
+#ifndef LOG_ASYNC_RING_RECORDS
+#define LOG_ASYNC_RING_RECORDS      256
+#endif
+
+// Size of a record, including the file:line prefix. Longer messages are
+// truncated.
+#ifndef LOG_ASYNC_RECORD_SIZE
+#define LOG_ASYNC_RECORD_SIZE       160
+#endif
+
+// Rate limit: messages accepted per call site per window.
+#ifndef LOG_ASYNC_BURST
+#define LOG_ASYNC_BURST             10
+#endif
+
+#ifndef LOG_ASYNC_WINDOW_MS
+#define LOG_ASYNC_WINDOW_MS         1000
+#endif
+
+// Number of call sites tracked per thread for the rate limit (power of 2).
+#ifndef LOG_ASYNC_SITES
+#define LOG_ASYNC_SITES             32
+#endif
+
+// Interval at which the background thread writes out the rings.
+#ifndef LOG_ASYNC_DRAIN_INTERVAL_MS
+#define LOG_ASYNC_DRAIN_INTERVAL_MS 10
+#endif
+
+#define LOG_ASYNC_SEVERITY_LOG      0
+#define LOG_ASYNC_SEVERITY_INFO     1
+#define LOG_ASYNC_SEVERITY_WARN     2
+#define LOG_ASYNC_SEVERITY_CRIT     3
+
+typedef struct
+{
+    uint32_t Written;       // records written to the output
+    uint32_t Dropped;       // records lost because a ring was full
+    uint32_t Suppressed;    // messages discarded by the rate limit
+}
+Log_Async_Stats_t;
+
+void
+Log_Async_Message(
+        const int Severity,
+        const char * szFile_p,
+        const int Line,
+        const char * szFormat_p,
+        ...) __attribute__ ((format (printf, 4, 5)));
+
+// Selects the output stream (default stdout).
+void
+Log_Async_SetOutput(
+        FILE * Output_p);
+
+// Writes out everything logged so far, including the pending rate limit
+// reports of the calling thread. Also done at exit.
+void
+Log_Async_Flush(void);
+
+void
+Log_Async_GetStats(
+        Log_Async_Stats_t * const Stats_p);
+
+// following implementation requires Variadic Macro support
+#define Log_Message(_str) \
+    Log_Async_Message(LOG_ASYNC_SEVERITY_LOG, __FILE__, __LINE__, "%s", _str)
+
+#define Log_FormattedMessage(...) \
+    Log_Async_Message(LOG_ASYNC_SEVERITY_LOG, __FILE__, __LINE__, __VA_ARGS__)
+
+#define Log_FormattedMessageINFO(...) \
+    Log_Async_Message(LOG_ASYNC_SEVERITY_INFO, __FILE__, __LINE__, __VA_ARGS__)
+
+#define Log_FormattedMessageWARN(...) \
+    Log_Async_Message(LOG_ASYNC_SEVERITY_WARN, __FILE__, __LINE__, __VA_ARGS__)
+
+#define Log_FormattedMessageCRIT(...) \
+    Log_Async_Message(LOG_ASYNC_SEVERITY_CRIT, __FILE__, __LINE__, __VA_ARGS__)
+
+#endif /* Include Guard */
+
+/* end of file log_impl.h */
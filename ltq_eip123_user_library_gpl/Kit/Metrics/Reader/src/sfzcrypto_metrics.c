@@ -0,0 +1,369 @@
+/* sfzcrypto_metrics.c
+ *
+ * Program to print the metrics of a process that uses the CAL, see
+ * metrics.h. Without arguments, the processes with metrics are listed.
+ *
+ * Usage: sfzcrypto_metrics [<pid> [<interval_s> [<count>]]]
+ *
+ * Without an interval, the totals since Metrics_Init are printed once.
+ * With an interval, the difference with the previous sample is printed
+ * every interval, as rates (per second) and latency percentiles.
+ */
+
+/*****************************************************************************
+* Copyright (c) 2008-2013 INSIDE Secure B.V. All Rights Reserved.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 2 of the License, or
+* any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "c_metrics.h"              // METRICS_SHM_NAME_*
+
+#include "metrics.h"                // Metrics_Block_t
+
+#include <dirent.h>                 // opendir, readdir
+#include <fcntl.h>                  // O_RDONLY
+#include <stddef.h>                 // offsetof
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>                 // atoi
+#include <string.h>                 // strncmp
+#include <sys/mman.h>               // shm_open, mmap
+#include <sys/stat.h>
+#include <unistd.h>                 // close, sleep
+
+#define METRICS_COUNTER_WORDS  (sizeof(Metrics_Block_t) / sizeof(uint32_t))
+
+// prints counter _name of M_p, see MetricsReader_Print
+#define METRICSREADER_COUNTER(_name) \
+    MetricsReader_PrintCounter(#_name, M_p->_name, Seconds)
+
+// names of the token opcodes, see CALCMLib_DecodeOpcode
+static const char * const MetricsReader_OpcodeNames[METRICS_OPCODE_COUNT] =
+{
+    "NOP", "Crypto", "Hash", "MAC", "TRNG", "Opcode 5", "AES-Wrap",
+    "AssetMgmt", "Opcode 8", "Opcode 9", "Opcode 10", "Opcode 11",
+    "Opcode 12", "Opcode 13", "Service", "System Info"
+};
+
+
+/*----------------------------------------------------------------------------
+ * MetricsReader_List
+ *
+ * Lists the processes with a metrics segment. Linux keeps the POSIX shared
+ * memory segments in /dev/shm.
+ */
+static int
+MetricsReader_List(void)
+{
+    const char * Prefix_p = METRICS_SHM_NAME_PREFIX + 1;    // skip the '/'
+    struct dirent * Entry_p;
+    DIR * Dir_p;
+    int Found = 0;
+
+    Dir_p = opendir("/dev/shm");
+    if (Dir_p == NULL)
+    {
+        printf("Cannot list the shared memory segments\n");
+        return 1;
+    }
+
+    while ((Entry_p = readdir(Dir_p)) != NULL)
+    {
+        if (strncmp(Entry_p->d_name, Prefix_p, strlen(Prefix_p)) == 0)
+        {
+            printf("%s\n", Entry_p->d_name + strlen(Prefix_p));
+            Found++;
+        }
+    }
+
+    closedir(Dir_p);
+
+    if (Found == 0)
+        printf("No processes with metrics found\n");
+
+    return 0;
+}
+
+
+/*----------------------------------------------------------------------------
+ * MetricsReader_Sample
+ *
+ * Copies the counters word by word; each word is read atomically.
+ */
+static void
+MetricsReader_Sample(
+        const Metrics_Block_t * const Block_p,
+        Metrics_Block_t * const Sample_p)
+{
+    const uint32_t * Src_p = (const uint32_t *)Block_p;
+    uint32_t * Dst_p = (uint32_t *)Sample_p;
+    unsigned int i;
+
+    for (i = 0; i < METRICS_COUNTER_WORDS; i++)
+        Dst_p[i] = __atomic_load_n(&Src_p[i], __ATOMIC_RELAXED);
+}
+
+
+/*----------------------------------------------------------------------------
+ * MetricsReader_Delta
+ *
+ * Sets the counters in Delta_p to the difference between Now_p and Prev_p
+ * (modulo 2^32, all counters wrap around).
+ */
+static void
+MetricsReader_Delta(
+        Metrics_Block_t * const Delta_p,
+        const Metrics_Block_t * const Now_p,
+        const Metrics_Block_t * const Prev_p)
+{
+    uint32_t * Delta32_p = (uint32_t *)Delta_p;
+    const uint32_t * Now32_p = (const uint32_t *)Now_p;
+    const uint32_t * Prev32_p = (const uint32_t *)Prev_p;
+    // the header is not a counter
+    unsigned int i = offsetof(Metrics_Block_t, Token) / sizeof(uint32_t);
+
+    *Delta_p = *Now_p;
+
+    for (; i < METRICS_COUNTER_WORDS; i++)
+        Delta32_p[i] = Now32_p[i] - Prev32_p[i];
+}
+
+
+/*----------------------------------------------------------------------------
+ * MetricsReader_Percentile
+ *
+ * Returns the upper bound (us) of the histogram bucket that holds the
+ * given percentile, or 0 when nothing was counted.
+ */
+static uint32_t
+MetricsReader_Percentile(
+        const Metrics_Latency_t * const Latency_p,
+        const unsigned int Percent)
+{
+    uint64_t Total = 0;
+    uint64_t Limit;
+    unsigned int b;
+
+    for (b = 0; b < METRICS_BUCKET_COUNT; b++)
+        Total += Latency_p->Buckets[b];
+
+    if (Total == 0)
+        return 0;
+
+    Limit = (Total * Percent + 99) / 100;
+
+    Total = 0;
+    for (b = 0; b < METRICS_BUCKET_COUNT; b++)
+    {
+        Total += Latency_p->Buckets[b];
+        if (Total >= Limit)
+            break;
+    }
+
+    if (b == 0)
+        return 0;
+
+    if (b >= METRICS_BUCKET_COUNT - 1)
+        return (uint32_t)1 << (METRICS_BUCKET_COUNT - 1);
+
+    return ((uint32_t)1 << b) - 1;
+}
+
+
+/*----------------------------------------------------------------------------
+ * MetricsReader_PrintLatency
+ */
+static void
+MetricsReader_PrintLatency(
+        const char * Name_p,
+        const Metrics_Latency_t * const Latency_p,
+        const double Seconds)
+{
+    if (Latency_p->Count == 0)
+        return;
+
+    if (Seconds > 0)
+        printf("  %-14s %10.1f/s", Name_p, Latency_p->Count / Seconds);
+    else
+        printf("  %-14s %10u  ", Name_p, Latency_p->Count);
+
+    printf(
+        " %8u %8u %8u %8u\n",
+        Latency_p->TotalUS / Latency_p->Count,
+        MetricsReader_Percentile(Latency_p, 50),
+        MetricsReader_Percentile(Latency_p, 90),
+        MetricsReader_Percentile(Latency_p, 99));
+}
+
+
+/*----------------------------------------------------------------------------
+ * MetricsReader_PrintCounter
+ */
+static void
+MetricsReader_PrintCounter(
+        const char * Name_p,
+        const uint32_t Value,
+        const double Seconds)
+{
+    if (Seconds > 0)
+        printf("  %-18s %12.1f/s\n", Name_p, Value / Seconds);
+    else
+        printf("  %-18s %12u\n", Name_p, Value);
+}
+
+
+/*----------------------------------------------------------------------------
+ * MetricsReader_Print
+ *
+ * Prints the counters; Seconds = 0 prints totals instead of rates.
+ */
+static void
+MetricsReader_Print(
+        const Metrics_Block_t * const M_p,
+        const double Seconds)
+{
+    unsigned int i;
+
+    printf(
+        "\n%-16s %12s %8s %8s %8s %8s\n",
+        "Latency (us)",
+        Seconds > 0 ? "rate" : "count",
+        "mean", "p50", "p90", "p99");
+
+    for (i = 0; i < METRICS_OPCODE_COUNT; i++)
+        MetricsReader_PrintLatency(
+                MetricsReader_OpcodeNames[i],
+                &M_p->Token[i],
+                Seconds);
+
+    MetricsReader_PrintLatency("CM lock wait", &M_p->LockWait, Seconds);
+    MetricsReader_PrintLatency(
+            "Kernel request",
+            &M_p->KernelRequests,
+            Seconds);
+
+    printf("Counters\n");
+    METRICSREADER_COUNTER(TokenErrors);
+    METRICSREADER_COUNTER(LockFailures);
+    METRICSREADER_COUNTER(BounceIn);
+    METRICSREADER_COUNTER(BounceOut);
+    METRICSREADER_COUNTER(BytesCopiedIn);
+    METRICSREADER_COUNTER(BytesCopiedOut);
+    METRICSREADER_COUNTER(TokenIDWaits);
+    METRICSREADER_COUNTER(TokenIDWaitLoops);
+    METRICSREADER_COUNTER(TokenIDTimeouts);
+    METRICSREADER_COUNTER(DMAAlloc);
+    METRICSREADER_COUNTER(DMAAllocFailures);
+    METRICSREADER_COUNTER(DMARegister);
+    METRICSREADER_COUNTER(DMARelease);
+    METRICSREADER_COUNTER(PreDMA);
+    METRICSREADER_COUNTER(PostDMA);
+    METRICSREADER_COUNTER(CacheBytes);
+    METRICSREADER_COUNTER(IntChecks);
+    METRICSREADER_COUNTER(IntSpurious);
+    METRICSREADER_COUNTER(IntDispatched);
+    METRICSREADER_COUNTER(KernelErrors);
+}
+
+
+/*----------------------------------------------------------------------------
+ * main
+ */
+int
+main(
+        int argc,
+        char ** argv)
+{
+    char Name[METRICS_SHM_NAME_SIZE];
+    const Metrics_Block_t * Block_p;
+    Metrics_Block_t Prev;
+    Metrics_Block_t Now;
+    Metrics_Block_t Delta;
+    struct stat Stat;
+    int Interval = 0;
+    int Count = 0;
+    int fd;
+
+    if (argc < 2)
+        return MetricsReader_List();
+
+    if (argc > 2)
+        Interval = atoi(argv[2]);
+
+    if (argc > 3)
+        Count = atoi(argv[3]);
+
+    snprintf(Name, sizeof(Name), "%s%s", METRICS_SHM_NAME_PREFIX, argv[1]);
+
+    fd = shm_open(Name, O_RDONLY, 0);
+    if (fd < 0)
+    {
+        printf("No metrics for process %s\n", argv[1]);
+        return 1;
+    }
+
+    if (fstat(fd, &Stat) != 0 ||
+        Stat.st_size < (off_t)sizeof(Metrics_Block_t))
+    {
+        printf("Metrics of process %s have an unknown format\n", argv[1]);
+        close(fd);
+        return 1;
+    }
+
+    Block_p = mmap(NULL, sizeof(Metrics_Block_t), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (Block_p == MAP_FAILED)
+    {
+        printf("Cannot map the metrics of process %s\n", argv[1]);
+        return 1;
+    }
+
+    if (__atomic_load_n(&Block_p->Magic, __ATOMIC_ACQUIRE) != METRICS_MAGIC ||
+        Block_p->Version != METRICS_VERSION ||
+        Block_p->Size != sizeof(Metrics_Block_t))
+    {
+        printf("Metrics of process %s have an unknown format\n", argv[1]);
+        return 1;
+    }
+
+    MetricsReader_Sample(Block_p, &Prev);
+
+    if (Interval <= 0)
+    {
+        printf("Process %u, totals:\n", Prev.ProcessID);
+        MetricsReader_Print(&Prev, 0);
+        return 0;
+    }
+
+    // the counters of a process are never reset, so the first interval
+    // starts now; Count = 0 means until interrupted
+    do
+    {
+        sleep(Interval);
+
+        MetricsReader_Sample(Block_p, &Now);
+        MetricsReader_Delta(&Delta, &Now, &Prev);
+        Prev = Now;
+
+        printf("Process %u, last %d s:\n", Now.ProcessID, Interval);
+        MetricsReader_Print(&Delta, Interval);
+        fflush(stdout);
+    }
+    while (Count == 0 || --Count > 0);
+
+    return 0;
+}
+
+/* end of file sfzcrypto_metrics.c */
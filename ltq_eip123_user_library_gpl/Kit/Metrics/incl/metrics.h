@@ -0,0 +1,198 @@
+/* metrics.h
+ *
+ * Metrics API
+ *
+ * The counters defined here describe what the CAL, the Driver Framework
+ * implementation and the UMDevXS proxy do: tokens and their latency, waits
+ * for the CM, bounce buffers, DMA resources, cache maintenance, TokenID
+ * polling, interrupts and kernel driver requests.
+ *
+ * With CFG_ENABLE_METRICS, Metrics_Init places the counters of the process
+ * in a named shared memory segment (see cs_metrics.h), where external tools
+ * such as sfzcrypto_metrics can read them without involving the process.
+ * The counters are updated with relaxed atomic operations: each counter is
+ * exact, but a reader can see the counters in a different order than they
+ * were updated. All counters are 32 bits and wrap around; readers should
+ * use the difference between two samples.
+ *
+ * Without CFG_ENABLE_METRICS, the METRICS_* macros are empty.
+ */
+
+/*****************************************************************************
+* Copyright (c) 2008-2013 INSIDE Secure B.V. All Rights Reserved.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 2 of the License, or
+* any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef INCLUDE_GUARD_METRICS_H
+#define INCLUDE_GUARD_METRICS_H
+
+#include <stdint.h>         // uint32_t
+#include <time.h>           // clock_gettime
+
+// layout of the shared memory segment; change the version with the layout
+#define METRICS_MAGIC           0x53464D54      // "SFMT"
+#define METRICS_VERSION         1
+
+// tokens are counted per opcode (bits 27:24 of the first token word)
+#define METRICS_OPCODE_COUNT    16
+
+// latency histogram: bucket 0 counts 0us, bucket b (b > 0) counts
+// [2^(b-1), 2^b) us; the last bucket also counts all longer latencies
+#define METRICS_BUCKET_COUNT    24
+
+typedef struct
+{
+    uint32_t Count;
+    uint32_t TotalUS;
+    uint32_t Buckets[METRICS_BUCKET_COUNT];
+} Metrics_Latency_t;
+
+typedef struct
+{
+    // written once, by Metrics_Init
+    uint32_t Magic;
+    uint32_t Version;
+    uint32_t Size;                  // sizeof(Metrics_Block_t)
+    uint32_t ProcessID;
+
+    // CAL: tokens per opcode, from handing over the token to the CM until
+    // the result token was read
+    Metrics_Latency_t Token[METRICS_OPCODE_COUNT];
+    uint32_t TokenErrors;
+
+    // CAL: waits for exclusive use of the CM (CAL_CM_Sched_Acquire)
+    Metrics_Latency_t LockWait;
+    uint32_t LockFailures;
+
+    // CAL: bounce buffers and bytes copied into and out of DMA buffers
+    uint32_t BounceIn;
+    uint32_t BounceOut;
+    uint32_t BytesCopiedIn;
+    uint32_t BytesCopiedOut;
+
+    // CAL: polling for the TokenID that the CM writes after the output
+    uint32_t TokenIDWaits;
+    uint32_t TokenIDWaitLoops;      // times the data had not arrived yet
+    uint32_t TokenIDTimeouts;
+
+    // DMAResource: buffers
+    uint32_t DMAAlloc;
+    uint32_t DMAAllocFailures;
+    uint32_t DMARegister;
+    uint32_t DMARelease;
+
+    // DMAResource: cache maintenance (PreDMA = clean, PostDMA = invalidate)
+    uint32_t PreDMA;
+    uint32_t PostDMA;
+    uint32_t CacheBytes;            // bytes passed to the kernel driver
+
+    // Interrupt Dispatcher (IntDispatchLib_CheckAndDispatchNow)
+    uint32_t IntChecks;
+    uint32_t IntSpurious;           // no enabled source was active
+    uint32_t IntDispatched;         // callbacks invoked
+
+    // UMDevXS proxy: requests to the kernel driver
+    Metrics_Latency_t KernelRequests;
+    uint32_t KernelErrors;
+} Metrics_Block_t;
+
+
+#ifdef CFG_ENABLE_METRICS
+
+// the block the counters are updated in; a process-local block until
+// Metrics_Init has created the shared memory segment
+extern Metrics_Block_t * Metrics_Block_p;
+
+
+/*----------------------------------------------------------------------------
+ * Metrics_Init
+ *
+ * Creates the shared memory segment for the calling process and moves the
+ * counters there. The segment is removed when the process exits. A child
+ * process created with fork() counts in a process-local block until it
+ * calls Metrics_Init itself.
+ *
+ * Return Value
+ *     0    Success (also when called again)
+ *     <0   Error, the counters remain process-local
+ */
+int
+Metrics_Init(void);
+
+
+/*----------------------------------------------------------------------------
+ * Metrics_TimeUS
+ *
+ * Returns the CLOCK_MONOTONIC time in microseconds, truncated to 32 bits.
+ */
+static inline uint32_t
+Metrics_TimeUS(void)
+{
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+        return 0;
+
+    return (uint32_t)(ts.tv_sec * 1000000UL + ts.tv_nsec / 1000);
+}
+
+
+/*----------------------------------------------------------------------------
+ * Metrics_Latency_Add
+ */
+static inline void
+Metrics_Latency_Add(
+        Metrics_Latency_t * const Latency_p,
+        const uint32_t US)
+{
+    unsigned int b = 0;
+
+    if (US != 0)
+        b = 32 - __builtin_clz(US);
+
+    if (b >= METRICS_BUCKET_COUNT)
+        b = METRICS_BUCKET_COUNT - 1;
+
+    __atomic_fetch_add(&Latency_p->Count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&Latency_p->TotalUS, US, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&Latency_p->Buckets[b], 1, __ATOMIC_RELAXED);
+}
+
+
+#define METRICS_ADD(_field, _n) \
+    (void)__atomic_fetch_add(&Metrics_Block_p->_field, \
+                             (uint32_t)(_n), \
+                             __ATOMIC_RELAXED)
+
+#define METRICS_INC(_field)  METRICS_ADD(_field, 1)
+
+// _t must be a uint32_t, declared under CFG_ENABLE_METRICS
+#define METRICS_TIMESTAMP(_t)  (_t) = Metrics_TimeUS()
+
+#define METRICS_LATENCY(_field, _t) \
+    Metrics_Latency_Add(&Metrics_Block_p->_field, Metrics_TimeUS() - (_t))
+
+#else
+
+#define METRICS_ADD(_field, _n)
+#define METRICS_INC(_field)
+#define METRICS_TIMESTAMP(_t)
+#define METRICS_LATENCY(_field, _t)
+
+#endif /* CFG_ENABLE_METRICS */
+
+#endif /* Include Guard */
+
+/* end of file metrics.h */
@@ -0,0 +1,45 @@
+/* c_metrics.h
+ *
+ * Configuration options for the Metrics module.
+ *
+ * This file includes cs_metrics.h (from the product-level) and then
+ * provides defaults for missing configuration switches.
+ */
+
+/*****************************************************************************
+* Copyright (c) 2008-2013 INSIDE Secure B.V. All Rights Reserved.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 2 of the License, or
+* any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef INCLUDE_GUARD_C_METRICS_H
+#define INCLUDE_GUARD_C_METRICS_H
+
+// get the product-level configuration
+#include "cs_metrics.h"
+
+#ifndef METRICS_SHM_NAME_PREFIX
+#define METRICS_SHM_NAME_PREFIX  "/sfzcrypto_metrics."
+#endif
+
+#ifndef METRICS_SHM_MODE
+#define METRICS_SHM_MODE  0644
+#endif
+
+// room for the prefix and the process ID
+#define METRICS_SHM_NAME_SIZE  (sizeof(METRICS_SHM_NAME_PREFIX) + 12)
+
+#endif /* INCLUDE_GUARD_C_METRICS_H */
+
+/* end of file c_metrics.h */
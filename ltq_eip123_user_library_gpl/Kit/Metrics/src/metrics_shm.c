@@ -0,0 +1,180 @@
+/* metrics_shm.c
+ *
+ * Metrics module, implementation with a POSIX shared memory segment per
+ * process.
+ */
+
+/*****************************************************************************
+* Copyright (c) 2008-2013 INSIDE Secure B.V. All Rights Reserved.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 2 of the License, or
+* any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "c_metrics.h"
+
+#include "metrics.h"            // the API to implement
+
+#ifdef CFG_ENABLE_METRICS
+
+#include <fcntl.h>              // O_*
+#include <pthread.h>            // pthread_mutex_*, pthread_atfork
+#include <stdio.h>              // snprintf
+#include <stdlib.h>             // atexit
+#include <string.h>             // memcpy
+#include <sys/mman.h>           // shm_open, shm_unlink, mmap
+#include <sys/stat.h>           // mode constants
+#include <unistd.h>             // ftruncate, close, getpid
+
+// counters before Metrics_Init, or when the segment cannot be created
+static Metrics_Block_t Metrics_LocalBlock;
+
+Metrics_Block_t * Metrics_Block_p = &Metrics_LocalBlock;
+
+static pthread_mutex_t Metrics_Lock = PTHREAD_MUTEX_INITIALIZER;
+
+// process that created the segment; 0 = none
+static pid_t Metrics_Owner = 0;
+static char Metrics_Name[METRICS_SHM_NAME_SIZE];
+static int Metrics_fHandlersInstalled = 0;
+
+
+/*----------------------------------------------------------------------------
+ * MetricsLib_AtExit
+ *
+ * Removes the segment of the process; the segment is not removed when a
+ * child process created with fork() exits.
+ */
+static void
+MetricsLib_AtExit(void)
+{
+    if (Metrics_Owner != 0 && Metrics_Owner == getpid())
+        shm_unlink(Metrics_Name);
+}
+
+
+/*----------------------------------------------------------------------------
+ * MetricsLib_AtFork_Child
+ *
+ * The segment is shared with the parent process; the child counts in the
+ * process-local block instead.
+ */
+static void
+MetricsLib_AtFork_Child(void)
+{
+    pthread_mutex_init(&Metrics_Lock, NULL);
+
+    Metrics_LocalBlock = *Metrics_Block_p;
+    Metrics_Block_p = &Metrics_LocalBlock;
+    Metrics_Owner = 0;
+}
+
+
+/*----------------------------------------------------------------------------
+ * Metrics_Init
+ */
+int
+Metrics_Init(void)
+{
+    Metrics_Block_t * Block_p;
+    int rv = 0;
+    int fd;
+
+    pthread_mutex_lock(&Metrics_Lock);
+
+    if (Metrics_Owner != 0)
+        goto done;  // already initialized
+
+    if (!Metrics_fHandlersInstalled)
+    {
+        if (atexit(MetricsLib_AtExit) != 0 ||
+            pthread_atfork(NULL, NULL, MetricsLib_AtFork_Child) != 0)
+        {
+            rv = -1;
+            goto done;
+        }
+
+        Metrics_fHandlersInstalled = 1;
+    }
+
+    snprintf(
+        Metrics_Name,
+        sizeof(Metrics_Name),
+        "%s%d",
+        METRICS_SHM_NAME_PREFIX,
+        (int)getpid());
+
+    // a segment of an earlier process with the same ID is replaced
+    fd = shm_open(
+            Metrics_Name,
+            O_RDWR | O_CREAT | O_TRUNC,
+            METRICS_SHM_MODE);
+    if (fd < 0)
+    {
+        rv = -2;
+        goto done;
+    }
+
+    if (ftruncate(fd, sizeof(Metrics_Block_t)) != 0)
+    {
+        close(fd);
+        shm_unlink(Metrics_Name);
+        rv = -3;
+        goto done;
+    }
+
+    Block_p = mmap(
+                NULL,
+                sizeof(Metrics_Block_t),
+                PROT_READ | PROT_WRITE,
+                MAP_SHARED,
+                fd,
+                0);
+
+    close(fd);
+
+    if (Block_p == MAP_FAILED)
+    {
+        shm_unlink(Metrics_Name);
+        rv = -4;
+        goto done;
+    }
+
+    // take over what was counted so far; concurrent updates of the local
+    // block can get lost while the counters move
+    memcpy(Block_p, &Metrics_LocalBlock, sizeof(Metrics_Block_t));
+
+    Block_p->Version = METRICS_VERSION;
+    Block_p->Size = sizeof(Metrics_Block_t);
+    Block_p->ProcessID = (uint32_t)getpid();
+
+    // readers check the magic last
+    __atomic_store_n(&Block_p->Magic, METRICS_MAGIC, __ATOMIC_RELEASE);
+    __atomic_store_n(&Metrics_Block_p, Block_p, __ATOMIC_RELEASE);
+
+    Metrics_Owner = getpid();
+
+done:
+    pthread_mutex_unlock(&Metrics_Lock);
+
+    return rv;
+}
+
+#else
+
+// avoid the "empty translation unit" warning
+extern const int _avoid_empty_translation_unit;
+
+#endif /* CFG_ENABLE_METRICS */
+
+/* end of file metrics_shm.c */